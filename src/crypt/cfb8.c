@@ -1,20 +1,202 @@
+#include <string.h>
 #include "cfb8.h"
 
-int cfb8_init(byte_t* key, EVP_CIPHER_CTX** e, EVP_CIPHER_CTX** d) {
+#if defined(__GNUC__) && defined(__x86_64__)
+#define CFB8_AESNI
+#include <immintrin.h>
+#endif
+
+#ifdef CFB8_AESNI
+
+#define CFB8_TARGET __attribute__((target("aes,sse4.1")))
+
+bool cfb8_accelerated() {
+
+	return __builtin_cpu_supports("aes") && __builtin_cpu_supports("sse4.1");
+
+}
+
+CFB8_TARGET static inline __m128i cfb8_expand_step(__m128i key, __m128i assist) {
+
+	assist = _mm_shuffle_epi32(assist, 0xFF);
+	key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+	key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+	key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+
+	return _mm_xor_si128(key, assist);
+
+}
+
+#define CFB8_EXPAND(i, rcon) keys[i] = cfb8_expand_step(keys[i - 1], _mm_aeskeygenassist_si128(keys[i - 1], rcon))
+
+CFB8_TARGET static void cfb8_expand_key(const byte_t* key, byte_t out[11][16]) {
+
+	__m128i keys[11];
+
+	keys[0] = _mm_loadu_si128((const __m128i*) key);
+	CFB8_EXPAND(1, 0x01);
+	CFB8_EXPAND(2, 0x02);
+	CFB8_EXPAND(3, 0x04);
+	CFB8_EXPAND(4, 0x08);
+	CFB8_EXPAND(5, 0x10);
+	CFB8_EXPAND(6, 0x20);
+	CFB8_EXPAND(7, 0x40);
+	CFB8_EXPAND(8, 0x80);
+	CFB8_EXPAND(9, 0x1B);
+	CFB8_EXPAND(10, 0x36);
+
+	for (uint32_t i = 0; i < 11; ++i) {
+		_mm_storeu_si128((__m128i*) out[i], keys[i]);
+	}
+
+}
+
+CFB8_TARGET static inline void cfb8_load_keys(const cfb8_cipher_t* cipher, __m128i keys[11]) {
+
+	for (uint32_t i = 0; i < 11; ++i) {
+		keys[i] = _mm_loadu_si128((const __m128i*) cipher->keys[i]);
+	}
+
+}
+
+CFB8_TARGET static inline __m128i cfb8_encrypt_block(__m128i block, const __m128i keys[11]) {
+
+	block = _mm_xor_si128(block, keys[0]);
+	for (uint32_t i = 1; i < 10; ++i) {
+		block = _mm_aesenc_si128(block, keys[i]);
+	}
+
+	return _mm_aesenclast_si128(block, keys[10]);
+
+}
+
+// the next byte's block is the last 15 bytes of the block before and the byte that was just sent
+CFB8_TARGET static inline __m128i cfb8_shift(__m128i iv, byte_t cipher) {
+
+	return _mm_insert_epi8(_mm_srli_si128(iv, 1), cipher, 15);
+
+}
+
+// each byte's block needs the ciphertext of the byte before, so encrypting goes one block at a time
+CFB8_TARGET static void cfb8_encrypt_aesni(cfb8_cipher_t* e, const byte_t* data, size_t len, byte_t* out) {
+
+	__m128i keys[11];
+	cfb8_load_keys(e, keys);
+
+	__m128i iv = _mm_loadu_si128((const __m128i*) e->iv);
+
+	for (size_t i = 0; i < len; ++i) {
+		const byte_t cipher = data[i] ^ (byte_t) _mm_cvtsi128_si32(cfb8_encrypt_block(iv, keys));
+		out[i] = cipher;
+		iv = cfb8_shift(iv, cipher);
+	}
+
+	_mm_storeu_si128((__m128i*) e->iv, iv);
+
+}
+
+#define CFB8_ALIGN(i) blocks[i] = _mm_alignr_epi8(cipher, previous, i)
+
+// the ciphertext is all there when decrypting, so 16 bytes' blocks go through the AES units together
+CFB8_TARGET static void cfb8_decrypt_aesni(cfb8_cipher_t* d, const byte_t* data, size_t len, byte_t* out) {
+
+	__m128i keys[11];
+	cfb8_load_keys(d, keys);
+
+	__m128i previous = _mm_loadu_si128((const __m128i*) d->iv);
+	size_t i = 0;
+
+	for (; i + 16 <= len; i += 16) {
+
+		// loaded before anything is written, so decrypting in place works
+		const __m128i cipher = _mm_loadu_si128((const __m128i*) (data + i));
+
+		__m128i blocks[16];
+		blocks[0] = previous;
+		CFB8_ALIGN(1);
+		CFB8_ALIGN(2);
+		CFB8_ALIGN(3);
+		CFB8_ALIGN(4);
+		CFB8_ALIGN(5);
+		CFB8_ALIGN(6);
+		CFB8_ALIGN(7);
+		CFB8_ALIGN(8);
+		CFB8_ALIGN(9);
+		CFB8_ALIGN(10);
+		CFB8_ALIGN(11);
+		CFB8_ALIGN(12);
+		CFB8_ALIGN(13);
+		CFB8_ALIGN(14);
+		CFB8_ALIGN(15);
+
+		for (uint32_t j = 0; j < 16; ++j) {
+			blocks[j] = _mm_xor_si128(blocks[j], keys[0]);
+		}
+		for (uint32_t round = 1; round < 10; ++round) {
+			for (uint32_t j = 0; j < 16; ++j) {
+				blocks[j] = _mm_aesenc_si128(blocks[j], keys[round]);
+			}
+		}
+
+		byte_t stream[16];
+		for (uint32_t j = 0; j < 16; ++j) {
+			stream[j] = (byte_t) _mm_cvtsi128_si32(_mm_aesenclast_si128(blocks[j], keys[10]));
+		}
+
+		_mm_storeu_si128((__m128i*) (out + i), _mm_xor_si128(cipher, _mm_loadu_si128((const __m128i*) stream)));
+
+		previous = cipher;
+
+	}
+
+	for (; i < len; ++i) {
+		const byte_t cipher = data[i];
+		out[i] = cipher ^ (byte_t) _mm_cvtsi128_si32(cfb8_encrypt_block(previous, keys));
+		previous = cfb8_shift(previous, cipher);
+	}
+
+	_mm_storeu_si128((__m128i*) d->iv, previous);
+
+}
+
+#else
+
+bool cfb8_accelerated() {
+
+	return false;
+
+}
+
+#endif
+
+int cfb8_init(byte_t* key, cfb8_cipher_t* e, cfb8_cipher_t* d) {
+
+	e->evp = NULL;
+	d->evp = NULL;
+
+#ifdef CFB8_AESNI
+	if (cfb8_accelerated()) {
+		cfb8_expand_key(key, e->keys);
+		memcpy(d->keys, e->keys, sizeof(d->keys));
+		memcpy(e->iv, key, sizeof(e->iv));
+		memcpy(d->iv, key, sizeof(d->iv));
+		return 1;
+	}
+#endif
 	
-	if ((*e = EVP_CIPHER_CTX_new()) == NULL) {
+	if ((e->evp = EVP_CIPHER_CTX_new()) == NULL) {
 		return 0;
 	}
 
-	if (EVP_EncryptInit_ex(*e, EVP_aes_128_cfb8(), NULL, key, key) != 1) {
+	if (EVP_EncryptInit_ex(e->evp, EVP_aes_128_cfb8(), NULL, key, key) != 1) {
 		return 0;
 	}
 
-	if ((*d = EVP_CIPHER_CTX_new()) == NULL) {
+	if ((d->evp = EVP_CIPHER_CTX_new()) == NULL) {
 		return 0;
 	}
 
-	if (EVP_DecryptInit_ex(*d, EVP_aes_128_cfb8(), NULL, key, key) != 1) {
+	if (EVP_DecryptInit_ex(d->evp, EVP_aes_128_cfb8(), NULL, key, key) != 1) {
 		return 0;
 	}
 
@@ -22,24 +204,38 @@ int cfb8_init(byte_t* key, EVP_CIPHER_CTX** e, EVP_CIPHER_CTX** d) {
 
 }
 
-int cfb8_encrypt(EVP_CIPHER_CTX* e, byte_t* restrict data, size_t len, byte_t* restrict out) {
+int cfb8_encrypt(cfb8_cipher_t* e, byte_t* data, size_t len, byte_t* out) {
+
+#ifdef CFB8_AESNI
+	if (e->evp == NULL) {
+		cfb8_encrypt_aesni(e, data, len, out);
+		return 1;
+	}
+#endif
 
 	int out_len = len;
-	return EVP_EncryptUpdate(e, out, &out_len, data, len);
+	return EVP_EncryptUpdate(e->evp, out, &out_len, data, len);
 
 }
 
-int cfb8_decrypt(EVP_CIPHER_CTX* d, byte_t* restrict data, size_t len, byte_t* restrict out) {
+int cfb8_decrypt(cfb8_cipher_t* d, byte_t* data, size_t len, byte_t* out) {
+
+#ifdef CFB8_AESNI
+	if (d->evp == NULL) {
+		cfb8_decrypt_aesni(d, data, len, out);
+		return 1;
+	}
+#endif
 
 	int out_len = len;
-	return EVP_DecryptUpdate(d, out, &out_len, data, len);
+	return EVP_DecryptUpdate(d->evp, out, &out_len, data, len);
 
 }
 
-int cfb8_done(EVP_CIPHER_CTX* e, EVP_CIPHER_CTX* d) {
+int cfb8_done(cfb8_cipher_t* e, cfb8_cipher_t* d) {
 
-	EVP_CIPHER_CTX_free(e);
-	EVP_CIPHER_CTX_free(d);
+	EVP_CIPHER_CTX_free(e->evp);
+	EVP_CIPHER_CTX_free(d->evp);
 
 	return 0;
 
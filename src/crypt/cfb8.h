@@ -1,7 +1,20 @@
+#pragma once
 #include <openssl/evp.h>
 #include "../main.h"
 
-int cfb8_init(byte_t* key, EVP_CIPHER_CTX** e, EVP_CIPHER_CTX** d);
-int cfb8_encrypt(EVP_CIPHER_CTX* e, byte_t* restrict data, size_t len, byte_t* restrict out);
-int cfb8_decrypt(EVP_CIPHER_CTX* d, byte_t* restrict data, size_t len, byte_t* restrict out);
-int cfb8_done(EVP_CIPHER_CTX* e, EVP_CIPHER_CTX* d);
\ No newline at end of file
+// AES-128 in CFB8 mode, going one way, the key is the IV too
+typedef struct {
+
+	EVP_CIPHER_CTX* evp; // only used if the CPU has no AES instructions
+	byte_t keys[11][16]; // round keys
+	byte_t iv[16]; // the last 16 bytes of ciphertext
+
+} cfb8_cipher_t;
+
+int cfb8_init(byte_t* key, cfb8_cipher_t* e, cfb8_cipher_t* d);
+int cfb8_encrypt(cfb8_cipher_t* e, byte_t* data, size_t len, byte_t* out);
+int cfb8_decrypt(cfb8_cipher_t* d, byte_t* data, size_t len, byte_t* out);
+int cfb8_done(cfb8_cipher_t* e, cfb8_cipher_t* d);
+
+// if the CPU's AES instructions are used instead of OpenSSL
+bool cfb8_accelerated();
\ No newline at end of file
@@ -431,7 +431,8 @@ size_t cht_server_list_ping(char* message) {
 	if (online_count > 0) {
 		mjson_val* sample = mjson_arr(doc);
 		const uint32_t online_length = ltg_get_online_length(sky_get_listener());
-		for (uint32_t i = 0; i < online_length; ++i) {
+		uint32_t sampled = 0;
+		for (uint32_t i = 0; i < online_length && sampled < LTG_STATUS_SAMPLE; ++i) {
 			ltg_client_t* player = ltg_get_online_client(sky_get_listener(), i);
 			if (player != NULL) {
 				mjson_val* val = mjson_obj(doc);
@@ -440,6 +441,7 @@ size_t cht_server_list_ping(char* message) {
 				ltg_uuid_to_string(ltg_client_get_uuid(player), uuid);
 				mjson_obj_add(val, mjson_string(doc, UTL_CSTRTOARG("id")), mjson_string(doc, uuid, 36));
 				mjson_arr_append(sample, val);
+				sampled++;
 			}
 		}
 		mjson_obj_add(players, mjson_string(doc, UTL_CSTRTOARG("sample")), sample);
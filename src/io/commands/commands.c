@@ -4,6 +4,7 @@
 #include "../../motor.h"
 #include "../../util/tree.h"
 #include "../../util/vector.h"
+#include "../../listening/listening.h"
 #include "../../listening/phd/play.h"
 #include "../../plugin/manager.h"
 #include "../../jobs/board.h"
@@ -15,7 +16,9 @@ UTL_VECTOR_DEFAULT(cmd_list, cmd_command_t*,
 	&cmd_stop_h,
 	&cmd_help_h,
 	&cmd_plugins_h,
-	&cmd_jb_h
+	&cmd_jb_h,
+	&cmd_net_h,
+	&cmd_capture_h
 );
 
 void cmd_add_defaults() {
@@ -271,17 +274,360 @@ bool cmd_plugins(char* args, const cmd_sender_t* sender) {
 bool cmd_jb(char* args, const cmd_sender_t* sender) {
 
 	if (args != NULL) {
-		return false;
+
+		cht_component_t msg = cht_new;
+
+		switch (cmd_hash(args)) {
+			case 0x10474288: { // "reset"
+				job_reset_telemetry();
+				msg.text = UTL_CSTRTOSTR("Job telemetry has been reset");
+			} break;
+			case 0x7c95e59b: { // "dump"
+				FILE* file = fopen("job-telemetry.json", "w");
+				if (file == NULL) {
+					msg.text = UTL_CSTRTOSTR("Could not open job-telemetry.json");
+					msg.color = cht_red;
+				} else {
+					job_write_telemetry(file);
+					fclose(file);
+					msg.text = UTL_CSTRTOSTR("Job telemetry written to job-telemetry.json");
+				}
+			} break;
+			default: {
+				return false;
+			}
+		}
+
+		cmd_message(sender, &msg);
+
+		return true;
+
 	}
 
 	char on_board[256];
-	const size_t on_board_len = sprintf(on_board, "Jobs on board: %zu", job_get_count());
+	const size_t on_board_len = sprintf(on_board, "Jobs on board: %zu (latency-critical: %zu, tick-critical: %zu, background: %zu), allocated: %u", job_get_count(), job_get_lane_count(job_lane_latency_critical), job_get_lane_count(job_lane_tick_critical), job_get_lane_count(job_lane_background), job_get_allocated());
 
 	cht_component_t msg = cht_new;
 	msg.text = UTL_ARRTOSTR(on_board, on_board_len);
 	
 	cmd_message(sender, &msg);
 
+	char tick[128];
+	const size_t tick_len = sprintf(tick, "Tick: %.2f mspt (average %.2f), %.2f tps", sky_get_mspt(), sky_get_average_mspt(), sky_get_tps());
+
+	cht_component_t tick_msg = cht_new;
+	tick_msg.text = UTL_ARRTOSTR(tick, tick_len);
+
+	cmd_message(sender, &tick_msg);
+
+	char idle[128];
+	const size_t idle_len = sprintf(idle, "Idle: %lu wakeups, %lu avoided by spinning, %lu parks", (uint64_t) job_board.idle.wakeups, (uint64_t) job_board.idle.wakeups_avoided, (uint64_t) job_board.idle.parks);
+
+	cht_component_t idle_msg = cht_new;
+	idle_msg.text = UTL_ARRTOSTR(idle, idle_len);
+
+	cmd_message(sender, &idle_msg);
+
+	// total time in handlers, to show each type's share of it
+	uint64_t run_total = 0;
+	for (job_type_t type = 0; type < job_count; ++type) {
+		run_total += utl_histogram_sum(&job_board.telemetry.types[type].run);
+	}
+
+	const float64_t elapsed = job_get_telemetry_time() / 1e9;
+
+	for (job_type_t type = 0; type < job_count; ++type) {
+
+		const uint64_t completed = job_board.telemetry.types[type].completed;
+		const uint64_t canceled = job_board.telemetry.types[type].canceled;
+
+		if (completed == 0 && canceled == 0) {
+			continue;
+		}
+
+		utl_histogram_t* wait = &job_board.telemetry.types[type].wait;
+		utl_histogram_t* run = &job_board.telemetry.types[type].run;
+
+		char line[512];
+		const size_t line_len = sprintf(line, "%s: %lu done (%.1f/s), %lu canceled, wait p50 %.1fus p99 %.1fus, run p50 %.1fus p99 %.1fus max %.1fus, %.1f%% of handler time",
+			job_get_type_name(type),
+			completed,
+			elapsed > 0 ? completed / elapsed : 0,
+			canceled,
+			utl_histogram_percentile(wait, 50) / 1e3,
+			utl_histogram_percentile(wait, 99) / 1e3,
+			utl_histogram_percentile(run, 50) / 1e3,
+			utl_histogram_percentile(run, 99) / 1e3,
+			utl_histogram_max(run) / 1e3,
+			run_total == 0 ? 0 : utl_histogram_sum(run) * 100.0 / run_total
+		);
+
+		cht_component_t type_msg = cht_new;
+		type_msg.text = UTL_ARRTOSTR(line, line_len);
+
+		cmd_message(sender, &type_msg);
+
+	}
+
+	return true;
+
+}
+
+typedef struct {
+
+	char username[17];
+	uint32_t depth;
+	bool lagging;
+
+} cmd_queue_depth_t;
+
+static int cmd_compare_queue_depth(const void* a, const void* b) {
+
+	const uint32_t depth_a = ((const cmd_queue_depth_t*) a)->depth;
+	const uint32_t depth_b = ((const cmd_queue_depth_t*) b)->depth;
+
+	return (depth_a < depth_b) - (depth_a > depth_b);
+
+}
+
+// the online clients with the most queued for them, the ones lagging the server
+static void cmd_net_clients(const cmd_sender_t* sender) {
+
+	ltg_listener_t* listener = sky_get_listener();
+
+	utl_vector_t depths = UTL_VECTOR_INITIALIZER(cmd_queue_depth_t);
+
+	// online clients are only freed after they are taken off the list, which can't happen while it's locked
+	with_lock (&listener->online.lock) {
+		const uint32_t online_length = utl_id_vector_length(&listener->online.vector);
+		for (uint32_t i = 0; i < online_length; ++i) {
+			ltg_client_t* client = UTL_ID_VECTOR_GET_AS(ltg_client_t*, &listener->online.vector, i);
+			if (client != NULL) {
+				cmd_queue_depth_t depth = {
+					.depth = ltg_client_get_queue_depth(client),
+					.lagging = ltg_client_is_lagging(client)
+				};
+				const string_t username = ltg_client_get_username(client);
+				memcpy(depth.username, username.value, UTL_MIN(username.length, 16));
+				utl_vector_push(&depths, &depth);
+			}
+		}
+	}
+
+	qsort(depths.array, depths.size, sizeof(cmd_queue_depth_t), cmd_compare_queue_depth);
+
+	char header[128];
+	const size_t header_len = sprintf(header, "Outbound queues (lagging over %u KiB until back to %u KiB):", LTG_QUEUE_HIGH >> 10, LTG_QUEUE_LOW >> 10);
+
+	cht_component_t header_msg = cht_new;
+	header_msg.text = UTL_ARRTOSTR(header, header_len);
+
+	cmd_message(sender, &header_msg);
+
+	for (uint32_t i = 0; i < depths.size && i < 10; ++i) {
+
+		const cmd_queue_depth_t* depth = utl_vector_get(&depths, i);
+
+		char line[128];
+		const size_t line_len = sprintf(line, "%s: %u bytes queued%s", depth->username, depth->depth, depth->lagging ? ", lagging" : "");
+
+		cht_component_t msg = cht_new;
+		msg.text = UTL_ARRTOSTR(line, line_len);
+		if (depth->lagging) {
+			msg.color = cht_red;
+		}
+
+		cmd_message(sender, &msg);
+
+	}
+
+	utl_term_vector(&depths);
+
+}
+
+bool cmd_net(char* args, const cmd_sender_t* sender) {
+
+	if (args != NULL) {
+		switch (cmd_hash(args)) {
+			case 0xcc179277: { // "clients"
+				cmd_net_clients(sender);
+				return true;
+			}
+			default: {
+				return false;
+			}
+		}
+	}
+
+	ltg_listener_t* listener = sky_get_listener();
+
+	for (uint32_t i = 0; i < listener->network.count; ++i) {
+
+		ltg_network_t* network = &listener->network.threads[i];
+
+		const uint64_t writes = network->sent.writes;
+		const uint64_t frames = network->sent.frames;
+		const uint64_t bytes = network->sent.bytes;
+
+		char line[256];
+		const size_t line_len = sprintf(line, "Network thread #%u (%s): %u clients, %lu writes, %lu frames (%.1f per write), %lu bytes (%.0f per write)",
+			i,
+			network->uring.enabled ? "io_uring" : SCK_POLLER_NAME,
+			(uint32_t) network->clients,
+			writes,
+			frames,
+			writes == 0 ? 0 : (float64_t) frames / writes,
+			bytes,
+			writes == 0 ? 0 : (float64_t) bytes / writes
+		);
+
+		cht_component_t msg = cht_new;
+		msg.text = UTL_ARRTOSTR(line, line_len);
+
+		cmd_message(sender, &msg);
+
+	}
+
+	const uint64_t frames = listener->compression.frames;
+	const uint64_t bytes = listener->compression.bytes;
+	const uint64_t compressed = listener->compression.compressed;
+
+	char line[256];
+	const size_t line_len = sprintf(line, "Compression (%u threads): %lu frames (%.1f%% of their size), %lu sent uncompressed",
+		listener->compression.count,
+		frames,
+		bytes == 0 ? 0 : (float64_t) compressed * 100 / bytes,
+		(uint64_t) listener->compression.raw
+	);
+
+	cht_component_t msg = cht_new;
+	msg.text = UTL_ARRTOSTR(line, line_len);
+
+	cmd_message(sender, &msg);
+
+	const pck_pool_stats_t pool = pck_get_pool_stats();
+
+	char pool_line[256];
+	const size_t pool_line_len = sprintf(pool_line, "Packet pool: %lu acquired, %lu allocated (%.1f%% reused), %lu freed, %lu too big to pool",
+		pool.acquired,
+		pool.allocated,
+		pool.acquired == 0 ? 0 : (float64_t) (pool.acquired - pool.allocated - pool.oversized) * 100 / pool.acquired,
+		pool.freed,
+		pool.oversized
+	);
+
+	cht_component_t pool_msg = cht_new;
+	pool_msg.text = UTL_ARRTOSTR(pool_line, pool_line_len);
+
+	cmd_message(sender, &pool_msg);
+
+	char backpressure_line[256];
+	const size_t backpressure_line_len = sprintf(backpressure_line, "Backpressure: clients lagged %lu times, %lu movement updates and %lu chunks held back, %lu disconnected for falling behind",
+		(uint64_t) listener->backpressure.lagged,
+		(uint64_t) listener->backpressure.shed,
+		(uint64_t) listener->backpressure.deferred,
+		(uint64_t) listener->backpressure.disconnected
+	);
+
+	cht_component_t backpressure_msg = cht_new;
+	backpressure_msg.text = UTL_ARRTOSTR(backpressure_line, backpressure_line_len);
+
+	cmd_message(sender, &backpressure_msg);
+
+	char admission_line[256];
+	const size_t admission_line_len = sprintf(admission_line, "Connections (%u acceptor threads): %lu admitted, %lu over the rate, %lu over the rate of their address",
+		listener->acceptors.count,
+		(uint64_t) listener->admission.admitted,
+		(uint64_t) listener->admission.throttled,
+		(uint64_t) listener->admission.throttled_address
+	);
+
+	cht_component_t admission_msg = cht_new;
+	admission_msg.text = UTL_ARRTOSTR(admission_line, admission_line_len);
+
+	cmd_message(sender, &admission_msg);
+
+	char status_line[256];
+	const size_t status_line_len = sprintf(status_line, "Server list: %lu responses (%lu built), %lu pings, %lu closed over the rate of their address",
+		(uint64_t) listener->status.served,
+		(uint64_t) listener->status.built,
+		(uint64_t) listener->status.pings,
+		(uint64_t) listener->status.throttled
+	);
+
+	cht_component_t status_msg = cht_new;
+	status_msg.text = UTL_ARRTOSTR(status_line, status_line_len);
+
+	cmd_message(sender, &status_msg);
+
+	return true;
+
+}
+
+bool cmd_capture(char* args, const cmd_sender_t* sender) {
+
+	ltg_listener_t* listener = sky_get_listener();
+
+	if (args != NULL) {
+
+		const uint32_t hash = cmd_hash(args);
+		bool found = false;
+
+		// online clients are only freed after they are taken off the list, which can't happen while it's locked
+		with_lock (&listener->online.lock) {
+			const uint32_t online_length = utl_id_vector_length(&listener->online.vector);
+			for (uint32_t i = 0; i < online_length; ++i) {
+				ltg_client_t* client = UTL_ID_VECTOR_GET_AS(ltg_client_t*, &listener->online.vector, i);
+				if (client == NULL) {
+					continue;
+				}
+				switch (hash) {
+					case 0xb885dde: { // "all"
+						client->capture.requested = true;
+					} break;
+					case 0x7c9e1b4b: { // "stop"
+						client->capture.requested = false;
+					} break;
+					default: {
+						// one player, started or stopped
+						if (hash == cmd_hash(client->username.value)) {
+							client->capture.requested = !client->capture.requested;
+							found = true;
+						}
+					} break;
+				}
+			}
+		}
+
+		switch (hash) {
+			case 0xb885dde: { // "all"
+				listener->capture.all = true;
+			} break;
+			case 0x7c9e1b4b: { // "stop"
+				listener->capture.all = false;
+			} break;
+			default: {
+				if (!found) {
+					return false;
+				}
+			} break;
+		}
+
+	}
+
+	char line[256];
+	const size_t line_len = sprintf(line, "Captures%s: %u files, %lu frames, %lu bytes written to " LTG_CAPTURE_DIRECTORY "/",
+		listener->capture.all ? " (every player)" : "",
+		(uint32_t) listener->capture.files,
+		(uint64_t) listener->capture.frames,
+		(uint64_t) listener->capture.bytes
+	);
+
+	cht_component_t msg = cht_new;
+	msg.text = UTL_ARRTOSTR(line, line_len);
+
+	cmd_message(sender, &msg);
+
 	return true;
 
 }
\ No newline at end of file
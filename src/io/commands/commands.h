@@ -125,6 +125,8 @@ extern bool cmd_stop(char*, const cmd_sender_t*);
 extern bool cmd_help(char*, const cmd_sender_t*);
 extern bool cmd_plugins(char*, const cmd_sender_t*);
 extern bool cmd_jb(char*, const cmd_sender_t*);
+extern bool cmd_net(char*, const cmd_sender_t*);
+extern bool cmd_capture(char*, const cmd_sender_t*);
 
 static const cmd_command_t cmd_stop_h = {
 	.label = UTL_CSTRTOSTR("stop"),
@@ -151,10 +153,26 @@ static const cmd_command_t cmd_plugins_h = {
 
 static const cmd_command_t cmd_jb_h = {
 	.label = UTL_CSTRTOSTR("jb"),
+	.usage = UTL_CSTRTOSTR("Usage: /jb [reset|dump]"),
 	.description = UTL_CSTRTOSTR("Get current status of the server's job board"),
 	.handler = cmd_jb
 };
 
+static const cmd_command_t cmd_net_h = {
+	.label = UTL_CSTRTOSTR("net"),
+	.usage = UTL_CSTRTOSTR("Usage: /net [clients]"),
+	.description = UTL_CSTRTOSTR("Get how much the network threads write, how well it's batched and compressed, and who is lagging"),
+	.handler = cmd_net
+};
+
+static const cmd_command_t cmd_capture_h = {
+	.label = UTL_CSTRTOSTR("capture"),
+	.usage = UTL_CSTRTOSTR("Usage: /capture [all|stop|<player>]"),
+	.description = UTL_CSTRTOSTR("Write what players send to files in captures/ to replay with bench-replay"),
+	.permission = UTL_CSTRTOSTR("server.capture"),
+	.handler = cmd_capture
+};
+
 /* CONSTANT MESSAGES */
 static const cht_component_t cmd_no_permission = {
 	.text = UTL_CSTRTOSTR("You don't have permission to use this command!"),
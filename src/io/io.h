@@ -124,6 +124,12 @@ static inline int32_t io_read_var_int(const byte_t* buffer, size_t max_length, s
 
 	if (__ENDIANNESS__ == io_little_endian) {
 
+		// most varints are ids and counts under 128
+		if (max_length != 0 && buffer[0] < 0x80) {
+			*length = 1;
+			return buffer[0];
+		}
+
 		for (*length = 0; *length < max_length && (read & 0x80); ++*length) {
 			read = io_read_int8(buffer + *length);
 			result |= ((read & 0x7F) << (7 * *length));
@@ -253,16 +259,8 @@ static inline void io_write_float64(byte_t* buffer, float64_t value, io_endianne
 
 static inline size_t io_var_int_length(uint32_t value) {
 
-	size_t len = 0;
-
-	do {
-
-		len++;
-		value >>= 7;
-
-	} while (value != 0);
-
-	return len;
+	// one byte for every 7 bits up to the highest set one
+	return (31 - __builtin_clz(value | 1)) / 7 + 1;
 
 }
 
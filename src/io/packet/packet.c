@@ -1,8 +1,11 @@
 #include <string.h>
 #include <stdlib.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include "packet.h"
 #include "../logger/logger.h"
 #include "../../util/util.h"
+#include "../../util/lock_util.h"
 
 pck_packet_t* pck_create(size_t length, io_endianness_t endianness) {
 
@@ -38,6 +41,196 @@ void pck_init_from_bytes(pck_packet_t* packet, byte_t* bytes, size_t length, io_
 
 }
 
+// free packets are linked through their cursor, it's set again when they're acquired
+static inline pck_packet_t* pck_next_free(const pck_packet_t* packet) {
+
+	return (pck_packet_t*) (uintptr_t) packet->cursor;
+
+}
+
+static inline void pck_link_free(pck_packet_t* packet, pck_packet_t* next) {
+
+	packet->cursor = (uintptr_t) next;
+
+}
+
+// packets each thread keeps for itself, so most acquires and releases don't touch shared memory
+static _Thread_local struct {
+	pck_packet_t* free[PCK_POOL_CLASSES];
+	uint32_t count[PCK_POOL_CLASSES];
+} pck_cache;
+
+// packets given back by threads with full caches, or that exited
+static struct {
+	pthread_mutex_t lock;
+	pck_packet_t* free[PCK_POOL_CLASSES];
+	uint32_t count[PCK_POOL_CLASSES];
+	pthread_key_t cache; // gives a thread's cached packets back when the thread exits
+	_Atomic uint64_t acquired;
+	_Atomic uint64_t allocated;
+	_Atomic uint64_t freed;
+	_Atomic uint64_t oversized;
+} pck_pool = {
+	.lock = PTHREAD_MUTEX_INITIALIZER
+};
+
+static pthread_once_t pck_cache_once = PTHREAD_ONCE_INIT;
+
+static inline size_t pck_class_size(uint8_t size_class) {
+
+	return (size_t) 1 << (PCK_POOL_MIN_SHIFT + size_class);
+
+}
+
+// how many packets of a size class a thread keeps, fewer the bigger they are
+static inline uint32_t pck_cache_limit(uint8_t size_class) {
+
+	const size_t limit = PCK_POOL_CACHE_BYTES / pck_class_size(size_class);
+
+	return limit > PCK_POOL_CACHE_MAX ? PCK_POOL_CACHE_MAX : limit == 0 ? 1 : limit;
+
+}
+
+// give count cached packets of a size class to the shared pool, freeing what it has no room for
+static void pck_give_back(uint8_t size_class, uint32_t count) {
+
+	const uint32_t shared_limit = PCK_POOL_SHARED_BYTES / pck_class_size(size_class);
+
+	with_lock (&pck_pool.lock) {
+		while (count-- != 0) {
+			pck_packet_t* packet = pck_cache.free[size_class];
+			pck_cache.free[size_class] = pck_next_free(packet);
+			pck_cache.count[size_class]--;
+			if (pck_pool.count[size_class] < shared_limit) {
+				pck_link_free(packet, pck_pool.free[size_class]);
+				pck_pool.free[size_class] = packet;
+				pck_pool.count[size_class]++;
+			} else {
+				free(packet);
+				atomic_fetch_add_explicit(&pck_pool.freed, 1, memory_order_relaxed);
+			}
+		}
+	}
+
+}
+
+static void pck_flush_cache(void* cache) {
+
+	(void) cache;
+
+	for (uint8_t i = 0; i < PCK_POOL_CLASSES; ++i) {
+		pck_give_back(i, pck_cache.count[i]);
+	}
+
+}
+
+static void pck_init_cache() {
+
+	pthread_key_create(&pck_pool.cache, pck_flush_cache);
+
+}
+
+// make sure what the thread is about to cache is given back when it exits
+static inline void pck_use_cache() {
+
+	pthread_once(&pck_cache_once, pck_init_cache);
+	pthread_setspecific(pck_pool.cache, &pck_cache);
+
+}
+
+pck_packet_t* pck_acquire(size_t length, io_endianness_t endianness) {
+
+	atomic_fetch_add_explicit(&pck_pool.acquired, 1, memory_order_relaxed);
+
+	uint8_t size_class = 0;
+	while (size_class < PCK_POOL_CLASSES && pck_class_size(size_class) < length) {
+		size_class++;
+	}
+
+	pck_packet_t* packet = NULL;
+
+	if (size_class == PCK_POOL_CLASSES) {
+
+		atomic_fetch_add_explicit(&pck_pool.oversized, 1, memory_order_relaxed);
+		packet = malloc(sizeof(pck_packet_t) + length);
+
+	} else {
+
+		// take half a cache worth from the shared pool
+		if (pck_cache.count[size_class] == 0) {
+
+			pck_use_cache();
+
+			with_lock (&pck_pool.lock) {
+				const uint32_t limit = (pck_cache_limit(size_class) + 1) / 2;
+				while (pck_pool.count[size_class] != 0 && pck_cache.count[size_class] != limit) {
+					pck_packet_t* shared = pck_pool.free[size_class];
+					pck_pool.free[size_class] = pck_next_free(shared);
+					pck_pool.count[size_class]--;
+					pck_link_free(shared, pck_cache.free[size_class]);
+					pck_cache.free[size_class] = shared;
+					pck_cache.count[size_class]++;
+				}
+			}
+
+		}
+
+		if (pck_cache.count[size_class] != 0) {
+			packet = pck_cache.free[size_class];
+			pck_cache.free[size_class] = pck_next_free(packet);
+			pck_cache.count[size_class]--;
+		} else {
+			atomic_fetch_add_explicit(&pck_pool.allocated, 1, memory_order_relaxed);
+			packet = malloc(sizeof(pck_packet_t) + pck_class_size(size_class));
+		}
+
+	}
+
+	packet->pool = size_class;
+	packet->endianness = endianness;
+	packet->length = length;
+	packet->cursor = 0;
+
+	return packet;
+
+}
+
+void pck_release(pck_packet_t* packet) {
+
+	const uint8_t size_class = packet->pool;
+
+	if (size_class == PCK_POOL_CLASSES) {
+		free(packet);
+		return;
+	}
+
+	if (pck_cache.count[size_class] == 0) {
+		pck_use_cache();
+	}
+
+	pck_link_free(packet, pck_cache.free[size_class]);
+	pck_cache.free[size_class] = packet;
+	pck_cache.count[size_class]++;
+
+	// give half of the cache back
+	const uint32_t limit = pck_cache_limit(size_class);
+	if (pck_cache.count[size_class] > limit) {
+		pck_give_back(size_class, pck_cache.count[size_class] - (limit + 1) / 2);
+	}
+
+}
+
+pck_pool_stats_t pck_get_pool_stats() {
+
+	return (pck_pool_stats_t) {
+		.acquired = pck_pool.acquired,
+		.allocated = pck_pool.allocated,
+		.freed = pck_pool.freed,
+		.oversized = pck_pool.oversized
+	};
+
+}
+
 // i know, terribly written function, it's debug, not production don't worry
 #if NDEBUG
 #else
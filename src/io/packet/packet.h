@@ -1,6 +1,7 @@
 #pragma once
 #include "../../main.h"
 #include "../io.h"
+#include "../varint/varint.h"
 #include "../nbt/mnbt.h"
 #include <assert.h>
 
@@ -12,6 +13,8 @@ typedef struct {
 	int32_t sub_length;
 	
 	io_endianness_t endianness : 1;
+
+	uint8_t pool; // size class of a packet from the pool
 	
 	byte_t length_prefix[6]; // the length of the packet
 	byte_t bytes[];
@@ -27,6 +30,12 @@ typedef struct {
 
 } pck_position_t;
 
+#define PCK_POOL_MIN_SHIFT 8 // the smallest size class holds 256 bytes
+#define PCK_POOL_CLASSES 14 // size classes, each twice as big as the one before, up to 2 MiB
+#define PCK_POOL_CACHE_BYTES 1048576 // bytes of each size class a thread keeps for itself
+#define PCK_POOL_CACHE_MAX 32 // most packets of a size class a thread keeps for itself
+#define PCK_POOL_SHARED_BYTES 8388608 // bytes of each size class kept for all threads, the rest are freed
+
 #define PCK_INLINE(name, len, end) byte_t name ##_r[sizeof(pck_packet_t) + len]; pck_packet_t* name = (pck_packet_t*) name ##_r; name->cursor = 0; name->length = len; name->endianness = end;
 
 #define PCK_READ_STRING(name, packet) int32_t name ##_length = pck_read_var_int(packet); char name [name ##_length + 1]; pck_read_bytes(packet, (uint8_t*) name, name ##_length); if (name ##_length + 1 != 0) { name [name ##_length] = '\0'; }
@@ -37,6 +46,23 @@ extern pck_packet_t* pck_from_bytes(byte_t*, size_t, io_endianness_t);
 
 extern void pck_init_from_bytes(pck_packet_t*, byte_t*, size_t, io_endianness_t);
 
+// what the packet pool handed out
+typedef struct {
+
+	uint64_t acquired;
+	uint64_t allocated; // newly allocated, the rest were reused
+	uint64_t freed;
+	uint64_t oversized; // too big for a size class, allocated and freed each time
+
+} pck_pool_stats_t;
+
+// get a packet with room for at least length bytes, reused from the pool when one of its size class was released before
+// big packets go here instead of the stack, give them back with pck_release
+extern pck_packet_t* pck_acquire(size_t length, io_endianness_t endianness);
+extern void pck_release(pck_packet_t* packet);
+
+extern pck_pool_stats_t pck_get_pool_stats();
+
 static inline int8_t pck_read_int8(pck_packet_t* packet) {
 
 	assert(packet->length - packet->cursor >= 1);
@@ -108,6 +134,12 @@ static inline int32_t pck_read_var_int(pck_packet_t* packet) {
 
 }
 
+static inline void pck_read_var_ints(pck_packet_t* packet, int32_t* values, size_t count) {
+
+	packet->cursor += io_read_var_ints(packet->bytes + packet->cursor, packet->length - packet->cursor, values, count);
+
+}
+
 static inline int64_t pck_read_var_long(pck_packet_t* packet) {
 
 	size_t size = 0;
@@ -211,6 +243,12 @@ static inline void pck_write_var_int(pck_packet_t* packet, int32_t value) {
 
 }
 
+static inline void pck_write_var_ints(pck_packet_t* packet, const int32_t* values, size_t count) {
+
+	packet->cursor += io_write_var_ints(packet->bytes + packet->cursor, values, count, packet->length - packet->cursor);
+
+}
+
 // waste between 0-4 bytes but you can always come back to it later and change it
 static inline void pck_write_long_var_int(pck_packet_t* packet, int32_t value) {
 
@@ -0,0 +1,495 @@
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "varint.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define IO_VARINT_SIMD
+#include <immintrin.h>
+#endif
+
+static size_t io_write_var_ints_scalar(byte_t* buffer, const int32_t* values, size_t count, size_t max_length) {
+
+	size_t offset = 0;
+
+	for (size_t i = 0; i < count; ++i) {
+		const size_t length = io_write_var_int(buffer + offset, values[i], max_length - offset);
+		if (length == 0) return 0;
+		offset += length;
+	}
+
+	return offset;
+
+}
+
+static size_t io_read_var_ints_scalar(const byte_t* buffer, size_t max_length, int32_t* values, size_t count) {
+
+	size_t offset = 0;
+
+	for (size_t i = 0; i < count; ++i) {
+		size_t length = 0;
+		values[i] = io_read_var_int(buffer + offset, max_length - offset, &length);
+		offset += length;
+	}
+
+	return offset;
+
+}
+
+static size_t io_var_ints_length_scalar(const int32_t* values, size_t count) {
+
+	size_t length = 0;
+
+	for (size_t i = 0; i < count; ++i) {
+		length += io_var_int_length(values[i]);
+	}
+
+	return length;
+
+}
+
+#ifdef IO_VARINT_SIMD
+
+#define IO_SSE41 __attribute__((target("sse4.1")))
+#define IO_AVX2 __attribute__((target("avx2")))
+
+/*
+	The kernels work out the bytes of several values at once and then write each value as one 8 byte word,
+	moving on by the value's length, so every value needs 8 bytes of room even if it only takes 1
+*/
+static inline void io_varint_put(byte_t** out, uint64_t word, uint32_t length) {
+
+	memcpy(*out, &word, sizeof(word));
+	*out += length;
+
+}
+
+// the value of the varint that is length bytes long at bytes, which needs 8 readable bytes
+static inline uint32_t io_varint_take(const byte_t* bytes, uint32_t length) {
+
+	uint64_t word;
+	memcpy(&word, bytes, sizeof(word));
+	word &= ((uint64_t) 1 << (length << 3)) - 1;
+
+	return (uint32_t) ((word & 0x7F) | ((word >> 1) & 0x3F80) | ((word >> 2) & 0x1FC000) | ((word >> 3) & 0xFE00000) | ((word >> 4) & 0xF0000000));
+
+}
+
+/*
+	Read the varints that start before limit in a window, ends has a bit set for every byte without a continuation bit
+	Varints never run past 5 bytes, so with 4 bytes after limit every one of them ends inside the window
+	Returns how many bytes were read
+*/
+static inline uint32_t io_varint_read_window(const byte_t* window, uint32_t ends, uint32_t limit, int32_t* values, size_t* n, size_t count) {
+
+	uint32_t position = 0;
+	size_t i = *n;
+
+	while (position < limit && i < count) {
+		const uint32_t length = __builtin_ctz((ends >> position) | 0x10) + 1;
+		values[i++] = io_varint_take(window + position, length);
+		position += length;
+	}
+
+	*n = i;
+
+	return position;
+
+}
+
+/*
+	For every way the first 8 bytes of a window can end varints, how to shuffle the varints of up to 3 bytes at the start of them
+	into 32 bit lanes, how many of them there are and how many bytes they take
+	Ids, tags and palettes are all varints of up to 3 bytes
+*/
+static struct {
+
+	byte_t shuffle[32];
+	uint8_t count;
+	uint8_t length;
+
+} io_varint_steps[256];
+
+static pthread_once_t io_varint_steps_once = PTHREAD_ONCE_INIT;
+
+static void io_varint_init_steps() {
+
+	for (uint32_t ends = 0; ends < 256; ++ends) {
+
+		// 0x80 zeroes a byte in a shuffle
+		memset(io_varint_steps[ends].shuffle, 0x80, sizeof(io_varint_steps[ends].shuffle));
+
+		uint32_t position = 0;
+		uint32_t count = 0;
+
+		while (position < 8) {
+			const uint32_t length = __builtin_ctz((ends >> position) | 0x100) + 1;
+			if (length > 3 || position + length > 8) break;
+			for (uint32_t i = 0; i < length; ++i) {
+				io_varint_steps[ends].shuffle[(count << 2) + i] = position + i;
+			}
+			position += length;
+			count++;
+		}
+
+		io_varint_steps[ends].count = count;
+		io_varint_steps[ends].length = position;
+
+	}
+
+}
+
+// the values of 4 varints of up to 3 bytes, shuffled into 32 bit lanes
+IO_SSE41 static inline __m128i io_varint_join(__m128i bytes, const byte_t* shuffle) {
+
+	const __m128i lanes = _mm_shuffle_epi8(bytes, _mm_loadu_si128((const __m128i*) shuffle));
+
+	return _mm_or_si128(
+		_mm_and_si128(lanes, _mm_set1_epi32(0x7F)),
+		_mm_or_si128(_mm_and_si128(_mm_srli_epi32(lanes, 1), _mm_set1_epi32(0x3F80)), _mm_and_si128(_mm_srli_epi32(lanes, 2), _mm_set1_epi32(0x1FC000)))
+	);
+
+}
+
+/*
+	Read up to 8 varints of up to 3 bytes from the start of a window at once, which needs room for 8 values
+	Returns how many bytes were read, 0 if the first varint is longer
+*/
+IO_SSE41 static inline uint32_t io_varint_read_step(__m128i bytes, uint32_t ends, int32_t* values, size_t* n) {
+
+	const uint32_t step = ends & 0xFF;
+	if (io_varint_steps[step].count == 0) return 0;
+
+	_mm_storeu_si128((__m128i*) (values + *n), io_varint_join(bytes, io_varint_steps[step].shuffle));
+	if (io_varint_steps[step].count > 4) {
+		_mm_storeu_si128((__m128i*) (values + *n + 4), io_varint_join(bytes, io_varint_steps[step].shuffle + 16));
+	}
+
+	*n += io_varint_steps[step].count;
+
+	return io_varint_steps[step].length;
+
+}
+
+// -1 in the lanes where value >= minimum, without a sign
+IO_SSE41 static inline __m128i io_varint_at_least_sse41(__m128i value, uint32_t minimum) {
+
+	return _mm_cmpeq_epi32(_mm_max_epu32(value, _mm_set1_epi32(minimum)), value);
+
+}
+
+IO_AVX2 static inline __m256i io_varint_at_least_avx2(__m256i value, uint32_t minimum) {
+
+	return _mm256_cmpeq_epi32(_mm256_max_epu32(value, _mm256_set1_epi32(minimum)), value);
+
+}
+
+IO_SSE41 static size_t io_write_var_ints_sse41(byte_t* buffer, const int32_t* values, size_t count, size_t max_length) {
+
+	byte_t* out = buffer;
+	size_t i = 0;
+
+	// the last of 4 values starts at most 15 bytes in and writes 8
+	for (; i + 4 <= count && (size_t) (out - buffer) + 23 <= max_length; i += 4) {
+
+		const __m128i value = _mm_loadu_si128((const __m128i*) (values + i));
+
+		const __m128i at_least_2 = io_varint_at_least_sse41(value, 1 << 7);
+		const __m128i at_least_3 = io_varint_at_least_sse41(value, 1 << 14);
+		const __m128i at_least_4 = io_varint_at_least_sse41(value, 1 << 21);
+		const __m128i at_least_5 = io_varint_at_least_sse41(value, 1 << 28);
+
+		// the first 4 groups of 7 bits, a byte each
+		__m128i low = _mm_and_si128(value, _mm_set1_epi32(0x7F));
+		low = _mm_or_si128(low, _mm_and_si128(_mm_slli_epi32(value, 1), _mm_set1_epi32(0x7F00)));
+		low = _mm_or_si128(low, _mm_and_si128(_mm_slli_epi32(value, 2), _mm_set1_epi32(0x7F0000)));
+		low = _mm_or_si128(low, _mm_and_si128(_mm_slli_epi32(value, 3), _mm_set1_epi32(0x7F000000)));
+
+		// a continuation bit on every byte with another after it
+		low = _mm_or_si128(low, _mm_and_si128(at_least_2, _mm_set1_epi32(0x80)));
+		low = _mm_or_si128(low, _mm_and_si128(at_least_3, _mm_set1_epi32(0x8000)));
+		low = _mm_or_si128(low, _mm_and_si128(at_least_4, _mm_set1_epi32(0x800000)));
+		low = _mm_or_si128(low, _mm_and_si128(at_least_5, _mm_set1_epi32(0x80000000)));
+
+		const __m128i high = _mm_srli_epi32(value, 28);
+		const __m128i length = _mm_sub_epi32(_mm_set1_epi32(1), _mm_add_epi32(_mm_add_epi32(at_least_2, at_least_3), _mm_add_epi32(at_least_4, at_least_5)));
+
+		uint64_t words[4];
+		uint32_t lengths[4];
+		_mm_storeu_si128((__m128i*) words, _mm_unpacklo_epi32(low, high));
+		_mm_storeu_si128((__m128i*) (words + 2), _mm_unpackhi_epi32(low, high));
+		_mm_storeu_si128((__m128i*) lengths, length);
+
+		for (uint32_t j = 0; j < 4; ++j) {
+			io_varint_put(&out, words[j], lengths[j]);
+		}
+
+	}
+
+	const size_t written = out - buffer;
+	if (i == count) return written;
+
+	const size_t rest = io_write_var_ints_scalar(out, values + i, count - i, max_length - written);
+	if (rest == 0) return 0;
+
+	return written + rest;
+
+}
+
+IO_SSE41 static size_t io_read_var_ints_sse41(const byte_t* buffer, size_t max_length, int32_t* values, size_t count) {
+
+	size_t offset = 0;
+	size_t n = 0;
+
+	while (n < count && max_length - offset >= 24) {
+
+		const __m128i bytes = _mm_loadu_si128((const __m128i*) (buffer + offset));
+		const uint32_t ends = ~_mm_movemask_epi8(bytes) & 0xFFFF;
+
+		// 16 values under 128 in a row, like most ids and counts, only need widening
+		if (ends == 0xFFFF && count - n >= 16) {
+			_mm_storeu_si128((__m128i*) (values + n), _mm_cvtepu8_epi32(bytes));
+			_mm_storeu_si128((__m128i*) (values + n + 4), _mm_cvtepu8_epi32(_mm_srli_si128(bytes, 4)));
+			_mm_storeu_si128((__m128i*) (values + n + 8), _mm_cvtepu8_epi32(_mm_srli_si128(bytes, 8)));
+			_mm_storeu_si128((__m128i*) (values + n + 12), _mm_cvtepu8_epi32(_mm_srli_si128(bytes, 12)));
+			n += 16;
+			offset += 16;
+			continue;
+		}
+
+		if (count - n >= 8) {
+			const uint32_t length = io_varint_read_step(bytes, ends, values, &n);
+			if (length != 0) {
+				offset += length;
+				continue;
+			}
+		}
+
+		offset += io_varint_read_window(buffer + offset, ends, 12, values, &n, count);
+
+	}
+
+	return offset + io_read_var_ints_scalar(buffer + offset, max_length - offset, values + n, count - n);
+
+}
+
+IO_SSE41 static size_t io_var_ints_length_sse41(const int32_t* values, size_t count) {
+
+	// counts down by one for every byte past the first
+	__m128i extra = _mm_setzero_si128();
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4) {
+		const __m128i value = _mm_loadu_si128((const __m128i*) (values + i));
+		extra = _mm_add_epi32(extra, _mm_add_epi32(
+			_mm_add_epi32(io_varint_at_least_sse41(value, 1 << 7), io_varint_at_least_sse41(value, 1 << 14)),
+			_mm_add_epi32(io_varint_at_least_sse41(value, 1 << 21), io_varint_at_least_sse41(value, 1 << 28))
+		));
+	}
+
+	int32_t lanes[4];
+	_mm_storeu_si128((__m128i*) lanes, extra);
+
+	return i - ((int64_t) lanes[0] + lanes[1] + lanes[2] + lanes[3]) + io_var_ints_length_scalar(values + i, count - i);
+
+}
+
+IO_AVX2 static size_t io_write_var_ints_avx2(byte_t* buffer, const int32_t* values, size_t count, size_t max_length) {
+
+	byte_t* out = buffer;
+	size_t i = 0;
+
+	// the last of 8 values starts at most 35 bytes in and writes 8
+	for (; i + 8 <= count && (size_t) (out - buffer) + 43 <= max_length; i += 8) {
+
+		const __m256i value = _mm256_loadu_si256((const __m256i*) (values + i));
+
+		const __m256i at_least_2 = io_varint_at_least_avx2(value, 1 << 7);
+		const __m256i at_least_3 = io_varint_at_least_avx2(value, 1 << 14);
+		const __m256i at_least_4 = io_varint_at_least_avx2(value, 1 << 21);
+		const __m256i at_least_5 = io_varint_at_least_avx2(value, 1 << 28);
+
+		__m256i low = _mm256_and_si256(value, _mm256_set1_epi32(0x7F));
+		low = _mm256_or_si256(low, _mm256_and_si256(_mm256_slli_epi32(value, 1), _mm256_set1_epi32(0x7F00)));
+		low = _mm256_or_si256(low, _mm256_and_si256(_mm256_slli_epi32(value, 2), _mm256_set1_epi32(0x7F0000)));
+		low = _mm256_or_si256(low, _mm256_and_si256(_mm256_slli_epi32(value, 3), _mm256_set1_epi32(0x7F000000)));
+
+		low = _mm256_or_si256(low, _mm256_and_si256(at_least_2, _mm256_set1_epi32(0x80)));
+		low = _mm256_or_si256(low, _mm256_and_si256(at_least_3, _mm256_set1_epi32(0x8000)));
+		low = _mm256_or_si256(low, _mm256_and_si256(at_least_4, _mm256_set1_epi32(0x800000)));
+		low = _mm256_or_si256(low, _mm256_and_si256(at_least_5, _mm256_set1_epi32(0x80000000)));
+
+		const __m256i high = _mm256_srli_epi32(value, 28);
+		const __m256i length = _mm256_sub_epi32(_mm256_set1_epi32(1), _mm256_add_epi32(_mm256_add_epi32(at_least_2, at_least_3), _mm256_add_epi32(at_least_4, at_least_5)));
+
+		// unpacking works inside each 128 bit half, so the words come out as 0 1 4 5 2 3 6 7
+		uint64_t words[8];
+		uint32_t lengths[8];
+		_mm256_storeu_si256((__m256i*) words, _mm256_unpacklo_epi32(low, high));
+		_mm256_storeu_si256((__m256i*) (words + 4), _mm256_unpackhi_epi32(low, high));
+		_mm256_storeu_si256((__m256i*) lengths, length);
+
+		io_varint_put(&out, words[0], lengths[0]);
+		io_varint_put(&out, words[1], lengths[1]);
+		io_varint_put(&out, words[4], lengths[2]);
+		io_varint_put(&out, words[5], lengths[3]);
+		io_varint_put(&out, words[2], lengths[4]);
+		io_varint_put(&out, words[3], lengths[5]);
+		io_varint_put(&out, words[6], lengths[6]);
+		io_varint_put(&out, words[7], lengths[7]);
+
+	}
+
+	const size_t written = out - buffer;
+	if (i == count) return written;
+
+	const size_t rest = io_write_var_ints_sse41(out, values + i, count - i, max_length - written);
+	if (rest == 0) return 0;
+
+	return written + rest;
+
+}
+
+IO_AVX2 static size_t io_read_var_ints_avx2(const byte_t* buffer, size_t max_length, int32_t* values, size_t count) {
+
+	size_t offset = 0;
+	size_t n = 0;
+
+	while (n < count && max_length - offset >= 40) {
+
+		const __m256i bytes = _mm256_loadu_si256((const __m256i*) (buffer + offset));
+		const uint32_t ends = ~(uint32_t) _mm256_movemask_epi8(bytes);
+
+		if (ends == 0xFFFFFFFF && count - n >= 32) {
+			for (uint32_t j = 0; j < 4; ++j) {
+				_mm256_storeu_si256((__m256i*) (values + n + (j << 3)), _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*) (buffer + offset + (j << 3)))));
+			}
+			n += 32;
+			offset += 32;
+			continue;
+		}
+
+		if (count - n >= 8) {
+			const uint32_t length = io_varint_read_step(_mm256_castsi256_si128(bytes), ends, values, &n);
+			if (length != 0) {
+				offset += length;
+				continue;
+			}
+		}
+
+		offset += io_varint_read_window(buffer + offset, ends, 28, values, &n, count);
+
+	}
+
+	return offset + io_read_var_ints_sse41(buffer + offset, max_length - offset, values + n, count - n);
+
+}
+
+IO_AVX2 static size_t io_var_ints_length_avx2(const int32_t* values, size_t count) {
+
+	__m256i extra = _mm256_setzero_si256();
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		const __m256i value = _mm256_loadu_si256((const __m256i*) (values + i));
+		extra = _mm256_add_epi32(extra, _mm256_add_epi32(
+			_mm256_add_epi32(io_varint_at_least_avx2(value, 1 << 7), io_varint_at_least_avx2(value, 1 << 14)),
+			_mm256_add_epi32(io_varint_at_least_avx2(value, 1 << 21), io_varint_at_least_avx2(value, 1 << 28))
+		));
+	}
+
+	int32_t lanes[8];
+	_mm256_storeu_si256((__m256i*) lanes, extra);
+
+	int64_t sum = 0;
+	for (uint32_t j = 0; j < 8; ++j) {
+		sum += lanes[j];
+	}
+
+	return i - sum + io_var_ints_length_sse41(values + i, count - i);
+
+}
+
+#endif
+
+static const io_varint_codec_t io_varint_codecs[] = {
+	[io_varint_scalar] = {
+		.name = "scalar",
+		.write = io_write_var_ints_scalar,
+		.read = io_read_var_ints_scalar,
+		.length = io_var_ints_length_scalar
+	},
+#ifdef IO_VARINT_SIMD
+	[io_varint_sse41] = {
+		.name = "SSE4.1",
+		.write = io_write_var_ints_sse41,
+		.read = io_read_var_ints_sse41,
+		.length = io_var_ints_length_sse41
+	},
+	[io_varint_avx2] = {
+		.name = "AVX2",
+		.write = io_write_var_ints_avx2,
+		.read = io_read_var_ints_avx2,
+		.length = io_var_ints_length_avx2
+	}
+#endif
+};
+
+static const io_varint_codec_t* _Atomic io_varint_codec = NULL;
+
+io_varint_kernel_t io_get_varint_kernel() {
+
+#ifdef IO_VARINT_SIMD
+	if (__builtin_cpu_supports("avx2")) return io_varint_avx2;
+	if (__builtin_cpu_supports("sse4.1")) return io_varint_sse41;
+#endif
+
+	return io_varint_scalar;
+
+}
+
+const io_varint_codec_t* io_get_varint_codec(io_varint_kernel_t kernel) {
+
+	if (kernel > io_get_varint_kernel()) return NULL;
+
+#ifdef IO_VARINT_SIMD
+	if (kernel != io_varint_scalar) {
+		pthread_once(&io_varint_steps_once, io_varint_init_steps);
+	}
+#endif
+
+	return &io_varint_codecs[kernel];
+
+}
+
+// picked the first time it's needed, every thread picks the same one
+static inline const io_varint_codec_t* io_varint_get_codec() {
+
+	const io_varint_codec_t* codec = atomic_load_explicit(&io_varint_codec, memory_order_relaxed);
+
+	if (codec == NULL) {
+		codec = io_get_varint_codec(io_get_varint_kernel());
+		atomic_store_explicit(&io_varint_codec, codec, memory_order_relaxed);
+	}
+
+	return codec;
+
+}
+
+size_t io_write_var_ints(byte_t* buffer, const int32_t* values, size_t count, size_t max_length) {
+
+	return io_varint_get_codec()->write(buffer, values, count, max_length);
+
+}
+
+size_t io_read_var_ints(const byte_t* buffer, size_t max_length, int32_t* values, size_t count) {
+
+	return io_varint_get_codec()->read(buffer, max_length, values, count);
+
+}
+
+size_t io_var_ints_length(const int32_t* values, size_t count) {
+
+	return io_varint_get_codec()->length(values, count);
+
+}
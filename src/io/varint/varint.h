@@ -0,0 +1,43 @@
+#pragma once
+#include "../io.h"
+
+// which of the bulk varint kernels to run, each one gives the same bytes and values as io_write_var_int and io_read_var_int
+typedef enum {
+
+	io_varint_scalar,
+	io_varint_sse41,
+	io_varint_avx2
+
+} io_varint_kernel_t;
+
+typedef struct {
+
+	const char* name;
+
+	size_t (*write)(byte_t* buffer, const int32_t* values, size_t count, size_t max_length);
+	size_t (*read)(const byte_t* buffer, size_t max_length, int32_t* values, size_t count);
+	size_t (*length)(const int32_t* values, size_t count);
+
+} io_varint_codec_t;
+
+// the best kernel this CPU can run
+extern io_varint_kernel_t io_get_varint_kernel();
+
+// returns NULL if this CPU can't run the kernel
+extern const io_varint_codec_t* io_get_varint_codec(io_varint_kernel_t kernel);
+
+/*
+	Write count varints one after the other
+	The bytes after the ones written can be changed too, up to max_length
+	Returns how many bytes were written, or 0 if they didn't all fit in max_length
+*/
+extern size_t io_write_var_ints(byte_t* buffer, const int32_t* values, size_t count, size_t max_length);
+
+/*
+	Read count varints one after the other, every value past the end of the buffer is 0
+	Returns how many bytes were read
+*/
+extern size_t io_read_var_ints(const byte_t* buffer, size_t max_length, int32_t* values, size_t count);
+
+// how many bytes io_write_var_ints will write for these values
+extern size_t io_var_ints_length(const int32_t* values, size_t count);
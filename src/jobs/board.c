@@ -1,9 +1,9 @@
+#include <sched.h>
 #include "board.h"
 #include "handlers.h"
 #include "../motor.h"
 #include "../util/vector.h"
-
-// TODO keep track of job traffic (increases everytime jobs aren't completed, decreases everytime they are)
+#include "../io/logger/logger.h"
 
 // default handler vectors
 UTL_VECTOR_DEFAULT(job_keep_alive_handlers, job_handler_t, 
@@ -51,6 +51,9 @@ UTL_VECTOR_DEFAULT(job_living_entity_damage_handlers, job_handler_t,
 UTL_VECTOR_DEFAULT(job_tick_world_handlers, job_handler_t,
 	job_handle_tick_world
 );
+UTL_VECTOR_DEFAULT(job_client_caught_up_handlers, job_handler_t,
+	job_handle_client_caught_up
+);
 
 UTL_VECTOR_DEFAULT(job_handlers, utl_vector_t*,
 	&job_keep_alive_handlers,
@@ -68,36 +71,443 @@ UTL_VECTOR_DEFAULT(job_handlers, utl_vector_t*,
 	&job_living_entity_teleport_look_handlers,
 	&job_living_entity_damage_handlers,
 	&job_tick_world_handlers,
+	&job_client_caught_up_handlers,
 );
 
+// lane of each job type
+static const job_lane_t job_lanes[job_count] = {
+	[job_keep_alive] = job_lane_latency_critical,
+	[job_global_chat_message] = job_lane_latency_critical,
+	[job_player_join] = job_lane_background,
+	[job_player_leave] = job_lane_latency_critical,
+	[job_send_update_pings] = job_lane_latency_critical,
+	[job_tick_region] = job_lane_tick_critical,
+	[job_unload_region] = job_lane_background,
+	[job_dig_block] = job_lane_latency_critical,
+	[job_entity_move] = job_lane_tick_critical,
+	[job_entity_teleport] = job_lane_tick_critical,
+	[job_living_entity_look] = job_lane_tick_critical,
+	[job_living_entity_move_look] = job_lane_tick_critical,
+	[job_living_entity_teleport_look] = job_lane_tick_critical,
+	[job_living_entity_damage] = job_lane_tick_critical,
+	[job_tick_world] = job_lane_tick_critical,
+	[job_client_caught_up] = job_lane_background
+};
+
 job_board_t job_board = {
 	.queue = {
 		.lock = PTHREAD_MUTEX_INITIALIZER,
 		.wait = PTHREAD_COND_INITIALIZER,
-		.list = UTL_LIST_INITIALIZER(uint32_t)
+		.sleeping = 0,
+		.lanes = {
+			[job_lane_latency_critical] = { .list = UTL_LIST_INITIALIZER(uint64_t), .length = 0 },
+			[job_lane_tick_critical] = { .list = UTL_LIST_INITIALIZER(uint64_t), .length = 0 },
+			[job_lane_background] = { .list = UTL_LIST_INITIALIZER(uint64_t), .length = 0 }
+		}
+	},
+	.lanes = {
+		[job_lane_latency_critical] = { .weight = 8, .target_latency = 50, .served = 0 },
+		[job_lane_tick_critical] = { .weight = 4, .target_latency = 50, .served = 0 },
+		[job_lane_background] = { .weight = 1, .target_latency = 1000, .served = 0 }
+	},
+	.tick = {
+		.lock = PTHREAD_MUTEX_INITIALIZER,
+		.done = PTHREAD_COND_INITIALIZER,
+		.pending = 0
+	},
+	.idle = {
+		.spin_rounds = 10,
+		.yield_rounds = 4,
+		.spinning = 0,
+		.wakeups = 0,
+		.wakeups_avoided = 0,
+		.parks = 0
 	},
-	.heap = {
+	.work_stealing = true,
+	.affinity = true,
+	.telemetry = {
+		.enabled = true,
+		.since = 0
+	},
+	.pool = {
 		.lock = PTHREAD_MUTEX_INITIALIZER,
-		.jobs = UTL_ID_VECTOR_INITIALIZER(job_work_t)
+		.free = 0,
+		.slab_count = 0,
+		.count = 0
 	}
 };
 
-uint32_t job_new(job_type_t type, const job_payload_t payload) {
+// jobs that are sent back to the worker that ran them last
+static const bool job_affine[job_count] = {
+	[job_tick_region] = true
+};
+
+// jobs that make up a tick, the next tick doesn't start until they are done
+static const bool job_tick_phase[job_count] = {
+	[job_tick_region] = true,
+	[job_tick_world] = true
+};
+
+static const char* job_type_names[job_count] = {
+	[job_keep_alive] = "keep_alive",
+	[job_global_chat_message] = "global_chat_message",
+	[job_player_join] = "player_join",
+	[job_player_leave] = "player_leave",
+	[job_send_update_pings] = "send_update_pings",
+	[job_tick_region] = "tick_region",
+	[job_unload_region] = "unload_region",
+	[job_dig_block] = "dig_block",
+	[job_entity_move] = "entity_move",
+	[job_entity_teleport] = "entity_teleport",
+	[job_living_entity_look] = "living_entity_look",
+	[job_living_entity_move_look] = "living_entity_move_look",
+	[job_living_entity_teleport_look] = "living_entity_teleport_look",
+	[job_living_entity_damage] = "living_entity_damage",
+	[job_tick_world] = "tick_world",
+	[job_client_caught_up] = "client_caught_up"
+};
+
+static inline uint64_t job_nanos() {
+
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+
+	return (uint64_t) time.tv_sec * 1000000000 + time.tv_nsec;
+
+}
+
+// the worker running on this thread, NULL if this thread is not a worker
+static _Thread_local sky_worker_t* job_local = NULL;
+
+#define JOB_CONTINUATIONS_DONE ((job_continuation_t*) 1)
+#define JOB_STATE_CANCELED (1ull << 31)
+#define JOB_STATE_REFERENCES 0x7FFFFFFFull
+#define JOB_CACHE_SIZE 64
+
+// free slots owned by this thread, so most allocations and frees don't touch shared memory
+static _Thread_local struct {
+	uint32_t count;
+	uint32_t slots[JOB_CACHE_SIZE];
+} job_cache = {
+	.count = 0
+};
+
+static pthread_once_t job_cache_once = PTHREAD_ONCE_INIT;
+
+// get the slot of a handle, NULL if the handle could never have been valid
+static inline job_slot_t* job_get_handle_slot(uint64_t id) {
+
+	const uint32_t index = job_get_index(id);
+
+	if (job_get_generation(id) == 0 || index >= atomic_load_explicit(&job_board.pool.slab_count, memory_order_acquire) * JOB_SLAB_SIZE) {
+		return NULL;
+	}
+
+	return job_get_slot(index);
+
+}
+
+static inline uint32_t job_state_generation(uint64_t state) {
+
+	return state >> 32;
+
+}
+
+static inline void job_push_free(uint32_t first, uint32_t last) {
+
+	job_slot_t* slot = job_get_slot(last);
+	uint64_t head = atomic_load_explicit(&job_board.pool.free, memory_order_relaxed);
+	uint64_t next;
+
+	// the upper half of the head is a tag, bumped on every change so a stale head never compares equal
+	do {
+		atomic_store_explicit(&slot->next, (uint32_t) head, memory_order_relaxed);
+		next = (((head >> 32) + 1) << 32) | (first + 1);
+	} while (!atomic_compare_exchange_weak_explicit(&job_board.pool.free, &head, next, memory_order_release, memory_order_relaxed));
+
+}
+
+static inline bool job_pop_free(uint32_t* index) {
+
+	uint64_t head = atomic_load_explicit(&job_board.pool.free, memory_order_acquire);
+	uint64_t next;
+
+	do {
+		if ((uint32_t) head == 0) {
+			return false;
+		}
+		// slabs are never freed, so this read is safe even if another thread takes the slot first
+		next = (((head >> 32) + 1) << 32) | atomic_load_explicit(&job_get_slot((uint32_t) head - 1)->next, memory_order_relaxed);
+	} while (!atomic_compare_exchange_weak_explicit(&job_board.pool.free, &head, next, memory_order_acquire, memory_order_acquire));
+
+	*index = (uint32_t) head - 1;
+
+	return true;
+
+}
+
+static void job_flush_cache(void* cache) {
+
+	(void) cache;
+
+	while (job_cache.count != 0) {
+		const uint32_t index = job_cache.slots[--job_cache.count];
+		job_push_free(index, index);
+	}
+
+}
+
+static void job_init_cache() {
+
+	pthread_key_create(&job_board.pool.cache, job_flush_cache);
+
+}
+
+// the cache gets flushed when this thread exits
+static inline void job_use_cache() {
+
+	pthread_once(&job_cache_once, job_init_cache);
+	pthread_setspecific(job_board.pool.cache, &job_cache);
+
+}
+
+static bool job_grow() {
+
+	with_lock (&job_board.pool.lock) {
+
+		// another thread may have grown the pool while we were waiting
+		if ((uint32_t) atomic_load(&job_board.pool.free) != 0) {
+			pthread_mutex_unlock(&job_board.pool.lock);
+			return true;
+		}
+
+		const uint32_t slab_count = atomic_load_explicit(&job_board.pool.slab_count, memory_order_relaxed);
+
+		if (slab_count == JOB_MAX_SLABS) {
+			pthread_mutex_unlock(&job_board.pool.lock);
+			log_error("Job pool exhausted, more than %d jobs exist", JOB_SLAB_SIZE * JOB_MAX_SLABS);
+			return false;
+		}
+
+		job_slot_t* slab = calloc(JOB_SLAB_SIZE, sizeof(job_slot_t));
+		const uint32_t first = slab_count * JOB_SLAB_SIZE;
+
+		for (uint32_t i = 0; i < JOB_SLAB_SIZE; ++i) {
+			atomic_init(&slab[i].state, 1ull << 32);
+			atomic_init(&slab[i].next, first + i + 2);
+		}
+
+		atomic_store_explicit(&job_board.pool.slabs[slab_count], slab, memory_order_release);
+		atomic_store_explicit(&job_board.pool.slab_count, slab_count + 1, memory_order_release);
+
+		job_push_free(first, first + JOB_SLAB_SIZE - 1);
+
+	}
+
+	return true;
+
+}
+
+uint64_t job_new(job_type_t type, const job_payload_t payload) {
 
-	const job_work_t init = {
+	if (job_cache.count == 0) {
+
+		job_use_cache();
+
+		// take half a cache worth of slots from the shared list, growing the pool if it is empty
+		while (job_cache.count < JOB_CACHE_SIZE / 2) {
+			if (!job_pop_free(&job_cache.slots[job_cache.count])) {
+				if (job_cache.count != 0 || !job_grow()) {
+					break;
+				}
+			} else {
+				job_cache.count++;
+			}
+		}
+
+		if (job_cache.count == 0) {
+			return 0;
+		}
+
+	}
+
+	const uint32_t index = job_cache.slots[--job_cache.count];
+	job_slot_t* slot = job_get_slot(index);
+
+	slot->work = (job_work_t) {
 		.type = type,
 		.payload = payload
 	};
+	atomic_store_explicit(&slot->dependencies, 1, memory_order_relaxed);
+	atomic_store_explicit(&slot->continuations, NULL, memory_order_relaxed);
+
+	atomic_fetch_add_explicit(&job_board.pool.count, 1, memory_order_relaxed);
+
+	return ((uint64_t) job_state_generation(atomic_load_explicit(&slot->state, memory_order_relaxed)) << 32) | index;
+
+}
+
+static inline void job_release(uint32_t index) {
+
+	atomic_fetch_sub_explicit(&job_board.pool.count, 1, memory_order_relaxed);
+
+	if (job_cache.count == 0) {
+		job_use_cache();
+	} else if (job_cache.count == JOB_CACHE_SIZE) {
+		// give half of the cache back
+		while (job_cache.count != JOB_CACHE_SIZE / 2) {
+			const uint32_t cached = job_cache.slots[--job_cache.count];
+			job_push_free(cached, cached);
+		}
+	}
+
+	job_cache.slots[job_cache.count++] = index;
+
+}
+
+bool job_retain(uint64_t id) {
+
+	job_slot_t* slot = job_get_handle_slot(id);
+
+	if (slot == NULL) {
+		return false;
+	}
+
+	uint64_t state = atomic_load_explicit(&slot->state, memory_order_relaxed);
 
-	uint32_t id = 0;
+	do {
+		if (job_state_generation(state) != job_get_generation(id)) {
+			return false;
+		}
+	} while (!atomic_compare_exchange_weak_explicit(&slot->state, &state, state + 1, memory_order_acq_rel, memory_order_relaxed));
+
+	return true;
+
+}
+
+void job_cancel(uint64_t id) {
+
+	job_slot_t* slot = job_get_handle_slot(id);
+
+	if (slot == NULL) {
+		return;
+	}
+
+	uint64_t state = atomic_load_explicit(&slot->state, memory_order_relaxed);
+
+	do {
+		// the job was already freed, the slot might belong to another job now
+		if (job_state_generation(state) != job_get_generation(id)) {
+			return;
+		}
+	} while (!atomic_compare_exchange_weak_explicit(&slot->state, &state, state | JOB_STATE_CANCELED, memory_order_acq_rel, memory_order_relaxed));
+
+	if ((state & JOB_STATE_CANCELED) == 0) {
+		atomic_fetch_add_explicit(&job_board.telemetry.types[slot->work.type].canceled, 1, memory_order_relaxed);
+	}
+
+}
+
+bool job_is_canceled(uint64_t id) {
+
+	job_slot_t* slot = job_get_handle_slot(id);
+
+	if (slot == NULL) {
+		return true;
+	}
+
+	const uint64_t state = atomic_load_explicit(&slot->state, memory_order_acquire);
+
+	return job_state_generation(state) != job_get_generation(id) || (state & JOB_STATE_CANCELED) != 0;
+
+}
+
+job_work_t* job_get_work(uint64_t id) {
+
+	job_slot_t* slot = job_get_handle_slot(id);
+
+	if (slot == NULL || job_state_generation(atomic_load_explicit(&slot->state, memory_order_acquire)) != job_get_generation(id)) {
+		return NULL;
+	}
+
+	return &slot->work;
+
+}
 
-	with_lock (&job_board.heap.lock) {
+bool job_then(uint64_t before, uint64_t after) {
 
-		id = utl_id_vector_push(&job_board.heap.jobs, &init);
+	job_slot_t* before_slot = job_get_handle_slot(before);
+	job_slot_t* after_slot = job_get_handle_slot(after);
 
+	if (before_slot == NULL || after_slot == NULL || job_get_work(before) == NULL || job_get_work(after) == NULL) {
+		return false;
 	}
 
-	return id;
+	// one more to wait on, unless the job is already on the board
+	uint32_t dependencies = atomic_load_explicit(&after_slot->dependencies, memory_order_relaxed);
+
+	do {
+		if (dependencies == 0) {
+			return false;
+		}
+	} while (!atomic_compare_exchange_weak_explicit(&after_slot->dependencies, &dependencies, dependencies + 1, memory_order_relaxed, memory_order_relaxed));
+
+	job_continuation_t* continuation = malloc(sizeof(job_continuation_t));
+	continuation->job = after;
+
+	job_continuation_t* head = atomic_load_explicit(&before_slot->continuations, memory_order_acquire);
+
+	do {
+		if (head == JOB_CONTINUATIONS_DONE) {
+			// finished while we were getting here
+			free(continuation);
+			atomic_fetch_sub_explicit(&after_slot->dependencies, 1, memory_order_relaxed);
+			return false;
+		}
+		continuation->next = head;
+	} while (!atomic_compare_exchange_weak_explicit(&before_slot->continuations, &head, continuation, memory_order_release, memory_order_acquire));
+
+	return true;
+
+}
+
+// take away one of the jobs a job waits on, returns true if it can go on the board
+static inline bool job_ready(job_slot_t* slot) {
+
+	return atomic_load_explicit(&slot->dependencies, memory_order_acquire) == 0 || atomic_fetch_sub_explicit(&slot->dependencies, 1, memory_order_acq_rel) == 1;
+
+}
+
+static void job_push(uint64_t id, job_work_t* work);
+
+// release the jobs waiting on a finished job, only the first call for a job does anything
+static void job_continue(job_slot_t* slot, bool canceled) {
+
+	job_continuation_t* continuation = atomic_exchange_explicit(&slot->continuations, JOB_CONTINUATIONS_DONE, memory_order_acq_rel);
+
+	if (continuation == JOB_CONTINUATIONS_DONE) {
+		return;
+	}
+
+	while (continuation != NULL) {
+
+		job_continuation_t* next = continuation->next;
+		const uint64_t id = continuation->job;
+		job_slot_t* waiting = job_get_slot(job_get_index(id));
+
+		if (canceled) {
+			job_cancel(id);
+		}
+
+		// the reference the board took in job_add goes with it
+		if (atomic_fetch_sub_explicit(&waiting->dependencies, 1, memory_order_acq_rel) == 1) {
+			job_push(id, &waiting->work);
+		}
+
+		free(continuation);
+		continuation = next;
+
+	}
 
 }
 
@@ -107,18 +517,38 @@ void job_add_handler(job_type_t job, job_handler_t handler) {
 
 }
 
-void job_handle(uint32_t id) {
+static inline void job_finish_tick_phase(job_type_t type) {
 
-	job_type_t type = job_count;
-	job_payload_t payload = { .client = NULL };
-	with_lock (&job_board.heap.lock) {
-		job_work_t* work = utl_id_vector_get(&job_board.heap.jobs, id);
-		if (work == NULL || work->canceled) {
-			pthread_mutex_unlock(&job_board.heap.lock);
-			return;
+	if (job_tick_phase[type] && atomic_fetch_sub_explicit(&job_board.tick.pending, 1, memory_order_acq_rel) == 1) {
+		with_lock (&job_board.tick.lock) {
+			pthread_cond_broadcast(&job_board.tick.done);
 		}
-		type = work->type;
-		payload = work->payload;
+	}
+
+}
+
+void job_handle(uint64_t id) {
+
+	job_work_t* work = job_get_work(id);
+
+	if (work == NULL) {
+		return;
+	}
+
+	const job_type_t type = work->type;
+	job_slot_t* slot = job_get_slot(job_get_index(id));
+
+	if (job_is_canceled(id)) {
+		job_continue(slot, true);
+		job_free(id);
+		job_finish_tick_phase(type);
+		return;
+	}
+
+	job_payload_t payload = work->payload;
+
+	if (job_board.telemetry.enabled) {
+		work->dequeued = job_nanos();
 	}
 
 	utl_vector_t* work_handlers = UTL_VECTOR_GET_AS(utl_vector_t*, &job_handlers, type);
@@ -136,22 +566,158 @@ void job_handle(uint32_t id) {
 
 	}
 
+	atomic_fetch_add_explicit(&job_board.telemetry.types[type].completed, 1, memory_order_relaxed);
+
+	if (job_affine[type] && job_local != NULL) {
+		work->affinity = job_local->id + 1;
+	}
+
+	if (work->dequeued != 0) {
+
+		work->completed = job_nanos();
+
+		// jobs handled directly were never on the board and have no wait
+		if (work->enqueued != 0) {
+			utl_histogram_record(&job_board.telemetry.types[type].wait, work->dequeued - work->enqueued);
+		}
+		utl_histogram_record(&job_board.telemetry.types[type].run, work->completed - work->dequeued);
+
+	}
+
+	job_continue(slot, false);
 	job_free(id);
+	job_finish_tick_phase(type);
 
 }
 
-void job_add(uint32_t id) {
-	
-	job_work_t* work = utl_id_vector_get(&job_board.heap.jobs, id);
+job_lane_t job_get_lane(job_type_t type) {
 
-	work->on_board++;
+	return job_lanes[type];
 
-	with_lock (&job_board.queue.lock) {
-		utl_list_push(&job_board.queue.list, &id);
+}
+
+// send a job back to the worker that ran it last, returns false if it has no worker to go to
+static inline bool job_add_affine(uint64_t id, const job_work_t* work, job_lane_t lane) {
+
+	if (!job_board.affinity || !job_affine[work->type] || work->affinity == 0 || work->affinity > sky_main.workers.vector.size) {
+		return false;
+	}
+
+	sky_worker_t* worker = UTL_VECTOR_GET_AS(sky_worker_t*, &sky_main.workers.vector, work->affinity - 1);
+
+	if (worker == job_local && job_board.work_stealing) {
+		utl_deque_push(&worker->deques[lane], id);
+		return true;
 	}
 
+	with_lock (&worker->inbox[lane].lock) {
+		utl_list_push(&worker->inbox[lane].list, &id);
+		worker->inbox[lane].length++;
+	}
+
+	return true;
+
+}
+
+static void job_push(uint64_t id, job_work_t* work) {
+
+	const job_lane_t lane = job_lanes[work->type];
+
+	if (job_board.telemetry.enabled) {
+		work->enqueued = job_nanos();
+	}
+
+	// back to the worker that ran it last, only that worker may take it so it has to be woken
+	const bool affine = job_add_affine(id, work, lane);
+
+	if (affine) {
+
+		// already on its way
+
+	} else if (job_board.work_stealing && job_local != NULL) {
+
+		// added by a worker, keep it local
+		utl_deque_push(&job_local->deques[lane], id);
+
+	} else {
+
+		with_lock (&job_board.queue.lock) {
+			utl_list_push(&job_board.queue.lanes[lane].list, &id);
+			job_board.queue.lanes[lane].length++;
+		}
+
+	}
+
+	// only take the lock to wake a worker if one is actually waiting and no spinning worker will take the job instead
+	atomic_thread_fence(memory_order_seq_cst);
+	if (job_board.queue.sleeping != 0) {
+		if (!affine && job_board.idle.spinning != 0) {
+			atomic_fetch_add_explicit(&job_board.idle.wakeups_avoided, 1, memory_order_relaxed);
+		} else {
+			atomic_fetch_add_explicit(&job_board.idle.wakeups, 1, memory_order_relaxed);
+			with_lock (&job_board.queue.lock) {
+				if (affine) {
+					pthread_cond_broadcast(&job_board.queue.wait);
+				} else {
+					pthread_cond_signal(&job_board.queue.wait);
+				}
+			}
+		}
+	}
+
+}
+
+void job_add(uint64_t id) {
+
+	if (!job_retain(id)) {
+		return;
+	}
+
+	job_slot_t* slot = job_get_slot(job_get_index(id));
+
+	// the tick waits for it even while it waits on other jobs
+	if (job_tick_phase[slot->work.type]) {
+		atomic_fetch_add_explicit(&job_board.tick.pending, 1, memory_order_relaxed);
+	}
+
+	// the last job it waits on puts it on the board
+	if (!job_ready(slot)) {
+		return;
+	}
+
+	job_push(id, &slot->work);
+
+}
+
+void job_add_retained(const uint64_t* ids, uint32_t count) {
+
+	if (count == 0) {
+		return;
+	}
+
+	const uint64_t enqueued = job_board.telemetry.enabled ? job_nanos() : 0;
+
 	with_lock (&job_board.queue.lock) {
-		pthread_cond_signal(&job_board.queue.wait);
+		for (uint32_t i = 0; i < count; ++i) {
+			job_slot_t* slot = job_get_slot(job_get_index(ids[i]));
+			job_work_t* work = &slot->work;
+			const job_lane_t lane = job_lanes[work->type];
+			if (job_tick_phase[work->type]) {
+				atomic_fetch_add_explicit(&job_board.tick.pending, 1, memory_order_relaxed);
+			}
+			if (!job_ready(slot)) {
+				continue;
+			}
+			work->enqueued = enqueued;
+			if (job_add_affine(ids[i], work, lane)) {
+				continue;
+			}
+			utl_list_push(&job_board.queue.lanes[lane].list, (void*) &ids[i]);
+			job_board.queue.lanes[lane].length++;
+		}
+		if (job_board.queue.sleeping != 0) {
+			pthread_cond_broadcast(&job_board.queue.wait);
+		}
 	}
 
 }
@@ -164,50 +730,337 @@ void job_resume() {
 
 }
 
-void job_free(uint32_t id) {
+void job_free(uint64_t id) {
+
+	job_slot_t* slot = job_get_handle_slot(id);
 
-	with_lock (&job_board.heap.lock) {
-		job_work_t* work = utl_id_vector_get(&job_board.heap.jobs, id);
+	if (slot == NULL) {
+		return;
+	}
 
-		work->on_board--;
+	uint64_t state = atomic_load_explicit(&slot->state, memory_order_relaxed);
+	uint64_t next;
 
-		if (work->repeat || work->on_board != 0) {
-			pthread_mutex_unlock(&job_board.heap.lock);
+	do {
+		if (job_state_generation(state) != job_get_generation(id) || (state & JOB_STATE_REFERENCES) == 0) {
 			return;
 		}
+		if ((state & JOB_STATE_REFERENCES) == 1) {
+			// last reference, move the slot on to the next generation, the last one wraps to 0 which no handle has
+			next = (uint64_t) (uint32_t) (job_state_generation(state) + 1) << 32;
+		} else {
+			next = state - 1;
+		}
+	} while (!atomic_compare_exchange_weak_explicit(&slot->state, &state, next, memory_order_acq_rel, memory_order_relaxed));
 
-		utl_id_vector_remove(&job_board.heap.jobs, id);
+	if ((state & JOB_STATE_REFERENCES) == 1) {
+		// never handled, the jobs waiting on it won't get what they wait for
+		job_continue(slot, true);
+		if (job_state_generation(state) != UINT32_MAX) {
+			job_release(job_get_index(id));
+		} else {
+			// retired, reusing it would bring back handles that were already handed out
+			atomic_fetch_sub_explicit(&job_board.pool.count, 1, memory_order_relaxed);
+		}
 	}
 
 }
 
-uint32_t job_get() {
+// lane scheduling of this thread, each lane moves forward by its stride every time a job is taken from it
+static _Thread_local struct {
+	uint64_t time;
+	uint64_t pass[job_lane_count];
+} job_stride = {
+	.time = 0
+};
 
-	uint32_t job = 0;
+#define JOB_STRIDE (1 << 20)
 
-	// wait for jobs
-	with_lock (&job_board.queue.lock) {
-	
-		while (job_board.queue.list.length == 0) {
-		
-			if (sky_get_status() == sky_stopping) {
+static inline uint64_t job_now() {
+
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+
+	return (uint64_t) time.tv_sec * 1000 + time.tv_nsec / 1000000;
+
+}
+
+static inline bool job_take_inbox(sky_worker_t* worker, job_lane_t lane, uint64_t* job, uint32_t backlog) {
+
+	if (worker->inbox[lane].length <= backlog) {
+		return false;
+	}
+
+	bool found = false;
+
+	with_lock (&worker->inbox[lane].lock) {
+		if (worker->inbox[lane].list.length > backlog) {
+			memcpy(job, utl_list_first(&worker->inbox[lane].list), sizeof(uint64_t));
+			utl_list_shift(&worker->inbox[lane].list);
+			worker->inbox[lane].length--;
+			found = true;
+		}
+	}
+
+	return found;
+
+}
+
+static inline bool job_try_get_lane(sky_worker_t* worker, job_lane_t lane, uint64_t* job) {
+
+	// our own jobs first, most recent first while they're still in cache
+	if (worker != NULL && utl_deque_pop(&worker->deques[lane], job)) {
+		return true;
+	}
+
+	// then jobs that were sent back to us
+	if (worker != NULL && job_take_inbox(worker, lane, job, 0)) {
+		return true;
+	}
+
+	// then jobs from outside of the workers, oldest first
+	if (job_board.queue.lanes[lane].length != 0) {
+
+		bool found = false;
+
+		with_lock (&job_board.queue.lock) {
+			if (job_board.queue.lanes[lane].list.length != 0) {
+				memcpy(job, utl_list_first(&job_board.queue.lanes[lane].list), sizeof(uint64_t));
+				utl_list_shift(&job_board.queue.lanes[lane].list);
+				job_board.queue.lanes[lane].length--;
+				found = true;
+			}
+		}
+
+		if (found) {
+			return true;
+		}
+
+	}
+
+	// then steal from the other workers, starting at the next one so thieves spread out
+	if (job_board.work_stealing) {
+
+		const uint32_t worker_count = sky_main.workers.vector.size;
+		const uint32_t start = (worker != NULL ? worker->id + 1 : 0);
+
+		for (uint32_t i = 0; i < worker_count; ++i) {
+
+			sky_worker_t* victim = UTL_VECTOR_GET_AS(sky_worker_t*, &sky_main.workers.vector, (start + i) % worker_count);
+
+			if (victim != worker && utl_deque_steal(&victim->deques[lane], job)) {
+				return true;
+			}
+
+		}
+
+	}
+
+	// last, take from workers that have more than one job sent back to them waiting, it costs them their cache
+	const uint32_t worker_count = sky_main.workers.vector.size;
+	const uint32_t start = (worker != NULL ? worker->id + 1 : 0);
+
+	for (uint32_t i = 0; i < worker_count; ++i) {
+
+		sky_worker_t* victim = UTL_VECTOR_GET_AS(sky_worker_t*, &sky_main.workers.vector, (start + i) % worker_count);
+
+		if (victim != worker && job_take_inbox(victim, lane, job, 1)) {
+			return true;
+		}
+
+	}
+
+	return false;
+
+}
+
+static inline void job_served(job_lane_t lane, uint64_t now) {
 
-				pthread_mutex_unlock(&job_board.queue.lock);
+	// only write once per millisecond, every worker reads this
+	if (job_board.lanes[lane].served != now) {
+		job_board.lanes[lane].served = now;
+	}
+
+}
+
+static inline bool job_try_get(sky_worker_t* worker, uint64_t* job) {
+
+	const uint64_t now = job_now();
+
+	// a lane that has gone past its target latency goes first, most critical lanes first
+	for (job_lane_t lane = 0; lane < job_lane_count; ++lane) {
+
+		if (now - job_board.lanes[lane].served > job_board.lanes[lane].target_latency) {
 
-				return 0;
+			// an empty lane isn't waiting on anything either
+			const bool found = job_try_get_lane(worker, lane, job);
+			job_served(lane, now);
 
+			if (found) {
+				return true;
 			}
 
-			pthread_cond_wait(&job_board.queue.wait, &job_board.queue.lock);
-		
 		}
-		
-		memcpy(&job, utl_list_first(&job_board.queue.list), sizeof(uint32_t));
-		utl_list_shift(&job_board.queue.list);
 
 	}
 
-	return job;
+	// otherwise try the lanes that are furthest behind their share first
+	job_lane_t order[job_lane_count];
+	for (job_lane_t lane = 0; lane < job_lane_count; ++lane) {
+		job_lane_t i = lane;
+		for (; i > 0 && job_stride.pass[order[i - 1]] > job_stride.pass[lane]; --i) {
+			order[i] = order[i - 1];
+		}
+		order[i] = lane;
+	}
+
+	for (uint32_t i = 0; i < job_lane_count; ++i) {
+
+		const job_lane_t lane = order[i];
+
+		if (job_try_get_lane(worker, lane, job)) {
+
+			// a lane that was idle doesn't get to catch up on the turns it missed
+			const uint64_t pass = job_stride.pass[lane] > job_stride.time ? job_stride.pass[lane] : job_stride.time;
+			job_stride.time = pass;
+			job_stride.pass[lane] = pass + JOB_STRIDE / (job_board.lanes[lane].weight != 0 ? job_board.lanes[lane].weight : 1);
+
+			job_served(lane, now);
+
+			return true;
+
+		}
+
+	}
+
+	return false;
+
+}
+
+// must be called with the queue lock
+static inline bool job_waiting(sky_worker_t* worker) {
+
+	atomic_thread_fence(memory_order_seq_cst);
+
+	for (job_lane_t lane = 0; lane < job_lane_count; ++lane) {
+
+		if (job_board.queue.lanes[lane].list.length != 0) {
+			return true;
+		}
+
+		for (uint32_t i = 0; i < sky_main.workers.vector.size; ++i) {
+			sky_worker_t* other = UTL_VECTOR_GET_AS(sky_worker_t*, &sky_main.workers.vector, i);
+			if (job_board.work_stealing && utl_deque_size(&other->deques[lane]) != 0) {
+				return true;
+			}
+			// jobs sent back to another worker can only be taken once it has a backlog
+			if (other->inbox[lane].length > (other == worker ? 0 : 1)) {
+				return true;
+			}
+		}
+
+	}
+
+	return false;
+
+}
+
+static inline void job_relax() {
+
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+	__asm__ __volatile__ ("yield");
+#endif
+
+}
+
+// wait for a job without parking for a while, backing off exponentially, returns false if none turned up
+static inline bool job_spin(uint64_t* job) {
+
+	const uint32_t spin_rounds = job_board.idle.spin_rounds;
+	const uint32_t rounds = spin_rounds + job_board.idle.yield_rounds;
+
+	if (rounds == 0) {
+		return false;
+	}
+
+	bool found = false;
+
+	atomic_fetch_add(&job_board.idle.spinning, 1);
+
+	for (uint32_t round = 0; round < rounds && !found; ++round) {
+
+		if (round < spin_rounds) {
+			const uint32_t spins = 1u << (round < 16 ? round : 16);
+			for (uint32_t i = 0; i < spins; ++i) {
+				job_relax();
+			}
+		} else {
+			sched_yield();
+		}
+
+		found = job_try_get(job_local, job);
+
+	}
+
+	// a job added from here on wakes a parked worker again, and we check for jobs once more before parking
+	atomic_fetch_sub(&job_board.idle.spinning, 1);
+
+	return found;
+
+}
+
+uint64_t job_get() {
+
+	uint64_t job = 0;
+
+	for (;;) {
+
+		if (job_try_get(job_local, &job) || job_spin(&job)) {
+			return job;
+		}
+
+		// nothing to do, wait for jobs
+		with_lock (&job_board.queue.lock) {
+
+			job_board.queue.sleeping++;
+
+			while (!job_waiting(job_local)) {
+
+				if (sky_main.workers.stopping) {
+
+					job_board.queue.sleeping--;
+
+					pthread_mutex_unlock(&job_board.queue.lock);
+
+					return 0;
+
+				}
+
+				atomic_fetch_add_explicit(&job_board.idle.parks, 1, memory_order_relaxed);
+				pthread_cond_wait(&job_board.queue.wait, &job_board.queue.lock);
+
+			}
+
+			job_board.queue.sleeping--;
+
+		}
+
+	}
+
+}
+
+size_t job_get_lane_count(job_lane_t lane) {
+
+	size_t length = job_board.queue.lanes[lane].length;
+
+	for (uint32_t i = 0; i < sky_main.workers.vector.size; ++i) {
+		sky_worker_t* worker = UTL_VECTOR_GET_AS(sky_worker_t*, &sky_main.workers.vector, i);
+		length += utl_deque_size(&worker->deques[lane]) + worker->inbox[lane].length;
+	}
+
+	return length;
 
 }
 
@@ -215,30 +1068,126 @@ size_t job_get_count() {
 
 	size_t length = 0;
 
-	with_lock (&job_board.queue.lock) {
-		length = job_board.queue.list.length;
+	for (job_lane_t lane = 0; lane < job_lane_count; ++lane) {
+		length += job_get_lane_count(lane);
 	}
 
 	return length;
 
 }
 
-job_type_t job_get_type(uint32_t job) {
+uint32_t job_get_allocated() {
+
+	return job_board.pool.count;
+
+}
+
+job_type_t job_get_type(uint64_t job) {
 
-	job_type_t type = job_count;
+	const job_work_t* work = job_get_work(job);
 
-	with_lock (&job_board.heap.lock) {
-		job_work_t* work = utl_id_vector_get(&job_board.heap.jobs, job);
-		type = work->type;
+	if (work == NULL) {
+		return job_count;
 	}
 
-	return type;
+	return work->type;
+
+}
+
+const char* job_get_type_name(job_type_t type) {
+
+	return job_type_names[type];
+
+}
+
+void job_reset_telemetry() {
+
+	for (job_type_t type = 0; type < job_count; ++type) {
+		atomic_store_explicit(&job_board.telemetry.types[type].completed, 0, memory_order_relaxed);
+		atomic_store_explicit(&job_board.telemetry.types[type].canceled, 0, memory_order_relaxed);
+		utl_histogram_reset(&job_board.telemetry.types[type].wait);
+		utl_histogram_reset(&job_board.telemetry.types[type].run);
+	}
+
+	atomic_store_explicit(&job_board.idle.wakeups, 0, memory_order_relaxed);
+	atomic_store_explicit(&job_board.idle.wakeups_avoided, 0, memory_order_relaxed);
+	atomic_store_explicit(&job_board.idle.parks, 0, memory_order_relaxed);
+
+	job_board.telemetry.since = job_nanos();
+
+}
+
+uint64_t job_get_telemetry_time() {
+
+	return job_nanos() - job_board.telemetry.since;
+
+}
+
+static void job_write_histogram(FILE* file, const char* name, utl_histogram_t* histogram) {
+
+	fprintf(file, "\"%s\":{\"count\":%lu,\"sum\":%lu,\"max\":%lu,\"p50\":%lu,\"p90\":%lu,\"p99\":%lu,\"p999\":%lu}",
+		name,
+		utl_histogram_count(histogram),
+		utl_histogram_sum(histogram),
+		utl_histogram_max(histogram),
+		utl_histogram_percentile(histogram, 50),
+		utl_histogram_percentile(histogram, 90),
+		utl_histogram_percentile(histogram, 99),
+		utl_histogram_percentile(histogram, 99.9)
+	);
+
+}
+
+void job_write_telemetry(FILE* file) {
+
+	const uint64_t elapsed = job_get_telemetry_time();
+
+	fprintf(file, "{\"enabled\":%s,\"elapsed\":%lu,\"types\":{", job_board.telemetry.enabled ? "true" : "false", elapsed);
+
+	for (job_type_t type = 0; type < job_count; ++type) {
+
+		const uint64_t completed = job_board.telemetry.types[type].completed;
+
+		fprintf(file, "%s\"%s\":{\"completed\":%lu,\"canceled\":%lu,\"per_second\":%.2f,", type == 0 ? "" : ",", job_type_names[type], completed, (uint64_t) job_board.telemetry.types[type].canceled, elapsed == 0 ? 0 : completed * 1e9 / elapsed);
+		job_write_histogram(file, "wait", &job_board.telemetry.types[type].wait);
+		fputc(',', file);
+		job_write_histogram(file, "run", &job_board.telemetry.types[type].run);
+		fputc('}', file);
+
+	}
+
+	fprintf(file, "},\"idle\":{\"wakeups\":%lu,\"wakeups_avoided\":%lu,\"parks\":%lu}}\n", (uint64_t) job_board.idle.wakeups, (uint64_t) job_board.idle.wakeups_avoided, (uint64_t) job_board.idle.parks);
+
+}
+
+void job_join_tick() {
+
+	uint64_t job;
+
+	while (atomic_load_explicit(&job_board.tick.pending, memory_order_acquire) != 0) {
+
+		// help with the tick instead of waiting on it
+		if (job_try_get_lane(job_local, job_lane_tick_critical, &job)) {
+			job_handle(job);
+			continue;
+		}
+
+		// the rest are already being run by workers
+		with_lock (&job_board.tick.lock) {
+			if (atomic_load_explicit(&job_board.tick.pending, memory_order_acquire) != 0) {
+				pthread_cond_wait(&job_board.tick.done, &job_board.tick.lock);
+			}
+		}
+
+	}
 
 }
 
 void job_work(sky_worker_t* worker) {
 
-	const uint32_t job = job_get();
+	job_local = worker;
+
+	const uint64_t job = job_get();
 	worker->job = job;
 	job_handle(job);
 
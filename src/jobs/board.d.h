@@ -19,11 +19,27 @@ typedef enum {
 	job_living_entity_teleport_look,
 	job_living_entity_damage,
 	job_tick_world,
+	job_client_caught_up,
 
 	job_count
 
 } job_type_t;
 
+// job types are sorted into lanes, workers take from each lane by its weight
+typedef enum {
+
+	job_lane_latency_critical, // clients are waiting on these, keep alives, chat, digging
+	job_lane_tick_critical, // world ticks and entity updates that have to keep up with the tick rate
+	job_lane_background, // joins and unloads, anything that can wait a bit
+
+	job_lane_count
+
+} job_lane_t;
+
 typedef union job_payload job_payload_t;
 
-typedef struct job_work job_work_t;
\ No newline at end of file
+typedef struct job_work job_work_t;
+
+typedef struct job_slot job_slot_t;
+
+typedef struct job_continuation job_continuation_t;
\ No newline at end of file
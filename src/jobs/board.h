@@ -1,6 +1,7 @@
 #pragma once
 #include <assert.h>
 #include <pthread.h>
+#include <stdio.h>
 
 #include "board.d.h"
 #include "../motor.d.h"
@@ -11,19 +12,84 @@
 
 #include "../main.h"
 #include "../util/list.h"
+#include "../util/histogram.h"
+
+/*
+Job handles are a slot index in the low 32 bits and the generation of the slot in the high 32 bits
+The generation changes every time a slot is reused, so stale handles are detected and ignored
+A slot that has gone through every generation is retired instead of being reused, so a handle never comes back
+Generation 0 is never used, so 0 is never a valid handle
+*/
+#define JOB_SLAB_SIZE 1024
+#define JOB_MAX_SLABS 1024
 
 struct job_board {
 
 	struct {
 		pthread_mutex_t lock;
 		pthread_cond_t wait;
-		utl_list_t list;
+		_Atomic uint32_t sleeping;
+		// injection queues, jobs added from outside of the workers (and all jobs when not work stealing)
+		struct {
+			utl_list_t list;
+			_Atomic uint32_t length;
+		} lanes[job_lane_count];
 	} queue;
 
+	struct {
+		uint32_t weight;
+		// milliseconds a lane can go without being served while it has jobs before it goes ahead of the others
+		uint32_t target_latency;
+		// last time a job was taken from the lane or the lane was found empty
+		_Atomic uint64_t served;
+	} lanes[job_lane_count];
+
+	// tick phase jobs (region and world ticks) on the board or running, the main thread joins them every tick
 	struct {
 		pthread_mutex_t lock;
-		utl_id_vector_t jobs;
-	} heap;
+		pthread_cond_t done;
+		_Atomic uint32_t pending;
+	} tick;
+
+	// workers out of jobs spin, then yield, then park, jobs added while one is spinning don't wake a parked one
+	struct {
+		uint32_t spin_rounds; // each round spins twice as long as the last
+		uint32_t yield_rounds; // rounds giving up the core before parking
+		_Atomic uint32_t spinning;
+		_Atomic uint64_t wakeups; // parked workers woken by a new job
+		_Atomic uint64_t wakeups_avoided; // left parked because a spinning worker would take the job
+		_Atomic uint64_t parks;
+	} idle;
+
+	// when enabled, jobs added by a worker go on that worker's deque and idle workers steal from the others
+	bool work_stealing;
+
+	// when enabled, region ticks go back to the worker that ran them last, so its cache still has the region
+	bool affinity;
+
+	// per job type counters and timings, in nanoseconds
+	struct {
+		// timestamps and histograms are only taken when enabled, counters always are
+		bool enabled;
+		// when the counters were last reset, rates are over the time since
+		_Atomic uint64_t since;
+		struct {
+			_Atomic uint64_t completed;
+			_Atomic uint64_t canceled;
+			utl_histogram_t wait; // from being put on the board until a worker starts it
+			utl_histogram_t run; // time spent in the handlers
+		} types[job_count];
+	} telemetry;
+
+	// slab allocated job slots, addressed by a handle of a slot index and a generation
+	struct {
+		pthread_mutex_t lock; // only taken to allocate a new slab
+		pthread_key_t cache; // flushes a thread's cached slots back when the thread exits
+		_Atomic uint64_t free; // tagged head of the shared free list
+		_Atomic uint32_t slab_count;
+		_Atomic uint32_t count;
+		job_slot_t* _Atomic slabs[JOB_MAX_SLABS];
+	} pool;
 
 };
 
@@ -33,6 +99,9 @@ union job_payload {
 
 	ltg_client_t* client;
 
+	// for jobs that run after the client may be gone, it's looked up when the job runs
+	uint32_t client_id;
+
 	struct {
 
 		ltg_client_t* client;
@@ -72,6 +141,9 @@ union job_payload {
 
 		bool on_ground;
 
+		// take the movement merged into the entity since the last broadcast
+		bool pending;
+
 	} entity_move;
 
 	struct {
@@ -116,6 +188,9 @@ union job_payload {
 
 		bool on_ground;
 
+		// take the movement merged into the entity since the last broadcast
+		bool pending;
+
 	} living_entity_move_look;
 
 	struct {
@@ -151,29 +226,122 @@ union job_payload {
 
 struct job_work {
 
-	const job_type_t type : 4;
-	uint8_t repeat;
-	uint8_t on_board;
-	bool canceled;
+	job_type_t type;
+
+	// nanoseconds, 0 if the job never got to that point or telemetry is disabled
+	uint64_t enqueued;
+	uint64_t dequeued;
+	uint64_t completed;
+
+	// id + 1 of the worker that last ran the job, 0 if it hasn't run on a worker
+	uint16_t affinity;
 
 	job_payload_t payload;
 
 };
 
-extern uint32_t job_new(job_type_t type, job_payload_t payload);
+struct job_continuation {
+
+	uint64_t job;
+	job_continuation_t* next;
+
+};
+
+struct job_slot {
+
+	// generation << 32 | canceled bit | references (times on the board + held by the scheduler)
+	_Atomic uint64_t state;
+	// next free slot index + 1 while on a free list
+	_Atomic uint32_t next;
+
+	// jobs this one waits on that haven't finished yet, + 1 until it is added to the board
+	_Atomic uint32_t dependencies;
+	// jobs waiting on this one, JOB_CONTINUATIONS_DONE once this one has finished
+	job_continuation_t* _Atomic continuations;
+
+	job_work_t work;
+
+};
+
+extern uint64_t job_new(job_type_t type, job_payload_t payload);
+
+static inline job_slot_t* job_get_slot(uint32_t index) {
+
+	return &atomic_load_explicit(&job_board.pool.slabs[index / JOB_SLAB_SIZE], memory_order_acquire)[index % JOB_SLAB_SIZE];
+
+}
+
+static inline uint32_t job_get_index(uint64_t id) {
+
+	return (uint32_t) id;
+
+}
+
+static inline uint32_t job_get_generation(uint64_t id) {
+
+	return id >> 32;
+
+}
+
+/*
+Take another reference to a job the caller already holds a reference to
+*/
+static inline void job_retain_held(uint64_t id) {
+
+	atomic_fetch_add_explicit(&job_get_slot(job_get_index(id))->state, 1, memory_order_relaxed);
+
+}
 
 typedef bool (*job_handler_t) (job_payload_t* payload);
 
 extern void job_add_handler(job_type_t type, job_handler_t handler);
-extern void job_handle(uint32_t id);
-extern void job_add(uint32_t id);
+extern void job_handle(uint64_t id);
+/*
+Put a job on the board, or once it has been added, let the last job it waits on put it on the board
+*/
+extern void job_add(uint64_t id);
+/*
+Make a job wait for another to finish before it runs, a job can wait on and be waited on by any number of jobs
+The waiting job must not have been added yet, the other must not have been freed, so either not added yet or held
+When the other job is canceled the waiting job is canceled with it
+Returns false if the other job already finished, the waiting job doesn't wait on it then
+*/
+extern bool job_then(uint64_t before, uint64_t after);
+/*
+Put jobs on the board in one go, the caller hands over a reference it already holds to each job
+*/
+extern void job_add_retained(const uint64_t* ids, uint32_t count);
 extern void job_resume();
+/*
+Wait until every tick phase job put on the board has been handled, helping with them while there are any to take
+Tick phase jobs have to be handled once taken off the board, or this never returns
+*/
+extern void job_join_tick();
+
+extern bool job_retain(uint64_t id);
+extern void job_free(uint64_t id);
+extern void job_cancel(uint64_t id);
+extern bool job_is_canceled(uint64_t id);
 
-extern void job_free(uint32_t id);
+/*
+Get the job a handle refers to, NULL if the handle is invalid or the job was already freed
+The caller must hold a reference to the job for the result to stay valid
+*/
+extern job_work_t* job_get_work(uint64_t id);
 
-extern uint32_t job_get();
+extern uint64_t job_get();
 
 extern size_t job_get_count();
-extern job_type_t job_get_type(uint32_t job);
+extern size_t job_get_lane_count(job_lane_t lane);
+extern job_lane_t job_get_lane(job_type_t type);
+extern uint32_t job_get_allocated();
+extern job_type_t job_get_type(uint64_t job);
+extern const char* job_get_type_name(job_type_t type);
+
+extern void job_reset_telemetry();
+// nanoseconds since the telemetry was last reset
+extern uint64_t job_get_telemetry_time();
+// write the telemetry of every job type as JSON
+extern void job_write_telemetry(FILE* file);
 
 extern void job_work(sky_worker_t* worker);
@@ -42,13 +42,20 @@ bool job_handle_global_chat_message(job_payload_t* payload) {
 	char out[1536];
 	const size_t out_len = cht_write_translation(&translation, out);
 
-	const uint32_t online_length = ltg_get_online_length(sky_get_listener());
-	for (uint32_t i = 0; i < online_length; ++i) {
-		ltg_client_t* client = ltg_get_online_client(sky_get_listener(), i);
-		if (client != NULL) {
-			phd_send_chat_message(client, out, out_len, ltg_client_get_uuid(payload->global_chat_message.client));
+	ltg_listener_t* listener = sky_get_listener();
+	ltg_broadcast_t* broadcast = phd_create_chat_message(out, out_len, ltg_client_get_uuid(payload->global_chat_message.client));
+
+	// online clients are only freed after they are taken off the list, which can't happen while it's locked
+	with_lock (&listener->online.lock) {
+		const uint32_t online_length = utl_id_vector_length(&listener->online.vector);
+		for (uint32_t i = 0; i < online_length; ++i) {
+			ltg_client_t* client = UTL_ID_VECTOR_GET_AS(ltg_client_t*, &listener->online.vector, i);
+			if (client != NULL) {
+				ltg_broadcast(client, broadcast);
+			}
 		}
 	}
+	ltg_release_broadcast(broadcast);
 	cht_term_translation(&translation);
 
 	free(payload->global_chat_message.message.value);
@@ -81,16 +88,25 @@ bool job_handle_player_join(job_payload_t* payload) {
 
 	char out[128];
 	const size_t out_len = cht_write_translation(&translation, out);
+	ltg_listener_t* listener = sky_get_listener();
+	ltg_broadcast_t* info = phd_create_player_info_add_player(payload->client);
+	ltg_broadcast_t* message = phd_create_system_chat_message(out, out_len);
+
 	// lock client vector
-	const uint32_t online_length = ltg_get_online_length(sky_get_listener());
-	for (uint32_t i = 0; i < online_length; ++i) {
-		ltg_client_t* client = ltg_get_online_client(sky_get_listener(), i);
-		if (client != NULL) {
-			phd_send_player_info_add_player(client, payload->client);
-			phd_send_system_chat_message(client, out, out_len);
+	with_lock (&listener->online.lock) {
+		const uint32_t online_length = utl_id_vector_length(&listener->online.vector);
+		for (uint32_t i = 0; i < online_length; ++i) {
+			ltg_client_t* client = UTL_ID_VECTOR_GET_AS(ltg_client_t*, &listener->online.vector, i);
+			if (client != NULL) {
+				ltg_broadcast(client, info);
+				ltg_broadcast(client, message);
+			}
 		}
 	}
 
+	ltg_release_broadcast(info);
+	ltg_release_broadcast(message);
+
 	cht_term_translation(&translation);
 
 	ent_entity_t* entity = ent_player_get_entity(ltg_client_get_entity(payload->client));
@@ -118,15 +134,24 @@ bool job_handle_player_leave(job_payload_t* payload) {
 	char out[128];
 	const size_t out_len = cht_write_translation(&translation, out);
 	
-	const uint32_t online_length = ltg_get_online_length(sky_get_listener());
-	for (uint32_t i = 0; i < online_length; ++i) {
-		ltg_client_t* client = ltg_get_online_client(sky_get_listener(), i);
-		if (client != NULL) {
-			phd_send_player_info_remove_player(client, payload->player_leave.uuid);
-			phd_send_system_chat_message(client, out, out_len);
+	ltg_listener_t* listener = sky_get_listener();
+	ltg_broadcast_t* info = phd_create_player_info_remove_player(payload->player_leave.uuid);
+	ltg_broadcast_t* message = phd_create_system_chat_message(out, out_len);
+
+	with_lock (&listener->online.lock) {
+		const uint32_t online_length = utl_id_vector_length(&listener->online.vector);
+		for (uint32_t i = 0; i < online_length; ++i) {
+			ltg_client_t* client = UTL_ID_VECTOR_GET_AS(ltg_client_t*, &listener->online.vector, i);
+			if (client != NULL) {
+				ltg_broadcast(client, info);
+				ltg_broadcast(client, message);
+			}
 		}
 	}
 
+	ltg_release_broadcast(info);
+	ltg_release_broadcast(message);
+
 	cht_term_translation(&translation);
 
 	return true;
@@ -135,11 +160,15 @@ bool job_handle_player_leave(job_payload_t* payload) {
 
 bool job_handle_send_update_pings(__attribute__((unused)) job_payload_t* payload) {
 
-	const uint32_t online_length = ltg_get_online_length(sky_get_listener());
-	for (uint32_t i = 0; i < online_length; ++i) {
-		ltg_client_t* client = ltg_get_online_client(sky_get_listener(), i);
-		if (client != NULL) {
-			phd_send_player_info_update_latency(client);
+	ltg_listener_t* listener = sky_get_listener();
+
+	with_lock (&listener->online.lock) {
+		const uint32_t online_length = utl_id_vector_length(&listener->online.vector);
+		for (uint32_t i = 0; i < online_length; ++i) {
+			ltg_client_t* client = UTL_ID_VECTOR_GET_AS(ltg_client_t*, &listener->online.vector, i);
+			if (client != NULL) {
+				phd_send_player_info_update_latency(client);
+			}
 		}
 	}
 
@@ -227,6 +256,11 @@ bool job_handle_dig_block(job_payload_t* payload) {
 
 }
 
+// relative move packets carry deltas as shorts of 1/4096 blocks, anything further has to be a teleport
+static inline bool job_exceeds_relative_move(float64_t d_x, float64_t d_y, float64_t d_z) {
+	return UTL_ABS(d_x) >= 8 || UTL_ABS(d_y) >= 8 || UTL_ABS(d_z) >= 8;
+}
+
 static inline void job_update_entity_move(uint32_t client_id, void* args) {
 	
 	job_payload_t* payload = args;
@@ -241,25 +275,56 @@ static inline void job_update_entity_move(uint32_t client_id, void* args) {
 			phd_update_sent_chunks_move(client, payload->entity_move.initial_chunk);
 		}
 	} else {
-		phd_send_entity_position(client, entity, payload->entity_move.d_x, payload->entity_move.d_y, payload->entity_move.d_z);
+		switch (ltg_shed_movement(client, ent_get_id(entity))) {
+			case ltg_movement_send: {
+				if (job_exceeds_relative_move(payload->entity_move.d_x, payload->entity_move.d_y, payload->entity_move.d_z)) {
+					phd_send_entity_teleport(client, entity);
+				} else {
+					phd_send_entity_position(client, entity, payload->entity_move.d_x, payload->entity_move.d_y, payload->entity_move.d_z);
+				}
+			} break;
+			case ltg_movement_resync: {
+				phd_update_resync_entity(client, entity);
+			} break;
+			case ltg_movement_skip: {
+				// the client is sent where the entity is once it catches up
+			} break;
+		}
 	}
 
 }
 
 bool job_handle_entity_move(job_payload_t* payload) {
-	
-	// what if the entity has been destroyed by the time this is handled? TODO
 
 	ent_entity_t* entity = payload->entity_move.entity;
 
-	// why not +=?
-	// well, Atomic implementations vary from PC to PC and operating system to operating system,
-	// and additions on floats are not very commonly implemented, but set usually is
-	entity->position.x = entity->position.x + payload->entity_move.d_x;
-	entity->position.y = entity->position.y + payload->entity_move.d_y;
-	entity->position.z = entity->position.z + payload->entity_move.d_z;
+	if (payload->entity_move.pending) {
 
-	entity->on_ground = payload->entity_move.on_ground;
+		ent_pending_move_t move;
+		payload->entity_move.initial_chunk = ent_get_chunk(entity);
+
+		if (!ent_take_pending_move(entity, &move)) {
+			ent_finish_pending_move(entity);
+			return false;
+		}
+
+		payload->entity_move.d_x = move.d_x;
+		payload->entity_move.d_y = move.d_y;
+		payload->entity_move.d_z = move.d_z;
+		payload->entity_move.on_ground = ent_is_on_ground(entity);
+
+	} else {
+
+		// why not +=?
+		// well, Atomic implementations vary from PC to PC and operating system to operating system,
+		// and additions on floats are not very commonly implemented, but set usually is
+		entity->position.x = entity->position.x + payload->entity_move.d_x;
+		entity->position.y = entity->position.y + payload->entity_move.d_y;
+		entity->position.z = entity->position.z + payload->entity_move.d_z;
+
+		entity->on_ground = payload->entity_move.on_ground;
+
+	}
 
 	// TODO physics
 
@@ -271,6 +336,10 @@ bool job_handle_entity_move(job_payload_t* payload) {
 	wld_chunk_t* chunk = ent_get_chunk(entity);
 	wld_chunk_subscribers_foreach(chunk, job_update_entity_move, payload);
 
+	if (payload->entity_move.pending) {
+		ent_finish_pending_move(entity);
+	}
+
 	return true;
 
 }
@@ -289,7 +358,7 @@ static inline void job_update_entity_teleport(uint32_t client_id, void* args) {
 			phd_update_sent_chunks_teleport(client, payload->entity_teleport.initial_chunk);
 		}
 		phd_send_player_position_and_look(client);
-	} else {
+	} else if (ltg_shed_movement(client, ent_get_id(entity)) != ltg_movement_skip) {
 		phd_send_entity_teleport(client, entity);
 	}
 
@@ -299,6 +368,9 @@ bool job_handle_entity_teleport(job_payload_t* payload) {
 
 	ent_entity_t* entity = payload->entity_teleport.entity;
 
+	// movement queued before the teleport was relative to the old position
+	ent_clear_pending_move(entity);
+
 	entity->position.world = payload->entity_teleport.world;
 	entity->position.x = payload->entity_teleport.x;
 	entity->position.y = payload->entity_teleport.y;
@@ -332,8 +404,18 @@ static inline void job_update_living_entity_look(uint32_t client_id, void* args)
 	if (ent_get_type(ent_le_get_entity(entity)) == ent_player && ent_player_get_le(ltg_client_get_entity(client)) == entity) {
 		// Do nothing
 	} else {
-		phd_send_entity_rotation(client, entity);
-		phd_send_entity_head_look(client, entity);
+		switch (ltg_shed_movement(client, ent_get_id(ent_le_get_entity(entity)))) {
+			case ltg_movement_send: {
+				phd_send_entity_rotation(client, entity);
+				phd_send_entity_head_look(client, entity);
+			} break;
+			case ltg_movement_resync: {
+				phd_update_resync_entity(client, ent_le_get_entity(entity));
+			} break;
+			case ltg_movement_skip: {
+				// the client is sent where the entity is once it catches up
+			} break;
+		}
 	}
 
 }
@@ -368,8 +450,22 @@ static inline void job_update_living_entity_move_look(uint32_t client_id, void*
 			phd_update_sent_chunks_move(client, payload->living_entity_move_look.initial_chunk);
 		}
 	} else {
-		phd_send_entity_position_and_rotation(client, entity, payload->living_entity_move_look.d_x, payload->living_entity_move_look.d_y, payload->living_entity_move_look.d_z);
-		phd_send_entity_head_look(client, entity);
+		switch (ltg_shed_movement(client, ent_get_id(ent_le_get_entity(entity)))) {
+			case ltg_movement_send: {
+				if (job_exceeds_relative_move(payload->living_entity_move_look.d_x, payload->living_entity_move_look.d_y, payload->living_entity_move_look.d_z)) {
+					phd_send_living_entity_teleport(client, entity);
+				} else {
+					phd_send_entity_position_and_rotation(client, entity, payload->living_entity_move_look.d_x, payload->living_entity_move_look.d_y, payload->living_entity_move_look.d_z);
+				}
+				phd_send_entity_head_look(client, entity);
+			} break;
+			case ltg_movement_resync: {
+				phd_update_resync_entity(client, ent_le_get_entity(entity));
+			} break;
+			case ltg_movement_skip: {
+				// the client is sent where the entity is once it catches up
+			} break;
+		}
 	}
 	
 }
@@ -378,9 +474,30 @@ bool job_handle_living_entity_move_look(job_payload_t* payload) {
 
 	ent_living_entity_t* entity = payload->living_entity_move_look.entity;
 
-	entity->entity.position.x = entity->entity.position.x + payload->living_entity_move_look.d_x;
-	entity->entity.position.y = entity->entity.position.y + payload->living_entity_move_look.d_y;
-	entity->entity.position.z = entity->entity.position.z + payload->living_entity_move_look.d_z;
+	if (payload->living_entity_move_look.pending) {
+
+		ent_pending_move_t move;
+		payload->living_entity_move_look.initial_chunk = ent_get_chunk(ent_le_get_entity(entity));
+
+		if (!ent_take_pending_move(ent_le_get_entity(entity), &move)) {
+			ent_finish_pending_move(ent_le_get_entity(entity));
+			return false;
+		}
+
+		payload->living_entity_move_look.d_x = move.d_x;
+		payload->living_entity_move_look.d_y = move.d_y;
+		payload->living_entity_move_look.d_z = move.d_z;
+		payload->living_entity_move_look.yaw = move.looked ? move.yaw : ent_le_get_yaw(entity);
+		payload->living_entity_move_look.pitch = move.looked ? move.pitch : ent_le_get_pitch(entity);
+		payload->living_entity_move_look.on_ground = ent_is_on_ground(ent_le_get_entity(entity));
+
+	} else {
+
+		entity->entity.position.x = entity->entity.position.x + payload->living_entity_move_look.d_x;
+		entity->entity.position.y = entity->entity.position.y + payload->living_entity_move_look.d_y;
+		entity->entity.position.z = entity->entity.position.z + payload->living_entity_move_look.d_z;
+
+	}
 
 	entity->rotation.yaw = payload->living_entity_move_look.yaw;
 	entity->rotation.pitch = payload->living_entity_move_look.pitch;
@@ -397,6 +514,10 @@ bool job_handle_living_entity_move_look(job_payload_t* payload) {
 	wld_chunk_t* chunk = ent_get_chunk(ent_le_get_entity(entity));
 	wld_chunk_subscribers_foreach(chunk, job_update_living_entity_move_look, payload);
 
+	if (payload->living_entity_move_look.pending) {
+		ent_finish_pending_move(ent_le_get_entity(entity));
+	}
+
 	return true;
 
 }
@@ -415,7 +536,7 @@ static inline void job_update_living_entity_teleport_look(uint32_t client_id, vo
 			phd_update_sent_chunks_teleport(client, payload->living_entity_teleport_look.initial_chunk);
 		}
 		phd_send_player_position_and_look(client);
-	} else {
+	} else if (ltg_shed_movement(client, ent_get_id(ent_le_get_entity(entity))) != ltg_movement_skip) {
 		phd_send_living_entity_teleport(client, entity);
 		phd_send_entity_head_look(client, entity);
 	}
@@ -426,6 +547,9 @@ bool job_handle_living_entity_teleport_look(job_payload_t* payload) {
 
 	ent_living_entity_t* entity = payload->living_entity_teleport_look.entity;
 
+	// movement queued before the teleport was relative to the old position
+	ent_clear_pending_move(ent_le_get_entity(entity));
+
 	entity->entity.position.world = payload->living_entity_teleport_look.world;
 
 	entity->entity.position.x = payload->living_entity_teleport_look.x;
@@ -508,4 +632,19 @@ bool job_handle_tick_world(job_payload_t* payload) {
 	
 	return true;
 
+}
+
+bool job_handle_client_caught_up(job_payload_t* payload) {
+
+	ltg_client_t* client = ltg_get_client_by_id(sky_get_listener(), payload->client_id);
+
+	// the client left, or never got far enough to be sent anything that is held back
+	if (client == NULL || ltg_client_get_entity(client) == NULL) {
+		return false;
+	}
+
+	phd_update_sent_chunks_caught_up(client);
+
+	return true;
+
 }
\ No newline at end of file
@@ -1,133 +1,280 @@
 #include "scheduler.h"
 #include "../board.h"
 #include "../../motor.h"
-#include "../../util/id_vector.h"
-#include "../../util/vector.h"
 #include <pthread.h>
 
+/*
+Hierarchical timing wheel
+Each level has 256 buckets, a bucket on level n covers 256^n ticks
+Level 0 alone holds anything due within the next 256 ticks, which covers region ticks and keep alives
+Every 256^n ticks the current bucket of level n is spread over the levels below it
+
+Every job slot has an entry with its bucket and its position in that bucket, so removing a job is a swap with the last one
+Buckets keep their capacity when they're emptied, so once the wheel is warm scheduling doesn't allocate
+*/
+
+#define SCH_LEVEL_BITS 8
+#define SCH_LEVEL_SIZE (1 << SCH_LEVEL_BITS)
+#define SCH_LEVEL_MASK (SCH_LEVEL_SIZE - 1)
+#define SCH_LEVELS 3
+#define SCH_BUCKETS (SCH_LEVELS * SCH_LEVEL_SIZE)
+#define SCH_RANGE (1ull << (SCH_LEVEL_BITS * SCH_LEVELS))
+
+typedef struct {
+
+	uint64_t expiry;
+	uint32_t repeat;
+	uint32_t position;
+	uint16_t bucket; // bucket + 1, 0 when not in the wheel
+
+} sch_entry_t;
+
+typedef struct {
+
+	uint64_t* ids;
+	uint32_t size;
+	uint32_t capacity;
+
+} sch_bucket_t;
+
 struct {
 
 	pthread_mutex_t lock;
-	utl_vector_t tape;
+	uint64_t tick;
+	sch_bucket_t buckets[SCH_BUCKETS];
+
+	// the bucket being expired or cascaded, swapped with the empty one it leaves behind
+	sch_bucket_t expired;
+
+	// one entry per job slot, only grows when the job pool does
+	sch_entry_t* entries;
+	uint32_t capacity;
 
 } sch_scheduler = {
 	.lock = PTHREAD_MUTEX_INITIALIZER,
-	.tape = UTL_VECTOR_INITIALIZER(utl_vector_t)
+	.tick = 0,
+	.expired = {
+		.ids = NULL,
+		.size = 0,
+		.capacity = 0
+	},
+	.entries = NULL,
+	.capacity = 0
 };
 
-static inline void sch_push_l(uint32_t id, uint32_t delay) {
+static inline sch_entry_t* sch_get_entry_l(uint64_t id) {
 
-	const utl_vector_t empty = UTL_VECTOR_INITIALIZER(uint32_t);
+	const uint32_t index = job_get_index(id);
 
-	while (delay >= sch_scheduler.tape.size) { // fill up to the delay with empty vectors
+	if (index >= sch_scheduler.capacity) {
+
+		// cover the whole pool, the new entries are not in the wheel
+		const uint32_t capacity = (index / JOB_SLAB_SIZE + 1) * JOB_SLAB_SIZE;
+		sch_scheduler.entries = realloc(sch_scheduler.entries, sizeof(sch_entry_t) * capacity);
+		memset(sch_scheduler.entries + sch_scheduler.capacity, 0, sizeof(sch_entry_t) * (capacity - sch_scheduler.capacity));
+		sch_scheduler.capacity = capacity;
 
-		utl_vector_push(&sch_scheduler.tape, &empty);
-	
 	}
 
-	utl_vector_t* vector = utl_vector_get(&sch_scheduler.tape, delay);
+	return &sch_scheduler.entries[index];
+
+}
+
+static inline void sch_link_l(uint64_t id, sch_entry_t* entry) {
+
+	uint64_t delta = entry->expiry - sch_scheduler.tick;
+
+	// jobs past the end of the wheel wait in the furthest bucket and are placed again when it comes around
+	if (delta >= SCH_RANGE) {
+		delta = SCH_RANGE - 1;
+	}
+
+	const uint64_t expiry = sch_scheduler.tick + delta;
+
+	uint32_t level = 0;
+	while (delta >= (1ull << (SCH_LEVEL_BITS * (level + 1)))) {
+		level++;
+	}
+
+	const uint16_t bucket = (level << SCH_LEVEL_BITS) | ((expiry >> (SCH_LEVEL_BITS * level)) & SCH_LEVEL_MASK);
+	sch_bucket_t* list = &sch_scheduler.buckets[bucket];
+
+	if (list->size == list->capacity) {
+		list->capacity = (list->capacity > 0 ? list->capacity * 2 : 16);
+		list->ids = realloc(list->ids, sizeof(uint64_t) * list->capacity);
+	}
+
+	entry->bucket = bucket + 1;
+	entry->position = list->size;
+
+	list->ids[list->size++] = id;
+
+}
+
+static inline void sch_unlink_l(sch_entry_t* entry) {
+
+	sch_bucket_t* list = &sch_scheduler.buckets[entry->bucket - 1];
+
+	// move the last job of the bucket into the hole
+	const uint64_t last = list->ids[--list->size];
+	list->ids[entry->position] = last;
+	sch_scheduler.entries[job_get_index(last)].position = entry->position;
+
+	entry->bucket = 0;
 
-	utl_vector_push(vector, &id);
+}
+
+// take a bucket out of the wheel, leaving the empty expired bucket in its place
+static inline uint64_t* sch_take_l(uint32_t bucket, uint32_t* count) {
+
+	const sch_bucket_t taken = sch_scheduler.buckets[bucket];
+	sch_scheduler.buckets[bucket] = sch_scheduler.expired;
+	sch_scheduler.expired = taken;
+
+	*count = taken.size;
+	sch_scheduler.expired.size = 0;
+
+	return taken.ids;
 
 }
 
-static inline void sch_push(uint32_t id, uint32_t delay) {
+// the scheduler keeps the reference the caller retained until the job is put on the board
+static inline void sch_push(uint64_t id, uint32_t delay, uint32_t repeat) {
 
 	with_lock (&sch_scheduler.lock) {
 
-		sch_push_l(id, delay);
+		sch_entry_t* entry = sch_get_entry_l(id);
+		entry->expiry = sch_scheduler.tick + delay;
+		entry->repeat = repeat;
+		sch_link_l(id, entry);
 		
 	}
 
 }
 
-uint32_t sch_schedule(uint32_t id, uint32_t delay) {
+uint64_t sch_schedule(uint64_t id, uint32_t delay) {
 
 	if (delay == 0) {
 		job_add(id);
-	} else {
-		sch_push(id, delay - 1);
+	} else if (job_retain(id)) {
+		sch_push(id, delay, 0);
 	}
 	return id;
 
 }
 
-uint32_t sch_schedule_repeating(uint32_t id, uint32_t delay, uint32_t interval) {
+uint64_t sch_schedule_repeating(uint64_t id, uint32_t delay, uint32_t interval) {
 
 	assert(delay != 0);
 	assert(interval != 0);
 
-	job_work_t* job = utl_id_vector_get(&job_board.heap.jobs, id);
-
-	job->repeat = interval;
-
-	sch_push(id, delay - 1);
+	if (job_retain(id)) {
+		sch_push(id, delay, interval);
+	}
 
 	return id;
 
 }
 
-void sch_cancel(uint32_t id) {
+void sch_cancel(uint64_t id) {
 
-	job_work_t* work = utl_id_vector_get(&job_board.heap.jobs, id);
+	// does nothing if the job was already freed, even if its slot was reused
+	job_cancel(id);
 
-	if (work == NULL) return;
+	// hold a reference so the slot can't be reused while we look at it
+	if (!job_retain(id)) {
+		return;
+	}
 
-	work->repeat = false;
-	work->canceled = true;
+	bool scheduled = false;
+
+	with_lock (&sch_scheduler.lock) {
+
+		sch_entry_t* entry = sch_get_entry_l(id);
+
+		if (entry->bucket != 0) {
+			sch_unlink_l(entry);
+			scheduled = true;
+		}
+
+	}
+
+	// drop the scheduler's reference too if the job was taken out of the wheel
+	if (scheduled) {
+		job_free(id);
+	}
+
+	job_free(id);
 
 }
 
 void sch_tick() {
+
+	uint64_t* due = NULL;
+	uint32_t due_count = 0;
 	
 	with_lock (&sch_scheduler.lock) {
 
-		// get schedule
-		if (sch_scheduler.tape.size == 0) {
-			pthread_mutex_unlock(&sch_scheduler.lock);
-			return;
-		}
+		const uint64_t tick = ++sch_scheduler.tick;
+		uint32_t count;
 
-		utl_vector_t* vector = utl_vector_get(&sch_scheduler.tape, 0);
+		// spread buckets over the levels below them, higher levels first so jobs moving down more than one level are caught by the lower cascades
+		for (uint32_t level = SCH_LEVELS - 1; level > 0; --level) {
+			if ((tick & ((1ull << (SCH_LEVEL_BITS * level)) - 1)) == 0) {
 
-		if (vector->size > 0) {
+				const uint64_t* ids = sch_take_l((level << SCH_LEVEL_BITS) | ((tick >> (SCH_LEVEL_BITS * level)) & SCH_LEVEL_MASK), &count);
 
-			with_lock (&job_board.queue.lock) {
+				for (uint32_t i = 0; i < count; ++i) {
+					sch_link_l(ids[i], &sch_scheduler.entries[job_get_index(ids[i])]);
+				}
+
+			}
+		}
 
-				for (uint32_t i = 0; i < vector->size; ++i) {
+		due = sch_take_l(tick & SCH_LEVEL_MASK, &count);
 
-					uint32_t id = UTL_VECTOR_GET_AS(uint32_t, vector, i);
+		for (uint32_t i = 0; i < count; ++i) {
 
-					job_work_t* scheduled = utl_id_vector_get(&job_board.heap.jobs, id);
+			const uint64_t id = due[i];
+			sch_entry_t* entry = &sch_scheduler.entries[job_get_index(id)];
 
-					if (!scheduled->canceled) {
+			if (entry->expiry > tick) {
 
-						utl_list_push(&job_board.queue.list, &id);
+				// parked in the furthest bucket, not due yet
+				sch_link_l(id, entry);
+				continue;
 
-						if (scheduled->repeat) {
+			}
 
-							sch_push_l(id, scheduled->repeat);
+			due[due_count++] = id;
 
-						}
+			// canceled jobs are skipped when they are handled, a canceled repeating job doesn't get another run
+			if (entry->repeat && !job_is_canceled(id)) {
 
-					} else {
+				// the board gets a new reference, the scheduler keeps its own for the next run
+				job_retain_held(id);
 
-						scheduled->repeat = 0;
-						job_free(id);
+				entry->expiry = tick + entry->repeat;
+				sch_link_l(id, entry);
 
-					}
+			} else {
 
-				}
+				// the scheduler's reference is handed to the board
+				entry->bucket = 0;
 
 			}
 
-			job_resume();
-
 		}
 
-		utl_term_vector(vector);
-		utl_vector_shift(&sch_scheduler.tape);
-
 	}
 
+	// the expired bucket is only reused by the next tick, so it can be handed over outside of the scheduler lock
+	job_add_retained(due, due_count);
+
 }
+
+uint64_t sch_get_tick() {
+
+	return sch_scheduler.tick;
+
+}
\ No newline at end of file
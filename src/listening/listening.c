@@ -1,3 +1,6 @@
+#include <ctype.h>
+#include <errno.h>
+#include <string.h>
 #include <libdeflate.h>
 #include "listening.h"
 #include "../motor.h"
@@ -8,6 +11,7 @@
 #include "../io/io.h"
 #include "../io/chat/chat.h"
 #include "../io/chat/translation.h"
+#include "../io/filesystem/filesystem.h"
 
 // packet handlers
 #include "phd/handshake.h"
@@ -15,263 +19,1754 @@
 #include "phd/login.h"
 #include "phd/play.h"
 
+#ifdef SCK_URING
+#include <sys/eventfd.h>
+#endif
+
+static void ltg_ready(ltg_client_t* client, bool wake);
+static void ltg_remove_client(ltg_client_t* client);
+
+#ifdef SCK_URING
+// what a completion is for, kept in the low bits of the client pointer
+#define LTG_URING_RECV 0
+#define LTG_URING_WRITE 1
+#define LTG_URING_WAKE 2
+#define LTG_URING_TIMEOUT 3
+#define LTG_URING_TAGS 3
+
+static const struct __kernel_timespec ltg_send_timeout = {
+	.tv_sec = LTG_SEND_TIMEOUT / 1000,
+	.tv_nsec = (LTG_SEND_TIMEOUT % 1000) * 1000000
+};
+
+static bool ltg_uring_init(ltg_network_t* network) {
+
+	if (!sck_uring_init(&network->uring.ring, LTG_URING_ENTRIES)) {
+		return false;
+	}
+
+	if (!sck_uring_provide_buffers(&network->uring.ring, 0, LTG_URING_RECV_BUFFERS, LTG_MAX_RECEIVE)) {
+		sck_uring_term(&network->uring.ring);
+		return false;
+	}
+
+	// the kernel keeps the send slots mapped, so writes from them skip the copy into the socket's pages
+	network->uring.slots.memory = malloc((size_t) LTG_URING_SEND_SLOTS * LTG_SEND_CHUNK);
+	network->uring.slots.free = malloc(LTG_URING_SEND_SLOTS * sizeof(uint16_t));
+
+	struct iovec slots[LTG_URING_SEND_SLOTS];
+	for (uint32_t i = 0; i < LTG_URING_SEND_SLOTS; ++i) {
+		slots[i].iov_base = network->uring.slots.memory + (size_t) i * LTG_SEND_CHUNK;
+		slots[i].iov_len = LTG_SEND_CHUNK;
+		network->uring.slots.free[i] = LTG_URING_SEND_SLOTS - 1 - i;
+	}
+	network->uring.slots.free_count = LTG_URING_SEND_SLOTS;
+
+	if (!sck_uring_register_buffers(&network->uring.ring, slots, LTG_URING_SEND_SLOTS)) {
+		sck_uring_term(&network->uring.ring);
+		free(network->uring.slots.memory);
+		free(network->uring.slots.free);
+		return false;
+	}
+
+	pthread_mutex_init(&network->uring.slots.lock, NULL);
+
+	// io_uring waits on blocking files itself, a non-blocking one would just fail the read
+	network->wake = eventfd(0, 0);
+
+	return true;
+
+}
+
+static void ltg_uring_term(ltg_network_t* network) {
+
+	sck_uring_term(&network->uring.ring);
+	close(network->wake);
+
+	free(network->uring.slots.memory);
+	free(network->uring.slots.free);
+	pthread_mutex_destroy(&network->uring.slots.lock);
+
+}
+#else
+// io_uring is linux only, the poller is used instead
+static bool ltg_uring_init(ltg_network_t* network) {
+
+	(void) network;
+	return false;
+
+}
+
+static void ltg_uring_term(ltg_network_t* network) {
+
+	(void) network;
+
+}
+#endif
+
+// get a chunk to queue frames in, registered slots are used while there are free ones
+static void ltg_new_chunk(ltg_network_t* network, ltg_send_chunk_t* chunk, size_t length) {
+
+	chunk->length = 0;
+	chunk->offset = 0;
+	chunk->encrypted = 0;
+	chunk->frames = 0;
+	chunk->slot = -1;
+	chunk->buffer = NULL;
+	chunk->broadcast = NULL;
+	chunk->compressing = false;
+	chunk->capacity = length > LTG_SEND_CHUNK ? length : LTG_SEND_CHUNK;
+
+	if (network->uring.enabled && length <= LTG_SEND_CHUNK) {
+		with_lock (&network->uring.slots.lock) {
+			if (network->uring.slots.free_count != 0) {
+				chunk->slot = network->uring.slots.free[--network->uring.slots.free_count];
+			}
+		}
+	}
+
+	if (chunk->slot < 0) {
+		chunk->buffer = pck_acquire(chunk->capacity, io_big_endian);
+		chunk->bytes = chunk->buffer->bytes;
+	} else {
+		chunk->bytes = network->uring.slots.memory + (size_t) chunk->slot * LTG_SEND_CHUNK;
+	}
+
+}
+
+// give back what a chunk was queued in
+static void ltg_release_chunk(ltg_network_t* network, ltg_send_chunk_t* chunk) {
+
+	if (chunk->broadcast != NULL) {
+		ltg_release_broadcast(chunk->broadcast);
+		return;
+	}
+
+	if (chunk->slot < 0) {
+		pck_release(chunk->buffer);
+		return;
+	}
+
+	with_lock (&network->uring.slots.lock) {
+		network->uring.slots.free[network->uring.slots.free_count++] = chunk->slot;
+	}
+
+}
+
+// forget everything queued for the client, the client's lock is held
+static void ltg_drop_outbound(ltg_network_t* network, ltg_client_t* client) {
+
+	while (client->outbound.chunks.length != 0) {
+		ltg_send_chunk_t* chunk = utl_list_first(&client->outbound.chunks);
+		// the compression thread throws the frame away when it's done with it
+		if (!chunk->compressing) {
+			ltg_release_chunk(network, chunk);
+		}
+		utl_list_shift(&client->outbound.chunks);
+	}
+
+	client->outbound.bytes = 0;
+	client->outbound.dropped = true;
+
+}
+
+// take what was written off the front of the client's queue, the client's lock is held
+static void ltg_written(ltg_network_t* network, ltg_client_t* client, uint32_t written) {
+
+	network->sent.writes++;
+	network->sent.bytes += written;
+	client->outbound.bytes -= written;
+
+	while (written != 0) {
+
+		ltg_send_chunk_t* chunk = utl_list_first(&client->outbound.chunks);
+		const uint32_t left = chunk->length - chunk->offset;
+		const uint32_t part = written < left ? written : left;
+
+		chunk->offset += part;
+		written -= part;
+
+		if (chunk->offset == chunk->length) {
+			network->sent.frames += chunk->frames;
+			ltg_release_chunk(network, chunk);
+			utl_list_shift(&client->outbound.chunks);
+		}
+
+	}
+
+	// caught up, what was held back while the client lagged is sent by a job
+	if (client->outbound.lagging && client->outbound.bytes <= LTG_QUEUE_LOW) {
+		client->outbound.lagging = false;
+		if (client->outbound.held) {
+			client->outbound.held = false;
+			job_add(job_new(job_client_caught_up, (job_payload_t) { .client_id = client->id }));
+		}
+	}
+
+}
+
+// encrypt what was queued in the chunk since it was last written, false if the chunk is still being compressed
+static bool ltg_prepare_chunk(ltg_client_t* client, ltg_send_chunk_t* chunk) {
+
+	if (chunk->compressing) {
+		return false;
+	}
+
+	// chunks are prepared in the order they're written, so the cipher sees the bytes in that order too
+	if (chunk->encrypted < chunk->length) {
+		cfb8_encrypt(&client->encryption.encrypt, chunk->bytes + chunk->encrypted, chunk->length - chunk->encrypted, chunk->bytes + chunk->encrypted);
+		chunk->encrypted = chunk->length;
+	}
+
+	return true;
+
+}
+
 void ltg_init(ltg_listener_t* listener) {
 
-	log_info("Starting listener...");
+	log_info("Starting listener...");
+
+	// generate RSA keypair
+	cry_rsa_gen_key_pair(&listener->keypair);
+
+	// one network thread per networking core by default
+	if (listener->network.count == 0) {
+		listener->network.count = sky_main.affinity.network_cores != 0 ? sky_main.affinity.network_cores : 1;
+	}
+
+	listener->network.threads = calloc(listener->network.count, sizeof(ltg_network_t));
+
+	for (uint32_t i = 0; i < listener->network.count; ++i) {
+
+		ltg_network_t* network = &listener->network.threads[i];
+		network->listener = listener;
+
+		pthread_mutex_init(&network->ready.lock, NULL);
+		utl_init_list(&network->ready.list, sizeof(ltg_client_t*));
+
+		if (listener->network.io_uring) {
+			network->uring.enabled = ltg_uring_init(network);
+			if (!network->uring.enabled) {
+				log_warn("Could not set up io_uring, network thread #%u uses " SCK_POLLER_NAME, i);
+			}
+		}
+
+		if (!network->uring.enabled && !sck_poller_init(&network->poller)) {
+			log_error("Could not set up " SCK_POLLER_NAME " for network thread #%u", i);
+		}
+
+		pthread_create(&network->thread, NULL, t_ltg_network, network);
+
+	}
+
+	// one compression thread per network thread by default
+	if (listener->compression.count == 0) {
+		listener->compression.count = listener->network.count;
+	}
+
+	listener->compression.threads = calloc(listener->compression.count, sizeof(pthread_t));
+
+	for (uint32_t i = 0; i < listener->compression.count; ++i) {
+		pthread_create(&listener->compression.threads[i], NULL, t_ltg_compress, listener);
+	}
+
+	// init sockets
+	if (sck_init() != SCK_OK) {
+		return;
+	}
+
+	// set address
+	listener->address.addr.sin_family = AF_INET;
+	listener->address.addr.sin_addr.s_addr = INADDR_ANY;
+	listener->address.addr.sin_port = io_htons(listener->address.port);
+
+	// one acceptor per network thread by default
+	if (listener->acceptors.count == 0) {
+		listener->acceptors.count = listener->network.count;
+	}
+
+	listener->acceptors.threads = calloc(listener->acceptors.count, sizeof(ltg_acceptor_t));
+
+	uint32_t listening = 0;
+
+	while (listening < listener->acceptors.count) {
+
+		ltg_acceptor_t* acceptor = &listener->acceptors.threads[listening];
+		acceptor->listener = listener;
+		acceptor->socket = sck_create();
+
+		// without SO_REUSEPORT the port only takes one socket
+		const bool shared = sck_set_reuse_port(acceptor->socket) == SCK_OK;
+
+		if (sck_bind(acceptor->socket, (struct sockaddr*) &listener->address.addr, sizeof(struct sockaddr)) != SCK_OK || sck_listen(acceptor->socket) != SCK_OK) {
+			sck_close(acceptor->socket);
+			break;
+		}
+
+		pthread_create(&acceptor->thread, NULL, t_ltg_run, acceptor);
+		listening++;
+
+		if (!shared) {
+			break;
+		}
+
+	}
+
+	listener->acceptors.count = listening;
+
+	if (listening == 0) {
+		log_error("Could not listen on port %u", listener->address.port);
+	} else {
+		log_info("Listening on port %u (%u acceptor threads)", listener->address.port, listening);
+	}
+
+}
+
+// refill the bucket for the time since it was last refilled and take a token from it if there is one
+static bool ltg_take_token(ltg_bucket_t* bucket, uint32_t rate, uint32_t burst, int64_t now) {
+
+	bucket->tokens = UTL_MIN(bucket->tokens + (float32_t) (now - bucket->refilled) * rate / 1000, (float32_t) burst);
+	bucket->refilled = now;
+
+	if (bucket->tokens < 1) {
+		return false;
+	}
+
+	bucket->tokens -= 1;
+
+	return true;
+
+}
+
+// the address's bucket in the table, an address that wasn't seen in a while takes over the least recently used one
+static ltg_bucket_t* ltg_get_bucket(ltg_bucket_t* addresses, uint32_t address, uint32_t burst, int64_t now) {
+
+	const uint32_t start = (address * 0x9E3779B1u) >> (32 - __builtin_ctz(LTG_ADMISSION_ADDRESSES));
+	ltg_bucket_t* oldest = NULL;
+
+	for (uint32_t i = 0; i < LTG_ADMISSION_PROBES; ++i) {
+		ltg_bucket_t* probe = &addresses[(start + i) & (LTG_ADMISSION_ADDRESSES - 1)];
+		if (probe->address == address) {
+			return probe;
+		}
+		if (oldest == NULL || probe->refilled < oldest->refilled) {
+			oldest = probe;
+		}
+	}
+
+	// and starts with a full bucket
+	oldest->address = address;
+	oldest->tokens = burst;
+	oldest->refilled = now;
+
+	return oldest;
+
+}
+
+// proxies on the same machine bring in everyone's connections
+static inline bool ltg_is_loopback(uint32_t address) {
+	return (ntohl(address) >> 24) == 127;
+}
+
+bool ltg_admit(ltg_listener_t* listener, uint32_t address, int64_t now) {
+
+	bool admitted = true;
+
+	with_lock (&listener->admission.lock) {
+
+		const uint32_t rate = listener->admission.address_rate;
+
+		if (rate != 0 && !ltg_is_loopback(address)) {
+
+			ltg_bucket_t* bucket = ltg_get_bucket(listener->admission.addresses, address, listener->admission.address_burst, now);
+
+			admitted = ltg_take_token(bucket, rate, listener->admission.address_burst, now);
+
+			if (!admitted) {
+				listener->admission.throttled_address++;
+			}
+
+		}
+
+		// a flood from one address doesn't use up what everyone else gets
+		if (admitted && listener->admission.rate != 0) {
+
+			admitted = ltg_take_token(&listener->admission.all, listener->admission.rate, listener->admission.burst, now);
+
+			if (!admitted) {
+				listener->admission.throttled++;
+			}
+
+		}
+
+	}
+
+	if (admitted) {
+		listener->admission.admitted++;
+	}
+
+	return admitted;
+
+}
+
+bool ltg_admit_status(ltg_listener_t* listener, uint32_t address, int64_t now) {
+
+	const uint32_t rate = listener->status.rate;
+
+	if (rate == 0 || ltg_is_loopback(address)) {
+		return true;
+	}
+
+	bool admitted = true;
+
+	with_lock (&listener->status.lock) {
+		ltg_bucket_t* bucket = ltg_get_bucket(listener->status.addresses, address, listener->status.burst, now);
+		admitted = ltg_take_token(bucket, rate, listener->status.burst, now);
+	}
+
+	if (!admitted) {
+		listener->status.throttled++;
+	}
+
+	return admitted;
+
+}
+
+ltg_broadcast_t* ltg_get_status(ltg_listener_t* listener, uint32_t* generation) {
+
+	ltg_broadcast_t* response = NULL;
+
+	with_lock (&listener->status.lock) {
+		response = listener->status.response;
+		if (response != NULL) {
+			ltg_retain_broadcast(response);
+		}
+		*generation = listener->status.generation;
+	}
+
+	return response;
+
+}
+
+void ltg_set_status(ltg_listener_t* listener, ltg_broadcast_t* response, uint32_t generation) {
+
+	ltg_broadcast_t* replaced = NULL;
+
+	with_lock (&listener->status.lock) {
+		// a player joined or left while it was built, the next request builds it again
+		if (listener->status.generation == generation) {
+			replaced = listener->status.response;
+			ltg_retain_broadcast(response);
+			listener->status.response = response;
+		}
+	}
+
+	if (replaced != NULL) {
+		ltg_release_broadcast(replaced);
+	}
+
+}
+
+void ltg_invalidate_status(ltg_listener_t* listener) {
+
+	ltg_broadcast_t* response = NULL;
+
+	with_lock (&listener->status.lock) {
+		response = listener->status.response;
+		listener->status.response = NULL;
+		listener->status.generation++;
+	}
+
+	// clients it's queued for still hold it
+	if (response != NULL) {
+		ltg_release_broadcast(response);
+	}
+
+}
+
+void* t_ltg_run(void* args) {
+
+	ltg_acceptor_t* acceptor = args;
+	ltg_listener_t* listener = acceptor->listener;
+
+	// how long to wait before accepting again after a failure, and how many failures weren't warned about yet
+	int64_t backoff = 0;
+	int64_t warned = -LTG_ACCEPT_LOG_INTERVAL;
+	uint32_t failures = 0;
+
+	for (;;) {
+
+		// forever
+
+		int32_t socket;
+		struct sockaddr_in address;
+		int address_size = sizeof(struct sockaddr_in);
+		socket = sck_accept(acceptor->socket, (struct sockaddr*) &address, &address_size);
+
+		if (socket == SCK_FAILED) {
+
+			const int error = errno;
+
+			// the connection was gone before it was taken in, or a signal came in
+			if (error == ECONNABORTED || error == EINTR) {
+				continue;
+			}
+
+			// the listening socket was shut down or closed
+			if (error == EBADF || error == EINVAL) {
+				break;
+			}
+
+			// out of file descriptors, buffers or memory, the connection waits in the backlog until some are freed
+			const int64_t now = ltg_millis();
+			failures++;
+			if (now - warned >= LTG_ACCEPT_LOG_INTERVAL) {
+				log_warn("Could not accept connections (%s), %u tries failed, trying again", strerror(error), failures);
+				warned = now;
+				failures = 0;
+			}
+
+			backoff = backoff == 0 ? LTG_ACCEPT_BACKOFF_MIN : (backoff * 2 < LTG_ACCEPT_BACKOFF_MAX ? backoff * 2 : LTG_ACCEPT_BACKOFF_MAX);
+			const struct timespec wait = {
+				.tv_sec = backoff / 1000,
+				.tv_nsec = (backoff % 1000) * 1000000
+			};
+			nanosleep(&wait, NULL);
+
+			continue;
+
+		}
+
+		backoff = 0;
+
+		if (!ltg_admit(listener, address.sin_addr.s_addr, ltg_millis())) {
+
+			// too many connections, nothing was allocated for this one yet
+			sck_close(socket);
+
+		} else {
+
+			// allocate new client and set address and socket
+			ltg_client_t* client = calloc(1, sizeof(ltg_client_t));
+			client->listener = listener;
+			client->socket = socket;
+			pthread_mutex_init(&client->lock, NULL);
+			client->address.addr = address;
+			client->address.size = address_size;
+			client->state = ltg_handshake;
+			utl_init_list(&client->outbound.chunks, sizeof(ltg_send_chunk_t));
+			utl_init_bit_vector(&client->outbound.stale);
+
+			// accept the client
+			ltg_accept(client);
+
+		}
+	}
+
+	return (void*) 1;
+
+}
+
+// free everything the client holds, only the client's network thread may do this
+static void ltg_free_client(ltg_client_t* client) {
+
+	ltg_network_t* network = client->network;
+
+	// remove from client list, from here on nothing else can find the client
+	with_lock (&client->listener->clients.lock) {
+		utl_id_vector_remove(&client->listener->clients.vector, client->id);
+	}
+
+	pthread_mutex_lock(&client->lock);
+	pthread_mutex_destroy(&client->lock);
+
+	// frames that never made it out
+	ltg_drop_outbound(network, client);
+	utl_term_list(&client->outbound.chunks);
+	utl_term_bit_vector(&client->outbound.stale);
+
+	if (!network->uring.enabled) {
+		sck_poller_remove(&network->poller, client->socket);
+	}
+
+	sck_close(client->socket);
+	network->clients--;
+
+	if (client->capture.file != NULL) {
+		fclose(client->capture.file);
+	}
+
+	free(client->receive.bytes);
+
+	// free username
+	UTL_FREESTR(client->username);
+
+	// free skin
+	UTL_FREESTR(client->textures.value);
+	UTL_FREESTR(client->textures.signature);
+
+	// free encryption key
+	if (client->encryption.enabled) {
+		cfb8_done(&client->encryption.encrypt, &client->encryption.decrypt);
+	}
+
+	free(client);
+
+}
+
+void ltg_accept(ltg_client_t* client) {
+
+	ltg_listener_t* listener = client->listener;
+
+	// lock clients
+	with_lock (&listener->clients.lock) {
+		client->id = utl_id_vector_push(&listener->clients.vector, &client);
+	}
+
+	// give the client to the network thread with the fewest clients
+	ltg_network_t* network = &listener->network.threads[0];
+	for (uint32_t i = 1; i < listener->network.count; ++i) {
+		if (listener->network.threads[i].clients < network->clients) {
+			network = &listener->network.threads[i];
+		}
+	}
+
+	network->clients++;
+	client->network = network;
+	client->thread = network->thread;
+
+	if (network->uring.enabled) {
+		// the network thread arms the first receive
+		ltg_ready(client, true);
+		return;
+	}
+
+	// clients are only read from when their network thread knows there is something to read
+	if (sck_set_blocking(client->socket, false) != SCK_OK) {
+		log_error("Could not make client socket non-blocking");
+		ltg_free_client(client);
+		return;
+	}
+
+	if (!sck_poller_add(&network->poller, client->socket, client)) {
+		// the network thread never heard of the client, so it's still ours to free
+		log_error("Could not add client socket to its network thread");
+		ltg_free_client(client);
+	}
+
+}
+
+// make room to receive into, false if the frame the client is sending can't fit
+static bool ltg_receive_reserve(ltg_client_t* client) {
+
+	// everything was handled, start over at the front and give back what a big frame needed
+	if (client->receive.start == client->receive.end) {
+		if (client->receive.capacity != LTG_RECEIVE_BUFFER) {
+			client->receive.bytes = realloc(client->receive.bytes, LTG_RECEIVE_BUFFER);
+			client->receive.capacity = LTG_RECEIVE_BUFFER;
+		}
+		client->receive.start = client->receive.end = LTG_RECEIVE_HEADROOM;
+	}
+
+	if (client->receive.end < client->receive.capacity) {
+		return true;
+	}
+
+	// move the partial frame to the front
+	if (client->receive.start > LTG_RECEIVE_HEADROOM) {
+		const uint32_t partial = client->receive.end - client->receive.start;
+		memmove(client->receive.bytes + LTG_RECEIVE_HEADROOM, client->receive.bytes + client->receive.start, partial);
+		client->receive.start = LTG_RECEIVE_HEADROOM;
+		client->receive.end = LTG_RECEIVE_HEADROOM + partial;
+		return true;
+	}
+
+	// the partial frame fills the buffer, grow it up to the biggest frame a client may send
+	if (client->receive.capacity >= LTG_RECEIVE_MAX) {
+		return false;
+	}
+
+	client->receive.capacity = client->receive.capacity * 2 < LTG_RECEIVE_MAX ? client->receive.capacity * 2 : LTG_RECEIVE_MAX;
+	client->receive.bytes = realloc(client->receive.bytes, client->receive.capacity);
+
+	return true;
+
+}
+
+/*
+ * Get a packet for the bytes, its header goes over the bytes in front of them, which were already handled
+ * The bytes are moved down a little if that's what it takes for the header to be aligned
+ */
+static inline pck_packet_t* ltg_received_packet(byte_t* bytes, uint32_t length) {
+
+	const size_t misaligned = ((uintptr_t) bytes - offsetof(pck_packet_t, bytes)) & (_Alignof(pck_packet_t) - 1);
+
+	if (misaligned != 0) {
+		memmove(bytes - misaligned, bytes, length);
+		bytes -= misaligned;
+	}
+
+	return (pck_packet_t*) (bytes - offsetof(pck_packet_t, bytes));
+
+}
+
+/*
+ * Handle the complete frames in what the client sent, the rest waits for more
+ * The received bytes must be right after what was received before
+ * If return is false, disconnect the client
+ */
+static bool ltg_handle_received(ltg_client_t* client, uint32_t received) {
+
+	byte_t* const bytes = client->receive.bytes;
+
+	if (client->encryption.enabled && cfb8_decrypt(&client->encryption.decrypt, bytes + client->receive.end, received, bytes + client->receive.end) != 1) {
+		log_error("Decryption failed");
+		return false;
+	}
+
+	client->receive.end += received;
+
+	while (client->receive.start < client->receive.end) {
+
+		byte_t* frame = bytes + client->receive.start;
+		const uint32_t available = client->receive.end - client->receive.start;
+
+		// legacy server list ping, it has no length
+		if (client->state == ltg_handshake && frame[0] == 0xFE) {
+			pck_packet_t* packet = ltg_received_packet(frame, available);
+			packet->cursor = 0;
+			packet->length = available;
+			packet->sub_length = 0xFE;
+			packet->endianness = io_big_endian;
+			client->receive.start = client->receive.end;
+			return ltg_handle_packet(client, packet);
+		}
+
+		size_t length_length;
+		const int32_t length = io_read_var_int(frame, available < 3 ? available : 3, &length_length);
+
+		if (frame[length_length - 1] & 0x80) {
+			if (available < 3) {
+				// the length isn't all here yet
+				break;
+			}
+			log_error("Client sent a frame that is too long");
+			return false;
+		}
+
+		if (length <= 0 || length > LTG_MAX_FRAME) {
+			log_error("Client sent a frame with a bad length (%d)", length);
+			return false;
+		}
+
+		// a connection that doesn't start with a handshake is dropped before its frame is waited for
+		if (client->state == ltg_handshake && (length > PHD_HANDSHAKE_MAX_LENGTH || (available > length_length && frame[length_length] != 0x00))) {
+			return false;
+		}
+
+		if (available < length_length + length) {
+			break;
+		}
+
+		client->receive.start += length_length + length;
+
+		// the frame is read where it was received, not copied out
+		pck_packet_t* packet = ltg_received_packet(frame + length_length, length);
+		packet->cursor = 0;
+		packet->length = packet->sub_length = length;
+		packet->endianness = io_big_endian;
+
+		const bool encrypted = client->encryption.enabled;
+
+		if (!ltg_handle_packet(client, packet)) {
+			return false;
+		}
+
+		// encryption starts right after the packet that enabled it, whatever came with it is still encrypted
+		if (!encrypted && client->encryption.enabled && client->receive.start < client->receive.end) {
+			if (cfb8_decrypt(&client->encryption.decrypt, bytes + client->receive.start, client->receive.end - client->receive.start, bytes + client->receive.start) != 1) {
+				log_error("Decryption failed");
+				return false;
+			}
+		}
+
+	}
+
+	return true;
+
+}
+
+/*
+ * Receive what the client sent
+ * If return is false, disconnect the client
+ */
+static bool ltg_receive(ltg_client_t* client) {
+
+	if (!ltg_receive_reserve(client)) {
+		log_error("Client sent a frame that does not fit");
+		return false;
+	}
+
+	// receive straight into the client's buffer
+	const int32_t length = sck_recv(client->socket, (char*) client->receive.bytes + client->receive.end, client->receive.capacity - client->receive.end);
+
+	if (length == 0) {
+		// client disconnected
+		return false;
+	} else if (length < 0) {
+		// nothing to read after all, or the connection broke
+		return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+	}
+
+	return ltg_handle_received(client, length);
+
+}
+
+bool ltg_receive_bytes(ltg_client_t* client, const byte_t* bytes, uint32_t length) {
+
+	while (length != 0) {
+
+		if (!ltg_receive_reserve(client)) {
+			log_error("Client sent a frame that does not fit");
+			return false;
+		}
+
+		const uint32_t copied = length < client->receive.capacity - client->receive.end ? length : client->receive.capacity - client->receive.end;
+		memcpy(client->receive.bytes + client->receive.end, bytes, copied);
+		bytes += copied;
+		length -= copied;
+
+		if (!ltg_handle_received(client, copied)) {
+			return false;
+		}
+
+	}
+
+	return true;
+
+}
+
+// wake the network thread up from waiting on its sockets
+static bool ltg_wake(ltg_network_t* network) {
+
+#ifdef SCK_URING
+	if (network->uring.enabled) {
+		const uint64_t value = 1;
+		return write(network->wake, &value, sizeof(value)) == sizeof(value);
+	}
+#endif
+
+	return sck_poller_wake(&network->poller);
+
+}
+
+// put the client on its network thread's ready list, waking the thread up if asked to
+static void ltg_ready(ltg_client_t* client, bool wake) {
+
+	ltg_network_t* network = client->network;
+
+	with_lock (&network->ready.lock) {
+		if (!client->outbound.ready) {
+			client->outbound.ready = true;
+			utl_list_push(&network->ready.list, &client);
+		}
+	}
+
+	if (wake && pthread_self() != network->thread && !ltg_wake(network)) {
+		log_error("Could not wake network thread");
+	}
+
+}
+
+void ltg_wake_client(ltg_client_t* client) {
+
+	ltg_ready(client, true);
+
+}
+
+// take the next client off the ready list, NULL once it's empty
+static ltg_client_t* ltg_next_ready(ltg_network_t* network) {
+
+	ltg_client_t* client = NULL;
+
+	with_lock (&network->ready.lock) {
+		if (network->ready.list.length != 0) {
+			client = *(ltg_client_t**) utl_list_first(&network->ready.list);
+			utl_list_shift(&network->ready.list);
+			client->outbound.ready = false;
+		}
+	}
+
+	return client;
+
+}
+
+// pick the login back up once the session server has answered
+static void ltg_resume_auth(ltg_client_t* client) {
+
+	if (!client->auth.pending) {
+		return;
+	}
+
+	phd_auth_t* auth = NULL;
+
+	with_lock (&client->lock) {
+		auth = client->auth.finished;
+		client->auth.finished = NULL;
+	}
+
+	if (auth == NULL) {
+		return;
+	}
+
+	client->auth.pending = false;
+
+	if (!phd_finish_auth(client, auth)) {
+		ltg_disconnect(client);
+	}
+
+}
+
+// free the client once nothing can reach it anymore, if it's on the ready list it's freed when it's taken off
+static void ltg_release_client(ltg_network_t* network, ltg_client_t* client) {
+
+	bool ready = false;
+
+	with_lock (&network->ready.lock) {
+		ready = client->outbound.ready;
+	}
+
+	if (!ready) {
+		ltg_remove_client(client);
+	}
+
+}
+
+#ifdef SCK_URING
+// give the kernel what the client needs next, and free the client once it's done with it
+static void ltg_uring_update(ltg_network_t* network, ltg_client_t* client) {
+
+	sck_uring_t* ring = &network->uring.ring;
+	const uint64_t data = (uint64_t) (uintptr_t) client;
+
+	bool disconnect = false;
+	bool shut = false;
+	uint32_t compressing = 0;
+
+	with_lock (&client->lock) {
+
+		// the queue of a client that fell too far behind is thrown away, once the kernel isn't writing from it
+		if (client->outbound.overflowed && !client->uring.writing) {
+			ltg_drop_outbound(network, client);
+		}
+
+		disconnect = client->outbound.disconnect;
+		compressing = client->outbound.compressing;
+
+		ltg_send_chunk_t* chunk = client->outbound.chunks.length != 0 ? utl_list_first(&client->outbound.chunks) : NULL;
+
+		// a frame that's still being compressed holds up the rest, the compression thread wakes us up when it's done
+		if (!client->uring.closed && !client->uring.writing && chunk != NULL && ltg_prepare_chunk(client, chunk)) {
+
+			// frames queued after the write was submitted go out with the next one
+			client->uring.writing = true;
+			client->uring.pending++;
+
+			if (chunk->slot < 0) {
+				sck_uring_send(ring, client->socket, chunk->bytes + chunk->offset, chunk->length - chunk->offset, data | LTG_URING_WRITE, &ltg_send_timeout, LTG_URING_TIMEOUT);
+			} else {
+				sck_uring_write_fixed(ring, client->socket, chunk->bytes + chunk->offset, chunk->length - chunk->offset, chunk->slot, data | LTG_URING_WRITE, &ltg_send_timeout, LTG_URING_TIMEOUT);
+			}
+
+		} else if (!client->uring.closed && !client->uring.writing && chunk == NULL && disconnect) {
+			shut = true;
+		}
+
+	}
+
+	if (!client->uring.closed && !client->uring.receiving && !disconnect) {
+		client->uring.receiving = true;
+		client->uring.pending++;
+		sck_uring_recv_multishot(ring, client->socket, data | LTG_URING_RECV);
+	}
+
+	if (shut) {
+		// ends the receive, so the kernel lets go of the client
+		sck_shutdown(client->socket);
+		client->uring.closed = true;
+	}
+
+	if (client->uring.closed && client->uring.pending == 0 && compressing == 0 && !client->auth.pending) {
+		ltg_release_client(network, client);
+	}
+
+}
+
+static void ltg_uring_receive(ltg_network_t* network, ltg_client_t* client, const struct io_uring_cqe* cqe) {
+
+	sck_uring_t* ring = &network->uring.ring;
+
+	// multishot receives keep going until they say otherwise
+	if (!(cqe->flags & IORING_CQE_F_MORE)) {
+		client->uring.receiving = false;
+		client->uring.pending--;
+	}
+
+	if (cqe->res > 0 && (cqe->flags & IORING_CQE_F_BUFFER)) {
+
+		const uint16_t id = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+
+		// the kernel picked the buffer, so the bytes are copied over to the client's
+		if (!client->uring.closed && !ltg_receive_bytes(client, sck_uring_get_recv_buffer(ring, id), cqe->res)) {
+			ltg_disconnect(client);
+		}
+
+		sck_uring_return_buffer(ring, id);
+		return;
+
+	}
+
+	// out of buffers, the receive is armed again when the client is updated
+	if (cqe->res == -ENOBUFS) {
+		return;
+	}
+
+	// the client left or the connection broke
+	if (!client->uring.closed) {
+		ltg_disconnect(client);
+	}
+
+}
+
+static void ltg_uring_written(ltg_network_t* network, ltg_client_t* client, int32_t result) {
+
+	client->uring.pending--;
+
+	with_lock (&client->lock) {
+
+		client->uring.writing = false;
+
+		if (result > 0) {
+			// short writes carry on from where they stopped
+			ltg_written(network, client, result);
+		} else {
+			// the client is gone or has stopped reading, nothing queued will make it there
+			ltg_drop_outbound(network, client);
+			client->outbound.disconnect = true;
+		}
+
+	}
+
+}
+
+static void ltg_uring_run(ltg_network_t* network) {
+
+	ltg_listener_t* listener = network->listener;
+	sck_uring_t* ring = &network->uring.ring;
+
+	sck_uring_read(ring, network->wake, &network->uring.wake, sizeof(network->uring.wake), LTG_URING_WAKE);
+
+	// keep going until the listener stops and every client is gone
+	while (!listener->network.stopping || network->clients != 0) {
+
+		// everything the ready clients need goes into one submit
+		ltg_client_t* client;
+		while ((client = ltg_next_ready(network)) != NULL) {
+			ltg_resume_auth(client);
+			ltg_uring_update(network, client);
+		}
+
+		// the last client may have just been freed, nothing would wake us up again
+		if (listener->network.stopping && network->clients == 0) {
+			break;
+		}
+
+		if (sck_uring_submit(ring, true) < 0) {
+			log_error("Network thread could not submit to io_uring");
+			break;
+		}
+
+		struct io_uring_cqe cqe;
+
+		while (sck_uring_next(ring, &cqe)) {
+
+			ltg_client_t* client = (ltg_client_t*) (uintptr_t) (cqe.user_data & ~(uint64_t) LTG_URING_TAGS);
+
+			switch (cqe.user_data & LTG_URING_TAGS) {
+				case LTG_URING_WAKE: {
+					// woken up to submit writes or to check if we're stopping
+					sck_uring_read(ring, network->wake, &network->uring.wake, sizeof(network->uring.wake), LTG_URING_WAKE);
+				} break;
+				case LTG_URING_RECV: {
+					network->client = client;
+					ltg_uring_receive(network, client, &cqe);
+					network->client = NULL;
+					ltg_uring_update(network, client);
+				} break;
+				case LTG_URING_WRITE: {
+					ltg_uring_written(network, client, cqe.res);
+					ltg_uring_update(network, client);
+				} break;
+				default: {
+					// send timeouts are seen through their writes
+				} break;
+			}
+
+		}
+
+	}
+
+}
+#endif
+
+// write as much of the client's queue as its socket takes in, false if the client can't be written to anymore
+// full is set if the socket didn't have room for all of it
+static bool ltg_poller_write(ltg_network_t* network, ltg_client_t* client, bool* full) {
+
+	utl_list_t* chunks = &client->outbound.chunks;
+
+	*full = false;
+
+	while (chunks->length != 0) {
+
+		// the chunks go out together, as many frames as fit in the socket with one call
+		struct iovec vectors[LTG_MAX_IOVECS];
+		int32_t count = 0;
+		size_t total = 0;
+
+		for (uint32_t i = 0, node = chunks->first; i < chunks->length && count < LTG_MAX_IOVECS; ++i, node = utl_list_next(chunks, node)) {
+			ltg_send_chunk_t* chunk = utl_list_get(chunks, node);
+			if (!ltg_prepare_chunk(client, chunk)) {
+				break;
+			}
+			vectors[count].iov_base = chunk->bytes + chunk->offset;
+			vectors[count].iov_len = chunk->length - chunk->offset;
+			total += vectors[count].iov_len;
+			count++;
+		}
+
+		// the rest waits for a compression thread, which wakes us up when it's done
+		if (count == 0) {
+			return true;
+		}
+
+		const int32_t sent = sck_send_vector(client->socket, vectors, count);
+
+		if (sent < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			*full = true;
+			return errno == EAGAIN || errno == EWOULDBLOCK;
+		}
+
+		ltg_written(network, client, sent);
+
+		// the socket is full, the rest waits until it has room
+		if ((size_t) sent < total) {
+			*full = true;
+			return true;
+		}
+
+	}
+
+	return true;
+
+}
+
+// write what's queued for the client, and free the client once it's being disconnected
+static void ltg_poller_update(ltg_network_t* network, ltg_client_t* client) {
+
+	bool disconnect = false;
+
+	with_lock (&client->lock) {
+
+		bool full = false;
+
+		// the queue of a client that fell too far behind is thrown away instead of written
+		if (client->outbound.overflowed) {
+			ltg_drop_outbound(network, client);
+		}
+
+		if (!ltg_poller_write(network, client, &full)) {
+			// the client is gone or has stopped reading, nothing queued will make it there
+			ltg_drop_outbound(network, client);
+			client->outbound.disconnect = true;
+		}
+
+		// the compression threads or the auth thread still have the client, the last one to finish wakes us up again
+		disconnect = client->outbound.disconnect && client->outbound.compressing == 0 && !client->auth.pending;
+
+		// wait for the socket to have room only while there's something left to write
+		const bool polling = !client->outbound.disconnect && full;
+
+		if (polling != client->outbound.polling) {
+			client->outbound.polling = polling;
+			sck_poller_set_writable(&network->poller, client->socket, client, polling);
+		}
+
+	}
+
+	if (disconnect) {
+		// a client being disconnected only gets what fits in its socket right away
+		sck_shutdown(client->socket);
+		ltg_release_client(network, client);
+	}
+
+}
+
+void* t_ltg_network(void* args) {
+
+	ltg_network_t* network = args;
+	ltg_listener_t* listener = network->listener;
+
+#ifdef SCK_URING
+	if (network->uring.enabled) {
+		ltg_uring_run(network);
+		return NULL;
+	}
+#endif
+
+	sck_poll_event_t events[LTG_MAX_EVENTS];
+
+	// keep going until the listener stops and every client is gone
+	while (!listener->network.stopping || network->clients != 0) {
+
+		// woken up to write or to check if we're stopping when there are no events
+		const int32_t count = sck_poller_wait(&network->poller, events, LTG_MAX_EVENTS);
+
+		if (count < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			log_error("Network thread could not wait for sockets");
+			break;
+		}
+
+		for (int32_t i = 0; i < count; ++i) {
+
+			ltg_client_t* client = events[i].data;
+
+			// the client is freed before the next wait, what it sends until then doesn't matter
+			if (client->outbound.disconnect) {
+				continue;
+			}
+
+			// there's room in the socket for the rest of the queue
+			if (events[i].writable) {
+				ltg_ready(client, false);
+			}
+
+			if (!events[i].readable) {
+				continue;
+			}
+
+			network->client = client;
+
+			if (!ltg_receive(client)) {
+				ltg_disconnect(client);
+			}
+
+			network->client = NULL;
+
+		}
+
+		// what was queued since the last wait is written before waiting again
+		ltg_client_t* client;
+		while ((client = ltg_next_ready(network)) != NULL) {
+			ltg_resume_auth(client);
+			ltg_poller_update(network, client);
+		}
+
+	}
+
+	return NULL;
+
+}
+
+// each thread that compresses or decompresses keeps what it used until it exits, instead of each client keeping its own
+typedef struct {
+
+	struct libdeflate_compressor* compressors[LTG_COMPRESSION_LEVELS];
+	struct libdeflate_decompressor* decompressor;
+
+} ltg_deflate_t;
+
+static pthread_key_t ltg_deflate;
+static pthread_once_t ltg_deflate_once = PTHREAD_ONCE_INIT;
+
+static void ltg_free_deflate(void* args) {
+
+	ltg_deflate_t* deflate = args;
+
+	for (uint32_t i = 0; i < LTG_COMPRESSION_LEVELS; ++i) {
+		libdeflate_free_compressor(deflate->compressors[i]);
+	}
+	libdeflate_free_decompressor(deflate->decompressor);
+
+	free(deflate);
+
+}
+
+static void ltg_init_deflate() {
+
+	pthread_key_create(&ltg_deflate, ltg_free_deflate);
+
+}
+
+static ltg_deflate_t* ltg_get_deflate() {
+
+	pthread_once(&ltg_deflate_once, ltg_init_deflate);
+
+	ltg_deflate_t* deflate = pthread_getspecific(ltg_deflate);
+	if (deflate == NULL) {
+		deflate = calloc(1, sizeof(ltg_deflate_t));
+		pthread_setspecific(ltg_deflate, deflate);
+	}
+
+	return deflate;
+
+}
+
+static struct libdeflate_compressor* ltg_get_compressor(int32_t level) {
+
+	ltg_deflate_t* deflate = ltg_get_deflate();
+
+	if (deflate->compressors[level] == NULL) {
+		deflate->compressors[level] = libdeflate_alloc_compressor(level);
+	}
+
+	return deflate->compressors[level];
+
+}
+
+static struct libdeflate_decompressor* ltg_get_decompressor() {
+
+	ltg_deflate_t* deflate = ltg_get_deflate();
+
+	if (deflate->decompressor == NULL) {
+		deflate->decompressor = libdeflate_alloc_decompressor();
+	}
+
+	return deflate->decompressor;
+
+}
+
+static void ltg_open_capture(ltg_client_t* client) {
+
+	if (!fs_dir_exists(LTG_CAPTURE_DIRECTORY)) {
+		fs_mkdir(LTG_CAPTURE_DIRECTORY);
+	}
+
+	// offline names aren't checked, so they're kept out of the path
+	char name[17] = { 0 };
+	for (uint32_t i = 0; i < 16 && i < client->username.length; ++i) {
+		const char c = client->username.value[i];
+		name[i] = isalnum((unsigned char) c) ? c : '_';
+	}
+
+	char path[64];
+	sprintf(path, LTG_CAPTURE_DIRECTORY "/%s-%ld.mcap", name, (long) time(NULL));
+
+	client->capture.file = fopen(path, "wb");
+
+	if (client->capture.file == NULL) {
+		log_error("Could not open '%s' for writing!", path);
+		client->capture.requested = false;
+		return;
+	}
+
+	byte_t header[10];
+	memcpy(header, LTG_CAPTURE_MAGIC, 4);
+	header[4] = LTG_CAPTURE_VERSION;
+	const size_t header_length = 5 + io_write_var_int(header + 5, sky_get_protocol(), 5);
+	fwrite(header, header_length, 1, client->capture.file);
+
+	client->capture.last = ltg_millis();
+	client->listener->capture.files++;
+
+	log_info("Capturing %s to '%s'", client->username.value, path);
+
+}
+
+// write the frame to the client's capture, decrypted and decompressed
+static void ltg_capture(ltg_client_t* client, pck_packet_t* packet) {
+
+	if (client->capture.requested && client->capture.file == NULL) {
+		ltg_open_capture(client);
+	} else if (!client->capture.requested && client->capture.file != NULL) {
+		fclose(client->capture.file);
+		client->capture.file = NULL;
+	}
+
+	if (client->capture.file == NULL) {
+		return;
+	}
+
+	const int64_t now = ltg_millis();
+	const size_t length = packet->length - packet->cursor;
+
+	byte_t header[10];
+	size_t header_length = io_write_var_int(header, now - client->capture.last, 5);
+	header_length += io_write_var_int(header + header_length, length, 5);
+
+	fwrite(header, header_length, 1, client->capture.file);
+	fwrite(pck_cursor(packet), length, 1, client->capture.file);
+
+	client->capture.last = now;
+	client->listener->capture.frames++;
+	client->listener->capture.bytes += header_length + length;
+
+}
+
+// give the packet to the handlers of the client's state
+static bool ltg_dispatch(ltg_client_t* client, pck_packet_t* packet) {
+
+	switch (client->state) {
+		case ltg_handshake: {
+			return phd_handshake(client, packet);
+		}
+		case ltg_status: {
+			return phd_status(client, packet);
+		}
+		case ltg_login: {
+			return phd_login(client, packet);
+		}
+		case ltg_play: {
+			ltg_capture(client, packet);
+			return phd_play(client, packet);
+		}
+		default: {
+			log_warn("Client is in an unknown state! (%d)", client->state);
+			return false;
+		}
+	}
+
+}
 
-	// generate RSA keypair
-	cry_rsa_gen_key_pair(&listener->keypair);
+/*
+ * Handle one complete frame, without its length
+ * If return is false, disconnect the client
+ */
+bool ltg_handle_packet(ltg_client_t* client, pck_packet_t* packet) {
 
-	// start listening thread
-	pthread_create(&listener->thread, NULL, t_ltg_run, listener);
+	if (!client->compression_enabled) {
+		return ltg_dispatch(client, packet);
+	}
+
+	const int32_t data_length = pck_read_var_int(packet);
+
+	if (data_length == 0) { // uncompressed
+		packet->sub_length = packet->length - packet->cursor;
+		return ltg_dispatch(client, packet);
+	}
+
+	if (data_length < 0 || data_length > LTG_MAX_FRAME) {
+		log_error("Client sent a corrupt packet! (2)");
+		return false;
+	}
+
+	pck_packet_t* decompressed = pck_acquire(data_length, io_big_endian);
+
+	// it's zlib compression time
+	size_t actual_length = 0;
+	if (libdeflate_zlib_decompress(ltg_get_decompressor(), pck_cursor(packet), packet->length - packet->cursor, pck_cursor(decompressed), data_length, &actual_length) != LIBDEFLATE_SUCCESS) {
+		log_error("Client sent a corrupt packet! (0)");
+		pck_release(decompressed);
+		return false;
+	}
+
+	if (actual_length != (unsigned) data_length) {
+		log_error("Client sent a corrupt packet! (1)");
+		pck_release(decompressed);
+		return false;
+	}
+
+	decompressed->sub_length = decompressed->length = actual_length;
+
+	const bool handled = ltg_dispatch(client, decompressed);
+
+	pck_release(decompressed);
+
+	return handled;
 
 }
 
-void* t_ltg_run(void* args) {
+// count bytes just queued for the client, the client's lock is held
+static inline void ltg_queued(ltg_client_t* client, uint32_t length) {
 
-	ltg_listener_t* listener = args;
+	const uint32_t queued = client->outbound.bytes;
+	client->outbound.bytes += length;
 
-	// init sockets
-	if (sck_init() != SCK_OK) {
-		return NULL;
+	// a client is lagging from when its queue goes over the high mark until it is written down to the low mark
+	if (!client->outbound.lagging && client->outbound.bytes >= LTG_QUEUE_HIGH) {
+		client->outbound.lagging = true;
+		client->outbound.lagging_since = ltg_millis();
+		client->listener->backpressure.lagged++;
 	}
 
-	// create socket
-	listener->address.socket = sck_create();
+	// a client that fell too far behind isn't going to catch up
+	if (client->outbound.lagging && !client->outbound.overflowed && (client->outbound.bytes >= LTG_QUEUE_MAX || ltg_millis() - client->outbound.lagging_since >= LTG_LAG_TIMEOUT)) {
+		log_warn("Disconnecting %s, it fell %u bytes behind", client->username.value != NULL ? client->username.value : "a client", client->outbound.bytes);
+		client->listener->backpressure.disconnected++;
+		client->outbound.overflowed = true;
+		client->outbound.disconnect = true;
+		ltg_ready(client, true);
+		return;
+	}
 
-	// set address
-	listener->address.addr.sin_family = AF_INET;
-	listener->address.addr.sin_addr.s_addr = INADDR_ANY;
-	listener->address.addr.sin_port = io_htons(listener->address.port);
+	// the queue is written at the end of the tick, unless it gets big before then
+	ltg_ready(client, queued < LTG_FLUSH_THRESHOLD && client->outbound.bytes >= LTG_FLUSH_THRESHOLD);
 
-	// bind socket
-	if (sck_bind(listener->address.socket, (struct sockaddr*) &listener->address.addr, sizeof(struct sockaddr)) != SCK_OK) {
-		return NULL;
+}
+
+// queue a frame for the client's network thread, the client's lock is held
+static void ltg_enqueue(ltg_client_t* client, const byte_t* bytes, size_t length) {
+
+	// nothing more reaches a client that is being disconnected
+	if (client->outbound.disconnect) {
+		return;
 	}
 
-	// listen
-	if (sck_listen(listener->address.socket) != SCK_OK) {
-		return NULL;
+	utl_list_t* chunks = &client->outbound.chunks;
+	ltg_send_chunk_t* chunk = chunks->length != 0 ? utl_list_last(chunks) : NULL;
+
+	if (chunk == NULL || chunk->capacity - chunk->length < length) {
+		ltg_send_chunk_t next;
+		ltg_new_chunk(client->network, &next, length);
+		utl_list_push(chunks, &next);
+		chunk = utl_list_last(chunks);
 	}
-	log_info("Listening on port %u", listener->address.port);
 
-	for (;;) {
+	memcpy(chunk->bytes + chunk->length, bytes, length);
 
-		// forever
+	chunk->length += length;
+	chunk->frames++;
 
-		int32_t socket;
-		struct sockaddr_in address;
-		int address_size = sizeof(struct sockaddr_in);
-		socket = sck_accept(listener->address.socket, (struct sockaddr*) &address, &address_size);
+	// the network thread encrypts what's queued right before writing it
+	if (!client->encryption.enabled) {
+		chunk->encrypted = chunk->length;
+	}
 
-		if (socket == SCK_FAILED) {
+	ltg_queued(client, length);
 
-			// something failed when connecting a client
-			break;
+}
 
-		} else {
+// frame a packet for a client with compression without compressing it, out needs room for 5 more bytes than the packet
+static size_t ltg_uncompressed_frame(const byte_t* bytes, size_t length, byte_t* out) {
 
-			// allocate new client and set address and socket
-			ltg_client_t* client = calloc(1, sizeof(ltg_client_t));
-			client->listener = listener;
-			client->socket = socket;
-			pthread_mutex_init(&client->lock, NULL);
-			client->address.addr = address;
-			client->address.size = address_size;
-			client->state = ltg_handshake;
+	const size_t length_length = io_var_int_length(length + 1);
 
-			// accept the client
-			ltg_accept(client);
+	io_write_var_int(out, length + 1, 5);
+	out[length_length] = 0;
+	memcpy(out + length_length + 1, bytes, length);
 
-		}
+	return length + length_length + 1;
+
+}
+
+// compress a packet into a frame for a client with compression, out needs room for 10 more bytes than the packet
+// returns the length of the frame, 0 if compressing didn't make it smaller
+static size_t ltg_compress_frame(struct libdeflate_compressor* compressor, const byte_t* bytes, size_t length, byte_t* out, byte_t** frame) {
+
+	const size_t compressed_length = libdeflate_zlib_compress(compressor, bytes, length, out + 10, length);
+
+	if (compressed_length == 0) {
+		return 0;
 	}
 
-	return (void*) 1;
+	const size_t data_length_length = io_var_int_length(length);
+	const size_t packet_length_length = io_var_int_length(compressed_length + data_length_length);
+
+	*frame = out + 10 - data_length_length - packet_length_length;
+	io_write_var_int(*frame, compressed_length + data_length_length, 5);
+	io_write_var_int(*frame + packet_length_length, length, 5);
+
+	return compressed_length + data_length_length + packet_length_length;
 
 }
 
-void ltg_accept(ltg_client_t* client) {
+// how hard to compress a packet, the busier the ticks the faster the level
+static int32_t ltg_compression_level(byte_t id) {
 
-	// lock clients
-	with_lock (&client->listener->clients.lock) {
-		client->id = utl_id_vector_push(&client->listener->clients.vector, &client);
+	const float64_t load = sky_get_average_mspt() / (SKY_NANOS_PER_TICK / 1000000.0);
+
+	// chunks and light are most of what's sent, and higher levels take much longer on them for little
+	const bool bulk = id == 0x22 || id == 0x25;
+
+	if (load > 0.75) {
+		return 1;
+	} else if (load > 0.5) {
+		return bulk ? 2 : 4;
+	} else if (load > 0.25) {
+		return bulk ? 4 : 6;
 	}
 
-	// create client listening thread
-	pthread_create(&client->thread, NULL, t_ltg_client, client);
+	return bulk ? 6 : 9;
 
 }
 
-void* t_ltg_client(void* args) {
+// compress a packet into a frame for clients with compression, out needs room for 10 more bytes than the packet
+// returns the length of the frame, 0 if the packet is better sent uncompressed
+static size_t ltg_deflate_frame(const byte_t* bytes, size_t length, byte_t* out, byte_t** frame) {
 
-	ltg_client_t* client = args;
+	ltg_listener_t* listener = sky_get_listener();
 
-	// create receive packet (on stack)
-	PCK_INLINE(recvd, LTG_MAX_RECEIVE, io_big_endian);
+	// the id is the first byte for every packet the server sends
+	const byte_t id = bytes[0] & 0x7F;
+	_Atomic uint32_t* incompressible = &listener->compression.incompressible[id];
 
-	for (;;) {
+	// a packet type that keeps not getting smaller is sent uncompressed, with a try every so often to see if that's still so
+	const uint32_t streak = *incompressible;
+	if (streak >= LTG_INCOMPRESSIBLE_STREAK && (streak + 1) % LTG_INCOMPRESSIBLE_RETRY != 0) {
+		(*incompressible)++;
+		listener->compression.raw++;
+		return 0;
+	}
 
-		// receive packet
-		recvd->length = sck_recv(client->socket, (char*) recvd->bytes, LTG_MAX_RECEIVE);
+	const size_t frame_length = ltg_compress_frame(ltg_get_compressor(ltg_compression_level(id)), bytes, length, out, frame);
 
-		if ((int32_t) recvd->length <= 0) {
-			// client disconnected
-			break;
-		} else {
-			// handle packet
-			recvd->cursor = 0;
-
-			if (client->encryption.enabled) {
-				PCK_INLINE(decrypted, recvd->length, io_big_endian);
-				if (cfb8_decrypt(client->encryption.decrypt, recvd->bytes, recvd->length, decrypted->bytes) != 1) {
-					log_error("Decryption failed");
-					break;
-				}
-				decrypted->length = recvd->length;
+	// barely smaller isn't worth the client decompressing it
+	if (frame_length == 0 || frame_length > length - length / 16) {
+		(*incompressible)++;
+		listener->compression.raw++;
+		return 0;
+	}
 
-				if (!ltg_handle_packet(client, decrypted)) {
-					break;
-				}
-			} else {
-				if (!ltg_handle_packet(client, recvd)) {
-					break;
-				}
-			}
+	*incompressible = 0;
+	listener->compression.frames++;
+	listener->compression.bytes += length;
+	listener->compression.compressed += frame_length;
 
-		}
+	return frame_length;
+
+}
+
+// hand the packet to a compression thread and hold its place in the queue, the client's lock is held
+static void ltg_enqueue_compressed(ltg_client_t* client, const byte_t* bytes, size_t length) {
+
+	// nothing more reaches a client that is being disconnected
+	if (client->outbound.disconnect) {
+		return;
 	}
 
-	ltg_disconnect(client);
+	ltg_listener_t* listener = client->listener;
+
+	ltg_compression_t compression = {
+		.client = client,
+		.packet = pck_acquire(length, io_big_endian),
+		.encrypt = client->encryption.enabled
+	};
+	memcpy(compression.packet->bytes, bytes, length);
+
+	// nothing fits in the chunk, so later frames are queued after it
+	ltg_send_chunk_t chunk = {
+		.bytes = NULL,
+		.length = 0,
+		.capacity = 0,
+		.offset = 0,
+		.encrypted = 0,
+		.frames = 0,
+		.slot = -1,
+		.buffer = NULL,
+		.broadcast = NULL,
+		.compressing = true
+	};
+	utl_list_push(&client->outbound.chunks, &chunk);
+	compression.node = client->outbound.chunks.last;
+	client->outbound.compressing++;
+
+	with_lock (&listener->compression.lock) {
+		utl_list_push(&listener->compression.queue, &compression);
+		pthread_cond_signal(&listener->compression.wait);
+	}
 
-	return NULL;
 }
 
-/*
- * Handle packets
- * If return is false, disconnect the client
- */
-bool ltg_handle_packet(ltg_client_t* client, pck_packet_t* packet) {
+// compress a packet and put the frame where its place in the client's queue is
+static void ltg_compress(ltg_compression_t* compression) {
 
-	size_t next_packet = 0;
+	ltg_client_t* client = compression->client;
+	pck_packet_t* packet = compression->packet;
 
-	do {
-		packet->cursor = next_packet;
+	// the frame is written from where it was compressed to
+	pck_packet_t* out = pck_acquire(packet->length + 10, io_big_endian);
+	byte_t* frame = NULL;
 
-		if (client->compression_enabled) {
-			const int32_t packet_length = pck_read_var_int(packet);
-			const size_t length_ptr = packet->cursor;
-			const int32_t data_length = pck_read_var_int(packet);
+	size_t frame_length = ltg_deflate_frame(packet->bytes, packet->length, out->bytes, &frame);
 
-			if (data_length == 0) { // uncompressed
-				packet->sub_length = packet_length - 1;
-				next_packet = packet->cursor + packet->sub_length;
-			} else {
-				packet->sub_length = data_length;
-				next_packet = length_ptr + packet_length;
-
-				PCK_INLINE(decompressed, data_length, io_big_endian);
-				
-				// it's zlib compression time
-				if (client->compression.decompressor == NULL) {
-					client->compression.decompressor = libdeflate_alloc_decompressor();
-				}
+	if (frame_length == 0) {
+		frame = out->bytes;
+		frame_length = ltg_uncompressed_frame(packet->bytes, packet->length, out->bytes);
+	}
 
-				size_t actual_length = 0;
-				if (libdeflate_zlib_decompress(client->compression.decompressor, pck_cursor(packet), packet_length - (packet->cursor - length_ptr), pck_cursor(decompressed), data_length, &actual_length) != LIBDEFLATE_SUCCESS) {
-					log_error("Client sent a corrupt packet! (0)");
-					return false;
-				}
+	pck_release(packet);
 
-				if (actual_length != (unsigned) data_length) {
-					log_error("Client sent a corrupt packet! (1)");
-					return false;
-				}
+	bool dropped = false;
 
-				decompressed->sub_length = decompressed->length =  actual_length;
-
-				switch (client->state) {
-					case ltg_handshake: {
-						if (!phd_handshake(client, decompressed)) {
-							return false;
-						}
-					} break;
-					case ltg_status: {
-						if (!phd_status(client, decompressed)) {
-							return false;
-						}
-					} break;
-					case ltg_login: {
-						if (!phd_login(client, decompressed)) {
-							return false;
-						}
-					} break;
-					case ltg_play: {
-						if (!phd_play(client, decompressed)) {
-							return false;
-						}
-					} break;
-					default: {
-						log_warn("Client is in an unknown state! (%d)", client->state);
-						return false;
-					}
-				}
+	with_lock (&client->lock) {
 
-				continue;
+		client->outbound.compressing--;
+		dropped = client->outbound.dropped;
+
+		if (!dropped) {
+
+			ltg_send_chunk_t* chunk = utl_list_get(&client->outbound.chunks, compression->node);
+			chunk->bytes = frame;
+			chunk->buffer = out;
+			chunk->length = chunk->capacity = frame_length;
+			chunk->encrypted = compression->encrypt ? 0 : frame_length;
+			chunk->frames = 1;
+			chunk->compressing = false;
+
+			ltg_queued(client, frame_length);
 
-			}
-		} else {
-			packet->sub_length = pck_read_var_int(packet);
-			next_packet = packet->cursor + packet->sub_length;
 		}
 
-		switch (client->state) {
-			case ltg_handshake: {
-				if (!phd_handshake(client, packet)) {
-					return false;
-				}
-			} break;
-			case ltg_status: {
-				if (!phd_status(client, packet)) {
-					return false;
-				}
-			} break;
-			case ltg_login: {
-				if (!phd_login(client, packet)) {
-					return false;
-				}
-			} break;
-			case ltg_play: {
-				if (!phd_play(client, packet)) {
-					return false;
-				}
-			} break;
-			default: {
-				log_warn("Client is in an unknown state! (%d)", client->state);
-				return false;
-			}
+		// the network thread may have written everything up to the frame already, or be waiting to free the client
+		if (dropped || compression->node == client->outbound.chunks.first || client->outbound.disconnect) {
+			ltg_ready(client, true);
 		}
-	} while (next_packet < packet->length);
 
-	return true;
+	}
+
+	if (dropped) {
+		pck_release(out);
+	}
 
 }
 
-// send encryption step (used in compressed and uncompressed)
-static inline void ltg_send_e(ltg_client_t* client, byte_t* bytes, size_t length) {
-	
-	if (client->encryption.enabled) {
+void* t_ltg_compress(void* args) {
 
-		// encrypt packet
-		byte_t encrypted[length];
+	ltg_listener_t* listener = args;
 
-		cfb8_encrypt(client->encryption.encrypt, bytes, length, encrypted);
+	for (;;) {
 
-		sck_send(client->socket, (char*) encrypted, length);
+		ltg_compression_t compression = {
+			.client = NULL
+		};
+
+		with_lock (&listener->compression.lock) {
+			while (listener->compression.queue.length == 0 && !listener->compression.stopping) {
+				pthread_cond_wait(&listener->compression.wait, &listener->compression.lock);
+			}
+			if (listener->compression.queue.length != 0) {
+				compression = *(ltg_compression_t*) utl_list_first(&listener->compression.queue);
+				utl_list_shift(&listener->compression.queue);
+			}
+		}
+
+		// stopping, and every client is gone
+		if (compression.client == NULL) {
+			break;
+		}
+
+		ltg_compress(&compression);
 
-	} else {
-		sck_send(client->socket, (char*) bytes, length);
 	}
 
+	return NULL;
+
 }
 
 // sends the packet to the client specified
@@ -285,41 +1780,38 @@ void ltg_send(ltg_client_t* client, pck_packet_t* packet) {
 		if (client->compression_enabled) {
 
 			if (length >= sky_get_network_compression_threshold()) { // compress the packet
-			
-				byte_t compressed[length + 10];
-				size_t compressed_length = 0;
-
-				bytes = compressed + 10;
-				
-				// it's zlib compression time
-				if (client->compression.compressor == NULL) {
-					client->compression.compressor = libdeflate_alloc_compressor(6);
-				}
 
-				compressed_length = libdeflate_zlib_compress(client->compression.compressor, packet->bytes, length, bytes, length);
+				// the compression threads take it from here once they're running
+				if (client->listener->compression.threads != NULL) {
+
+					ltg_enqueue_compressed(client, packet->bytes, length);
+
+					pthread_mutex_unlock(&client->lock);
+					return;
+
+				}
+			
+				pck_packet_t* compressed = pck_acquire(length + 10, io_big_endian);
 
-				if (compressed_length != 0) {
+				const size_t frame_length = ltg_deflate_frame(packet->bytes, length, compressed->bytes, &bytes);
 
-					const size_t data_length_length = io_var_int_length(length);
-					const size_t packet_length_length = io_var_int_length(compressed_length + data_length_length);
-					
-					bytes = bytes - data_length_length - packet_length_length;
-					io_write_var_int(bytes, compressed_length + data_length_length, 5);
-					io_write_var_int(bytes + packet_length_length, length, 5);
-					length = compressed_length + data_length_length + packet_length_length;
+				if (frame_length != 0) {
 
-					ltg_send_e(client, bytes, length);
+					ltg_enqueue(client, bytes, frame_length);
+					pck_release(compressed);
 
 					pthread_mutex_unlock(&client->lock);
 					return;
 
 				}
 
+				pck_release(compressed);
+
 			}
 			
 			// do not compress the packet
 			const size_t length_length = io_var_int_length(length + 1);
-			bytes = packet->bytes - length_length - 1;
+			bytes = packet->length_prefix + sizeof(packet->length_prefix) - length_length - 1;
 			io_write_var_int(bytes, length + 1, 5);
 			bytes[length_length] = 0;
 			length += length_length + 1;
@@ -327,26 +1819,155 @@ void ltg_send(ltg_client_t* client, pck_packet_t* packet) {
 		} else {
 
 			const size_t length_length = io_var_int_length(length);
-			bytes = packet->bytes - length_length;
+			bytes = packet->length_prefix + sizeof(packet->length_prefix) - length_length;
 			io_write_var_int(bytes, length, 5);
 			length += length_length;
 
 		}
 
-		ltg_send_e(client, bytes, length);
+		ltg_enqueue(client, bytes, length);
 
 	}
 
 }
 
-void ltg_disconnect(ltg_client_t* client) {
+ltg_broadcast_t* ltg_create_broadcast(pck_packet_t* packet) {
 
-	if (pthread_self() != client->thread) {
-		sck_shutdown(client->socket);
-		return;
+	const size_t length = packet->cursor;
+	const size_t length_length = io_var_int_length(length);
+
+	// room for both frames, a compressed one is never bigger than an uncompressed one
+	ltg_broadcast_t* broadcast = malloc(sizeof(ltg_broadcast_t) + (length + 5) + (length + 10));
+	broadcast->references = 1;
+
+	// frame for clients without compression
+	broadcast->plain = broadcast->frames;
+	io_write_var_int(broadcast->plain, length, 5);
+	memcpy(broadcast->plain + length_length, packet->bytes, length);
+	broadcast->plain_length = length + length_length;
+
+	byte_t* out = broadcast->plain + broadcast->plain_length;
+
+	// frame for clients with compression, compressed once for all of them
+	if (length >= sky_get_network_compression_threshold()) {
+
+		const size_t frame_length = ltg_deflate_frame(packet->bytes, length, out, &broadcast->bytes);
+
+		if (frame_length != 0) {
+			broadcast->length = frame_length;
+			return broadcast;
+		}
+
+	}
+
+	broadcast->bytes = out;
+	broadcast->length = ltg_uncompressed_frame(packet->bytes, length, out);
+
+	return broadcast;
+
+}
+
+void ltg_broadcast(ltg_client_t* client, ltg_broadcast_t* broadcast) {
+
+	with_lock (&client->lock) {
+
+		const byte_t* bytes = client->compression_enabled ? broadcast->bytes : broadcast->plain;
+		const uint32_t length = client->compression_enabled ? broadcast->length : broadcast->plain_length;
+
+		if (client->encryption.enabled || length < LTG_BROADCAST_SHARE) {
+			ltg_enqueue(client, bytes, length);
+		} else if (!client->outbound.disconnect) {
+			// the same bytes are written to every client, so they're queued without a copy
+			ltg_retain_broadcast(broadcast);
+			ltg_send_chunk_t chunk = {
+				.bytes = (byte_t*) bytes,
+				.length = length,
+				.capacity = length,
+				.offset = 0,
+				.encrypted = length,
+				.frames = 1,
+				.slot = -1,
+				.buffer = NULL,
+				.broadcast = broadcast,
+				.compressing = false
+			};
+			utl_list_push(&client->outbound.chunks, &chunk);
+			ltg_queued(client, length);
+		}
+
+	}
+
+}
+
+ltg_movement_t ltg_shed_movement(ltg_client_t* client, uint32_t entity_id) {
+
+	ltg_movement_t movement = ltg_movement_send;
+
+	with_lock (&client->lock) {
+		if (client->outbound.lagging) {
+			// only the entity is remembered, where it is is looked up when the client catches up
+			utl_bit_vector_set_bit(&client->outbound.stale, entity_id);
+			client->outbound.held = true;
+			movement = ltg_movement_skip;
+		} else if (utl_bit_vector_test_bit(&client->outbound.stale, entity_id)) {
+			utl_bit_vector_reset_bit(&client->outbound.stale, entity_id);
+			movement = ltg_movement_resync;
+		}
+	}
+
+	if (movement == ltg_movement_skip) {
+		client->listener->backpressure.shed++;
+	}
+
+	return movement;
+
+}
+
+bool ltg_take_stale(ltg_client_t* client, uint32_t entity_id) {
+
+	bool stale = false;
+
+	with_lock (&client->lock) {
+		stale = utl_bit_vector_test_bit(&client->outbound.stale, entity_id);
+		if (stale) {
+			utl_bit_vector_reset_bit(&client->outbound.stale, entity_id);
+		}
+	}
+
+	return stale;
+
+}
+
+bool ltg_defer_chunk(ltg_client_t* client, uint8_t distance) {
+
+	bool defer = false;
+
+	with_lock (&client->lock) {
+		if (client->outbound.lagging && distance > LTG_DEFER_DISTANCE) {
+			client->outbound.held = true;
+			defer = true;
+		}
 	}
-		
-	sck_shutdown(client->socket);
+
+	if (defer) {
+		client->listener->backpressure.deferred++;
+	}
+
+	return defer;
+
+}
+
+void ltg_disconnect(ltg_client_t* client) {
+
+	// the network thread shuts the socket down once what's queued for the client is written
+	client->outbound.disconnect = true;
+
+	ltg_ready(client, true);
+
+}
+
+// the client's network thread is done with it
+static void ltg_remove_client(ltg_client_t* client) {
 
 	switch (client->state) {
 		case ltg_play: {
@@ -357,6 +1978,7 @@ void ltg_disconnect(ltg_client_t* client) {
 			with_lock (&client->listener->online.lock) {
 				utl_id_vector_remove(&client->listener->online.vector, client->online_node);
 			}
+			ltg_invalidate_status(client->listener);
 
 			// create player leave job
 			job_payload_t payload = {
@@ -367,7 +1989,7 @@ void ltg_disconnect(ltg_client_t* client) {
 			payload.player_leave.username[payload.player_leave.username_length] = 0;
 			memcpy(payload.player_leave.username, client->username.value, client->username.length);
 			memcpy(payload.player_leave.uuid, client->uuid, sizeof(ltg_uuid_t));
-			uint32_t work = job_new(job_player_leave, payload);
+			uint64_t work = job_new(job_player_leave, payload);
 			
 			job_add(work);
 			
@@ -379,40 +2001,44 @@ void ltg_disconnect(ltg_client_t* client) {
 		} break;
 	}
 
-	pthread_mutex_lock(&client->lock);
-	pthread_mutex_destroy(&client->lock);
-	sck_close(client->socket);
+	ltg_free_client(client);
 
-	// remove from client list
-	with_lock (&client->listener->clients.lock) {
-		utl_id_vector_remove(&client->listener->clients.vector, client->id);
-	}
+}
 
-	// free compressors
-	libdeflate_free_compressor(client->compression.compressor);
-	libdeflate_free_decompressor(client->compression.decompressor);
+void ltg_flush(ltg_listener_t* listener) {
 
-	// free username
-	UTL_FREESTR(client->username);
+	for (uint32_t i = 0; i < listener->network.count; ++i) {
 
-	// free skin
-	UTL_FREESTR(client->textures.value);
-	UTL_FREESTR(client->textures.signature);
+		ltg_network_t* network = &listener->network.threads[i];
 
-	// free encryption key
-	if (client->encryption.enabled) {
-		cfb8_done(client->encryption.encrypt, client->encryption.decrypt);
-	}
+		uint32_t ready = 0;
 
-	free(client);
+		with_lock (&network->ready.lock) {
+			ready = network->ready.list.length;
+		}
+
+		if (ready != 0 && !ltg_wake(network)) {
+			log_error("Could not wake network thread #%u", i);
+		}
+
+	}
 
 }
 
 void ltg_term(ltg_listener_t* listener) {
 
-	// cancel main thread
-	sck_close(listener->address.socket);
-	pthread_cancel(listener->thread);
+	// stop accepting clients
+	for (uint32_t i = 0; i < listener->acceptors.count; ++i) {
+		ltg_acceptor_t* acceptor = &listener->acceptors.threads[i];
+		sck_shutdown(acceptor->socket);
+		pthread_cancel(acceptor->thread);
+		pthread_join(acceptor->thread, NULL);
+		sck_close(acceptor->socket);
+	}
+
+	free(listener->acceptors.threads);
+	listener->acceptors.threads = NULL;
+	listener->acceptors.count = 0;
 
 	// disconnect message
 	cht_translation_t disconnect_message = cht_translation_new;
@@ -421,22 +2047,58 @@ void ltg_term(ltg_listener_t* listener) {
 	char message[128];
 	size_t message_length = cht_write_translation(&disconnect_message, message);
 
-	// disconnect all clients
+	// disconnect all clients, a client can't be freed while it's in the list and the list is locked
 	with_lock (&listener->clients.lock) {
 		for (uint32_t i = 0; i < listener->clients.vector.array.size; ++i) {
 			ltg_client_t* client = UTL_ID_VECTOR_GET_AS(ltg_client_t*, &listener->clients.vector, i);
 			if (client != NULL) {
-				pthread_mutex_unlock(&listener->clients.lock);
 				phd_send_disconnect(client, message, message_length);
 				ltg_disconnect(client);
-				if (pthread_self() != client->thread) {
-					pthread_join(client->thread, NULL);
-				}
-				pthread_mutex_lock(&listener->clients.lock);
 			}
 		}
 	}
 
+	// network threads stop once they have cleaned up after their clients
+	listener->network.stopping = true;
+
+	for (uint32_t i = 0; i < listener->network.count; ++i) {
+		if (!ltg_wake(&listener->network.threads[i])) {
+			log_error("Could not wake network thread #%u", i);
+		}
+	}
+
+	for (uint32_t i = 0; i < listener->network.count; ++i) {
+		ltg_network_t* network = &listener->network.threads[i];
+		pthread_join(network->thread, NULL);
+		if (network->uring.enabled) {
+			ltg_uring_term(network);
+		} else {
+			sck_poller_term(&network->poller);
+		}
+		utl_term_list(&network->ready.list);
+		pthread_mutex_destroy(&network->ready.lock);
+	}
+
+	free(listener->network.threads);
+
+	// every client is gone, so no login is waiting on the session server
+	phd_term_auth();
+
+	// every client is gone, so nothing is left to compress
+	with_lock (&listener->compression.lock) {
+		listener->compression.stopping = true;
+		pthread_cond_broadcast(&listener->compression.wait);
+	}
+
+	for (uint32_t i = 0; i < listener->compression.count; ++i) {
+		pthread_join(listener->compression.threads[i], NULL);
+	}
+
+	free(listener->compression.threads);
+	utl_term_list(&listener->compression.queue);
+
+	ltg_invalidate_status(listener);
+
 	sck_term();
 
 }
\ No newline at end of file
@@ -124,13 +124,15 @@ typedef enum {
 
 } ltg_locale_t;
 
-#define LTG_MAX_RECEIVE 3276 // max amount of bytes client can send
+#define LTG_MAX_RECEIVE 3276 // max amount of bytes received from a client at once
 #define LTG_AES_KEY_LENGTH 16 // length of AES key
 
 typedef byte_t ltg_uuid_t[16];
 
 typedef struct ltg_listener ltg_listener_t;
 
+typedef struct ltg_network ltg_network_t;
+
 typedef enum {
 
 	ltg_handshake = 0,
@@ -1,11 +1,14 @@
 #pragma once
 #include <pthread.h>
+#include <time.h>
 
 #include "listening.d.h"
 #include "../world/entity/living/player/player.d.h"
 
 #include "../main.h"
 #include "../util/id_vector.h"
+#include "../util/list.h"
+#include "../util/bit_vector.h"
 #include "../util/util.h"
 #include "../util/lock_util.h"
 #include "../util/str_util.h"
@@ -13,16 +16,224 @@
 #include "../crypt/rsa.h"
 #include "../crypt/cfb8.h"
 #include "socket/socket.h"
+#include "socket/poller.h"
+#include "socket/uring.h"
+
+#define LTG_MAX_EVENTS 64 // socket events a network thread takes at once
+#define LTG_SEND_TIMEOUT 10000 // milliseconds an io_uring write waits for a client to make room before giving up on it
+#define LTG_MAX_FRAME 2097151 // biggest frame a client may send, the most a 3 byte length can say
+#define LTG_RECEIVE_BUFFER 4096 // bytes a client's receive buffer starts with and shrinks back to
+#define LTG_RECEIVE_HEADROOM (offsetof(pck_packet_t, bytes) + _Alignof(pck_packet_t) - 1) // room for the packet header in front of the first frame, and to move the frame down to align it
+#define LTG_RECEIVE_MAX (LTG_RECEIVE_HEADROOM + 3 + LTG_MAX_FRAME) // most a client's receive buffer can grow to
+#define LTG_URING_ENTRIES 1024 // submission queue entries of a network thread's io_uring
+#define LTG_URING_RECV_BUFFERS 256 // buffers the kernel can receive into (power of 2)
+#define LTG_URING_SEND_SLOTS 256 // registered buffers, each holds a send chunk
+#define LTG_SEND_CHUNK 16384 // bytes frames are queued in, bigger frames get a chunk of their own
+#define LTG_FLUSH_THRESHOLD 65536 // queued bytes that get a client written before the end of the tick
+#define LTG_MAX_IOVECS 64 // chunks written with one call
+#define LTG_BROADCAST_SHARE 1024 // broadcasts at least this big are written from their shared bytes to clients without encryption
+#define LTG_COMPRESSION_LEVELS 13 // libdeflate's levels, 0 to 12
+#define LTG_INCOMPRESSIBLE_STREAK 8 // frames of a packet type in a row that didn't get smaller before the type is sent uncompressed
+#define LTG_INCOMPRESSIBLE_RETRY 64 // frames of an uncompressed packet type between tries to compress it again
+#define LTG_QUEUE_HIGH 1048576 // queued bytes that make a client lagging, it stops getting movement updates and far chunks
+#define LTG_QUEUE_LOW 262144 // a lagging client has caught up once its queue is down to this
+#define LTG_QUEUE_MAX 16777216 // queued bytes that get a client disconnected right away
+#define LTG_LAG_TIMEOUT 30000 // milliseconds a client can lag before it's disconnected
+#define LTG_DEFER_DISTANCE 2 // chunks this close to a lagging client are still sent to it
+#define LTG_ADMISSION_ADDRESSES 4096 // addresses whose connections are throttled on their own (power of 2)
+#define LTG_ADMISSION_PROBES 4 // places an address's bucket can be in, the least recently used one is taken over
+#define LTG_ACCEPT_BACKOFF_MIN 10 // milliseconds an acceptor waits after running out of file descriptors or memory, doubled each time it fails again
+#define LTG_ACCEPT_BACKOFF_MAX 1000 // most milliseconds an acceptor waits before trying again
+#define LTG_ACCEPT_LOG_INTERVAL 10000 // milliseconds between warnings about connections that could not be accepted
+#define LTG_STATUS_SAMPLE 12 // online players listed in the server list ping
+#define LTG_CAPTURE_DIRECTORY "captures"
+#define LTG_CAPTURE_MAGIC "MCAP" // starts a capture, then its version and the protocol as a var int
+#define LTG_CAPTURE_VERSION 1 // each frame is the milliseconds since the last one and its length as var ints, then the frame
 
 #define LTG_UUID_UNPACK(uuid) (ltg_uuid_t) { uuid[0], uuid[1], uuid[2], uuid[3], uuid[4], uuid[5], uuid[6], uuid[7], uuid[8], uuid[9], uuid[10], uuid[11], uuid[12], uuid[13], uuid[14], uuid[15] }
 
-struct ltg_listener {
+// takes in connections on its own socket, the kernel spreads connections over the sockets on the port
+typedef struct {
+
+	ltg_listener_t* listener;
+
+	pthread_t thread;
+
+	int32_t socket;
+
+} ltg_acceptor_t;
+
+// connections are let in while there are tokens for them, tokens come back at a steady rate up to a limit
+typedef struct {
+
+	uint32_t address; // of the connections it's for, 0 for all of them
+	float32_t tokens;
+	int64_t refilled; // milliseconds
+
+} ltg_bucket_t;
+
+struct ltg_network {
+
+	ltg_listener_t* listener;
 
 	pthread_t thread;
 
+	// waits on the clients' sockets, when io_uring isn't used
+	sck_poller_t poller;
+
+	// wakes the thread up when io_uring is used
+	int32_t wake;
+
+	// client whose socket is being handled, NULL in between
+	ltg_client_t* _Atomic client;
+
+	_Atomic uint32_t clients;
+
+	// clients with something to write, a receive to arm or a disconnect to do, taken care of when the thread wakes up
+	struct {
+		pthread_mutex_t lock;
+		utl_list_t list;
+	} ready;
+
+	// what was written to the clients
+	struct {
+		_Atomic uint64_t writes;
+		_Atomic uint64_t frames;
+		_Atomic uint64_t bytes;
+	} sent;
+
+	// used instead of the poller when enabled and the kernel supports it
+	struct {
+		bool enabled;
+#ifdef SCK_URING
+		sck_uring_t ring;
+#endif
+		uint64_t wake;
+		// registered buffers, chunks are queued in a free one
+		struct {
+			pthread_mutex_t lock;
+			byte_t* memory;
+			uint16_t* free;
+			uint32_t free_count;
+		} slots;
+	} uring;
+
+};
+
+// a packet framed and compressed once for all the clients it's sent to, only encryption is done for each client
+typedef struct {
+
+	_Atomic uint32_t references;
+	uint32_t plain_length;
+	uint32_t length;
+	byte_t* plain; // frame for clients without compression
+	byte_t* bytes; // frame for clients with compression
+	byte_t frames[];
+
+} ltg_broadcast_t;
+
+// a packet waiting for a compression thread, its chunk keeps its place in the client's queue
+typedef struct {
+
+	ltg_client_t* client;
+	pck_packet_t* packet; // copy of the packet from the pool
+	uint32_t node; // the chunk in the client's queue
+	bool encrypt; // the client had encryption when the packet was sent
+
+} ltg_compression_t;
+
+typedef struct {
+
+	byte_t* bytes;
+	uint32_t length;
+	uint32_t capacity;
+	uint32_t offset; // written so far
+	uint32_t encrypted; // bytes at the front that are ready to be written, the rest is encrypted first
+	uint32_t frames;
+	int32_t slot; // -1 if the bytes are in a pooled packet
+	pck_packet_t* buffer; // the pooled packet the bytes are in
+	ltg_broadcast_t* broadcast; // the bytes are a broadcast's, which is held until they are written
+	bool compressing; // the frame isn't compressed yet, nothing from here on is written until it is
+
+} ltg_send_chunk_t;
+
+struct ltg_listener {
+
+	// accept new clients
+	struct {
+		uint32_t count; // 0 for one per network thread
+		ltg_acceptor_t* threads;
+	} acceptors;
+
+	// connections over the rates are closed before anything is allocated for them, 0 means no limit
+	struct {
+		pthread_mutex_t lock;
+		uint32_t rate; // connections a second
+		uint32_t burst;
+		uint32_t address_rate; // connections a second from one address, connections from loopback aren't limited
+		uint32_t address_burst;
+		ltg_bucket_t all;
+		ltg_bucket_t addresses[LTG_ADMISSION_ADDRESSES];
+		_Atomic uint64_t admitted;
+		_Atomic uint64_t throttled; // closed because of the rate of all connections
+		_Atomic uint64_t throttled_address; // closed because of the rate of their address
+	} admission;
+
+	// the server list ping response is framed once and sent to everyone until what's in it changes
+	struct {
+		pthread_mutex_t lock;
+		ltg_broadcast_t* response; // NULL until it's built again
+		uint32_t generation; // changes every time the response goes out of date
+		uint32_t rate; // status requests and pings a second from one address, loopback isn't limited
+		uint32_t burst;
+		ltg_bucket_t addresses[LTG_ADMISSION_ADDRESSES];
+		_Atomic uint64_t served;
+		_Atomic uint64_t built;
+		_Atomic uint64_t pings;
+		_Atomic uint64_t throttled; // connections closed because of the rate of their address
+	} status;
+
+	// network threads, each waits on the sockets of its own clients
+	struct {
+		uint32_t count; // 0 for one per networking core
+		ltg_network_t* threads;
+		_Atomic bool stopping;
+		bool io_uring;
+	} network;
+
+	// compress big frames so the threads sending them don't have to
+	struct {
+		uint32_t count; // 0 for one per network thread
+		pthread_t* threads; // NULL until the listener starts, frames are compressed by their sender until then
+		pthread_mutex_t lock;
+		pthread_cond_t wait;
+		utl_list_t queue; // ltg_compression_t
+		bool stopping;
+		_Atomic uint32_t incompressible[128]; // frames of each packet id in a row that didn't get smaller
+		_Atomic uint64_t frames; // compressed frames
+		_Atomic uint64_t raw; // frames big enough to compress that were sent uncompressed
+		_Atomic uint64_t bytes; // compressed frames' bytes before they were compressed
+		_Atomic uint64_t compressed; // and after
+	} compression;
+
+	// play state frames clients send, written to a file for each client to replay later
+	struct {
+		_Atomic bool all; // every client is captured once it starts playing
+		_Atomic uint32_t files;
+		_Atomic uint64_t frames;
+		_Atomic uint64_t bytes;
+	} capture;
+
+	// clients that can't keep up with what is sent to them
+	struct {
+		_Atomic uint64_t lagged; // times a client's queue went over the high mark
+		_Atomic uint64_t shed; // movement updates not sent to lagging clients
+		_Atomic uint64_t deferred; // chunks held back from lagging clients
+		_Atomic uint64_t disconnected; // clients that fell too far behind
+	} backpressure;
+
 	// address
 	struct {
-		int32_t socket;
 		struct sockaddr_in addr;
 		uint16_t port;
 	} address;
@@ -46,18 +257,21 @@ struct ltg_client {
 
 	ltg_listener_t* listener;
 
-	// client's thread
+	// network thread that receives from the client
+	ltg_network_t* network;
 	pthread_t thread;
 	
+	// what was received and not handled yet, only touched by the network thread
+	struct {
+		byte_t* bytes;
+		uint32_t start;
+		uint32_t end;
+		uint32_t capacity;
+	} receive;
+
 	// player entity (only non-null when in PLAY state)
 	ent_player_t* entity;
 
-	// compressors and decompressors
-	struct {
-		struct libdeflate_compressor* compressor;
-		struct libdeflate_decompressor* decompressor;
-	} compression;
-
 	// textures (only non-null after auth)
 	struct {
 		string_t value;
@@ -88,11 +302,48 @@ struct ltg_client {
 
 	ltg_locale_t locale;
 
-	uint32_t keep_alive;
+	uint64_t keep_alive;
+
+	// frames waiting for the network thread to write them, locked by the client
+	struct {
+		utl_list_t chunks; // ltg_send_chunk_t
+		uint32_t bytes; // queued and not written yet
+		bool ready; // on the network thread's ready list, locked by the list
+		bool polling; // waiting for room in the socket
+		uint32_t compressing; // frames at the compression threads, the client is only freed when there are none
+		bool dropped; // nothing queued will make it to the client, frames still being compressed are thrown away
+		_Atomic bool disconnect; // shut the socket down once the queue is written
+		bool overflowed; // fell too far behind, the queue is thrown away instead of written
+		bool lagging; // went over the high mark and isn't back down to the low mark yet
+		bool held; // movement updates or chunks were held back while lagging
+		int64_t lagging_since;
+		utl_bit_vector_t stale; // entities whose movement updates were skipped, by id
+	} outbound;
+
+	// frames the client sends, the file is only touched by the network thread, which opens or closes it when it's asked to
+	struct {
+		_Atomic bool requested;
+		FILE* file;
+		int64_t last; // milliseconds the last frame was written at
+	} capture;
+
+	// the session server is asked about the login by the auth thread, the network thread picks the login back up once it answers
+	struct {
+		bool pending; // only touched by the network thread, the client is only freed when it's false
+		struct phd_auth* finished; // locked by the client, the answer waiting for the network thread
+	} auth;
 
+	// only used with io_uring, chunks are written one at a time and in order
 	struct {
-		EVP_CIPHER_CTX* encrypt;
-		EVP_CIPHER_CTX* decrypt;
+		uint32_t pending; // operations the kernel still has, the client is only freed when there are none
+		bool receiving;
+		bool writing;
+		bool closed;
+	} uring;
+
+	struct {
+		cfb8_cipher_t encrypt;
+		cfb8_cipher_t decrypt;
 		bool enabled : 1;
 	} encryption;
 
@@ -114,8 +365,29 @@ struct ltg_client {
 
 extern void ltg_init();
 extern void* t_ltg_run(void*);
+// milliseconds on a clock that only goes forward, for rates and timeouts
+static inline int64_t ltg_millis() {
+
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+
+	return (int64_t) time.tv_sec * 1000 + time.tv_nsec / 1000000;
+
+}
+
+// take a token for a connection from the address, false if it should be closed
+extern bool ltg_admit(ltg_listener_t* listener, uint32_t address, int64_t now);
+// take a token for a status request or ping from the address, false if the connection should be closed
+extern bool ltg_admit_status(ltg_listener_t* listener, uint32_t address, int64_t now);
+// the cached server list ping response, retained for the caller, or NULL and the generation to cache a new one under
+extern ltg_broadcast_t* ltg_get_status(ltg_listener_t* listener, uint32_t* generation);
+// cache the response unless it went out of date while it was built
+extern void ltg_set_status(ltg_listener_t* listener, ltg_broadcast_t* response, uint32_t generation);
+// the online players or the motd changed
+extern void ltg_invalidate_status(ltg_listener_t* listener);
 extern void ltg_accept(ltg_client_t*);
-extern void* t_ltg_client(void*);
+extern void* t_ltg_network(void*);
+extern void* t_ltg_compress(void*);
 
 static inline ltg_client_t* ltg_get_client_by_id(ltg_listener_t* listener, uint32_t id) {
 	
@@ -129,12 +401,53 @@ static inline ltg_client_t* ltg_get_client_by_id(ltg_listener_t* listener, uint3
 
 }
 
+// handle one frame the client sent, false if the client should be disconnected
 extern bool ltg_handle_packet(ltg_client_t* client, pck_packet_t* packet);
+// take bytes as if the client sent them, split anywhere, false if the client should be disconnected
+extern bool ltg_receive_bytes(ltg_client_t* client, const byte_t* bytes, uint32_t length);
 
 extern void ltg_send(ltg_client_t*, pck_packet_t*);
+// have the client's network thread look at it, for other threads that have something for it
+extern void ltg_wake_client(ltg_client_t* client);
+
+// frame the packet once to send it to many clients, the caller holds the only reference
+extern ltg_broadcast_t* ltg_create_broadcast(pck_packet_t* packet);
+extern void ltg_broadcast(ltg_client_t* client, ltg_broadcast_t* broadcast);
+
+static inline void ltg_retain_broadcast(ltg_broadcast_t* broadcast) {
+
+	atomic_fetch_add_explicit(&broadcast->references, 1, memory_order_relaxed);
+
+}
+
+static inline void ltg_release_broadcast(ltg_broadcast_t* broadcast) {
+
+	if (atomic_fetch_sub_explicit(&broadcast->references, 1, memory_order_acq_rel) == 1) {
+		free(broadcast);
+	}
+
+}
 
 extern void ltg_disconnect(ltg_client_t*);
 
+// what to do with a movement update of an entity for a client
+typedef enum {
+
+	ltg_movement_send, // send the update as it is
+	ltg_movement_resync, // updates were skipped while the client lagged, send where the entity is now instead
+	ltg_movement_skip // the client is lagging, it gets where the entity is once it catches up
+
+} ltg_movement_t;
+
+extern ltg_movement_t ltg_shed_movement(ltg_client_t* client, uint32_t entity_id);
+// true if the client skipped movement updates of the entity and wasn't sent where it is since
+extern bool ltg_take_stale(ltg_client_t* client, uint32_t entity_id);
+// true if the chunk is held back until the client catches up
+extern bool ltg_defer_chunk(ltg_client_t* client, uint8_t distance);
+
+// wake up the network threads that have frames to write, called at the end of each tick
+extern void ltg_flush(ltg_listener_t* listener);
+
 extern void ltg_term(ltg_listener_t* listener);
 
 static inline void ltg_uuid_to_string(const ltg_uuid_t uuid, char* out) {
@@ -237,6 +550,31 @@ static inline ent_player_t* ltg_client_get_entity(const ltg_client_t* client) {
 	return client->entity;
 }
 
+// bytes queued for the client that weren't written yet
+static inline uint32_t ltg_client_get_queue_depth(ltg_client_t* client) {
+
+	uint32_t depth = 0;
+
+	with_lock (&client->lock) {
+		depth = client->outbound.bytes;
+	}
+
+	return depth;
+
+}
+
+static inline bool ltg_client_is_lagging(ltg_client_t* client) {
+
+	bool lagging = false;
+
+	with_lock (&client->lock) {
+		lagging = client->outbound.lagging;
+	}
+
+	return lagging;
+
+}
+
 static inline int64_t ltg_client_get_last_receive(const ltg_client_t* client) {
 	return client->last_recv;
 }
@@ -267,8 +605,16 @@ static inline bool ltg_client_has_textures_signature(const ltg_client_t* client)
 	return false;
 }
 
-static inline pthread_t ltg_get_thread(const ltg_listener_t* listener) {
-	return listener->thread;
+static inline bool ltg_is_acceptor_thread(const ltg_listener_t* listener, pthread_t thread) {
+
+	for (uint32_t i = 0; i < listener->acceptors.count && listener->acceptors.threads != NULL; ++i) {
+		if (pthread_equal(listener->acceptors.threads[i].thread, thread)) {
+			return true;
+		}
+	}
+
+	return false;
+
 }
 
 static inline uint32_t ltg_get_client_count(ltg_listener_t* listener) {
@@ -313,6 +659,12 @@ static inline void ltg_add_online(ltg_listener_t* listener, ltg_client_t* client
 		client->online_node = utl_id_vector_push(&listener->online.vector, &client);
 	}
 
+	if (listener->capture.all) {
+		client->capture.requested = true;
+	}
+
+	ltg_invalidate_status(listener);
+
 }
 
 static inline uint32_t ltg_get_online_count(ltg_listener_t* listener) {
@@ -26,10 +26,16 @@ bool phd_handshake(ltg_client_t* client, pck_packet_t* packet) {
 bool phd_handle_handshake(ltg_client_t* client, pck_packet_t* packet) {
 
 	ltg_client_set_protocol(client, pck_read_var_int(packet));
-	PCK_READ_STRING(address, packet); // connecting address
+
+	// the connecting address isn't used, it's only checked to fit in the packet
+	const int32_t address_length = pck_read_var_int(packet);
+	if (address_length < 0 || address_length > PHD_HANDSHAKE_MAX_ADDRESS || packet->length - packet->cursor < (uint32_t) address_length + 3) {
+		return false;
+	}
+	packet->cursor += address_length;
 	pck_read_int16(packet); // port
 
-	// set state to next state
+	// set state to next state, anything after it is ignored
 	int32_t next_state = pck_read_var_int(packet);
 	if (next_state == ltg_login || next_state == ltg_status) {
 		ltg_client_set_state(client, next_state);
@@ -3,6 +3,9 @@
 #include "../../io/packet/packet.h"
 #include "../listening.h"
 
+#define PHD_HANDSHAKE_MAX_ADDRESS 98301 // bytes of the address a client connected to, 32767 characters of up to 3 bytes so proxies can forward players in it
+#define PHD_HANDSHAKE_MAX_LENGTH (1 + 5 + 3 + PHD_HANDSHAKE_MAX_ADDRESS + 2 + 5) // longest a handshake frame can be
+
 extern bool phd_handshake(ltg_client_t*, pck_packet_t*);
 
 //inboud
@@ -9,14 +9,33 @@
 #include "../../io/chat/translation.h"
 #include "../../crypt/random.h"
 
-struct {
+struct phd_auth {
 
+	ltg_client_t* client;
 	CURL* curl;
-	pthread_mutex_t lock;
+	string_t response;
+	CURLcode result;
 
-} phd_authRequest = {
-	.curl = NULL,
-	.lock = PTHREAD_MUTEX_INITIALIZER
+};
+
+// one thread asks the session server about every login at once, so network threads never wait on it
+struct {
+
+	pthread_once_t once;
+	pthread_t thread;
+	pthread_mutex_t lock;
+	CURLM* multi;
+	utl_list_t queue; // phd_auth_t*, waiting for the auth thread to start them
+	bool started;
+	bool stopping;
+
+} phd_auth = {
+	.once = PTHREAD_ONCE_INIT,
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.multi = NULL,
+	.queue = UTL_LIST_INITIALIZER(phd_auth_t*),
+	.started = false,
+	.stopping = false
 };
 
 size_t phd_auth_response_write(void* ptr, size_t size, size_t nmemb, string_t* r) {
@@ -32,8 +51,121 @@ size_t phd_auth_response_write(void* ptr, size_t size, size_t nmemb, string_t* r
 
 }
 
+static void phd_free_auth(phd_auth_t* request) {
+
+	if (request->curl != NULL) {
+		curl_easy_cleanup(request->curl);
+	}
+	free(request->response.value);
+	free(request);
+
+}
+
+static void* t_phd_auth(__attribute__((unused)) void* args) {
+
+	for (;;) {
+
+		bool stopping = false;
+
+		// start what the network threads queued
+		with_lock (&phd_auth.lock) {
+			while (phd_auth.queue.length != 0) {
+				phd_auth_t* request = *(phd_auth_t**) utl_list_first(&phd_auth.queue);
+				utl_list_shift(&phd_auth.queue);
+				curl_multi_add_handle(phd_auth.multi, request->curl);
+			}
+			stopping = phd_auth.stopping;
+		}
+
+		// only stopped once every client is gone, so nothing is left running
+		if (stopping) {
+			break;
+		}
+
+		int running = 0;
+		curl_multi_perform(phd_auth.multi, &running);
+
+		// hand the answers to the clients' network threads
+		CURLMsg* message;
+		int left = 0;
+
+		while ((message = curl_multi_info_read(phd_auth.multi, &left)) != NULL) {
+
+			if (message->msg != CURLMSG_DONE) {
+				continue;
+			}
+
+			phd_auth_t* request = NULL;
+			curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, &request);
+			request->result = message->data.result;
+			curl_multi_remove_handle(phd_auth.multi, request->curl);
+
+			with_lock (&request->client->lock) {
+				request->client->auth.finished = request;
+			}
+
+			ltg_wake_client(request->client);
+
+		}
+
+		// woken up early when a login is queued, and when a request times out
+		curl_multi_poll(phd_auth.multi, NULL, 0, PHD_AUTH_POLL, NULL);
+
+	}
+
+	return NULL;
+
+}
+
+static void phd_start_auth() {
+
+	CURLM* multi = curl_multi_init();
+
+	if (multi == NULL) {
+		log_error("Failed to initialize cURL");
+		return;
+	}
+
+	phd_auth.multi = multi;
+
+	with_lock (&phd_auth.lock) {
+		phd_auth.started = pthread_create(&phd_auth.thread, NULL, t_phd_auth, NULL) == 0;
+	}
+
+	if (!phd_auth.started) {
+		log_error("Could not start the auth thread");
+	}
+
+}
+
+void phd_term_auth() {
+
+	bool started = false;
+
+	with_lock (&phd_auth.lock) {
+		phd_auth.stopping = true;
+		started = phd_auth.started;
+	}
+
+	if (!started) {
+		return;
+	}
+
+	curl_multi_wakeup(phd_auth.multi);
+	pthread_join(phd_auth.thread, NULL);
+
+	curl_multi_cleanup(phd_auth.multi);
+	utl_term_list(&phd_auth.queue);
+
+}
+
 bool phd_login(ltg_client_t* client, pck_packet_t* packet) {
 
+	// the client has nothing to send while the session server is asked, and the login can't go on twice
+	if (client->auth.pending) {
+		return false;
+	}
+
 	const int32_t id = pck_read_var_int(packet);
 
 	switch (id) {
@@ -158,77 +290,100 @@ bool phd_handle_encryption_response(ltg_client_t* client, pck_packet_t* packet)
 
 	}
 
-	// auth with Mojang's servers...
+	// create server_id hash
+	EVP_MD_CTX* hash = EVP_MD_CTX_create();
+	EVP_DigestInit_ex(hash, EVP_sha1(), NULL);
+	EVP_DigestUpdate(hash, (byte_t*) "", 0);
+	EVP_DigestUpdate(hash, secret.bytes, LTG_AES_KEY_LENGTH);
+	EVP_DigestUpdate(hash, cry_get_asn1_bytes(ltg_get_rsa_keys(sky_get_listener())), cry_get_asn1_length(ltg_get_rsa_keys(sky_get_listener())));
+	unsigned int digest_length = 20;
+	byte_t server_id_hash[digest_length];
+	EVP_DigestFinal_ex(hash, server_id_hash, &digest_length);
+	EVP_MD_CTX_destroy(hash);
+
+	// create server_id string
+	char server_id[(digest_length << 1) + 2];
+	utl_to_minecraft_hex(server_id, server_id_hash, digest_length);
+
+	char url[98 + (digest_length << 1)];
+	sprintf(url, "https://sessionserver.mojang.com/session/minecraft/hasJoined?username=%s&serverId=%s", UTL_STRTOCSTR(ltg_client_get_username(client)), server_id);
+
+	// auth with Mojang's servers on the auth thread, phd_finish_auth picks the login back up once they answer
+	phd_auth_t* request = malloc(sizeof(phd_auth_t));
+	request->client = client;
+	request->result = CURLE_OK;
+	request->response.length = 0;
+	request->response.value = malloc(1);
+	request->response.value[0] = '\0';
+	request->curl = curl_easy_init();
+
+	if (request->curl == NULL) {
+		log_error("Failed to initialize cURL");
+		phd_free_auth(request);
+		return false;
+	}
+
+	curl_easy_setopt(request->curl, CURLOPT_URL, url);
+	curl_easy_setopt(request->curl, CURLOPT_TCP_FASTOPEN, 1L);
+	curl_easy_setopt(request->curl, CURLOPT_IPRESOLVE, CURL_IPRESOLVE_V4);
+	curl_easy_setopt(request->curl, CURLOPT_NOSIGNAL, 1L);
+	curl_easy_setopt(request->curl, CURLOPT_TIMEOUT, (long) PHD_AUTH_TIMEOUT);
+	curl_easy_setopt(request->curl, CURLOPT_CONNECTTIMEOUT, (long) PHD_AUTH_CONNECT_TIMEOUT);
+	curl_easy_setopt(request->curl, CURLOPT_WRITEFUNCTION, phd_auth_response_write);
+	curl_easy_setopt(request->curl, CURLOPT_WRITEDATA, &request->response);
+	curl_easy_setopt(request->curl, CURLOPT_PRIVATE, request);
 
-	long http_code = 0;
-	string_t response;
+	pthread_once(&phd_auth.once, phd_start_auth);
 
-	with_lock (&phd_authRequest.lock) {
+	bool queued = false;
 
-		if (phd_authRequest.curl == NULL) {
-			phd_authRequest.curl = curl_easy_init();
-			if (!phd_authRequest.curl) {
-				pthread_mutex_unlock(&phd_authRequest.lock);
-				log_error("Failed to initialize cURL");
-				return false;
-			}
-			curl_easy_setopt(phd_authRequest.curl, CURLOPT_TCP_FASTOPEN, 1);
-			curl_easy_setopt(phd_authRequest.curl, CURLOPT_IPRESOLVE, CURL_IPRESOLVE_V4);
-			curl_easy_setopt(phd_authRequest.curl, CURLOPT_WRITEFUNCTION, phd_auth_response_write);
+	with_lock (&phd_auth.lock) {
+		if (phd_auth.started && !phd_auth.stopping) {
+			utl_list_push(&phd_auth.queue, &request);
+			queued = true;
 		}
-		CURLcode res;
-
-		// create server_id hash
-		EVP_MD_CTX* hash = EVP_MD_CTX_create();
-		EVP_DigestInit_ex(hash, EVP_sha1(), NULL);
-		EVP_DigestUpdate(hash, (byte_t*) "", 0);
-		EVP_DigestUpdate(hash, secret.bytes, LTG_AES_KEY_LENGTH);
-		EVP_DigestUpdate(hash, cry_get_asn1_bytes(ltg_get_rsa_keys(sky_get_listener())), cry_get_asn1_length(ltg_get_rsa_keys(sky_get_listener())));
-		unsigned int digest_length = 20;
-		byte_t server_id_hash[digest_length];
-		EVP_DigestFinal_ex(hash, server_id_hash, &digest_length);
-		EVP_MD_CTX_destroy(hash);
-
-		// create server_id string
-		char server_id[(digest_length << 1) + 2];
-		utl_to_minecraft_hex(server_id, server_id_hash, digest_length);
-
-		char request[98 + (digest_length << 1)];
-		sprintf(request, "https://sessionserver.mojang.com/session/minecraft/hasJoined?username=%s&serverId=%s", UTL_STRTOCSTR(ltg_client_get_username(client)), server_id);
-		curl_easy_setopt(phd_authRequest.curl, CURLOPT_URL, request);
-
-		// prepare response string
-		response.length = 0;
-		response.value = malloc(1);
-		response.value[0] = '\0';
-
-		curl_easy_setopt(phd_authRequest.curl, CURLOPT_WRITEDATA, &response);
-
-		res = curl_easy_perform(phd_authRequest.curl);
-		if (res != CURLE_OK) {
-			
-			pthread_mutex_unlock(&phd_authRequest.lock);
-
-			log_error("Could not authenticate client: %s", curl_easy_strerror(res));
-
-			if (response.value != NULL)
-				free(response.value);
-			
-			return false;
+	}
 
-		}
+	if (!queued) {
+		phd_free_auth(request);
+		return false;
+	}
 
-		curl_easy_getinfo(phd_authRequest.curl, CURLINFO_RESPONSE_CODE, &http_code);
+	// the client is kept until the answer is back
+	client->auth.pending = true;
+	curl_multi_wakeup(phd_auth.multi);
+
+	return true;
 
+}
+
+bool phd_finish_auth(ltg_client_t* client, phd_auth_t* request) {
+
+	// the client is already on its way out
+	if (client->outbound.disconnect) {
+		phd_free_auth(request);
+		return false;
+	}
+
+	if (request->result != CURLE_OK) {
+		log_error("Could not authenticate client: %s", curl_easy_strerror(request->result));
+		phd_free_auth(request);
+		return false;
 	}
 
+	long http_code = 0;
+	curl_easy_getinfo(request->curl, CURLINFO_RESPONSE_CODE, &http_code);
+
 	if (http_code != 200) {
 		
 		log_info("User attempted to login with an invalid session! (Server returned %ld)", http_code);
+		phd_free_auth(request);
 		return false;
 
 	}
 
+	const string_t response = request->response;
+
 	mjson_doc* auth = mjson_read(response.value, response.length);
 
 	mjson_val* auth_obj = mjson_get_root(auth);
@@ -279,7 +434,7 @@ bool phd_handle_encryption_response(ltg_client_t* client, pck_packet_t* packet)
 										log_error("Property type has not been set, is the json response from the auth server curropted?");
 										
 										mjson_free(auth);
-										free(response.value);
+										phd_free_auth(request);
 										return false;
 									}
 									case textures: {
@@ -297,7 +452,7 @@ bool phd_handle_encryption_response(ltg_client_t* client, pck_packet_t* packet)
 										log_error("Property type has not been set, is the json response from the auth server curropted?");
 										
 										mjson_free(auth);
-										free(response.value);
+										phd_free_auth(request);
 										return false;
 									}
 									case textures: {
@@ -320,7 +475,7 @@ bool phd_handle_encryption_response(ltg_client_t* client, pck_packet_t* packet)
 
 	// free auth response and auth json doc
 	mjson_free(auth);
-	free(response.value);
+	phd_free_auth(request);
 
 	phd_update_login_success(client);
 
@@ -3,10 +3,22 @@
 #include "../../io/packet/packet.h"
 #include "../listening.h"
 
+#define PHD_AUTH_TIMEOUT 10 // seconds a login waits for the session server to answer
+#define PHD_AUTH_CONNECT_TIMEOUT 5 // seconds a login waits to connect to the session server
+#define PHD_AUTH_POLL 1000 // most milliseconds the auth thread waits without looking at its requests
+
+// a login the session server is asked about
+typedef struct phd_auth phd_auth_t;
+
 extern bool phd_login(ltg_client_t*, pck_packet_t*);
 
 extern size_t phd_auth_response_write(void*, size_t, size_t, string_t*);
 
+// pick the login back up with the session server's answer, on the client's network thread, false if the client should be disconnected
+extern bool phd_finish_auth(ltg_client_t* client, phd_auth_t* request);
+// stop the auth thread, once no client is waiting on it
+extern void phd_term_auth();
+
 //inbound
 extern bool phd_handle_login_start(ltg_client_t*, pck_packet_t*);
 extern bool phd_handle_encryption_response(ltg_client_t*, pck_packet_t*);
@@ -516,11 +516,7 @@ bool phd_handle_player_position(ltg_client_t* client, pck_packet_t* packet) {
 	const float64_t z = pck_read_float64(packet);
 	const bool on_ground = pck_read_int8(packet);
 
-	const float64_t d_x = x - ent_get_x(entity);
-	const float64_t d_y = y - ent_get_y(entity);
-	const float64_t d_z = z - ent_get_z(entity);
-
-	ent_move(entity, d_x, d_y, d_z, on_ground);
+	ent_move_to(entity, x, y, z, on_ground);
 
 	/*
 	if (old_chunk != player->living_entity.entity.chunk) {
@@ -548,11 +544,7 @@ bool phd_handle_player_position_and_look(ltg_client_t* client, pck_packet_t* pac
 
 	const bool on_ground = pck_read_int8(packet);
 
-	const float64_t d_x = x - ent_get_x(ent_le_get_entity(player));
-	const float64_t d_y = y - ent_get_y(ent_le_get_entity(player));
-	const float64_t d_z = z - ent_get_z(ent_le_get_entity(player));
-
-	ent_le_move_look(player, d_x, d_y, d_z, yaw, pitch, on_ground);
+	ent_le_move_look_to(player, x, y, z, yaw, pitch, on_ground);
 
 	/*if (old_chunk != player->living_entity.entity.chunk) {
 
@@ -844,33 +836,65 @@ void phd_send_server_difficulty(ltg_client_t* client) {
 
 }
 
-void phd_send_chat_message(ltg_client_t* client, const char* message, size_t message_len, const ltg_uuid_t uuid) {
-
-	PCK_INLINE(packet, 23 + message_len, io_big_endian);
+static void phd_write_chat_message(pck_packet_t* packet, const char* message, size_t message_len, const ltg_uuid_t uuid) {
 
 	pck_write_var_int(packet, 0x0F);
 	pck_write_string(packet, message, message_len);
 	pck_write_int8(packet, 0); // position
 	pck_write_bytes(packet, uuid, 16);
 
+}
+
+void phd_send_chat_message(ltg_client_t* client, const char* message, size_t message_len, const ltg_uuid_t uuid) {
+
+	PCK_INLINE(packet, 23 + message_len, io_big_endian);
+
+	phd_write_chat_message(packet, message, message_len, uuid);
+
 	ltg_send(client, packet);
 
 }
 
-void phd_send_system_chat_message(ltg_client_t* client, const char* message, size_t message_len) {
+ltg_broadcast_t* phd_create_chat_message(const char* message, size_t message_len, const ltg_uuid_t uuid) {
 
 	PCK_INLINE(packet, 23 + message_len, io_big_endian);
 
+	phd_write_chat_message(packet, message, message_len, uuid);
+
+	return ltg_create_broadcast(packet);
+
+}
+
+static void phd_write_system_chat_message(pck_packet_t* packet, const char* message, size_t message_len) {
+
 	pck_write_var_int(packet, 0x0F);
 	pck_write_string(packet, message, message_len);
 	pck_write_int8(packet, 1); // position
 	pck_write_int64(packet, 0); // sender
 	pck_write_int64(packet, 0);
+
+}
+
+void phd_send_system_chat_message(ltg_client_t* client, const char* message, size_t message_len) {
+
+	PCK_INLINE(packet, 23 + message_len, io_big_endian);
+
+	phd_write_system_chat_message(packet, message, message_len);
 	
 	ltg_send(client, packet);
 
 }
 
+ltg_broadcast_t* phd_create_system_chat_message(const char* message, size_t message_len) {
+
+	PCK_INLINE(packet, 23 + message_len, io_big_endian);
+
+	phd_write_system_chat_message(packet, message, message_len);
+
+	return ltg_create_broadcast(packet);
+
+}
+
 void phd_send_declare_commands(ltg_client_t* client) {
 
 	ltg_send(client, cmd_get_graph());
@@ -973,330 +997,312 @@ void phd_send_keep_alive(ltg_client_t* client, uint64_t id) {
 
 }
 
-struct {
-	pck_packet_t* packet;
-	pthread_mutex_t lock;
-} phd_chunk_packet = {
-	.packet = NULL,
-	.lock = PTHREAD_MUTEX_INITIALIZER
-};
-
 // This is one chunky function, optimize it if possible TODO
 void phd_send_chunk_data_and_update_light(ltg_client_t* client, wld_chunk_t* chunk) {
 
-	with_lock (&phd_chunk_packet.lock) {
+	// each sender gets its own packet, so chunks are written on many workers at once
+	pck_packet_t* packet = pck_acquire(262144, io_big_endian);
 
-		if (phd_chunk_packet.packet == NULL) {
-			phd_chunk_packet.packet = pck_create(262144, io_big_endian);
-		}
+	pck_write_var_int(packet, 0x22);
+	pck_write_int32(packet, wld_get_chunk_x(chunk));
+	pck_write_int32(packet, wld_get_chunk_z(chunk));
 
-		pck_packet_t* packet = phd_chunk_packet.packet;
+	// CHUNK MASK
 
-		packet->cursor = 0;
-		
-		pck_write_var_int(packet, 0x22);
-		pck_write_int32(packet, wld_get_chunk_x(chunk));
-		pck_write_int32(packet, wld_get_chunk_z(chunk));
-
-		// CHUNK MASK
-
-		/*
-		const uint16_t chunk_mask_length = ((chunk_height - 1) >> 6) + 1;
-		pck_write_var_int(packet, chunk_mask_length);
-		int64_t primary_chunk_mask[chunk_mask_length];
-		memset(primary_chunk_mask, 0, sizeof(primary_chunk_mask));
-		for (uint16_t i = 0; i < chunk_height; ++i) {
-			if (wld_chunk_section_get_block_count(wld_chunk_get_section(chunk, i)) != 0) {
-				primary_chunk_mask[i >> 6] |= (1 << (i & 0x3f));
-			}
+	/*
+	const uint16_t chunk_mask_length = ((chunk_height - 1) >> 6) + 1;
+	pck_write_var_int(packet, chunk_mask_length);
+	int64_t primary_chunk_mask[chunk_mask_length];
+	memset(primary_chunk_mask, 0, sizeof(primary_chunk_mask));
+	for (uint16_t i = 0; i < chunk_height; ++i) {
+		if (wld_chunk_section_get_block_count(wld_chunk_get_section(chunk, i)) != 0) {
+			primary_chunk_mask[i >> 6] |= (1 << (i & 0x3f));
 		}
-		for (uint16_t i = 0; i < chunk_mask_length; ++i) {
-			pck_write_int64(packet, primary_chunk_mask[i]);
-		}*/
-
-		/*
-		int32_t primary_chunk_mask = 0;
-		for (uint16_t i = 0; i < chunk_height; ++i) {
-			if (chunk->sections[i].block_count != 0) {
-				primary_chunk_mask |= (1 << i);
-			}
+	}
+	for (uint16_t i = 0; i < chunk_mask_length; ++i) {
+		pck_write_int64(packet, primary_chunk_mask[i]);
+	}*/
+
+	/*
+	int32_t primary_chunk_mask = 0;
+	for (uint16_t i = 0; i < chunk_height; ++i) {
+		if (chunk->sections[i].block_count != 0) {
+			primary_chunk_mask |= (1 << i);
 		}
-		pck_write_var_int(packet, primary_chunk_mask);
-		*/
+	}
+	pck_write_var_int(packet, primary_chunk_mask);
+	*/
 
-		// HEIGHTMAP
-		
-		const uint16_t chunk_height = mat_get_chunk_height(wld_get_environment(wld_chunk_get_world(chunk)));
+	// HEIGHTMAP
+	
+	const uint16_t chunk_height = mat_get_chunk_height(wld_get_environment(wld_chunk_get_world(chunk)));
 
-		const uint8_t bits_per_heightmap = ceil(log2((chunk_height << 4) + 1));
-		const uint32_t heightmap_size = 1 + (255 / (64 / bits_per_heightmap));
-		int64_t motion_blocking[heightmap_size];
-		int64_t world_surface[heightmap_size];
+	const uint8_t bits_per_heightmap = ceil(log2((chunk_height << 4) + 1));
+	const uint32_t heightmap_size = 1 + (255 / (64 / bits_per_heightmap));
+	int64_t motion_blocking[heightmap_size];
+	int64_t world_surface[heightmap_size];
 
-		utl_encode_shorts_to_longs(wld_chunk_get_highest_motion_blocking(chunk), 256, bits_per_heightmap, motion_blocking);
-		utl_encode_shorts_to_longs(wld_chunk_get_highest_world_surface(chunk), 256, bits_per_heightmap, world_surface);
+	utl_encode_shorts_to_longs(wld_chunk_get_highest_motion_blocking(chunk), 256, bits_per_heightmap, motion_blocking);
+	utl_encode_shorts_to_longs(wld_chunk_get_highest_world_surface(chunk), 256, bits_per_heightmap, world_surface);
 
-		// create heightmap
-		mnbt_doc* doc = mnbt_new();
-		mnbt_tag* tag = mnbt_new_tag(doc, UTL_CSTRTOARG(""), MNBT_COMPOUND, mnbt_val_compound());
-		mnbt_push_tag(tag, mnbt_new_tag(doc, UTL_CSTRTOARG("MOTION_BLOCKING"), MNBT_LONG_ARRAY, mnbt_val_long_array(motion_blocking, heightmap_size)));
-		mnbt_push_tag(tag, mnbt_new_tag(doc, UTL_CSTRTOARG("WORLD_SURFACE"), MNBT_LONG_ARRAY, mnbt_val_long_array(world_surface, heightmap_size)));
-		mnbt_set_root(doc, tag);
+	// create heightmap
+	mnbt_doc* doc = mnbt_new();
+	mnbt_tag* tag = mnbt_new_tag(doc, UTL_CSTRTOARG(""), MNBT_COMPOUND, mnbt_val_compound());
+	mnbt_push_tag(tag, mnbt_new_tag(doc, UTL_CSTRTOARG("MOTION_BLOCKING"), MNBT_LONG_ARRAY, mnbt_val_long_array(motion_blocking, heightmap_size)));
+	mnbt_push_tag(tag, mnbt_new_tag(doc, UTL_CSTRTOARG("WORLD_SURFACE"), MNBT_LONG_ARRAY, mnbt_val_long_array(world_surface, heightmap_size)));
+	mnbt_set_root(doc, tag);
 
-		pck_write_nbt(packet, doc);
+	pck_write_nbt(packet, doc);
 
-		mnbt_free(doc);
+	mnbt_free(doc);
 
-		// BIOMES
+	// BIOMES
 
-		/*
-		pck_write_var_int(packet, chunk_height << 6);
+	/*
+	pck_write_var_int(packet, chunk_height << 6);
 
-		for (uint16_t i = 0; i < chunk_height; ++i) {
-			for (uint8_t x = 0; x < 4; ++x) {
-				for (uint8_t z = 0; z < 4; ++z) {
-					for (uint8_t y = 0; y < 4; ++y) {
-						pck_write_var_int(packet, wld_chunk_section_get_biome(wld_chunk_get_section(chunk, i), x, y, z));
-					}
+	for (uint16_t i = 0; i < chunk_height; ++i) {
+		for (uint8_t x = 0; x < 4; ++x) {
+			for (uint8_t z = 0; z < 4; ++z) {
+				for (uint8_t y = 0; y < 4; ++y) {
+					pck_write_var_int(packet, wld_chunk_section_get_biome(wld_chunk_get_section(chunk, i), x, y, z));
 				}
 			}
 		}
-		*/
-
-		// CHUNK DATA
-
-		// am i really gonna waste time copying data from one stream to another or am i gonna just waste 4 bytes?
-		// you're damn right i'm gonna waste 4 bytes, speed is key
-		const size_t data_len = packet->cursor;
-		packet->cursor += 5;
+	}
+	*/
 
-		for (uint16_t i = 0; i < chunk_height; ++i) {
+	// CHUNK DATA
 
-			const uint16_t block_count = wld_chunk_section_get_block_count(wld_chunk_get_section(chunk, i));
+	// am i really gonna waste time copying data from one stream to another or am i gonna just waste 4 bytes?
+	// you're damn right i'm gonna waste 4 bytes, speed is key
+	const size_t data_len = packet->cursor;
+	packet->cursor += 5;
 
-			pck_write_int16(packet, block_count);
+	for (uint16_t i = 0; i < chunk_height; ++i) {
 
-			// block state array
-			if (block_count > 0) {
-				struct {
-					mat_block_protocol_id_t array[256];
-					uint8_t length;
-				} palette = {
-					.length = 1
-				};
-				palette.array[0] = wld_chunk_section_get_blocks(wld_chunk_get_section(chunk, i))[0];
-				
-				int8_t block_array[4096];
+		const uint16_t block_count = wld_chunk_section_get_block_count(wld_chunk_get_section(chunk, i));
 
-				struct {
-					mat_block_protocol_id_t block;
-					uint16_t palette;
-				} previous = {
-					.block = palette.array[0],
-					.palette = 0
-				};
+		pck_write_int16(packet, block_count);
 
-				for (uint16_t j = 0; j < 4096; ++j) {
+		// block state array
+		if (block_count > 0) {
+			struct {
+				int32_t array[256]; // as wide as a varint so it can be written in one go
+				uint8_t length;
+			} palette = {
+				.length = 1
+			};
+			palette.array[0] = wld_chunk_section_get_blocks(wld_chunk_get_section(chunk, i))[0];
+			
+			int8_t block_array[4096];
 
-					const mat_block_protocol_id_t block = wld_chunk_section_get_blocks(wld_chunk_get_section(chunk, i))[j];
-					if (block == previous.block) {
-						block_array[j] = previous.palette;
-					} else {
-						// test if block is in palette
-						for (uint8_t k = 0; k < palette.length; ++k) {
-							if (palette.array[k] == block) {
-								block_array[j] = previous.palette = k;
-								previous.block = block;
+			struct {
+				mat_block_protocol_id_t block;
+				uint16_t palette;
+			} previous = {
+				.block = palette.array[0],
+				.palette = 0
+			};
 
-								goto end;
-							}
-						}
+			for (uint16_t j = 0; j < 4096; ++j) {
 
-						// add to palette (it hasn't been found)
-						if (palette.length < 255) {
-							palette.array[palette.length] = block;
-							block_array[j] = previous.palette = palette.length++;
+				const mat_block_protocol_id_t block = wld_chunk_section_get_blocks(wld_chunk_get_section(chunk, i))[j];
+				if (block == previous.block) {
+					block_array[j] = previous.palette;
+				} else {
+					// test if block is in palette
+					for (uint8_t k = 0; k < palette.length; ++k) {
+						if (palette.array[k] == block) {
+							block_array[j] = previous.palette = k;
 							previous.block = block;
-						} else {
-							// palette is too big, use direct
-							break;
+
+							goto end;
 						}
 					}
-					end:{}
-				}
 
-				if (palette.length == 1) {
-					pck_write_int8(packet, 0);
-					pck_write_var_int(packet, palette.array[0]);
-					pck_write_var_int(packet, 0);
-				} else if (palette.length < 255) {
-					// use palette
-					uint8_t bits_per_block;
-					if (palette.length < 17) {
-						bits_per_block = 4;
-					} else if (palette.length < 33) {
-						bits_per_block = 5;
-					} else if (palette.length < 65) {
-						bits_per_block = 6;
-					} else if (palette.length < 129) {
-						bits_per_block = 7;
+					// add to palette (it hasn't been found)
+					if (palette.length < 255) {
+						palette.array[palette.length] = block;
+						block_array[j] = previous.palette = palette.length++;
+						previous.block = block;
 					} else {
-						bits_per_block = 8;
-					}
-					const uint8_t blocks_per_long = 64 / bits_per_block;
-					const int32_t data_array_length = 1 + (4095 / blocks_per_long);
-
-					pck_write_int8(packet, bits_per_block);
-					pck_write_var_int(packet, palette.length);
-					for (uint8_t j = 0; j < palette.length; ++j) {
-						pck_write_var_int(packet, palette.array[j]);
+						// palette is too big, use direct
+						break;
 					}
-
-					pck_write_var_int(packet, data_array_length);
-					
-					utl_encode_bytes_to_longs_r(block_array, 4096, bits_per_block, (int64_t*) pck_cursor(packet));
-					packet->cursor += data_array_length << 3;
-				} else {
-					// direct
-					const uint8_t bits_per_block = 15; // log2(block_state_count)
-					const uint8_t blocks_per_long = 64 / bits_per_block;
-					const int32_t data_array_length = 1 + (4095 / blocks_per_long);
-
-					pck_write_int8(packet, bits_per_block);
-					pck_write_var_int(packet, data_array_length); // data array length
-					
-					utl_encode_shorts_to_longs_r((int16_t*) wld_chunk_section_get_blocks(wld_chunk_get_section(chunk, i)), 4096, bits_per_block, (int64_t*) pck_cursor(packet));
-					packet->cursor += data_array_length << 3;
 				}
-			} else {
+				end:{}
+			}
+
+			if (palette.length == 1) {
 				pck_write_int8(packet, 0);
-				pck_write_var_int(packet, mat_get_block_default_protocol_id_by_type(mat_block_air));
+				pck_write_var_int(packet, palette.array[0]);
 				pck_write_var_int(packet, 0);
-			}
-			// biome array
-			{
-				struct {
-					mat_biome_type_t array[64];
-					uint8_t length;
-				} palette = {
-					.length = 1
-				};
-				palette.array[0] = wld_chunk_section_get_biomes(wld_chunk_get_section(chunk, i))[0];
-
-				int8_t biome_array[64];
-
-				struct {
-					mat_biome_type_t biome;
-					uint16_t palette;
-				} previous = {
-					.biome = palette.array[0],
-					.palette = 0
-				};
-
-				for (uint16_t j = 0; j < 64; ++j) {
-
-					const mat_biome_type_t biome = wld_chunk_section_get_biomes(wld_chunk_get_section(chunk, i))[j];
-					if (biome == previous.biome) {
-						biome_array[j] = previous.palette;
-					} else {
-						// test if block is in palette
-						for (uint8_t k = 0; k < palette.length; ++k) {
-							if (palette.array[k] == biome) {
-								biome_array[j] = previous.palette = k;
-								previous.biome = biome;
+			} else if (palette.length < 255) {
+				// use palette
+				uint8_t bits_per_block;
+				if (palette.length < 17) {
+					bits_per_block = 4;
+				} else if (palette.length < 33) {
+					bits_per_block = 5;
+				} else if (palette.length < 65) {
+					bits_per_block = 6;
+				} else if (palette.length < 129) {
+					bits_per_block = 7;
+				} else {
+					bits_per_block = 8;
+				}
+				const uint8_t blocks_per_long = 64 / bits_per_block;
+				const int32_t data_array_length = 1 + (4095 / blocks_per_long);
 
-								goto endb;
-							}
-						}
+				pck_write_int8(packet, bits_per_block);
+				pck_write_var_int(packet, palette.length);
+				pck_write_var_ints(packet, palette.array, palette.length);
 
-						// add to palette (it hasn't been found)
-						if (palette.length < 8) {
-							palette.array[palette.length] = biome;
-							biome_array[j] = previous.palette = palette.length++;
+				pck_write_var_int(packet, data_array_length);
+				
+				utl_encode_bytes_to_longs_r(block_array, 4096, bits_per_block, (int64_t*) pck_cursor(packet));
+				packet->cursor += data_array_length << 3;
+			} else {
+				// direct
+				const uint8_t bits_per_block = 15; // log2(block_state_count)
+				const uint8_t blocks_per_long = 64 / bits_per_block;
+				const int32_t data_array_length = 1 + (4095 / blocks_per_long);
+
+				pck_write_int8(packet, bits_per_block);
+				pck_write_var_int(packet, data_array_length); // data array length
+				
+				utl_encode_shorts_to_longs_r((int16_t*) wld_chunk_section_get_blocks(wld_chunk_get_section(chunk, i)), 4096, bits_per_block, (int64_t*) pck_cursor(packet));
+				packet->cursor += data_array_length << 3;
+			}
+		} else {
+			pck_write_int8(packet, 0);
+			pck_write_var_int(packet, mat_get_block_default_protocol_id_by_type(mat_block_air));
+			pck_write_var_int(packet, 0);
+		}
+		// biome array
+		{
+			struct {
+				mat_biome_type_t array[64];
+				uint8_t length;
+			} palette = {
+				.length = 1
+			};
+			palette.array[0] = wld_chunk_section_get_biomes(wld_chunk_get_section(chunk, i))[0];
+
+			int8_t biome_array[64];
+
+			struct {
+				mat_biome_type_t biome;
+				uint16_t palette;
+			} previous = {
+				.biome = palette.array[0],
+				.palette = 0
+			};
+
+			for (uint16_t j = 0; j < 64; ++j) {
+
+				const mat_biome_type_t biome = wld_chunk_section_get_biomes(wld_chunk_get_section(chunk, i))[j];
+				if (biome == previous.biome) {
+					biome_array[j] = previous.palette;
+				} else {
+					// test if block is in palette
+					for (uint8_t k = 0; k < palette.length; ++k) {
+						if (palette.array[k] == biome) {
+							biome_array[j] = previous.palette = k;
 							previous.biome = biome;
-						} else {
-							// palette is too big, use direct
-							break;
+
+							goto endb;
 						}
 					}
-					endb:{}
-				}
 
-				if (palette.length == 1) {
-					pck_write_int8(packet, 0);
-					pck_write_var_int(packet, palette.array[0]);
-					pck_write_var_int(packet, 0);
-				} else if (palette.length < 9) {
-					// use palette
-					uint8_t bits_per_biome;
-					if (palette.length < 3) {
-						bits_per_biome = 1;
-					} else if (palette.length < 5) {
-						bits_per_biome = 2;
+					// add to palette (it hasn't been found)
+					if (palette.length < 8) {
+						palette.array[palette.length] = biome;
+						biome_array[j] = previous.palette = palette.length++;
+						previous.biome = biome;
 					} else {
-						bits_per_biome = 3;
-					}
-					const uint8_t biomes_per_long = 64 / bits_per_biome;
-					const int32_t data_array_length = 1 + (63 / biomes_per_long);
-
-					pck_write_int8(packet, bits_per_biome);
-					pck_write_var_int(packet, palette.length);
-					for (uint8_t j = 0; j < palette.length; ++j) {
-						pck_write_var_int(packet, palette.array[j]);
+						// palette is too big, use direct
+						break;
 					}
+				}
+				endb:{}
+			}
 
-					pck_write_var_int(packet, data_array_length);
-					
-					utl_encode_bytes_to_longs_r(biome_array, 64, bits_per_biome, (int64_t*) pck_cursor(packet));
-					packet->cursor += data_array_length << 3;
+			if (palette.length == 1) {
+				pck_write_int8(packet, 0);
+				pck_write_var_int(packet, palette.array[0]);
+				pck_write_var_int(packet, 0);
+			} else if (palette.length < 9) {
+				// use palette
+				uint8_t bits_per_biome;
+				if (palette.length < 3) {
+					bits_per_biome = 1;
+				} else if (palette.length < 5) {
+					bits_per_biome = 2;
 				} else {
-					// direct
-					const uint8_t bits_per_biome = 4; // log2(biome_count)
-					const uint8_t biomes_per_long = 64 / bits_per_biome;
-					const int32_t data_array_length = 1 + (63 / biomes_per_long);
-
-					pck_write_int8(packet, bits_per_biome);
-					pck_write_var_int(packet, data_array_length); // data array length
-					
-					utl_encode_bytes_to_longs_r((int8_t*) wld_chunk_section_get_biomes(wld_chunk_get_section(chunk, i)), 64, bits_per_biome, (int64_t*) pck_cursor(packet));
-					packet->cursor += data_array_length << 3;
+					bits_per_biome = 3;
 				}
+				const uint8_t biomes_per_long = 64 / bits_per_biome;
+				const int32_t data_array_length = 1 + (63 / biomes_per_long);
+
+				pck_write_int8(packet, bits_per_biome);
+				pck_write_var_int(packet, palette.length);
+				for (uint8_t j = 0; j < palette.length; ++j) {
+					pck_write_var_int(packet, palette.array[j]);
+				}
+
+				pck_write_var_int(packet, data_array_length);
+				
+				utl_encode_bytes_to_longs_r(biome_array, 64, bits_per_biome, (int64_t*) pck_cursor(packet));
+				packet->cursor += data_array_length << 3;
+			} else {
+				// direct
+				const uint8_t bits_per_biome = 4; // log2(biome_count)
+				const uint8_t biomes_per_long = 64 / bits_per_biome;
+				const int32_t data_array_length = 1 + (63 / biomes_per_long);
+
+				pck_write_int8(packet, bits_per_biome);
+				pck_write_var_int(packet, data_array_length); // data array length
+				
+				utl_encode_bytes_to_longs_r((int8_t*) wld_chunk_section_get_biomes(wld_chunk_get_section(chunk, i)), 64, bits_per_biome, (int64_t*) pck_cursor(packet));
+				packet->cursor += data_array_length << 3;
 			}
 		}
+	}
 
-		const size_t current = packet->cursor;
-		packet->cursor = data_len;
-		pck_write_long_var_int(packet, current - data_len - 5);
-		packet->cursor = current;
+	const size_t current = packet->cursor;
+	packet->cursor = data_len;
+	pck_write_long_var_int(packet, current - data_len - 5);
+	packet->cursor = current;
 
-		// BLOCK ENTITIES
-		// TODO block entities
-		pck_write_var_int(packet, 0);
-
-		// light
-		pck_write_int8(packet, true); // trust edges
+	// BLOCK ENTITIES
+	// TODO block entities
+	pck_write_var_int(packet, 0);
 
-		pck_write_var_int(packet, 0); // sky light mask length
+	// light
+	pck_write_int8(packet, true); // trust edges
 
-		pck_write_var_int(packet, 0); // block light mask length
+	pck_write_var_int(packet, 0); // sky light mask length
 
-		pck_write_var_int(packet, 0); // empty sky light mask length
+	pck_write_var_int(packet, 0); // block light mask length
 
-		pck_write_var_int(packet, 0); // empty block light mask length
+	pck_write_var_int(packet, 0); // empty sky light mask length
 
-		pck_write_var_int(packet, 0); // sky light array count
+	pck_write_var_int(packet, 0); // empty block light mask length
 
-		pck_write_var_int(packet, 0); // block light array count
+	pck_write_var_int(packet, 0); // sky light array count
 
-		ltg_send(client, packet);
+	pck_write_var_int(packet, 0); // block light array count
 
-	}
+	ltg_send(client, packet);
+	pck_release(packet);
 
 }
 
 void phd_send_update_light(ltg_client_t* client, wld_chunk_t* chunk) {
 
-	PCK_INLINE(packet, 8192, io_big_endian);
+	pck_packet_t* packet = pck_acquire(8192, io_big_endian);
 
 	pck_write_var_int(packet, 0x25);
 	pck_write_var_int(packet, wld_get_chunk_x(chunk));
@@ -1317,6 +1323,7 @@ void phd_send_update_light(ltg_client_t* client, wld_chunk_t* chunk) {
 	pck_write_var_int(packet, 0); // block light array count
 
 	ltg_send(client, packet);
+	pck_release(packet);
 
 }
 
@@ -1343,7 +1350,7 @@ void phd_send_join_game(ltg_client_t* client) {
 	const mat_codec_t* codec = mat_get_codec();
 	const mat_codec_t* dimension_codec = mat_get_dimension_codec(wld_get_environment(player_world));
 
-	PCK_INLINE(packet, codec->size + dimension_codec->size + 1024, io_big_endian);
+	pck_packet_t* packet = pck_acquire(codec->size + dimension_codec->size + 1024, io_big_endian);
 
 	pck_write_var_int(packet, 0x26);
 	pck_write_int32(packet, ent_get_id(ent_player_get_entity(player))); // entity ID
@@ -1381,6 +1388,7 @@ void phd_send_join_game(ltg_client_t* client) {
 	pck_write_int8(packet, wld_is_flat(player_world)); // is flat
 
 	ltg_send(client, packet);
+	pck_release(packet);
 
 	// NORMAL LOGIN SEQUENCE
 	phd_send_plugin_message(client, UTL_CSTRTOARG("minecraft:brand"), (const byte_t*) UTL_CSTRTOARG("\x07MotorMC"));
@@ -1510,7 +1518,7 @@ void phd_send_player_info_add_players(ltg_client_t* client) {
 		return;
 	}
 
-	PCK_INLINE(packet, 3 + (online_count * 2048), io_big_endian);
+	pck_packet_t* packet = pck_acquire(3 + (online_count * 2048), io_big_endian);
 
 	pck_write_var_int(packet, 0x36);
 	pck_write_var_int(packet, 0);
@@ -1549,12 +1557,12 @@ void phd_send_player_info_add_players(ltg_client_t* client) {
 	}
 
 	ltg_send(client, packet);
+	pck_release(packet);
 
 }
 
-void phd_send_player_info_add_player(ltg_client_t* client, ltg_client_t* player) {
+static void phd_write_player_info_add_player(pck_packet_t* packet, ltg_client_t* player) {
 
-	PCK_INLINE(packet, 2048, io_big_endian);
 	pck_write_var_int(packet, 0x36);
 	pck_write_var_int(packet, 0); // action
 	pck_write_var_int(packet, 1); // number of players
@@ -1581,17 +1589,37 @@ void phd_send_player_info_add_player(ltg_client_t* client, ltg_client_t* player)
 
 	pck_write_int8(packet, false); // has display name
 
+}
+
+void phd_send_player_info_add_player(ltg_client_t* client, ltg_client_t* player) {
+
+	PCK_INLINE(packet, 2048, io_big_endian);
+
+	phd_write_player_info_add_player(packet, player);
+
 	ltg_send(client, packet);
 
 }
 
+ltg_broadcast_t* phd_create_player_info_add_player(ltg_client_t* player) {
+
+	PCK_INLINE(packet, 2048, io_big_endian);
+
+	phd_write_player_info_add_player(packet, player);
+
+	return ltg_create_broadcast(packet);
+
+}
+
 void phd_send_player_info_update_gamemode(__attribute__((unused)) ltg_client_t* client, __attribute__((unused)) ltg_client_t* player) {
 
 }
 
 void phd_send_player_info_update_latency(ltg_client_t* client) {
 
-	uint32_t online_count = ltg_get_online_count(sky_get_listener());
+	ltg_listener_t* listener = sky_get_listener();
+
+	uint32_t online_count = utl_id_vector_count(&listener->online.vector);
 
 	PCK_INLINE(packet, 21 * online_count + 6, io_big_endian);
 
@@ -1599,9 +1627,9 @@ void phd_send_player_info_update_latency(ltg_client_t* client) {
 	pck_write_var_int(packet, 2); // update latency
 	pck_write_var_int(packet, online_count);
 	
-	const uint32_t online_length = ltg_get_online_length(sky_get_listener());
+	const uint32_t online_length = utl_id_vector_length(&listener->online.vector);
 	for (uint32_t i = 0; i < online_length; ++i) {
-		ltg_client_t* player = ltg_get_online_client(sky_get_listener(), i);
+		ltg_client_t* player = UTL_ID_VECTOR_GET_AS(ltg_client_t*, &listener->online.vector, i);
 		if (player != NULL) {
 			pck_write_bytes(packet, ltg_client_get_uuid(player), 16);
 			pck_write_var_int(packet, ltg_client_get_ping(player));
@@ -1618,18 +1646,35 @@ void phd_send_player_info_update_display_name(__attribute__((unused)) ltg_client
 
 }
 
-void phd_send_player_info_remove_player(ltg_client_t* client, ltg_uuid_t uuid) {
+static void phd_write_player_info_remove_player(pck_packet_t* packet, ltg_uuid_t uuid) {
 
-	PCK_INLINE(packet, 19, io_big_endian);
 	pck_write_var_int(packet, 0x36);
 	pck_write_var_int(packet, 4);
 	pck_write_var_int(packet, 1);
 	pck_write_bytes(packet, uuid, 16);
 
+}
+
+void phd_send_player_info_remove_player(ltg_client_t* client, ltg_uuid_t uuid) {
+
+	PCK_INLINE(packet, 19, io_big_endian);
+
+	phd_write_player_info_remove_player(packet, uuid);
+
 	ltg_send(client, packet);
 
 }
 
+ltg_broadcast_t* phd_create_player_info_remove_player(ltg_uuid_t uuid) {
+
+	PCK_INLINE(packet, 19, io_big_endian);
+
+	phd_write_player_info_remove_player(packet, uuid);
+
+	return ltg_create_broadcast(packet);
+
+}
+
 void phd_send_player_position_and_look(ltg_client_t* client) {
 
 	PCK_INLINE(packet, 40, io_big_endian);
@@ -1695,7 +1740,7 @@ void phd_send_respawn(ltg_client_t* client, wld_world_t* world, bool keep_metada
 
 	const mat_codec_t* dimension_codec = mat_get_dimension_codec(wld_get_environment(world));
 
-	PCK_INLINE(packet, 19 + dimension_codec->size + UTL_STRLEN(wld_get_name(world)), io_big_endian);
+	pck_packet_t* packet = pck_acquire(19 + dimension_codec->size + UTL_STRLEN(wld_get_name(world)), io_big_endian);
 
 	pck_write_var_int(packet, 0x3d);
 	pck_write_bytes(packet, dimension_codec->bytes, dimension_codec->size);
@@ -1708,6 +1753,7 @@ void phd_send_respawn(ltg_client_t* client, wld_world_t* world, bool keep_metada
 	pck_write_int8(packet, keep_metadata);
 
 	ltg_send(client, packet);
+	pck_release(packet);
 
 }
 
@@ -1862,7 +1908,7 @@ void phd_send_living_entity_teleport(ltg_client_t* client, ent_living_entity_t*
 
 void phd_send_declare_recipes(ltg_client_t* client) {
 
-	PCK_INLINE(packet, 6 + rec_recipes.size * 128, io_big_endian);
+	pck_packet_t* packet = pck_acquire(6 + rec_recipes.size * 128, io_big_endian);
 	
 	pck_write_var_int(packet, 0x66);
 	pck_write_var_int(packet, rec_recipes.size);
@@ -1874,12 +1920,13 @@ void phd_send_declare_recipes(ltg_client_t* client) {
 	}
 
 	ltg_send(client, packet);
+	pck_release(packet);
 
 }
 
 void phd_send_tags(ltg_client_t* client) {
 
-	PCK_INLINE(packet, 16384, io_big_endian);
+	pck_packet_t* packet = pck_acquire(16384, io_big_endian);
 
 	pck_write_var_int(packet, 0x67);
 	pck_write_var_int(packet, 5);
@@ -1890,9 +1937,7 @@ void phd_send_tags(ltg_client_t* client) {
 	for (int32_t i = 0; i < mat_block_tag_count; ++i) {
 		pck_write_string(packet, UTL_STRTOARG(mat_block_tags[i]->identifier));
 		pck_write_var_int(packet, mat_block_tags[i]->count);
-		for (int32_t j = 0; j < mat_block_tags[i]->count; ++j) {
-			pck_write_var_int(packet, mat_block_tags[i]->entries[j]);
-		}
+		pck_write_var_ints(packet, mat_block_tags[i]->entries, mat_block_tags[i]->count);
 	}
 
 	pck_write_string(packet, UTL_CSTRTOARG("minecraft:item"));
@@ -1901,9 +1946,7 @@ void phd_send_tags(ltg_client_t* client) {
 	for (int32_t i = 0; i < mat_item_tag_count; ++i) {
 		pck_write_string(packet, UTL_STRTOARG(mat_item_tags[i]->identifier));
 		pck_write_var_int(packet, mat_item_tags[i]->count);
-		for (int32_t j = 0; j < mat_item_tags[i]->count; ++j) {
-			pck_write_var_int(packet, mat_item_tags[i]->entries[j]);
-		}
+		pck_write_var_ints(packet, mat_item_tags[i]->entries, mat_item_tags[i]->count);
 	}
 
 	pck_write_string(packet, UTL_CSTRTOARG("minecraft:fluid"));
@@ -1912,9 +1955,7 @@ void phd_send_tags(ltg_client_t* client) {
 	for (int32_t i = 0; i < mat_fluid_tag_count; ++i) {
 		pck_write_string(packet, UTL_STRTOARG(mat_fluid_tags[i]->identifier));
 		pck_write_long_var_int(packet, mat_fluid_tags[i]->count);
-		for (int32_t j = 0; j < mat_fluid_tags[i]->count; ++j) {
-			pck_write_var_int(packet, mat_fluid_tags[i]->entries[j]);
-		}
+		pck_write_var_ints(packet, mat_fluid_tags[i]->entries, mat_fluid_tags[i]->count);
 	}
 
 	pck_write_string(packet, UTL_CSTRTOARG("minecraft:entity_type"));
@@ -1923,9 +1964,7 @@ void phd_send_tags(ltg_client_t* client) {
 	for (int32_t i = 0; i < mat_entity_type_tag_count; ++i) {
 		pck_write_string(packet, UTL_STRTOARG(mat_entity_type_tags[i]->identifier));
 		pck_write_var_int(packet, mat_entity_type_tags[i]->count);
-		for (int32_t j = 0; j < mat_entity_type_tags[i]->count; ++j) {
-			pck_write_var_int(packet, mat_entity_type_tags[i]->entries[j]);
-		}
+		pck_write_var_ints(packet, mat_entity_type_tags[i]->entries, mat_entity_type_tags[i]->count);
 	}
 
 	pck_write_string(packet, UTL_CSTRTOARG("minecraft:game_event"));
@@ -1934,12 +1973,11 @@ void phd_send_tags(ltg_client_t* client) {
 	for (int32_t i = 0; i < mat_game_event_tag_count; ++i) {
 		pck_write_string(packet, UTL_STRTOARG(mat_game_event_tags[i]->identifier));
 		pck_write_var_int(packet, mat_game_event_tags[i]->count);
-		for (int32_t j = 0; j < mat_game_event_tags[i]->count; ++j) {
-			pck_write_var_int(packet, mat_game_event_tags[i]->entries[j]);
-		}
+		pck_write_var_ints(packet, mat_game_event_tags[i]->entries, mat_game_event_tags[i]->count);
 	}
 
 	ltg_send(client, packet);
+	pck_release(packet);
 
 }
 
@@ -2218,6 +2256,38 @@ void phd_update_sent_chunks_leave(ltg_client_t* client) {
 
 }
 
+void phd_update_sent_chunks_caught_up(ltg_client_t* client) {
+
+	ent_entity_t* player = ent_player_get_entity(ltg_client_get_entity(client));
+	const wld_chunk_t* chunk = ent_get_chunk(player);
+
+	const uint8_t client_render_distance = ltg_client_get_render_distance(client);
+
+	for (int16_t x = -client_render_distance; x <= client_render_distance; ++x) {
+		for (int16_t z = -client_render_distance; z <= client_render_distance; ++z) {
+
+			wld_chunk_t* v_c = wld_relative_chunk(chunk, x, z);
+
+			// held back while the client was lagging
+			if (!wld_chunk_has_subscriber(v_c, ltg_client_get_id(client))) {
+				phd_update_subscribe_chunk(client, v_c);
+				continue;
+			}
+
+			// entities that moved while the client was lagging and haven't moved since
+			const uint32_t entity_length = wld_chunk_get_entity_length(v_c);
+			for (uint32_t i = 0; i < entity_length; ++i) {
+				ent_entity_t* entity = wld_chunk_get_entity(v_c, i);
+				if (entity != NULL && entity != player && ltg_take_stale(client, ent_get_id(entity))) {
+					phd_update_resync_entity(client, entity);
+				}
+			}
+
+		}
+	}
+
+}
+
 void phd_update_respawn(ltg_client_t* client) {
 
 	// TODO do something here
@@ -75,6 +75,9 @@ extern void phd_send_server_difficulty(ltg_client_t* client);
 
 extern void phd_send_chat_message(ltg_client_t* client, const char* message, size_t message_length, const ltg_uuid_t uuid);
 extern void phd_send_system_chat_message(ltg_client_t* client, const char* message, size_t message_length);
+// the same packets framed once, to be sent to many clients with ltg_broadcast
+extern ltg_broadcast_t* phd_create_chat_message(const char* message, size_t message_length, const ltg_uuid_t uuid);
+extern ltg_broadcast_t* phd_create_system_chat_message(const char* message, size_t message_length);
 
 extern void phd_send_clear_tiles(ltg_client_t*);
 extern void phd_send_tab_complete(ltg_client_t*);
@@ -118,11 +121,13 @@ extern void phd_send_death_combat_event(ltg_client_t* client, ent_player_t* play
 
 extern void phd_send_player_info_add_players(ltg_client_t* client);
 extern void phd_send_player_info_add_player(ltg_client_t* client, ltg_client_t* player);
+extern ltg_broadcast_t* phd_create_player_info_add_player(ltg_client_t* player);
 extern void phd_send_player_info_update_gamemode(ltg_client_t* client, ltg_client_t* player);
 // does NOT lock players list, expects it to be locked beforehand
 extern void phd_send_player_info_update_latency(ltg_client_t* client);
 extern void phd_send_player_info_update_display_name(ltg_client_t* client, ltg_client_t* player);
 extern void phd_send_player_info_remove_player(ltg_client_t* client, ltg_uuid_t uuid);
+extern ltg_broadcast_t* phd_create_player_info_remove_player(ltg_uuid_t uuid);
 
 extern void phd_send_face_player(ltg_client_t*);
 extern void phd_send_player_position_and_look(ltg_client_t* client);
@@ -191,8 +196,29 @@ static inline void phd_update_send_entity(ltg_client_t* client, ent_entity_t* en
 	}
 }
 
+// send where an entity is now to a client that skipped its movement updates
+static inline void phd_update_resync_entity(ltg_client_t* client, ent_entity_t* entity) {
+	switch (ent_get_type(entity)) {
+		case ent_player: {
+			phd_send_living_entity_teleport(client, (ent_living_entity_t*) entity);
+			phd_send_entity_head_look(client, (ent_living_entity_t*) entity);
+		} break;
+		default: {
+			phd_send_entity_teleport(client, entity);
+		} break;
+	}
+}
+
 static inline void phd_update_subscribe_chunk(ltg_client_t* client, wld_chunk_t* chunk) {
 
+	// a lagging client only gets the chunks around it, the rest are sent once it catches up
+	const wld_chunk_t* center = ent_get_chunk(ent_player_get_entity(ltg_client_get_entity(client)));
+	const int64_t distance = UTL_MAX(UTL_ABS(wld_get_chunk_x(chunk) - wld_get_chunk_x(center)), UTL_ABS(wld_get_chunk_z(chunk) - wld_get_chunk_z(center)));
+
+	if (ltg_defer_chunk(client, UTL_MIN(distance, UINT8_MAX))) {
+		return;
+	}
+
 	phd_send_chunk_data_and_update_light(client, chunk);
 	wld_subscribe_chunk(chunk, ltg_client_get_id(client));
 
@@ -217,5 +243,6 @@ extern void phd_update_sent_chunks_move(ltg_client_t* client, const wld_chunk_t*
 extern void phd_update_sent_chunks_teleport(ltg_client_t* client, const wld_chunk_t* old_chunk);
 extern void phd_update_sent_chunks_remove(ltg_client_t* client, const wld_chunk_t* chunk);
 extern void phd_update_sent_chunks_leave(ltg_client_t* client);
+extern void phd_update_sent_chunks_caught_up(ltg_client_t* client);
 
 extern void phd_update_respawn(ltg_client_t* client);
\ No newline at end of file
@@ -6,6 +6,11 @@ bool phd_status(ltg_client_t* client, pck_packet_t* packet) {
 
 	const int32_t id = pck_read_var_int(packet);
 
+	// scanners and refresh storms get their connection closed
+	if (!ltg_admit_status(client->listener, client->address.addr.sin_addr.s_addr, ltg_millis())) {
+		return false;
+	}
+
 	switch (id) {
 		case 0x00: {
 			return phd_handle_request(client, packet);
@@ -40,23 +45,41 @@ bool phd_handle_ping(ltg_client_t* client, pck_packet_t* packet) {
 
 	phd_send_pong(client, random);
 
+	client->listener->status.pings++;
+
 	return true;
 
 }
 
 void phd_send_response(ltg_client_t* client) {
 
-	// TODO cache SLP
+	ltg_listener_t* listener = client->listener;
 
-	char slp[2048];
-	int32_t slp_length = cht_server_list_ping(slp);
+	uint32_t generation;
+	ltg_broadcast_t* response = ltg_get_status(listener, &generation);
 
-	PCK_INLINE(response, 2048, io_big_endian);
+	// built again only after the motd or the online players changed
+	if (response == NULL) {
 
-	pck_write_var_int(response, 0x00);
-	pck_write_string(response, slp, slp_length);
+		char slp[2048];
+		int32_t slp_length = cht_server_list_ping(slp);
 
-	ltg_send(client, response);
+		PCK_INLINE(packet, 2048, io_big_endian);
+
+		pck_write_var_int(packet, 0x00);
+		pck_write_string(packet, slp, slp_length);
+
+		response = ltg_create_broadcast(packet);
+		ltg_set_status(listener, response, generation);
+
+		listener->status.built++;
+
+	}
+
+	ltg_broadcast(client, response);
+	ltg_release_broadcast(response);
+
+	listener->status.served++;
 
 }
 
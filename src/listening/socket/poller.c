@@ -0,0 +1,355 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "poller.h"
+#include "../../util/lock_util.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+bool sck_poller_init(sck_poller_t* poller) {
+
+	poller->epoll = epoll_create1(0);
+	poller->wake = eventfd(0, EFD_NONBLOCK);
+
+	// the wake up event is the only one without data
+	struct epoll_event event = {
+		.events = EPOLLIN,
+		.data.ptr = NULL
+	};
+
+	if (poller->epoll < 0 || poller->wake < 0 || epoll_ctl(poller->epoll, EPOLL_CTL_ADD, poller->wake, &event) != 0) {
+		sck_poller_term(poller);
+		return false;
+	}
+
+	return true;
+
+}
+
+bool sck_poller_add(sck_poller_t* poller, int32_t socket, void* data) {
+
+	struct epoll_event event = {
+		.events = EPOLLIN | EPOLLRDHUP,
+		.data.ptr = data
+	};
+
+	return epoll_ctl(poller->epoll, EPOLL_CTL_ADD, socket, &event) == 0;
+
+}
+
+void sck_poller_remove(sck_poller_t* poller, int32_t socket) {
+
+	epoll_ctl(poller->epoll, EPOLL_CTL_DEL, socket, NULL);
+
+}
+
+void sck_poller_set_writable(sck_poller_t* poller, int32_t socket, void* data, bool writable) {
+
+	struct epoll_event event = {
+		.events = EPOLLIN | EPOLLRDHUP | (writable ? EPOLLOUT : 0),
+		.data.ptr = data
+	};
+
+	epoll_ctl(poller->epoll, EPOLL_CTL_MOD, socket, &event);
+
+}
+
+int32_t sck_poller_wait(sck_poller_t* poller, sck_poll_event_t* events, uint32_t max) {
+
+	struct epoll_event ready[SCK_POLLER_MAX_EVENTS];
+
+	const int32_t count = epoll_wait(poller->epoll, ready, max < SCK_POLLER_MAX_EVENTS ? max : SCK_POLLER_MAX_EVENTS, -1);
+
+	if (count < 0) {
+		return -1;
+	}
+
+	int32_t written = 0;
+
+	for (int32_t i = 0; i < count; ++i) {
+
+		if (ready[i].data.ptr == NULL) {
+			uint64_t wakes;
+			if (read(poller->wake, &wakes, sizeof(wakes)) < 0) {
+				// already read
+			}
+			continue;
+		}
+
+		events[written++] = (sck_poll_event_t) {
+			.data = ready[i].data.ptr,
+			.readable = (ready[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) != 0,
+			.writable = (ready[i].events & EPOLLOUT) != 0
+		};
+
+	}
+
+	return written;
+
+}
+
+bool sck_poller_wake(sck_poller_t* poller) {
+
+	const uint64_t value = 1;
+	return write(poller->wake, &value, sizeof(value)) == sizeof(value);
+
+}
+
+void sck_poller_term(sck_poller_t* poller) {
+
+	if (poller->epoll >= 0) {
+		close(poller->epoll);
+	}
+	if (poller->wake >= 0) {
+		close(poller->wake);
+	}
+
+}
+
+#else
+
+#ifdef __WINDOWS__
+#define poll WSAPoll
+
+// windows can only poll sockets, so the thread is woken up through a socket connected to itself
+static bool sck_poller_open_wake(sck_poller_t* poller) {
+
+	const SOCKET wake = socket(AF_INET, SOCK_DGRAM, 0);
+
+	if (wake == INVALID_SOCKET) {
+		return false;
+	}
+
+	struct sockaddr_in address = {
+		.sin_family = AF_INET,
+		.sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+		.sin_port = 0
+	};
+	int length = sizeof(address);
+	u_long nonblocking = 1;
+
+	if (bind(wake, (struct sockaddr*) &address, sizeof(address)) != 0 || getsockname(wake, (struct sockaddr*) &address, &length) != 0 || connect(wake, (struct sockaddr*) &address, sizeof(address)) != 0 || ioctlsocket(wake, FIONBIO, &nonblocking) != 0) {
+		closesocket(wake);
+		return false;
+	}
+
+	poller->wake[0] = poller->wake[1] = wake;
+
+	return true;
+
+}
+
+static bool sck_poller_signal(sck_poller_t* poller) {
+
+	const char value = 1;
+	return send(poller->wake[1], &value, 1, 0) == 1;
+
+}
+
+static void sck_poller_drain(sck_poller_t* poller) {
+
+	char wakes[64];
+	while (recv(poller->wake[0], wakes, sizeof(wakes), 0) > 0);
+
+}
+
+static void sck_poller_close_wake(sck_poller_t* poller) {
+
+	closesocket(poller->wake[0]);
+
+}
+#else
+static bool sck_poller_open_wake(sck_poller_t* poller) {
+
+	if (pipe(poller->wake) != 0) {
+		return false;
+	}
+
+	fcntl(poller->wake[0], F_SETFL, fcntl(poller->wake[0], F_GETFL, 0) | O_NONBLOCK);
+	fcntl(poller->wake[1], F_SETFL, fcntl(poller->wake[1], F_GETFL, 0) | O_NONBLOCK);
+
+	return true;
+
+}
+
+static bool sck_poller_signal(sck_poller_t* poller) {
+
+	const char value = 1;
+	// a full pipe already wakes the thread up
+	return write(poller->wake[1], &value, 1) == 1 || errno == EAGAIN || errno == EWOULDBLOCK;
+
+}
+
+static void sck_poller_drain(sck_poller_t* poller) {
+
+	char wakes[64];
+	while (read(poller->wake[0], wakes, sizeof(wakes)) > 0);
+
+}
+
+static void sck_poller_close_wake(sck_poller_t* poller) {
+
+	close(poller->wake[0]);
+	close(poller->wake[1]);
+
+}
+#endif
+
+bool sck_poller_init(sck_poller_t* poller) {
+
+	memset(poller, 0, sizeof(sck_poller_t));
+
+	if (!sck_poller_open_wake(poller)) {
+		return false;
+	}
+
+	pthread_mutex_init(&poller->lock, NULL);
+
+	poller->capacity = 16;
+	poller->fds = malloc(poller->capacity * sizeof(struct pollfd));
+	poller->data = malloc(poller->capacity * sizeof(void*));
+
+	poller->fds[0] = (struct pollfd) { .fd = poller->wake[0], .events = POLLIN };
+	poller->data[0] = NULL;
+	poller->count = 1;
+
+	return true;
+
+}
+
+// the position of the socket, 0 if it was never added (that's where the wake up socket is)
+static inline uint32_t sck_poller_find_l(sck_poller_t* poller, int32_t socket) {
+
+	for (uint32_t i = 1; i < poller->count; ++i) {
+		if (poller->fds[i].fd == socket) {
+			return i;
+		}
+	}
+
+	return 0;
+
+}
+
+bool sck_poller_add(sck_poller_t* poller, int32_t socket, void* data) {
+
+	with_lock (&poller->lock) {
+
+		if (poller->count == poller->capacity) {
+			poller->capacity <<= 1;
+			poller->fds = realloc(poller->fds, poller->capacity * sizeof(struct pollfd));
+			poller->data = realloc(poller->data, poller->capacity * sizeof(void*));
+		}
+
+		poller->fds[poller->count] = (struct pollfd) { .fd = socket, .events = POLLIN };
+		poller->data[poller->count] = data;
+		poller->count++;
+
+	}
+
+	// the waiting thread has to start over to wait on it too
+	return sck_poller_wake(poller);
+
+}
+
+void sck_poller_remove(sck_poller_t* poller, int32_t socket) {
+
+	with_lock (&poller->lock) {
+
+		const uint32_t index = sck_poller_find_l(poller, socket);
+
+		if (index != 0) {
+			poller->count--;
+			poller->fds[index] = poller->fds[poller->count];
+			poller->data[index] = poller->data[poller->count];
+		}
+
+	}
+
+}
+
+void sck_poller_set_writable(sck_poller_t* poller, int32_t socket, void* data, bool writable) {
+
+	with_lock (&poller->lock) {
+
+		const uint32_t index = sck_poller_find_l(poller, socket);
+
+		if (index != 0) {
+			poller->fds[index].events = POLLIN | (writable ? POLLOUT : 0);
+			poller->data[index] = data;
+		}
+
+	}
+
+}
+
+int32_t sck_poller_wait(sck_poller_t* poller, sck_poll_event_t* events, uint32_t max) {
+
+	uint32_t count = 0;
+
+	with_lock (&poller->lock) {
+
+		if (poller->polled_capacity < poller->count) {
+			poller->polled_capacity = poller->capacity;
+			poller->polled = realloc(poller->polled, poller->polled_capacity * sizeof(struct pollfd));
+			poller->polled_data = realloc(poller->polled_data, poller->polled_capacity * sizeof(void*));
+		}
+
+		count = poller->count;
+		memcpy(poller->polled, poller->fds, count * sizeof(struct pollfd));
+		memcpy(poller->polled_data, poller->data, count * sizeof(void*));
+
+	}
+
+	if (poll(poller->polled, count, -1) < 0) {
+		return -1;
+	}
+
+	if (poller->polled[0].revents != 0) {
+		sck_poller_drain(poller);
+	}
+
+	// sockets past max are still ready next time
+	uint32_t written = 0;
+
+	for (uint32_t i = 1; i < count && written < max; ++i) {
+
+		const int16_t ready = poller->polled[i].revents;
+
+		if (ready == 0) {
+			continue;
+		}
+
+		events[written++] = (sck_poll_event_t) {
+			.data = poller->polled_data[i],
+			.readable = (ready & (POLLIN | POLLHUP | POLLERR)) != 0,
+			.writable = (ready & POLLOUT) != 0
+		};
+
+	}
+
+	return written;
+
+}
+
+bool sck_poller_wake(sck_poller_t* poller) {
+
+	return sck_poller_signal(poller);
+
+}
+
+void sck_poller_term(sck_poller_t* poller) {
+
+	sck_poller_close_wake(poller);
+	pthread_mutex_destroy(&poller->lock);
+
+	free(poller->fds);
+	free(poller->data);
+	free(poller->polled);
+	free(poller->polled_data);
+
+}
+
+#endif
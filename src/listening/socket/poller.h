@@ -0,0 +1,71 @@
+#pragma once
+#include <pthread.h>
+#include "socket.h"
+
+/*
+Waits for sockets to be readable or writable, and for other threads to wake the waiting thread up
+epoll on linux, poll everywhere else
+Only one thread may wait, any thread may add sockets and wake it up
+*/
+
+#define SCK_POLLER_MAX_EVENTS 64 // most events one wait returns
+
+#ifdef __linux__
+#define SCK_POLLER_NAME "epoll"
+#else
+#define SCK_POLLER_NAME "poll"
+#ifndef __WINDOWS__
+#include <poll.h>
+#endif
+#endif
+
+typedef struct {
+
+#ifdef __linux__
+	int32_t epoll;
+	// eventfd
+	int32_t wake;
+#else
+	// the sockets and what was added with them, the wake up socket first
+	pthread_mutex_t lock;
+	struct pollfd* fds;
+	void** data;
+	uint32_t count;
+	uint32_t capacity;
+
+	// copied from the above to wait on without holding the lock
+	struct pollfd* polled;
+	void** polled_data;
+	uint32_t polled_capacity;
+
+	// read end and write end
+	int32_t wake[2];
+#endif
+
+} sck_poller_t;
+
+typedef struct {
+
+	void* data;
+	// hang ups and errors count as readable, the read finds out what happened
+	bool readable;
+	bool writable;
+
+} sck_poll_event_t;
+
+extern bool sck_poller_init(sck_poller_t* poller);
+
+// the socket is waited on for reading until it is removed
+extern bool sck_poller_add(sck_poller_t* poller, int32_t socket, void* data);
+extern void sck_poller_remove(sck_poller_t* poller, int32_t socket);
+// wait for the socket to have room to write too
+extern void sck_poller_set_writable(sck_poller_t* poller, int32_t socket, void* data, bool writable);
+
+/*
+	Wait until a socket is ready or the poller is woken up
+	Returns how many events were written, or -1 with errno set if the wait failed
+*/
+extern int32_t sck_poller_wait(sck_poller_t* poller, sck_poll_event_t* events, uint32_t max);
+extern bool sck_poller_wake(sck_poller_t* poller);
+
+extern void sck_poller_term(sck_poller_t* poller);
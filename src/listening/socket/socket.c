@@ -34,6 +34,24 @@ int32_t sck_create() {
 
 }
 
+int32_t sck_set_reuse_port(int32_t s) {
+
+#if defined(__WINDOWS__) || !defined(SO_REUSEPORT)
+	(void) s;
+	return SCK_FAILED;
+#else
+	const int32_t on = 1;
+
+	// connections left over from a restart don't keep the port taken either
+	if (setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) != 0) {
+		return SCK_FAILED;
+	}
+
+	return setsockopt(s, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+#endif
+
+}
+
 int32_t sck_bind(int32_t s, struct sockaddr* addr, int32_t addrSize) {
 
 	int32_t b = bind(s, addr, addrSize);
@@ -50,7 +68,7 @@ int32_t sck_bind(int32_t s, struct sockaddr* addr, int32_t addrSize) {
 
 int32_t sck_listen(int32_t s) {
 
-	int32_t l = listen(s, 3);
+	int32_t l = listen(s, SOMAXCONN);
 
 	if (l != 0) {
 		log_error("Failed to listen on socket!");
@@ -70,12 +88,40 @@ int32_t sck_accept(int32_t l, struct sockaddr* addr, int* addrSize) {
 
 }
 
+int32_t sck_set_blocking(int32_t s, bool blocking) {
+
+#ifdef __WINDOWS__
+	u_long mode = !blocking;
+	return ioctlsocket(s, FIONBIO, &mode);
+#else
+	const int32_t flags = fcntl(s, F_GETFL, 0);
+
+	if (flags < 0) {
+		return SCK_FAILED;
+	}
+
+	return fcntl(s, F_SETFL, blocking ? flags & ~O_NONBLOCK : flags | O_NONBLOCK);
+#endif
+
+}
+
 int32_t sck_send(int32_t s, char* message, int32_t len) {
 
 	return send(s, message, len, 0);
 
 }
 
+int32_t sck_send_vector(int32_t s, struct iovec* vectors, int32_t count) {
+
+#ifdef __WINDOWS__
+	// only the first buffer, the rest is sent on the next call
+	return send(s, vectors[0].iov_base, vectors[0].iov_len, 0);
+#else
+	return writev(s, vectors, count);
+#endif
+
+}
+
 int32_t sck_recv(int32_t s, char* message, int32_t maxlen) {
 
 	int32_t r = recv(s, message, maxlen, 0);
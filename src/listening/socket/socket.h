@@ -6,18 +6,29 @@
 
 #ifdef __WINDOWS__
 #include <winsock2.h>
+struct iovec {
+	void* iov_base;
+	size_t iov_len;
+};
 #else
 #include <unistd.h>
+#include <fcntl.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #endif
 
 extern int32_t sck_init();
 extern int32_t sck_create();
+// let more sockets bind to the same port, each gets a share of the connections
+extern int32_t sck_set_reuse_port(int32_t);
 extern int32_t sck_bind(int32_t, struct sockaddr*, int32_t);
 extern int32_t sck_listen(int32_t);
 extern int32_t sck_accept(int32_t, struct sockaddr*, int*);
+extern int32_t sck_set_blocking(int32_t, bool);
 extern int32_t sck_send(int32_t, char*, int32_t);
+// send from several buffers in one go, may send less than all of them
+extern int32_t sck_send_vector(int32_t, struct iovec*, int32_t);
 extern int32_t sck_recv(int32_t, char*, int32_t);
 extern int32_t sck_shutdown(int32_t);
 extern int32_t sck_close(int32_t);
@@ -0,0 +1,295 @@
+#include "uring.h"
+
+#ifdef SCK_URING
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+static inline int32_t sck_uring_setup(uint32_t entries, struct io_uring_params* params) {
+
+	return syscall(__NR_io_uring_setup, entries, params);
+
+}
+
+static inline int32_t sck_uring_enter(int32_t fd, uint32_t submit, uint32_t complete, uint32_t flags) {
+
+	return syscall(__NR_io_uring_enter, fd, submit, complete, flags, NULL, 0);
+
+}
+
+static inline int32_t sck_uring_register(int32_t fd, uint32_t opcode, const void* arg, uint32_t count) {
+
+	return syscall(__NR_io_uring_register, fd, opcode, arg, count);
+
+}
+
+bool sck_uring_init(sck_uring_t* uring, uint32_t entries) {
+
+	memset(uring, 0, sizeof(sck_uring_t));
+
+	struct io_uring_params params;
+	memset(&params, 0, sizeof(params));
+
+	uring->fd = sck_uring_setup(entries, &params);
+
+	if (uring->fd < 0) {
+		return false;
+	}
+
+	uring->maps.sq_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+	uring->maps.cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	uring->maps.sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+	// both rings can share a mapping on newer kernels
+	const bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+	if (single && uring->maps.cq_size > uring->maps.sq_size) {
+		uring->maps.sq_size = uring->maps.cq_size;
+	}
+
+	uring->maps.sq = mmap(NULL, uring->maps.sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_SQ_RING);
+
+	if (uring->maps.sq == MAP_FAILED) {
+		close(uring->fd);
+		return false;
+	}
+
+	if (single) {
+		uring->maps.cq = uring->maps.sq;
+	} else {
+		uring->maps.cq = mmap(NULL, uring->maps.cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_CQ_RING);
+		if (uring->maps.cq == MAP_FAILED) {
+			munmap(uring->maps.sq, uring->maps.sq_size);
+			close(uring->fd);
+			return false;
+		}
+	}
+
+	uring->sq.sqes = mmap(NULL, uring->maps.sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_SQES);
+
+	if (uring->sq.sqes == MAP_FAILED) {
+		if (!single) {
+			munmap(uring->maps.cq, uring->maps.cq_size);
+		}
+		munmap(uring->maps.sq, uring->maps.sq_size);
+		close(uring->fd);
+		return false;
+	}
+
+	byte_t* sq = uring->maps.sq;
+	uring->sq.head = (_Atomic uint32_t*) (sq + params.sq_off.head);
+	uring->sq.tail = (_Atomic uint32_t*) (sq + params.sq_off.tail);
+	uring->sq.mask = *(uint32_t*) (sq + params.sq_off.ring_mask);
+	uring->sq.entries = *(uint32_t*) (sq + params.sq_off.ring_entries);
+	uring->sq.array = (uint32_t*) (sq + params.sq_off.array);
+
+	byte_t* cq = uring->maps.cq;
+	uring->cq.head = (_Atomic uint32_t*) (cq + params.cq_off.head);
+	uring->cq.tail = (_Atomic uint32_t*) (cq + params.cq_off.tail);
+	uring->cq.mask = *(uint32_t*) (cq + params.cq_off.ring_mask);
+	uring->cq.cqes = (struct io_uring_cqe*) (cq + params.cq_off.cqes);
+
+	return true;
+
+}
+
+bool sck_uring_provide_buffers(sck_uring_t* uring, uint16_t group, uint16_t count, uint32_t size) {
+
+	void* ring;
+
+	if (posix_memalign(&ring, sysconf(_SC_PAGESIZE), count * sizeof(struct io_uring_buf)) != 0) {
+		return false;
+	}
+
+	memset(ring, 0, count * sizeof(struct io_uring_buf));
+
+	struct io_uring_buf_reg reg = {
+		.ring_addr = (uint64_t) (uintptr_t) ring,
+		.ring_entries = count,
+		.bgid = group
+	};
+
+	if (sck_uring_register(uring->fd, IORING_REGISTER_PBUF_RING, &reg, 1) != 0) {
+		free(ring);
+		return false;
+	}
+
+	uring->recv.ring = ring;
+	uring->recv.memory = malloc((size_t) count * size);
+	uring->recv.size = size;
+	uring->recv.count = count;
+	uring->recv.group = group;
+	uring->recv.tail = 0;
+
+	for (uint16_t i = 0; i < count; ++i) {
+		sck_uring_return_buffer(uring, i);
+	}
+
+	return true;
+
+}
+
+void sck_uring_return_buffer(sck_uring_t* uring, uint16_t id) {
+
+	struct io_uring_buf* buffer = &uring->recv.ring->bufs[uring->recv.tail & (uring->recv.count - 1)];
+	buffer->addr = (uint64_t) (uintptr_t) sck_uring_get_recv_buffer(uring, id);
+	buffer->len = uring->recv.size;
+	buffer->bid = id;
+
+	// the tail shares its place with the first buffer's reserved field, the kernel reads it after the buffer
+	atomic_store_explicit((_Atomic uint16_t*) &uring->recv.ring->tail, ++uring->recv.tail, memory_order_release);
+
+}
+
+bool sck_uring_register_buffers(sck_uring_t* uring, const struct iovec* buffers, uint32_t count) {
+
+	return sck_uring_register(uring->fd, IORING_REGISTER_BUFFERS, buffers, count) == 0;
+
+}
+
+// get free submission entries, submitting what is queued if there are not enough left
+static struct io_uring_sqe* sck_uring_get_sqes(sck_uring_t* uring, uint32_t count) {
+
+	const uint32_t tail = atomic_load_explicit(uring->sq.tail, memory_order_relaxed) + uring->sq.queued;
+
+	if (tail + count - atomic_load_explicit(uring->sq.head, memory_order_acquire) > uring->sq.entries) {
+		sck_uring_submit(uring, false);
+		return sck_uring_get_sqes(uring, count);
+	}
+
+	for (uint32_t i = 0; i < count; ++i) {
+		const uint32_t index = (tail + i) & uring->sq.mask;
+		memset(&uring->sq.sqes[index], 0, sizeof(struct io_uring_sqe));
+		uring->sq.array[index] = index;
+	}
+
+	uring->sq.queued += count;
+
+	return &uring->sq.sqes[tail & uring->sq.mask];
+
+}
+
+// the timeout has to directly follow what it limits, so both are taken at once
+static struct io_uring_sqe* sck_uring_get_timed_sqe(sck_uring_t* uring, const struct __kernel_timespec* timeout, uint64_t user_data) {
+
+	if (timeout == NULL) {
+		return sck_uring_get_sqes(uring, 1);
+	}
+
+	struct io_uring_sqe* sqe = sck_uring_get_sqes(uring, 2);
+	sqe->flags = IOSQE_IO_LINK;
+
+	struct io_uring_sqe* link = &uring->sq.sqes[(sqe - uring->sq.sqes + 1) & uring->sq.mask];
+	link->opcode = IORING_OP_LINK_TIMEOUT;
+	link->fd = -1;
+	link->addr = (uint64_t) (uintptr_t) timeout;
+	link->len = 1;
+	link->user_data = user_data;
+
+	return sqe;
+
+}
+
+void sck_uring_recv_multishot(sck_uring_t* uring, int32_t socket, uint64_t user_data) {
+
+	struct io_uring_sqe* sqe = sck_uring_get_sqes(uring, 1);
+	sqe->opcode = IORING_OP_RECV;
+	sqe->fd = socket;
+	sqe->ioprio = IORING_RECV_MULTISHOT;
+	sqe->flags = IOSQE_BUFFER_SELECT;
+	sqe->buf_group = uring->recv.group;
+	sqe->user_data = user_data;
+
+}
+
+void sck_uring_write_fixed(sck_uring_t* uring, int32_t socket, const byte_t* bytes, uint32_t length, uint16_t index, uint64_t user_data, const struct __kernel_timespec* timeout, uint64_t timeout_data) {
+
+	struct io_uring_sqe* sqe = sck_uring_get_timed_sqe(uring, timeout, timeout_data);
+	sqe->opcode = IORING_OP_WRITE_FIXED;
+	sqe->fd = socket;
+	sqe->addr = (uint64_t) (uintptr_t) bytes;
+	sqe->len = length;
+	sqe->buf_index = index;
+	sqe->user_data = user_data;
+
+}
+
+void sck_uring_send(sck_uring_t* uring, int32_t socket, const byte_t* bytes, uint32_t length, uint64_t user_data, const struct __kernel_timespec* timeout, uint64_t timeout_data) {
+
+	struct io_uring_sqe* sqe = sck_uring_get_timed_sqe(uring, timeout, timeout_data);
+	sqe->opcode = IORING_OP_SEND;
+	sqe->fd = socket;
+	sqe->addr = (uint64_t) (uintptr_t) bytes;
+	sqe->len = length;
+	sqe->user_data = user_data;
+
+}
+
+void sck_uring_read(sck_uring_t* uring, int32_t fd, void* buffer, uint32_t length, uint64_t user_data) {
+
+	struct io_uring_sqe* sqe = sck_uring_get_sqes(uring, 1);
+	sqe->opcode = IORING_OP_READ;
+	sqe->fd = fd;
+	sqe->addr = (uint64_t) (uintptr_t) buffer;
+	sqe->len = length;
+	sqe->user_data = user_data;
+
+}
+
+int32_t sck_uring_submit(sck_uring_t* uring, bool wait) {
+
+	const uint32_t queued = uring->sq.queued;
+
+	if (queued != 0) {
+		atomic_store_explicit(uring->sq.tail, atomic_load_explicit(uring->sq.tail, memory_order_relaxed) + queued, memory_order_release);
+		uring->sq.queued = 0;
+	}
+
+	// nothing to tell the kernel about
+	if (queued == 0 && (!wait || atomic_load_explicit(uring->cq.head, memory_order_relaxed) != atomic_load_explicit(uring->cq.tail, memory_order_acquire))) {
+		return 0;
+	}
+
+	int32_t submitted;
+
+	do {
+		submitted = sck_uring_enter(uring->fd, queued, wait ? 1 : 0, wait ? IORING_ENTER_GETEVENTS : 0);
+	} while (submitted < 0 && errno == EINTR);
+
+	return submitted;
+
+}
+
+bool sck_uring_next(sck_uring_t* uring, struct io_uring_cqe* cqe) {
+
+	const uint32_t head = atomic_load_explicit(uring->cq.head, memory_order_relaxed);
+
+	if (head == atomic_load_explicit(uring->cq.tail, memory_order_acquire)) {
+		return false;
+	}
+
+	*cqe = uring->cq.cqes[head & uring->cq.mask];
+	atomic_store_explicit(uring->cq.head, head + 1, memory_order_release);
+
+	return true;
+
+}
+
+void sck_uring_term(sck_uring_t* uring) {
+
+	munmap(uring->sq.sqes, uring->maps.sqes_size);
+	if (uring->maps.cq != uring->maps.sq) {
+		munmap(uring->maps.cq, uring->maps.cq_size);
+	}
+	munmap(uring->maps.sq, uring->maps.sq_size);
+
+	close(uring->fd);
+
+	free(uring->recv.ring);
+	free(uring->recv.memory);
+
+}
+
+#endif
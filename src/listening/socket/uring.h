@@ -0,0 +1,90 @@
+#pragma once
+#include "../../main.h"
+
+// io_uring is only there on linux, and only with kernel headers new enough to know about it
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define SCK_URING
+#endif
+#endif
+
+#ifdef SCK_URING
+#include <sys/uio.h>
+#include <linux/time_types.h>
+#include <linux/io_uring.h>
+
+/*
+Bare-bones io_uring, only what the network threads need: multishot receives into buffers the kernel picks
+from a provided buffer ring, writes from registered buffers, and reads for waking a thread up
+A ring must only be used by one thread
+*/
+
+typedef struct {
+
+	int32_t fd;
+
+	struct {
+		_Atomic uint32_t* head;
+		_Atomic uint32_t* tail;
+		uint32_t* array;
+		uint32_t mask;
+		uint32_t entries;
+		struct io_uring_sqe* sqes;
+		// filled in since the last submit
+		uint32_t queued;
+	} sq;
+
+	struct {
+		_Atomic uint32_t* head;
+		_Atomic uint32_t* tail;
+		uint32_t mask;
+		struct io_uring_cqe* cqes;
+	} cq;
+
+	struct {
+		void* sq;
+		size_t sq_size;
+		void* cq;
+		size_t cq_size;
+		size_t sqes_size;
+	} maps;
+
+	// buffers the kernel receives into, handed back once their data is handled
+	struct {
+		struct io_uring_buf_ring* ring;
+		byte_t* memory;
+		uint32_t size;
+		uint16_t count;
+		uint16_t group;
+		uint16_t tail;
+	} recv;
+
+} sck_uring_t;
+
+extern bool sck_uring_init(sck_uring_t* uring, uint32_t entries);
+// count has to be a power of 2
+extern bool sck_uring_provide_buffers(sck_uring_t* uring, uint16_t group, uint16_t count, uint32_t size);
+extern bool sck_uring_register_buffers(sck_uring_t* uring, const struct iovec* buffers, uint32_t count);
+
+extern void sck_uring_recv_multishot(sck_uring_t* uring, int32_t socket, uint64_t user_data);
+// writes give up with -ECANCELED after the timeout if it isn't NULL, the timeout completes with its own user data
+extern void sck_uring_write_fixed(sck_uring_t* uring, int32_t socket, const byte_t* bytes, uint32_t length, uint16_t index, uint64_t user_data, const struct __kernel_timespec* timeout, uint64_t timeout_data);
+extern void sck_uring_send(sck_uring_t* uring, int32_t socket, const byte_t* bytes, uint32_t length, uint64_t user_data, const struct __kernel_timespec* timeout, uint64_t timeout_data);
+extern void sck_uring_read(sck_uring_t* uring, int32_t fd, void* buffer, uint32_t length, uint64_t user_data);
+
+// submit everything queued, waiting for at least one completion if wait is set
+extern int32_t sck_uring_submit(sck_uring_t* uring, bool wait);
+// take the next completion, false if there are none
+extern bool sck_uring_next(sck_uring_t* uring, struct io_uring_cqe* cqe);
+
+static inline byte_t* sck_uring_get_recv_buffer(sck_uring_t* uring, uint16_t id) {
+
+	return uring->recv.memory + (size_t) id * uring->recv.size;
+
+}
+
+extern void sck_uring_return_buffer(sck_uring_t* uring, uint16_t id);
+
+extern void sck_uring_term(sck_uring_t* uring);
+
+#endif
@@ -1,6 +1,7 @@
 #define _POSIX_C_SOURCE 200809L
 
 #include <time.h>
+#include <ctype.h>
 #include <curl/curl.h>
 #include "motor.h"
 #include <signal.h>
@@ -9,6 +10,7 @@
 #include "jobs/scheduler/scheduler.h"
 #include "util/ansi_escapes.h"
 #include "util/util.h"
+#include "util/cpu.h"
 #include "plugin/manager.h"
 #include "io/chat/chat.h"
 #include "io/filesystem/filesystem.h"
@@ -16,6 +18,8 @@
 #include "world/world.h"
 #include "world/material/material.h"
 #include "test/tests.h"
+#include "test/bench.h"
+#include "test/bots.h"
 
 sky_main_t sky_main = {
 	.protocol = __MC_PRO__,
@@ -26,10 +30,20 @@ sky_main_t sky_main = {
 		.op = 4
 	},
 	.workers = {
-		.count = 4,
+		.count = 0,
 		.vector = UTL_VECTOR_INITIALIZER(sky_worker_t*)
 	},
+	.affinity = {
+		.pin_threads = false,
+		.network_cores = 1
+	},
 	.status = sky_starting,
+
+	.tick = {
+		.last = 0,
+		.average = 0,
+		.interval = SKY_NANOS_PER_TICK
+	},
 	
 	.world = {
 		.name = UTL_CSTRTOSTR("world"),
@@ -53,6 +67,18 @@ sky_main_t sky_main = {
 		.address = {
 			.port = 25565
 		},
+		.admission = {
+			.lock = PTHREAD_MUTEX_INITIALIZER,
+			.rate = 200,
+			.burst = 400,
+			.address_rate = 5,
+			.address_burst = 20
+		},
+		.status = {
+			.lock = PTHREAD_MUTEX_INITIALIZER,
+			.rate = 10,
+			.burst = 20
+		},
 		.clients = {
 			.lock = PTHREAD_MUTEX_INITIALIZER,
 			.vector = UTL_ID_VECTOR_INITIALIZER(ltg_client_t*)
@@ -61,6 +87,11 @@ sky_main_t sky_main = {
 			.lock = PTHREAD_MUTEX_INITIALIZER,
 			.vector = UTL_ID_VECTOR_INITIALIZER(ltg_client_t*),
 			.max = 20
+		},
+		.compression = {
+			.lock = PTHREAD_MUTEX_INITIALIZER,
+			.wait = PTHREAD_COND_INITIALIZER,
+			.queue = UTL_LIST_INITIALIZER(ltg_compression_t)
 		}
 	}
 
@@ -97,7 +128,7 @@ void sky_handle_signal_crash(int signal) {
 		log_error("\t\tCONSOLE THREAD");
 	} else if (pthread_self() == sky_get_main_thread()) {
 		log_error("\t\tMAIN THREAD");
-	} else if (pthread_self() == ltg_get_thread(sky_get_listener())) {
+	} else if (ltg_is_acceptor_thread(sky_get_listener(), pthread_self())) {
 		log_error("\t\tLISTENER THREAD");
 	} else {
 		for (size_t i = 0; i < sky_main.workers.vector.size; ++i) {
@@ -109,12 +140,16 @@ void sky_handle_signal_crash(int signal) {
 			}
 		}
 
-		for (size_t i = 0; i < ltg_get_client_count(sky_get_listener()); ++i) {
-			ltg_client_t* client = ltg_get_client_by_id(sky_get_listener(), i);
-			if (client != NULL && pthread_self() == ltg_client_get_thread(client)) {
-				log_error("\t\tCLIENT #%lld", i);
-				log_error("\tCLIENT STATE %u", ltg_client_get_state(client));
-				log_error("\tENCRYPTION ENABLED %d", ltg_client_is_encryption_enabled(client));
+		for (uint32_t i = 0; i < sky_get_listener()->network.count; ++i) {
+			ltg_network_t* network = &sky_get_listener()->network.threads[i];
+			if (pthread_self() == network->thread) {
+				log_error("\t\tNETWORK THREAD #%u", i);
+				ltg_client_t* client = network->client;
+				if (client != NULL) {
+					log_error("\tCLIENT #%u", ltg_client_get_id(client));
+					log_error("\tCLIENT STATE %u", ltg_client_get_state(client));
+					log_error("\tENCRYPTION ENABLED %d", ltg_client_is_encryption_enabled(client));
+				}
 				goto identified;
 			}
 		}
@@ -168,12 +203,49 @@ int main(int argc, char* argv[]) {
 	// encryption / login setup
 	curl_global_init(CURL_GLOBAL_DEFAULT);
 
-	// run tests if args includes "test"
+	// bots to run against the server if args includes "bench-bots", then how many and for how many seconds
+	uint32_t bots = 0;
+	uint32_t bot_seconds = BOT_DEFAULT_SECONDS;
+
+	// captures to replay if args includes "bench-replay", after how many copies of each and how fast
+	char** replays = NULL;
+	uint32_t replay_count = 0;
+	uint32_t replay_copies = 1;
+	float64_t replay_speed = 1;
+
+	// run tests if args includes "test", benchmarks if it includes "bench"
 	for (int i = 1; i < argc; ++i) {
 		switch (utl_hash(argv[i])) {
 			case 0x7c9e6865: {
 				return test_run_all();
 			} break;
+			case 0xf25a4e5: {
+				return bench_run_all();
+			} break;
+			case 0xf5df6f6a: { // "bench-bots"
+				bots = BOT_DEFAULT_COUNT;
+				if (i + 1 < argc && isdigit(argv[i + 1][0])) {
+					bots = atoi(argv[++i]);
+				}
+				if (i + 1 < argc && isdigit(argv[i + 1][0])) {
+					bot_seconds = atoi(argv[++i]);
+				}
+			} break;
+			case 0x1014449f: { // "bench-replay"
+				if (i + 2 >= argc) {
+					log_error("Usage: bench-replay <copies> <speed> <capture>...");
+					return EXIT_FAILURE;
+				}
+				replay_copies = atoi(argv[++i]);
+				replay_speed = atof(argv[++i]);
+				replays = argv + i + 1;
+				replay_count = argc - i - 1;
+				i = argc;
+				if (replay_count == 0 || replay_copies == 0 || replay_speed <= 0) {
+					log_error("Usage: bench-replay <copies> <speed> <capture>...");
+					return EXIT_FAILURE;
+				}
+			} break;
 			default: {
 				// do nothing
 				log_warn("Unknown argument: %s", argv[i]);
@@ -197,6 +269,13 @@ int main(int argc, char* argv[]) {
 
 	}
 
+	// the bots play offline and all connect from loopback at once
+	if (bots != 0 || replays != NULL) {
+		log_info("Benchmarking with bots, online mode and the connection rate are turned off");
+		sky_main.online_mode = false;
+		sky_main.listener.admission.rate = 0;
+	}
+
 	// setup motd if null
 	if (sky_main.motd == NULL) {
 
@@ -223,28 +302,45 @@ int main(int argc, char* argv[]) {
 	// initiate socket
 	ltg_init(sky_get_listener());
 
+	// rates are measured from the server start
+	job_reset_telemetry();
+
 	// we're ready for takeoff
 	sky_main.status = sky_running;
 
 	// start main thread
 	pthread_create(&sky_main.thread, NULL, t_sky_main, NULL);
 
-	// create worker threads
-	for (size_t i = 0; i < sky_main.workers.count; ++i) {
-
-		sky_worker_t* worker = malloc(sizeof(sky_worker_t));
-		worker->id = i;
+	// one core for the main thread and the reserved networking cores, workers get the rest
+	const uint32_t available_cpus = utl_get_available_cpus();
+	if (sky_main.workers.count == 0) {
+		sky_main.workers.count = available_cpus > 1u + sky_main.affinity.network_cores ? available_cpus - 1 - sky_main.affinity.network_cores : 1;
+	}
+	log_info("Starting %zu workers (%u cores available)", sky_main.workers.count, available_cpus);
 
-		utl_vector_push(&sky_main.workers.vector, &worker);
+	// a spinning worker would only hold up the thread adding the job it waits for
+	if (available_cpus == 1) {
+		job_board.idle.spin_rounds = 0;
+	}
 
-		pthread_create(&worker->thread, NULL, t_sky_worker, worker);
+	sky_start_workers();
 
+	if (sky_main.affinity.pin_threads) {
+		sky_pin_threads();
 	}
 
 	struct timespec time_now;
 	clock_gettime(CLOCK_REALTIME, &time_now);
 	log_info("Done (%.3fs)! For help type 'help'", ((time_now.tv_sec * SKY_NANOS_PER_SECOND + time_now.tv_nsec) - (start.tv_sec * SKY_NANOS_PER_SECOND + start.tv_nsec)) / 1000000000.0f);
 
+	// the server stops once the bots are done
+	if (bots != 0) {
+		return bot_run_all(bots, bot_seconds);
+	}
+	if (replays != NULL) {
+		return bot_replay_all(replay_copies, replay_speed, replays, replay_count);
+	}
+
 	// enter console loop, threads are started and such, nothing else needs to be done on this thread
 	char in[256];
 	for (;;) {
@@ -257,12 +353,121 @@ int main(int argc, char* argv[]) {
 
 }
 
+void sky_start_workers() {
+
+	sky_main.workers.stopping = false;
+
+	// create workers, all of them have to exist before any starts stealing from the others
+	for (size_t i = 0; i < sky_main.workers.count; ++i) {
+
+		sky_worker_t* worker = malloc(sizeof(sky_worker_t));
+		worker->id = i;
+		worker->job = 0;
+		for (uint32_t lane = 0; lane < job_lane_count; ++lane) {
+			utl_init_deque(&worker->deques[lane], 256);
+			pthread_mutex_init(&worker->inbox[lane].lock, NULL);
+			utl_init_list(&worker->inbox[lane].list, sizeof(uint64_t));
+			worker->inbox[lane].length = 0;
+		}
+
+		utl_vector_push(&sky_main.workers.vector, &worker);
+
+	}
+
+	// start worker threads
+	for (size_t i = 0; i < sky_main.workers.vector.size; ++i) {
+
+		sky_worker_t* worker = UTL_VECTOR_GET_AS(sky_worker_t*, &sky_main.workers.vector, i);
+
+		pthread_create(&worker->thread, NULL, t_sky_worker, worker);
+
+	}
+
+}
+
+void sky_stop_workers() {
+
+	// join to each worker
+	// resume workers waiting for jobs
+	sky_main.workers.stopping = true;
+	job_resume();
+
+	for (size_t i = 0; i < sky_main.workers.vector.size; ++i) {
+
+		sky_worker_t* worker = UTL_VECTOR_GET_AS(sky_worker_t*, &sky_main.workers.vector, i);
+
+		if (pthread_self() != worker->thread) {
+			pthread_join(worker->thread, NULL);
+		}
+
+	}
+
+	// workers steal from each other until they exit, so only free their queues once all are joined
+	for (size_t i = 0; i < sky_main.workers.vector.size; ++i) {
+
+		sky_worker_t* worker = UTL_VECTOR_GET_AS(sky_worker_t*, &sky_main.workers.vector, i);
+
+		if (pthread_self() != worker->thread) {
+			for (uint32_t lane = 0; lane < job_lane_count; ++lane) {
+				utl_term_deque(&worker->deques[lane]);
+				utl_term_list(&worker->inbox[lane].list);
+				pthread_mutex_destroy(&worker->inbox[lane].lock);
+			}
+		}
+
+	}
+
+}
+
+void sky_pin_threads() {
+
+	uint32_t cpus[UTL_MAX_CPUS];
+	const uint32_t cpu_count = utl_get_cpus(cpus, UTL_MAX_CPUS);
+	const uint32_t network_cores = sky_main.affinity.network_cores;
+
+	if (cpu_count < 2 + network_cores) {
+		log_warn("Not pinning threads, %u cores are not enough for the main thread, %u networking cores and the workers", cpu_count, network_cores);
+		return;
+	}
+
+	bool pinned = utl_pin_thread(sky_main.thread, &cpus[0], 1);
+
+	// the acceptors and the compression threads share the networking cores, network threads get one each
+	if (network_cores != 0) {
+		ltg_listener_t* listener = sky_get_listener();
+		for (uint32_t i = 0; i < listener->acceptors.count; ++i) {
+			pinned &= utl_pin_thread(listener->acceptors.threads[i].thread, &cpus[1], network_cores);
+		}
+		for (uint32_t i = 0; i < listener->network.count; ++i) {
+			pinned &= utl_pin_thread(listener->network.threads[i].thread, &cpus[1 + i % network_cores], 1);
+		}
+		for (uint32_t i = 0; i < listener->compression.count; ++i) {
+			pinned &= utl_pin_thread(listener->compression.threads[i], &cpus[1], network_cores);
+		}
+	}
+
+	// workers share the remaining cores round robin when there are more workers than cores
+	const uint32_t* worker_cpus = &cpus[1 + network_cores];
+	const uint32_t worker_cpu_count = cpu_count - 1 - network_cores;
+
+	for (size_t i = 0; i < sky_main.workers.vector.size; ++i) {
+		sky_worker_t* worker = UTL_VECTOR_GET_AS(sky_worker_t*, &sky_main.workers.vector, i);
+		pinned &= utl_pin_thread(worker->thread, &worker_cpus[i % worker_cpu_count], 1);
+	}
+
+	if (!pinned) {
+		log_warn("Some threads could not be pinned to their cores");
+	}
+
+}
+
 void* t_sky_main(__attribute__((unused)) void* input) {
 
 	// schedule update pings job
 	sch_schedule_repeating(job_new(job_send_update_pings, (job_payload_t) {}), 200, 200);
 
-	struct timespec nextTick, currentTime, sleepTime;
+	struct timespec nextTick, currentTime, sleepTime, tickStart, tickEnd;
+	uint64_t lastStart = 0;
 
 	clock_gettime(CLOCK_MONOTONIC, &nextTick);
 
@@ -282,7 +487,7 @@ void* t_sky_main(__attribute__((unused)) void* input) {
 			sleepTime.tv_sec = 0;
 			sleepTime.tv_nsec = 0;
 			if ((sky_to_nanos(currentTime) - sky_to_nanos(nextTick)) / SKY_NANOS_PER_TICK > SKY_SKIP_TICKS) {
-				log_warn("Can't keep up! Is the server overloaded? Running %lums or %d ticks behind", (sky_to_nanos(currentTime) - sky_to_nanos(nextTick)) / 1000000, (sky_to_nanos(currentTime) - sky_to_nanos(nextTick)) / SKY_NANOS_PER_TICK);
+				log_warn("Can't keep up! Is the server overloaded? Running %lums or %d ticks behind (%.2f mspt, average %.2f)", (sky_to_nanos(currentTime) - sky_to_nanos(nextTick)) / 1000000, (sky_to_nanos(currentTime) - sky_to_nanos(nextTick)) / SKY_NANOS_PER_TICK, sky_get_mspt(), sky_get_average_mspt());
 				clock_gettime(CLOCK_MONOTONIC, &nextTick);
 			}
 		}
@@ -295,8 +500,25 @@ void* t_sky_main(__attribute__((unused)) void* input) {
 
 		nanosleep(&sleepTime, NULL);
 
-		// do tick stuff
+		// do tick stuff, the workers run the region and world ticks and we wait for them to be done
+		clock_gettime(CLOCK_MONOTONIC, &tickStart);
+
 		sch_tick();
+		job_join_tick();
+
+		// everything the tick sent goes out together
+		ltg_flush(sky_get_listener());
+
+		clock_gettime(CLOCK_MONOTONIC, &tickEnd);
+
+		// moving averages over about 20 ticks
+		const uint64_t took = sky_to_nanos(tickEnd) - sky_to_nanos(tickStart);
+		sky_main.tick.last = took;
+		sky_main.tick.average = sky_main.tick.average + ((int64_t) took - (int64_t) sky_main.tick.average) / 20;
+		if (lastStart != 0) {
+			sky_main.tick.interval = sky_main.tick.interval + ((int64_t) (sky_to_nanos(tickStart) - lastStart) - (int64_t) sky_main.tick.interval) / 20;
+		}
+		lastStart = sky_to_nanos(tickStart);
 
 	}
 
@@ -308,7 +530,7 @@ void* t_sky_worker(void* args) {
 
 	sky_worker_t* worker = args;
 
-	while (sky_main.status != sky_stopping) {
+	while (!sky_main.workers.stopping) {
 
 		// do work
 		job_work(worker);
@@ -333,7 +555,176 @@ void sky_load_server_json() {
 			uint32_t hash = utl_hash(key);
 			switch (hash) {
 				case 0x574c2735: { // "worker-count"
-					sky_main.workers.count = mjson_get_int(key_val.value);
+					if (key_val.value->type == MJSON_STRING) {
+						const char* count = mjson_get_string(key_val.value);
+						if (utl_hash(count) == 0x7c94415e) { // "auto"
+							sky_main.workers.count = 0;
+						} else {
+							log_warn("Unknown worker count '%s' in server.json!", count);
+						}
+					} else {
+						sky_main.workers.count = mjson_get_int(key_val.value);
+					}
+				} break;
+				case 0x8e1eabc7: { // "network-threads"
+					if (key_val.value->type == MJSON_STRING) {
+						const char* count = mjson_get_string(key_val.value);
+						if (utl_hash(count) == 0x7c94415e) { // "auto"
+							sky_main.listener.network.count = 0;
+						} else {
+							log_warn("Unknown network thread count '%s' in server.json!", count);
+						}
+					} else {
+						sky_main.listener.network.count = mjson_get_int(key_val.value);
+					}
+				} break;
+				case 0x51ba12af: { // "compression-threads"
+					if (key_val.value->type == MJSON_STRING) {
+						const char* count = mjson_get_string(key_val.value);
+						if (utl_hash(count) == 0x7c94415e) { // "auto"
+							sky_main.listener.compression.count = 0;
+						} else {
+							log_warn("Unknown compression thread count '%s' in server.json!", count);
+						}
+					} else {
+						sky_main.listener.compression.count = mjson_get_int(key_val.value);
+					}
+				} break;
+				case 0x9933f9ce: { // "acceptor-threads"
+					if (key_val.value->type == MJSON_STRING) {
+						const char* count = mjson_get_string(key_val.value);
+						if (utl_hash(count) == 0x7c94415e) { // "auto"
+							sky_main.listener.acceptors.count = 0;
+						} else {
+							log_warn("Unknown acceptor thread count '%s' in server.json!", count);
+						}
+					} else {
+						sky_main.listener.acceptors.count = mjson_get_int(key_val.value);
+					}
+				} break;
+				case 0xfb1c0d58: { // "connection-throttle"
+					const uint32_t key_val_size = mjson_get_size(key_val.value);
+					for (uint32_t j = 0; j < key_val_size; ++j) {
+						mjson_property setting = mjson_obj_get(key_val.value, j);
+						const char* s_key = mjson_get_string(setting.label);
+						const int32_t s_hash = utl_hash(s_key);
+						switch (s_hash) {
+							case 0x7c9d3eb1: { // "rate"
+								sky_main.listener.admission.rate = mjson_get_int(setting.value);
+							} break;
+							case 0xf2e7e15: { // "burst"
+								sky_main.listener.admission.burst = mjson_get_int(setting.value);
+							} break;
+							case 0x4aacfca4: { // "address-rate"
+								sky_main.listener.admission.address_rate = mjson_get_int(setting.value);
+							} break;
+							case 0x9f35fa68: { // "address-burst"
+								sky_main.listener.admission.address_burst = mjson_get_int(setting.value);
+							} break;
+							case 0x17e1c0c2: { // "status-rate"
+								sky_main.listener.status.rate = mjson_get_int(setting.value);
+							} break;
+							case 0x13034246: { // "status-burst"
+								sky_main.listener.status.burst = mjson_get_int(setting.value);
+							} break;
+							default: {
+								log_warn("Unknown value '%s' in server.json! (%x)", s_key, s_hash);
+							} break;
+						}
+					}
+				} break;
+				case 0xb2f5d639: { // "capture"
+					sky_main.listener.capture.all = mjson_get_boolean(key_val.value);
+				} break;
+				case 0x34b199af: { // "io-uring"
+					sky_main.listener.network.io_uring = mjson_get_boolean(key_val.value);
+				} break;
+				case 0x184199b4: { // "cpu-affinity"
+					const uint32_t key_val_size = mjson_get_size(key_val.value);
+					for (uint32_t j = 0; j < key_val_size; ++j) {
+						mjson_property setting = mjson_obj_get(key_val.value, j);
+						const char* s_key = mjson_get_string(setting.label);
+						const int32_t s_hash = utl_hash(s_key);
+						switch (s_hash) {
+							case 0x5d9d9364: { // "pin-threads"
+								sky_main.affinity.pin_threads = mjson_get_boolean(setting.value);
+							} break;
+							case 0x7ad47898: { // "network-cores"
+								sky_main.affinity.network_cores = mjson_get_int(setting.value);
+							} break;
+							default: {
+								log_warn("Unknown value '%s' in server.json! (%x)", s_key, s_hash);
+							} break;
+						}
+					}
+				} break;
+				case 0xee8f92c: { // "work-stealing"
+					job_board.work_stealing = mjson_get_boolean(key_val.value);
+				} break;
+				case 0xe233fa10: { // "region-affinity"
+					job_board.affinity = mjson_get_boolean(key_val.value);
+				} break;
+				case 0xb514ecea: { // "worker-idle"
+					const uint32_t key_val_size = mjson_get_size(key_val.value);
+					for (uint32_t j = 0; j < key_val_size; ++j) {
+						mjson_property setting = mjson_obj_get(key_val.value, j);
+						const char* s_key = mjson_get_string(setting.label);
+						const int32_t s_hash = utl_hash(s_key);
+						switch (s_hash) {
+							case 0x7e05f3c7: { // "spin-rounds"
+								job_board.idle.spin_rounds = mjson_get_int(setting.value);
+							} break;
+							case 0xcf15c484: { // "yield-rounds"
+								job_board.idle.yield_rounds = mjson_get_int(setting.value);
+							} break;
+							default: {
+								log_warn("Unknown value '%s' in server.json! (%x)", s_key, s_hash);
+							} break;
+						}
+					}
+				} break;
+				case 0xb2a84f48: { // "job-telemetry"
+					job_board.telemetry.enabled = mjson_get_boolean(key_val.value);
+				} break;
+				case 0x86cb7160: { // "job-lanes"
+					const uint32_t key_val_size = mjson_get_size(key_val.value);
+					for (uint32_t j = 0; j < key_val_size; ++j) {
+						mjson_property lane = mjson_obj_get(key_val.value, j);
+						const char* l_key = mjson_get_string(lane.label);
+						const int32_t l_hash = utl_hash(l_key);
+						job_lane_t lane_id;
+						switch (l_hash) {
+							case 0x8c6c05cd: { // "latency-critical"
+								lane_id = job_lane_latency_critical;
+							} break;
+							case 0xd741f9c8: { // "tick-critical"
+								lane_id = job_lane_tick_critical;
+							} break;
+							case 0x677e1785: { // "background"
+								lane_id = job_lane_background;
+							} break;
+							default: {
+								log_warn("Unknown job lane '%s' in server.json! (%x)", l_key, l_hash);
+							} continue;
+						}
+						const uint32_t lane_size = mjson_get_size(lane.value);
+						for (uint32_t k = 0; k < lane_size; ++k) {
+							mjson_property setting = mjson_obj_get(lane.value, k);
+							const char* s_key = mjson_get_string(setting.label);
+							const int32_t s_hash = utl_hash(s_key);
+							switch (s_hash) {
+								case 0x24d3ea4d: { // "weight"
+									job_board.lanes[lane_id].weight = mjson_get_int(setting.value);
+								} break;
+								case 0xb9927949: { // "target-latency"
+									job_board.lanes[lane_id].target_latency = mjson_get_int(setting.value);
+								} break;
+								default: {
+									log_warn("Unknown value '%s' in server.json! (%x)", s_key, s_hash);
+								} break;
+							}
+						}
+					}
 				} break;
 				case 0x6f29f27f: { // "max-tick-time"
 					sky_main.max_tick_time = mjson_get_int(key_val.value);
@@ -507,78 +898,140 @@ void sky_gen_server_json() {
 
 	const byte_t server_json[] = {
 		0x7b, 0x0d, 0x0a, 0x09, 0x22, 0x77, 0x6f, 0x72, 0x6b, 0x65, 0x72, 0x2d,
-		0x63, 0x6f, 0x75, 0x6e, 0x74, 0x22, 0x3a, 0x20, 0x34, 0x2c, 0x0d, 0x0a,
-		0x09, 0x22, 0x6d, 0x61, 0x78, 0x2d, 0x74, 0x69, 0x63, 0x6b, 0x2d, 0x74,
-		0x69, 0x6d, 0x65, 0x22, 0x3a, 0x20, 0x36, 0x30, 0x30, 0x30, 0x30, 0x2c,
-		0x0d, 0x0a, 0x09, 0x22, 0x6c, 0x65, 0x76, 0x65, 0x6c, 0x22, 0x3a, 0x20,
-		0x7b, 0x0d, 0x0a, 0x09, 0x09, 0x22, 0x6e, 0x61, 0x6d, 0x65, 0x22, 0x3a,
-		0x20, 0x22, 0x77, 0x6f, 0x72, 0x6c, 0x64, 0x22, 0x2c, 0x0d, 0x0a, 0x09,
-		0x09, 0x22, 0x6d, 0x61, 0x78, 0x2d, 0x73, 0x69, 0x7a, 0x65, 0x22, 0x3a,
-		0x20, 0x32, 0x39, 0x39, 0x39, 0x39, 0x39, 0x38, 0x34, 0x2c, 0x0d, 0x0a,
-		0x09, 0x09, 0x22, 0x73, 0x70, 0x61, 0x77, 0x6e, 0x2d, 0x70, 0x72, 0x6f,
-		0x74, 0x65, 0x63, 0x74, 0x69, 0x6f, 0x6e, 0x22, 0x3a, 0x20, 0x31, 0x36,
-		0x2c, 0x0d, 0x0a, 0x09, 0x09, 0x22, 0x67, 0x65, 0x6e, 0x65, 0x72, 0x61,
-		0x74, 0x6f, 0x72, 0x22, 0x3a, 0x20, 0x7b, 0x0d, 0x0a, 0x09, 0x09, 0x09,
-		0x22, 0x74, 0x79, 0x70, 0x65, 0x22, 0x3a, 0x20, 0x22, 0x64, 0x65, 0x66,
-		0x61, 0x75, 0x6c, 0x74, 0x22, 0x2c, 0x0d, 0x0a, 0x09, 0x09, 0x09, 0x22,
-		0x73, 0x65, 0x74, 0x74, 0x69, 0x6e, 0x67, 0x73, 0x22, 0x3a, 0x20, 0x22,
-		0x22, 0x2c, 0x0d, 0x0a, 0x09, 0x09, 0x09, 0x22, 0x73, 0x74, 0x72, 0x75,
-		0x63, 0x74, 0x75, 0x72, 0x65, 0x73, 0x22, 0x3a, 0x20, 0x74, 0x72, 0x75,
-		0x65, 0x2c, 0x0d, 0x0a, 0x09, 0x09, 0x09, 0x22, 0x73, 0x65, 0x65, 0x64,
-		0x22, 0x3a, 0x20, 0x30, 0x0d, 0x0a, 0x09, 0x09, 0x7d, 0x0d, 0x0a, 0x09,
-		0x7d, 0x2c, 0x0d, 0x0a, 0x09, 0x22, 0x67, 0x61, 0x6d, 0x65, 0x6d, 0x6f,
-		0x64, 0x65, 0x22, 0x3a, 0x20, 0x7b, 0x0d, 0x0a, 0x09, 0x09, 0x22, 0x64,
-		0x65, 0x66, 0x61, 0x75, 0x6c, 0x74, 0x22, 0x3a, 0x20, 0x22, 0x73, 0x75,
-		0x72, 0x76, 0x69, 0x76, 0x61, 0x6c, 0x22, 0x2c, 0x0d, 0x0a, 0x09, 0x09,
-		0x22, 0x66, 0x6f, 0x72, 0x63, 0x65, 0x22, 0x3a, 0x20, 0x74, 0x72, 0x75,
-		0x65, 0x0d, 0x0a, 0x09, 0x7d, 0x2c, 0x0d, 0x0a, 0x09, 0x22, 0x64, 0x69,
-		0x66, 0x66, 0x69, 0x63, 0x75, 0x6c, 0x74, 0x79, 0x22, 0x3a, 0x20, 0x7b,
-		0x0d, 0x0a, 0x09, 0x09, 0x22, 0x6c, 0x65, 0x76, 0x65, 0x6c, 0x22, 0x3a,
-		0x20, 0x22, 0x65, 0x61, 0x73, 0x79, 0x22, 0x2c, 0x0d, 0x0a, 0x09, 0x09,
-		0x22, 0x68, 0x61, 0x72, 0x64, 0x63, 0x6f, 0x72, 0x65, 0x22, 0x3a, 0x20,
-		0x66, 0x61, 0x6c, 0x73, 0x65, 0x0d, 0x0a, 0x09, 0x7d, 0x2c, 0x0d, 0x0a,
-		0x09, 0x22, 0x65, 0x6e, 0x66, 0x6f, 0x72, 0x63, 0x65, 0x2d, 0x77, 0x68,
-		0x69, 0x74, 0x65, 0x6c, 0x69, 0x73, 0x74, 0x22, 0x3a, 0x20, 0x66, 0x61,
-		0x6c, 0x73, 0x65, 0x2c, 0x0d, 0x0a, 0x09, 0x22, 0x65, 0x6e, 0x61, 0x62,
-		0x6c, 0x65, 0x2d, 0x63, 0x6f, 0x6d, 0x6d, 0x61, 0x6e, 0x64, 0x2d, 0x62,
-		0x6c, 0x6f, 0x63, 0x6b, 0x22, 0x3a, 0x20, 0x66, 0x61, 0x6c, 0x73, 0x65,
-		0x2c, 0x0d, 0x0a, 0x09, 0x22, 0x6d, 0x61, 0x78, 0x2d, 0x70, 0x6c, 0x61,
-		0x79, 0x65, 0x72, 0x73, 0x22, 0x3a, 0x20, 0x32, 0x30, 0x2c, 0x0d, 0x0a,
-		0x09, 0x22, 0x73, 0x70, 0x61, 0x77, 0x6e, 0x22, 0x3a, 0x20, 0x7b, 0x0d,
-		0x0a, 0x09, 0x09, 0x22, 0x6d, 0x6f, 0x6e, 0x73, 0x74, 0x65, 0x72, 0x73,
-		0x22, 0x3a, 0x20, 0x74, 0x72, 0x75, 0x65, 0x2c, 0x0d, 0x0a, 0x09, 0x09,
-		0x22, 0x6e, 0x70, 0x63, 0x73, 0x22, 0x3a, 0x20, 0x74, 0x72, 0x75, 0x65,
-		0x0d, 0x0a, 0x09, 0x7d, 0x2c, 0x0d, 0x0a, 0x09, 0x22, 0x72, 0x65, 0x6e,
-		0x64, 0x65, 0x72, 0x2d, 0x64, 0x69, 0x73, 0x74, 0x61, 0x6e, 0x63, 0x65,
-		0x22, 0x3a, 0x20, 0x31, 0x30, 0x2c, 0x0d, 0x0a, 0x09, 0x22, 0x73, 0x69,
-		0x6d, 0x75, 0x6c, 0x61, 0x74, 0x69, 0x6f, 0x6e, 0x2d, 0x64, 0x69, 0x73,
-		0x74, 0x61, 0x6e, 0x63, 0x65, 0x22, 0x3a, 0x20, 0x31, 0x30, 0x2c, 0x0d,
-		0x0a, 0x09, 0x22, 0x6f, 0x70, 0x2d, 0x70, 0x65, 0x72, 0x6d, 0x69, 0x73,
-		0x73, 0x69, 0x6f, 0x6e, 0x2d, 0x6c, 0x65, 0x76, 0x65, 0x6c, 0x22, 0x3a,
-		0x20, 0x34, 0x2c, 0x0d, 0x0a, 0x09, 0x22, 0x70, 0x76, 0x70, 0x22, 0x3a,
-		0x20, 0x74, 0x72, 0x75, 0x65, 0x2c, 0x0d, 0x0a, 0x09, 0x22, 0x73, 0x65,
-		0x72, 0x76, 0x65, 0x72, 0x22, 0x3a, 0x20, 0x7b, 0x0d, 0x0a, 0x09, 0x09,
-		0x22, 0x61, 0x64, 0x64, 0x72, 0x65, 0x73, 0x73, 0x22, 0x3a, 0x20, 0x22,
-		0x22, 0x2c, 0x0d, 0x0a, 0x09, 0x09, 0x22, 0x70, 0x6f, 0x72, 0x74, 0x22,
-		0x3a, 0x20, 0x32, 0x35, 0x35, 0x36, 0x35, 0x0d, 0x0a, 0x09, 0x7d, 0x2c,
-		0x0d, 0x0a, 0x09, 0x22, 0x70, 0x72, 0x65, 0x76, 0x65, 0x6e, 0x74, 0x2d,
-		0x70, 0x72, 0x6f, 0x78, 0x79, 0x2d, 0x63, 0x6f, 0x6e, 0x6e, 0x65, 0x63,
-		0x74, 0x69, 0x6f, 0x6e, 0x73, 0x22, 0x3a, 0x20, 0x74, 0x72, 0x75, 0x65,
-		0x2c, 0x0d, 0x0a, 0x09, 0x22, 0x6e, 0x65, 0x74, 0x77, 0x6f, 0x72, 0x6b,
-		0x2d, 0x63, 0x6f, 0x6d, 0x70, 0x72, 0x65, 0x73, 0x73, 0x69, 0x6f, 0x6e,
-		0x2d, 0x74, 0x68, 0x72, 0x65, 0x73, 0x68, 0x6f, 0x6c, 0x64, 0x22, 0x3a,
-		0x20, 0x32, 0x35, 0x36, 0x2c, 0x0d, 0x0a, 0x09, 0x22, 0x72, 0x65, 0x64,
-		0x75, 0x63, 0x65, 0x64, 0x2d, 0x64, 0x65, 0x62, 0x75, 0x67, 0x2d, 0x69,
-		0x6e, 0x66, 0x6f, 0x22, 0x3a, 0x20, 0x66, 0x61, 0x6c, 0x73, 0x65, 0x2c,
-		0x0d, 0x0a, 0x09, 0x22, 0x6f, 0x6e, 0x6c, 0x69, 0x6e, 0x65, 0x2d, 0x6d,
-		0x6f, 0x64, 0x65, 0x22, 0x3a, 0x20, 0x74, 0x72, 0x75, 0x65, 0x2c, 0x0d,
-		0x0a, 0x09, 0x22, 0x68, 0x69, 0x64, 0x65, 0x2d, 0x6f, 0x6e, 0x6c, 0x69,
-		0x6e, 0x65, 0x2d, 0x70, 0x6c, 0x61, 0x79, 0x65, 0x72, 0x73, 0x22, 0x3a,
-		0x20, 0x66, 0x61, 0x6c, 0x73, 0x65, 0x2c, 0x0d, 0x0a, 0x09, 0x22, 0x6d,
-		0x6f, 0x74, 0x64, 0x22, 0x3a, 0x20, 0x7b, 0x0d, 0x0a, 0x09, 0x09, 0x22,
-		0x74, 0x65, 0x78, 0x74, 0x22, 0x3a, 0x20, 0x22, 0x41, 0x20, 0x4d, 0x69,
-		0x6e, 0x65, 0x63, 0x72, 0x61, 0x66, 0x74, 0x20, 0x73, 0x65, 0x72, 0x76,
-		0x65, 0x72, 0x22, 0x0d, 0x0a, 0x09, 0x7d, 0x0d, 0x0a, 0x7d
+		0x63, 0x6f, 0x75, 0x6e, 0x74, 0x22, 0x3a, 0x20, 0x22, 0x61, 0x75, 0x74,
+		0x6f, 0x22, 0x2c, 0x0d, 0x0a, 0x09, 0x22, 0x6e, 0x65, 0x74, 0x77, 0x6f,
+		0x72, 0x6b, 0x2d, 0x74, 0x68, 0x72, 0x65, 0x61, 0x64, 0x73, 0x22, 0x3a,
+		0x20, 0x22, 0x61, 0x75, 0x74, 0x6f, 0x22, 0x2c, 0x0d, 0x0a, 0x09, 0x22,
+		0x63, 0x6f, 0x6d, 0x70, 0x72, 0x65, 0x73, 0x73, 0x69, 0x6f, 0x6e, 0x2d,
+		0x74, 0x68, 0x72, 0x65, 0x61, 0x64, 0x73, 0x22, 0x3a, 0x20, 0x22, 0x61,
+		0x75, 0x74, 0x6f, 0x22, 0x2c, 0x0d, 0x0a, 0x09, 0x22, 0x61, 0x63, 0x63,
+		0x65, 0x70, 0x74, 0x6f, 0x72, 0x2d, 0x74, 0x68, 0x72, 0x65, 0x61, 0x64,
+		0x73, 0x22, 0x3a, 0x20, 0x22, 0x61, 0x75, 0x74, 0x6f, 0x22, 0x2c, 0x0d,
+		0x0a, 0x09, 0x22, 0x63, 0x6f, 0x6e, 0x6e, 0x65, 0x63, 0x74, 0x69, 0x6f,
+		0x6e, 0x2d, 0x74, 0x68, 0x72, 0x6f, 0x74, 0x74, 0x6c, 0x65, 0x22, 0x3a,
+		0x20, 0x7b, 0x0d, 0x0a, 0x09, 0x09, 0x22, 0x72, 0x61, 0x74, 0x65, 0x22,
+		0x3a, 0x20, 0x32, 0x30, 0x30, 0x2c, 0x0d, 0x0a, 0x09, 0x09, 0x22, 0x62,
+		0x75, 0x72, 0x73, 0x74, 0x22, 0x3a, 0x20, 0x34, 0x30, 0x30, 0x2c, 0x0d,
+		0x0a, 0x09, 0x09, 0x22, 0x61, 0x64, 0x64, 0x72, 0x65, 0x73, 0x73, 0x2d,
+		0x72, 0x61, 0x74, 0x65, 0x22, 0x3a, 0x20, 0x35, 0x2c, 0x0d, 0x0a, 0x09,
+		0x09, 0x22, 0x61, 0x64, 0x64, 0x72, 0x65, 0x73, 0x73, 0x2d, 0x62, 0x75,
+		0x72, 0x73, 0x74, 0x22, 0x3a, 0x20, 0x32, 0x30, 0x2c, 0x0d, 0x0a, 0x09,
+		0x09, 0x22, 0x73, 0x74, 0x61, 0x74, 0x75, 0x73, 0x2d, 0x72, 0x61, 0x74,
+		0x65, 0x22, 0x3a, 0x20, 0x31, 0x30, 0x2c, 0x0d, 0x0a, 0x09, 0x09, 0x22,
+		0x73, 0x74, 0x61, 0x74, 0x75, 0x73, 0x2d, 0x62, 0x75, 0x72, 0x73, 0x74,
+		0x22, 0x3a, 0x20, 0x32, 0x30, 0x0d, 0x0a, 0x09, 0x7d, 0x2c, 0x0d, 0x0a,
+		0x09, 0x22, 0x63, 0x61, 0x70, 0x74, 0x75, 0x72, 0x65, 0x22, 0x3a, 0x20,
+		0x66, 0x61, 0x6c, 0x73, 0x65, 0x2c, 0x0d, 0x0a, 0x09, 0x22, 0x69, 0x6f,
+		0x2d, 0x75, 0x72, 0x69, 0x6e, 0x67, 0x22, 0x3a, 0x20, 0x66, 0x61, 0x6c,
+		0x73, 0x65, 0x2c, 0x0d, 0x0a, 0x09, 0x22, 0x63, 0x70, 0x75, 0x2d, 0x61,
+		0x66, 0x66, 0x69, 0x6e, 0x69, 0x74, 0x79, 0x22, 0x3a, 0x20, 0x7b, 0x0d,
+		0x0a, 0x09, 0x09, 0x22, 0x70, 0x69, 0x6e, 0x2d, 0x74, 0x68, 0x72, 0x65,
+		0x61, 0x64, 0x73, 0x22, 0x3a, 0x20, 0x66, 0x61, 0x6c, 0x73, 0x65, 0x2c,
+		0x0d, 0x0a, 0x09, 0x09, 0x22, 0x6e, 0x65, 0x74, 0x77, 0x6f, 0x72, 0x6b,
+		0x2d, 0x63, 0x6f, 0x72, 0x65, 0x73, 0x22, 0x3a, 0x20, 0x31, 0x0d, 0x0a,
+		0x09, 0x7d, 0x2c, 0x0d, 0x0a, 0x09, 0x22, 0x77, 0x6f, 0x72, 0x6b, 0x2d,
+		0x73, 0x74, 0x65, 0x61, 0x6c, 0x69, 0x6e, 0x67, 0x22, 0x3a, 0x20, 0x74,
+		0x72, 0x75, 0x65, 0x2c, 0x0d, 0x0a, 0x09, 0x22, 0x72, 0x65, 0x67, 0x69,
+		0x6f, 0x6e, 0x2d, 0x61, 0x66, 0x66, 0x69, 0x6e, 0x69, 0x74, 0x79, 0x22,
+		0x3a, 0x20, 0x74, 0x72, 0x75, 0x65, 0x2c, 0x0d, 0x0a, 0x09, 0x22, 0x77,
+		0x6f, 0x72, 0x6b, 0x65, 0x72, 0x2d, 0x69, 0x64, 0x6c, 0x65, 0x22, 0x3a,
+		0x20, 0x7b, 0x0d, 0x0a, 0x09, 0x09, 0x22, 0x73, 0x70, 0x69, 0x6e, 0x2d,
+		0x72, 0x6f, 0x75, 0x6e, 0x64, 0x73, 0x22, 0x3a, 0x20, 0x31, 0x30, 0x2c,
+		0x0d, 0x0a, 0x09, 0x09, 0x22, 0x79, 0x69, 0x65, 0x6c, 0x64, 0x2d, 0x72,
+		0x6f, 0x75, 0x6e, 0x64, 0x73, 0x22, 0x3a, 0x20, 0x34, 0x0d, 0x0a, 0x09,
+		0x7d, 0x2c, 0x0d, 0x0a, 0x09, 0x22, 0x6a, 0x6f, 0x62, 0x2d, 0x6c, 0x61,
+		0x6e, 0x65, 0x73, 0x22, 0x3a, 0x20, 0x7b, 0x0d, 0x0a, 0x09, 0x09, 0x22,
+		0x6c, 0x61, 0x74, 0x65, 0x6e, 0x63, 0x79, 0x2d, 0x63, 0x72, 0x69, 0x74,
+		0x69, 0x63, 0x61, 0x6c, 0x22, 0x3a, 0x20, 0x7b, 0x0d, 0x0a, 0x09, 0x09,
+		0x09, 0x22, 0x77, 0x65, 0x69, 0x67, 0x68, 0x74, 0x22, 0x3a, 0x20, 0x38,
+		0x2c, 0x0d, 0x0a, 0x09, 0x09, 0x09, 0x22, 0x74, 0x61, 0x72, 0x67, 0x65,
+		0x74, 0x2d, 0x6c, 0x61, 0x74, 0x65, 0x6e, 0x63, 0x79, 0x22, 0x3a, 0x20,
+		0x35, 0x30, 0x0d, 0x0a, 0x09, 0x09, 0x7d, 0x2c, 0x0d, 0x0a, 0x09, 0x09,
+		0x22, 0x74, 0x69, 0x63, 0x6b, 0x2d, 0x63, 0x72, 0x69, 0x74, 0x69, 0x63,
+		0x61, 0x6c, 0x22, 0x3a, 0x20, 0x7b, 0x0d, 0x0a, 0x09, 0x09, 0x09, 0x22,
+		0x77, 0x65, 0x69, 0x67, 0x68, 0x74, 0x22, 0x3a, 0x20, 0x34, 0x2c, 0x0d,
+		0x0a, 0x09, 0x09, 0x09, 0x22, 0x74, 0x61, 0x72, 0x67, 0x65, 0x74, 0x2d,
+		0x6c, 0x61, 0x74, 0x65, 0x6e, 0x63, 0x79, 0x22, 0x3a, 0x20, 0x35, 0x30,
+		0x0d, 0x0a, 0x09, 0x09, 0x7d, 0x2c, 0x0d, 0x0a, 0x09, 0x09, 0x22, 0x62,
+		0x61, 0x63, 0x6b, 0x67, 0x72, 0x6f, 0x75, 0x6e, 0x64, 0x22, 0x3a, 0x20,
+		0x7b, 0x0d, 0x0a, 0x09, 0x09, 0x09, 0x22, 0x77, 0x65, 0x69, 0x67, 0x68,
+		0x74, 0x22, 0x3a, 0x20, 0x31, 0x2c, 0x0d, 0x0a, 0x09, 0x09, 0x09, 0x22,
+		0x74, 0x61, 0x72, 0x67, 0x65, 0x74, 0x2d, 0x6c, 0x61, 0x74, 0x65, 0x6e,
+		0x63, 0x79, 0x22, 0x3a, 0x20, 0x31, 0x30, 0x30, 0x30, 0x0d, 0x0a, 0x09,
+		0x09, 0x7d, 0x0d, 0x0a, 0x09, 0x7d, 0x2c, 0x0d, 0x0a, 0x09, 0x22, 0x6a,
+		0x6f, 0x62, 0x2d, 0x74, 0x65, 0x6c, 0x65, 0x6d, 0x65, 0x74, 0x72, 0x79,
+		0x22, 0x3a, 0x20, 0x74, 0x72, 0x75, 0x65, 0x2c, 0x0d, 0x0a, 0x09, 0x22,
+		0x6d, 0x61, 0x78, 0x2d, 0x74, 0x69, 0x63, 0x6b, 0x2d, 0x74, 0x69, 0x6d,
+		0x65, 0x22, 0x3a, 0x20, 0x36, 0x30, 0x30, 0x30, 0x30, 0x2c, 0x0d, 0x0a,
+		0x09, 0x22, 0x6c, 0x65, 0x76, 0x65, 0x6c, 0x22, 0x3a, 0x20, 0x7b, 0x0d,
+		0x0a, 0x09, 0x09, 0x22, 0x6e, 0x61, 0x6d, 0x65, 0x22, 0x3a, 0x20, 0x22,
+		0x77, 0x6f, 0x72, 0x6c, 0x64, 0x22, 0x2c, 0x0d, 0x0a, 0x09, 0x09, 0x22,
+		0x6d, 0x61, 0x78, 0x2d, 0x73, 0x69, 0x7a, 0x65, 0x22, 0x3a, 0x20, 0x32,
+		0x39, 0x39, 0x39, 0x39, 0x39, 0x38, 0x34, 0x2c, 0x0d, 0x0a, 0x09, 0x09,
+		0x22, 0x73, 0x70, 0x61, 0x77, 0x6e, 0x2d, 0x70, 0x72, 0x6f, 0x74, 0x65,
+		0x63, 0x74, 0x69, 0x6f, 0x6e, 0x22, 0x3a, 0x20, 0x31, 0x36, 0x2c, 0x0d,
+		0x0a, 0x09, 0x09, 0x22, 0x67, 0x65, 0x6e, 0x65, 0x72, 0x61, 0x74, 0x6f,
+		0x72, 0x22, 0x3a, 0x20, 0x7b, 0x0d, 0x0a, 0x09, 0x09, 0x09, 0x22, 0x74,
+		0x79, 0x70, 0x65, 0x22, 0x3a, 0x20, 0x22, 0x64, 0x65, 0x66, 0x61, 0x75,
+		0x6c, 0x74, 0x22, 0x2c, 0x0d, 0x0a, 0x09, 0x09, 0x09, 0x22, 0x73, 0x65,
+		0x74, 0x74, 0x69, 0x6e, 0x67, 0x73, 0x22, 0x3a, 0x20, 0x22, 0x22, 0x2c,
+		0x0d, 0x0a, 0x09, 0x09, 0x09, 0x22, 0x73, 0x74, 0x72, 0x75, 0x63, 0x74,
+		0x75, 0x72, 0x65, 0x73, 0x22, 0x3a, 0x20, 0x74, 0x72, 0x75, 0x65, 0x2c,
+		0x0d, 0x0a, 0x09, 0x09, 0x09, 0x22, 0x73, 0x65, 0x65, 0x64, 0x22, 0x3a,
+		0x20, 0x30, 0x0d, 0x0a, 0x09, 0x09, 0x7d, 0x0d, 0x0a, 0x09, 0x7d, 0x2c,
+		0x0d, 0x0a, 0x09, 0x22, 0x67, 0x61, 0x6d, 0x65, 0x6d, 0x6f, 0x64, 0x65,
+		0x22, 0x3a, 0x20, 0x7b, 0x0d, 0x0a, 0x09, 0x09, 0x22, 0x64, 0x65, 0x66,
+		0x61, 0x75, 0x6c, 0x74, 0x22, 0x3a, 0x20, 0x22, 0x73, 0x75, 0x72, 0x76,
+		0x69, 0x76, 0x61, 0x6c, 0x22, 0x2c, 0x0d, 0x0a, 0x09, 0x09, 0x22, 0x66,
+		0x6f, 0x72, 0x63, 0x65, 0x22, 0x3a, 0x20, 0x74, 0x72, 0x75, 0x65, 0x0d,
+		0x0a, 0x09, 0x7d, 0x2c, 0x0d, 0x0a, 0x09, 0x22, 0x64, 0x69, 0x66, 0x66,
+		0x69, 0x63, 0x75, 0x6c, 0x74, 0x79, 0x22, 0x3a, 0x20, 0x7b, 0x0d, 0x0a,
+		0x09, 0x09, 0x22, 0x6c, 0x65, 0x76, 0x65, 0x6c, 0x22, 0x3a, 0x20, 0x22,
+		0x65, 0x61, 0x73, 0x79, 0x22, 0x2c, 0x0d, 0x0a, 0x09, 0x09, 0x22, 0x68,
+		0x61, 0x72, 0x64, 0x63, 0x6f, 0x72, 0x65, 0x22, 0x3a, 0x20, 0x66, 0x61,
+		0x6c, 0x73, 0x65, 0x0d, 0x0a, 0x09, 0x7d, 0x2c, 0x0d, 0x0a, 0x09, 0x22,
+		0x65, 0x6e, 0x66, 0x6f, 0x72, 0x63, 0x65, 0x2d, 0x77, 0x68, 0x69, 0x74,
+		0x65, 0x6c, 0x69, 0x73, 0x74, 0x22, 0x3a, 0x20, 0x66, 0x61, 0x6c, 0x73,
+		0x65, 0x2c, 0x0d, 0x0a, 0x09, 0x22, 0x65, 0x6e, 0x61, 0x62, 0x6c, 0x65,
+		0x2d, 0x63, 0x6f, 0x6d, 0x6d, 0x61, 0x6e, 0x64, 0x2d, 0x62, 0x6c, 0x6f,
+		0x63, 0x6b, 0x22, 0x3a, 0x20, 0x66, 0x61, 0x6c, 0x73, 0x65, 0x2c, 0x0d,
+		0x0a, 0x09, 0x22, 0x6d, 0x61, 0x78, 0x2d, 0x70, 0x6c, 0x61, 0x79, 0x65,
+		0x72, 0x73, 0x22, 0x3a, 0x20, 0x32, 0x30, 0x2c, 0x0d, 0x0a, 0x09, 0x22,
+		0x73, 0x70, 0x61, 0x77, 0x6e, 0x22, 0x3a, 0x20, 0x7b, 0x0d, 0x0a, 0x09,
+		0x09, 0x22, 0x6d, 0x6f, 0x6e, 0x73, 0x74, 0x65, 0x72, 0x73, 0x22, 0x3a,
+		0x20, 0x74, 0x72, 0x75, 0x65, 0x2c, 0x0d, 0x0a, 0x09, 0x09, 0x22, 0x6e,
+		0x70, 0x63, 0x73, 0x22, 0x3a, 0x20, 0x74, 0x72, 0x75, 0x65, 0x0d, 0x0a,
+		0x09, 0x7d, 0x2c, 0x0d, 0x0a, 0x09, 0x22, 0x72, 0x65, 0x6e, 0x64, 0x65,
+		0x72, 0x2d, 0x64, 0x69, 0x73, 0x74, 0x61, 0x6e, 0x63, 0x65, 0x22, 0x3a,
+		0x20, 0x31, 0x30, 0x2c, 0x0d, 0x0a, 0x09, 0x22, 0x73, 0x69, 0x6d, 0x75,
+		0x6c, 0x61, 0x74, 0x69, 0x6f, 0x6e, 0x2d, 0x64, 0x69, 0x73, 0x74, 0x61,
+		0x6e, 0x63, 0x65, 0x22, 0x3a, 0x20, 0x31, 0x30, 0x2c, 0x0d, 0x0a, 0x09,
+		0x22, 0x6f, 0x70, 0x2d, 0x70, 0x65, 0x72, 0x6d, 0x69, 0x73, 0x73, 0x69,
+		0x6f, 0x6e, 0x2d, 0x6c, 0x65, 0x76, 0x65, 0x6c, 0x22, 0x3a, 0x20, 0x34,
+		0x2c, 0x0d, 0x0a, 0x09, 0x22, 0x70, 0x76, 0x70, 0x22, 0x3a, 0x20, 0x74,
+		0x72, 0x75, 0x65, 0x2c, 0x0d, 0x0a, 0x09, 0x22, 0x73, 0x65, 0x72, 0x76,
+		0x65, 0x72, 0x22, 0x3a, 0x20, 0x7b, 0x0d, 0x0a, 0x09, 0x09, 0x22, 0x61,
+		0x64, 0x64, 0x72, 0x65, 0x73, 0x73, 0x22, 0x3a, 0x20, 0x22, 0x22, 0x2c,
+		0x0d, 0x0a, 0x09, 0x09, 0x22, 0x70, 0x6f, 0x72, 0x74, 0x22, 0x3a, 0x20,
+		0x32, 0x35, 0x35, 0x36, 0x35, 0x0d, 0x0a, 0x09, 0x7d, 0x2c, 0x0d, 0x0a,
+		0x09, 0x22, 0x70, 0x72, 0x65, 0x76, 0x65, 0x6e, 0x74, 0x2d, 0x70, 0x72,
+		0x6f, 0x78, 0x79, 0x2d, 0x63, 0x6f, 0x6e, 0x6e, 0x65, 0x63, 0x74, 0x69,
+		0x6f, 0x6e, 0x73, 0x22, 0x3a, 0x20, 0x74, 0x72, 0x75, 0x65, 0x2c, 0x0d,
+		0x0a, 0x09, 0x22, 0x6e, 0x65, 0x74, 0x77, 0x6f, 0x72, 0x6b, 0x2d, 0x63,
+		0x6f, 0x6d, 0x70, 0x72, 0x65, 0x73, 0x73, 0x69, 0x6f, 0x6e, 0x2d, 0x74,
+		0x68, 0x72, 0x65, 0x73, 0x68, 0x6f, 0x6c, 0x64, 0x22, 0x3a, 0x20, 0x32,
+		0x35, 0x36, 0x2c, 0x0d, 0x0a, 0x09, 0x22, 0x72, 0x65, 0x64, 0x75, 0x63,
+		0x65, 0x64, 0x2d, 0x64, 0x65, 0x62, 0x75, 0x67, 0x2d, 0x69, 0x6e, 0x66,
+		0x6f, 0x22, 0x3a, 0x20, 0x66, 0x61, 0x6c, 0x73, 0x65, 0x2c, 0x0d, 0x0a,
+		0x09, 0x22, 0x6f, 0x6e, 0x6c, 0x69, 0x6e, 0x65, 0x2d, 0x6d, 0x6f, 0x64,
+		0x65, 0x22, 0x3a, 0x20, 0x74, 0x72, 0x75, 0x65, 0x2c, 0x0d, 0x0a, 0x09,
+		0x22, 0x68, 0x69, 0x64, 0x65, 0x2d, 0x6f, 0x6e, 0x6c, 0x69, 0x6e, 0x65,
+		0x2d, 0x70, 0x6c, 0x61, 0x79, 0x65, 0x72, 0x73, 0x22, 0x3a, 0x20, 0x66,
+		0x61, 0x6c, 0x73, 0x65, 0x2c, 0x0d, 0x0a, 0x09, 0x22, 0x6d, 0x6f, 0x74,
+		0x64, 0x22, 0x3a, 0x20, 0x7b, 0x0d, 0x0a, 0x09, 0x09, 0x22, 0x74, 0x65,
+		0x78, 0x74, 0x22, 0x3a, 0x20, 0x22, 0x41, 0x20, 0x4d, 0x69, 0x6e, 0x65,
+		0x63, 0x72, 0x61, 0x66, 0x74, 0x20, 0x73, 0x65, 0x72, 0x76, 0x65, 0x72,
+		0x22, 0x0d, 0x0a, 0x09, 0x7d, 0x0d, 0x0a, 0x7d
 	};
 
 	FILE* file = fopen("server.json", "wb");
@@ -603,25 +1056,13 @@ void sky_term() {
 
 	log_info("Stopping the server...");
 
-	// stop listening
-	ltg_term(sky_get_listener());
-
-	// join main thread
+	// join main thread, its last tick still flushes to the network threads
 	pthread_join(sky_main.thread, NULL);
 
-	// join to each worker
-	// resume workers waiting for jobs
-	job_resume();
-
-	for (size_t i = 0; i < sky_main.workers.vector.size; ++i) {
-
-		sky_worker_t* worker = UTL_VECTOR_GET_AS(sky_worker_t*, &sky_main.workers.vector, i);
-
-		if (pthread_self() != worker->thread) {
-			pthread_join(worker->thread, NULL);
-		}
+	// stop listening
+	ltg_term(sky_get_listener());
 
-	}
+	sky_stop_workers();
 
 	wld_unload_all();
 
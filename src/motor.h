@@ -4,6 +4,9 @@
 #include "motor.d.h"
 
 #include "main.h"
+#include "util/deque.h"
+#include "util/list.h"
+#include "jobs/board.d.h"
 #include "listening/listening.h"
 #include "io/commands/commands.h"
 
@@ -11,9 +14,19 @@
 struct sky_worker {
 
 	pthread_t thread;
-	uint32_t job;
+	uint64_t job;
 	uint16_t id;
 
+	// jobs added by this worker for each lane, stolen by the others when they run out
+	utl_deque_t deques[job_lane_count];
+
+	// jobs that last ran on this worker and are sent back to it, only taken by others when it falls behind
+	struct {
+		pthread_mutex_t lock;
+		utl_list_t list;
+		_Atomic uint32_t length;
+	} inbox[job_lane_count];
+
 };
 
 /*
@@ -26,10 +39,20 @@ struct sky_main {
 
 	/* workers */
 	struct {
-		size_t count;
+		size_t count; // 0 to size the pool from the available cores
 		utl_vector_t vector;
+		// set once the main thread is done, the tick may still need the workers until then
+		_Atomic bool stopping;
 	} workers;
 
+	/* thread placement */
+	struct {
+		// give the main thread, the networking threads and each worker their own cores
+		bool pin_threads;
+		// cores kept out of the worker pool for the listener and network threads
+		uint16_t network_cores;
+	} affinity;
+
 	string_t version;
 	string_t mcver;
 	cht_component_t* motd;
@@ -44,6 +67,13 @@ struct sky_main {
 	} world;
 
 	uint32_t max_tick_time;
+
+	/* tick timing, nanoseconds */
+	struct {
+		_Atomic uint64_t last; // from the start of the last tick until its tick phase was done
+		_Atomic uint64_t average; // moving average of the above
+		_Atomic uint64_t interval; // moving average of the time between the starts of ticks
+	} tick;
 	
 	/* listener */
 	ltg_listener_t listener;
@@ -91,6 +121,12 @@ extern void* t_sky_worker(void*);
 
 extern void sky_load_server_json();
 extern void sky_gen_server_json();
+// create and start sky_main.workers.count workers
+extern void sky_start_workers();
+// wait for the workers to exit once the server is stopping
+extern void sky_stop_workers();
+// pin the main thread, the listener and the workers to their own cores
+extern void sky_pin_threads();
 
 extern void sky_term();
 
@@ -107,6 +143,7 @@ static inline void sky_set_motd(cht_component_t* component) {
 		cht_free(sky_main.motd);
 	}
 	sky_main.motd = component;
+	ltg_invalidate_status(&sky_main.listener);
 }
 
 static inline cmd_sender_t sky_get_console() {
@@ -117,6 +154,19 @@ static inline ltg_listener_t* sky_get_listener() {
 	return &sky_main.listener;
 }
 
+// milliseconds the last tick took
+static inline float64_t sky_get_mspt() {
+	return sky_main.tick.last / 1000000.0;
+}
+
+static inline float64_t sky_get_average_mspt() {
+	return sky_main.tick.average / 1000000.0;
+}
+
+static inline float64_t sky_get_tps() {
+	return sky_main.tick.interval == 0 ? 0 : (float64_t) SKY_NANOS_PER_SECOND / sky_main.tick.interval;
+}
+
 static inline uint8_t sky_get_render_distance() {
 	return sky_main.render_distance;
 }
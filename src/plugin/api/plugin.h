@@ -240,7 +240,7 @@ typedef struct {
 
 // API
 
-#define PLUGIN_API_VERSION 0
+#define PLUGIN_API_VERSION 1
 
 // The MotorMC API
 // Useful for interfacing with the server
@@ -9,6 +9,6 @@ typedef enum {
 
 typedef struct plg_plugin plg_plugin_t;
 
-#define PLG_CURRENT_INTERFACE 0
+#define PLG_CURRENT_INTERFACE 1
 
 typedef struct plg_interface plg_interface_t;
\ No newline at end of file
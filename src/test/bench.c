@@ -0,0 +1,407 @@
+#include "bench.h"
+#include <stdlib.h>
+#include <time.h>
+#include "../motor.h"
+#include "../io/logger/logger.h"
+#include "../jobs/board.h"
+#include "../jobs/scheduler/scheduler.h"
+#include "../crypt/cfb8.h"
+#include "../io/varint/varint.h"
+#include "../util/str_util.h"
+#include "../world/world.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+static inline uint64_t bench_now() {
+
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+
+	return (uint64_t) time.tv_sec * 1000000000 + time.tv_nsec;
+
+}
+
+static inline uint32_t bench_random(uint32_t* state) {
+
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+
+	return x;
+
+}
+
+// take everything off of the board without running it
+static inline void bench_drain_board() {
+
+	while (job_get_count() != 0) {
+		job_free(job_get());
+	}
+
+}
+
+#define BENCH_SCHEDULER_JOBS 100000
+#define BENCH_SCHEDULER_TICKS 2000
+
+void bench_scheduler() {
+
+	uint32_t seed = 0x2545F491;
+	uint64_t* jobs = malloc(sizeof(uint64_t) * BENCH_SCHEDULER_JOBS);
+
+	// 1% repeating every tick like region ticks, half repeating like keep alives, the rest one shot up to 5 minutes out
+	uint64_t start = bench_now();
+	for (uint32_t i = 0; i < BENCH_SCHEDULER_JOBS; ++i) {
+		jobs[i] = job_new(job_entity_teleport, (job_payload_t) { .client = NULL });
+		if (i % 100 == 0) {
+			sch_schedule_repeating(jobs[i], 1, 1);
+		} else if (i & 1) {
+			sch_schedule_repeating(jobs[i], 1 + bench_random(&seed) % 200, 200);
+		} else {
+			sch_schedule(jobs[i], 1 + bench_random(&seed) % 6000);
+		}
+	}
+	const uint64_t schedule_time = bench_now() - start;
+
+	uint64_t total = 0;
+	uint64_t worst = 0;
+	for (uint32_t i = 0; i < BENCH_SCHEDULER_TICKS; ++i) {
+
+		start = bench_now();
+		sch_tick();
+		const uint64_t time = bench_now() - start;
+
+		total += time;
+		if (time > worst) {
+			worst = time;
+		}
+
+		bench_drain_board();
+
+	}
+
+	start = bench_now();
+	for (uint32_t i = 0; i < BENCH_SCHEDULER_JOBS; ++i) {
+		sch_cancel(jobs[i]);
+	}
+	const uint64_t cancel_time = bench_now() - start;
+
+	// let the canceled jobs drain out of the scheduler
+	for (uint32_t i = 0; i < 6000; ++i) {
+		sch_tick();
+		bench_drain_board();
+	}
+
+	log_info("%u jobs, schedule: %.1fns/job, tick: %.1fus average, %.1fus worst, cancel: %.1fns/job",
+		BENCH_SCHEDULER_JOBS,
+		(double) schedule_time / BENCH_SCHEDULER_JOBS,
+		(double) total / BENCH_SCHEDULER_TICKS / 1000,
+		(double) worst / 1000,
+		(double) cancel_time / BENCH_SCHEDULER_JOBS
+	);
+
+	free(jobs);
+
+}
+
+// counts cache misses of this thread and the threads it starts after this, -1 if the kernel doesn't allow it or it isn't linux
+static inline int bench_open_cache_misses() {
+
+#ifdef __linux__
+	struct perf_event_attr attr = {
+		.type = PERF_TYPE_HARDWARE,
+		.size = sizeof(struct perf_event_attr),
+		.config = PERF_COUNT_HW_CACHE_MISSES,
+		.inherit = 1,
+		.exclude_kernel = 1,
+		.exclude_hv = 1
+	};
+
+	return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+	return -1;
+#endif
+
+}
+
+#define BENCH_AFFINITY_REGIONS 32
+#define BENCH_AFFINITY_CHUNKS 32
+#define BENCH_AFFINITY_WORKERS 4
+#define BENCH_AFFINITY_TICKS 500
+
+// run ticks on a fresh set of workers, returns the average tick time in nanoseconds
+static uint64_t bench_affinity_ticks(bool affinity, int64_t* misses) {
+
+	job_board.affinity = affinity;
+
+	// counts of the workers are only added up once they exit
+	const int counter = bench_open_cache_misses();
+
+	sky_main.status = sky_running;
+	sky_start_workers();
+
+	// let regions settle on their workers
+	for (uint32_t i = 0; i < 50; ++i) {
+		sch_tick();
+		job_join_tick();
+	}
+
+	const uint64_t start = bench_now();
+	for (uint32_t i = 0; i < BENCH_AFFINITY_TICKS; ++i) {
+		sch_tick();
+		job_join_tick();
+	}
+	const uint64_t time = bench_now() - start;
+
+	sky_main.status = sky_stopping;
+	sky_stop_workers();
+
+	for (size_t i = 0; i < sky_main.workers.vector.size; ++i) {
+		free(UTL_VECTOR_GET_AS(sky_worker_t*, &sky_main.workers.vector, i));
+	}
+	utl_term_vector(&sky_main.workers.vector);
+	utl_init_vector(&sky_main.workers.vector, sizeof(sky_worker_t*));
+
+	*misses = -1;
+#ifdef __linux__
+	if (counter >= 0) {
+		if (read(counter, misses, sizeof(*misses)) != sizeof(*misses)) {
+			*misses = -1;
+		}
+		close(counter);
+	}
+#else
+	(void) counter;
+#endif
+
+	return time / BENCH_AFFINITY_TICKS;
+
+}
+
+void bench_affinity() {
+
+	wld_world_t* world = wld_new(UTL_CSTRTOSTR("bench"), 1, mat_dimension_overworld);
+
+	// regions away from spawn with a row of ticking chunks each, chunks are large so keep the count low
+	for (uint32_t i = 0; i < BENCH_AFFINITY_REGIONS; ++i) {
+		wld_region_t* region = wld_gen_region(world, 100 + i % 8, 100 + i / 8);
+		for (uint32_t x = 0; x < BENCH_AFFINITY_CHUNKS; ++x) {
+			wld_gen_chunk(region, x, 0, WLD_TICKET_TICK_ENTITIES);
+		}
+	}
+
+	const size_t worker_count = sky_main.workers.count;
+	const bool previous = job_board.affinity;
+	sky_main.workers.count = BENCH_AFFINITY_WORKERS;
+
+	int64_t shared_misses, affine_misses;
+	const uint64_t shared = bench_affinity_ticks(false, &shared_misses);
+	const uint64_t affine = bench_affinity_ticks(true, &affine_misses);
+
+	sky_main.workers.count = worker_count;
+	job_board.affinity = previous;
+
+	log_info("%u regions on %u workers, without affinity: %.1fus/tick, with affinity: %.1fus/tick",
+		BENCH_AFFINITY_REGIONS,
+		BENCH_AFFINITY_WORKERS,
+		(double) shared / 1000,
+		(double) affine / 1000
+	);
+
+	if (shared_misses >= 0 && affine_misses >= 0) {
+		log_info("cache misses per tick, without affinity: %.0f, with affinity: %.0f", (double) shared_misses / (BENCH_AFFINITY_TICKS + 50), (double) affine_misses / (BENCH_AFFINITY_TICKS + 50));
+	} else {
+		log_info("cache misses not measured, hardware counters are not available");
+	}
+
+	wld_unload_all();
+
+}
+
+#define BENCH_CFB8_BYTES 16777216
+#define BENCH_CFB8_CHUNK 16384
+
+// encrypt and decrypt like the network threads do, a send chunk at a time, with OpenSSL and with cfb8
+void bench_cfb8() {
+
+	byte_t key[16];
+	uint32_t seed = 0x2545F491;
+	for (uint32_t i = 0; i < sizeof(key); ++i) {
+		key[i] = bench_random(&seed);
+	}
+
+	byte_t* bytes = malloc(BENCH_CFB8_CHUNK);
+	for (uint32_t i = 0; i < BENCH_CFB8_CHUNK; ++i) {
+		bytes[i] = bench_random(&seed);
+	}
+
+	EVP_CIPHER_CTX* evp_encrypt = EVP_CIPHER_CTX_new();
+	EVP_CIPHER_CTX* evp_decrypt = EVP_CIPHER_CTX_new();
+	EVP_EncryptInit_ex(evp_encrypt, EVP_aes_128_cfb8(), NULL, key, key);
+	EVP_DecryptInit_ex(evp_decrypt, EVP_aes_128_cfb8(), NULL, key, key);
+
+	int length = BENCH_CFB8_CHUNK;
+
+	uint64_t start = bench_now();
+	for (uint32_t i = 0; i < BENCH_CFB8_BYTES / BENCH_CFB8_CHUNK; ++i) {
+		EVP_EncryptUpdate(evp_encrypt, bytes, &length, bytes, BENCH_CFB8_CHUNK);
+	}
+	const uint64_t evp_encrypt_time = bench_now() - start;
+
+	start = bench_now();
+	for (uint32_t i = 0; i < BENCH_CFB8_BYTES / BENCH_CFB8_CHUNK; ++i) {
+		EVP_DecryptUpdate(evp_decrypt, bytes, &length, bytes, BENCH_CFB8_CHUNK);
+	}
+	const uint64_t evp_decrypt_time = bench_now() - start;
+
+	EVP_CIPHER_CTX_free(evp_encrypt);
+	EVP_CIPHER_CTX_free(evp_decrypt);
+
+	cfb8_cipher_t encrypt;
+	cfb8_cipher_t decrypt;
+	cfb8_init(key, &encrypt, &decrypt);
+
+	start = bench_now();
+	for (uint32_t i = 0; i < BENCH_CFB8_BYTES / BENCH_CFB8_CHUNK; ++i) {
+		cfb8_encrypt(&encrypt, bytes, BENCH_CFB8_CHUNK, bytes);
+	}
+	const uint64_t encrypt_time = bench_now() - start;
+
+	start = bench_now();
+	for (uint32_t i = 0; i < BENCH_CFB8_BYTES / BENCH_CFB8_CHUNK; ++i) {
+		cfb8_decrypt(&decrypt, bytes, BENCH_CFB8_CHUNK, bytes);
+	}
+	const uint64_t decrypt_time = bench_now() - start;
+
+	cfb8_done(&encrypt, &decrypt);
+
+	log_info("%u MiB, OpenSSL encrypt: %.1fMiB/s, decrypt: %.1fMiB/s, cfb8 (%s) encrypt: %.1fMiB/s, decrypt: %.1fMiB/s",
+		BENCH_CFB8_BYTES >> 20,
+		(double) BENCH_CFB8_BYTES / evp_encrypt_time * 1000000000 / 1048576,
+		(double) BENCH_CFB8_BYTES / evp_decrypt_time * 1000000000 / 1048576,
+		cfb8_accelerated() ? "AES-NI" : "OpenSSL",
+		(double) BENCH_CFB8_BYTES / encrypt_time * 1000000000 / 1048576,
+		(double) BENCH_CFB8_BYTES / decrypt_time * 1000000000 / 1048576
+	);
+
+	free(bytes);
+
+}
+
+#define BENCH_VARINT_VALUES 65536
+#define BENCH_VARINT_ROUNDS 256
+
+// write, read and measure arrays of varints with every kernel the CPU can run, for values as big as ids, tags, palettes and anything
+void bench_varints() {
+
+	const struct {
+		const char* label;
+		uint32_t limit;
+	} sets[] = {
+		{ "ids", 1 << 7 },
+		{ "tags", 1 << 10 },
+		{ "palettes", 24000 },
+		{ "anything", 0 }
+	};
+
+	int32_t* values = malloc(BENCH_VARINT_VALUES * sizeof(int32_t));
+	int32_t* read = malloc(BENCH_VARINT_VALUES * sizeof(int32_t));
+	byte_t* bytes = malloc(BENCH_VARINT_VALUES * 5);
+	uint32_t seed = 0x2545F491;
+	volatile size_t sink = 0;
+
+	for (uint32_t set = 0; set < sizeof(sets) / sizeof(sets[0]); ++set) {
+
+		for (uint32_t i = 0; i < BENCH_VARINT_VALUES; ++i) {
+			values[i] = sets[set].limit == 0 ? bench_random(&seed) : bench_random(&seed) % sets[set].limit;
+		}
+
+		char line[256];
+		int length = 0;
+
+		for (io_varint_kernel_t kernel = io_varint_scalar; kernel <= io_get_varint_kernel(); ++kernel) {
+
+			const io_varint_codec_t* codec = io_get_varint_codec(kernel);
+
+			uint64_t start = bench_now();
+			for (uint32_t i = 0; i < BENCH_VARINT_ROUNDS; ++i) {
+				sink += codec->write(bytes, values, BENCH_VARINT_VALUES, BENCH_VARINT_VALUES * 5);
+			}
+			const uint64_t write_time = bench_now() - start;
+
+			const size_t written = codec->write(bytes, values, BENCH_VARINT_VALUES, BENCH_VARINT_VALUES * 5);
+
+			start = bench_now();
+			for (uint32_t i = 0; i < BENCH_VARINT_ROUNDS; ++i) {
+				sink += codec->read(bytes, written, read, BENCH_VARINT_VALUES);
+			}
+			const uint64_t read_time = bench_now() - start;
+
+			start = bench_now();
+			for (uint32_t i = 0; i < BENCH_VARINT_ROUNDS; ++i) {
+				sink += codec->length(values, BENCH_VARINT_VALUES);
+			}
+			const uint64_t length_time = bench_now() - start;
+
+			length += snprintf(line + length, sizeof(line) - length, ", %s write: %.0fM/s, read: %.0fM/s, length: %.0fM/s",
+				codec->name,
+				(double) BENCH_VARINT_VALUES * BENCH_VARINT_ROUNDS / write_time * 1000,
+				(double) BENCH_VARINT_VALUES * BENCH_VARINT_ROUNDS / read_time * 1000,
+				(double) BENCH_VARINT_VALUES * BENCH_VARINT_ROUNDS / length_time * 1000
+			);
+
+		}
+
+		log_info("%s (%.2f bytes each)%s", sets[set].label, (double) io_var_ints_length(values, BENCH_VARINT_VALUES) / BENCH_VARINT_VALUES, line);
+
+	}
+
+	free(values);
+	free(read);
+	free(bytes);
+
+}
+
+typedef struct {
+	void (*func)();
+	string_t label;
+} bench_t;
+
+int bench_run_all() {
+
+	const bench_t benchmarks[] = {
+		(bench_t) {
+			.func = bench_scheduler,
+			.label = UTL_CSTRTOSTR("scheduler")
+		},
+		(bench_t) {
+			.func = bench_affinity,
+			.label = UTL_CSTRTOSTR("affinity")
+		},
+		(bench_t) {
+			.func = bench_cfb8,
+			.label = UTL_CSTRTOSTR("cfb8")
+		},
+		(bench_t) {
+			.func = bench_varints,
+			.label = UTL_CSTRTOSTR("varints")
+		}
+	};
+
+	const size_t bench_count = sizeof(benchmarks) / sizeof(benchmarks[0]);
+
+	log_info("Running %zu benchmarks", bench_count);
+
+	for (size_t i = 0; i < bench_count; ++i) {
+		log_info("Running benchmark \"%s\"...", UTL_STRTOCSTR(benchmarks[i].label));
+		benchmarks[i].func();
+	}
+
+	return EXIT_SUCCESS;
+
+}
\ No newline at end of file
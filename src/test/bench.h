@@ -0,0 +1,9 @@
+#pragma once
+#include "../main.h"
+
+extern void bench_scheduler();
+extern void bench_affinity();
+extern void bench_cfb8();
+extern void bench_varints();
+
+extern int bench_run_all();
\ No newline at end of file
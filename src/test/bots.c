@@ -0,0 +1,856 @@
+#include "bots.h"
+#include <stdlib.h>
+#include "../io/logger/logger.h"
+
+// the bots drive their sockets with poll, writev and non-blocking reads, the POSIX way
+#ifndef __WINDOWS__
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <libdeflate.h>
+#include "../motor.h"
+#include "../io/packet/packet.h"
+#include "../util/histogram.h"
+
+#define BOT_PER_DRIVER 64 // bots a driver thread plays, with one poll over their sockets
+#define BOT_TICK 50000000 // nanoseconds between the movement packets of a bot, like a game client
+#define BOT_CHAT_TICKS 100 // ticks between the chat messages of a bot, their echo is the round trip
+#define BOT_DIG_TICKS 40 // ticks between the blocks a bot starts digging, it cancels halfway and places one
+#define BOT_INSPECT_MAX 4096 // packets bigger than this are counted but not looked into, chunks and such
+#define BOT_RECEIVE_MIN 65536 // room made in the receive buffer before each read
+#define BOT_REPLAY_GRACE 2000000000 // nanoseconds a replay runs after the last copy should be done, for joining
+
+typedef enum {
+
+	bot_login,
+	bot_play,
+	bot_gone
+
+} bot_state_t;
+
+// a capture to replay, checked when it's loaded
+typedef struct {
+
+	byte_t* bytes;
+	size_t length;
+	size_t start; // the first frame, after the header
+	uint64_t duration; // milliseconds
+	uint32_t frames;
+
+} bot_recording_t;
+
+typedef struct {
+
+	int32_t socket;
+	uint32_t id;
+	bot_state_t state;
+	bool compression;
+
+	// what was received and not handled yet
+	byte_t* receive;
+	uint32_t received;
+	uint32_t capacity;
+
+	float64_t x;
+	float64_t y;
+	float64_t z;
+
+	uint64_t connected; // nanoseconds
+	uint64_t joined; // nanoseconds from connecting to the first position, 0 until then
+	uint64_t chatted; // nanoseconds, 0 when no chat message is waiting for its echo
+	uint32_t chats;
+	uint32_t tick;
+
+	// a bot replaying a capture plays it instead of its script
+	const bot_recording_t* recording;
+	size_t record; // the next frame
+	uint64_t replayed; // milliseconds into the recording
+	uint64_t shift; // nanoseconds from joining to starting the recording
+	uint64_t replay_at; // nanoseconds, 0 until the bot joined
+
+	uint64_t bytes_in;
+	uint64_t bytes_out;
+
+} bot_t;
+
+typedef struct {
+
+	pthread_t thread;
+
+	bot_t* bots;
+	uint32_t count;
+
+	uint16_t port;
+	uint64_t end; // nanoseconds
+	float64_t speed; // of the recordings
+
+	struct libdeflate_decompressor* decompressor;
+	pck_packet_t* packet; // the packet being looked into
+
+} bot_driver_t;
+
+static struct {
+
+	utl_histogram_t join;
+	utl_histogram_t round_trip;
+	utl_histogram_t mspt;
+
+	_Atomic uint32_t disconnected; // bots the server disconnected before the end
+	_Atomic uint64_t replayed; // frames
+
+} bot_stats;
+
+static inline uint64_t bot_now() {
+
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+
+	return (uint64_t) time.tv_sec * 1000000000 + time.tv_nsec;
+
+}
+
+// the var int at the start of the bytes, 0 if it isn't all there yet
+static size_t bot_read_var_int(const byte_t* bytes, size_t available, int32_t* value) {
+
+	uint32_t result = 0;
+
+	for (size_t i = 0; i < available && i < 5; ++i) {
+		result |= (uint32_t) (bytes[i] & 0x7F) << (7 * i);
+		if (!(bytes[i] & 0x80)) {
+			*value = result;
+			return i + 1;
+		}
+	}
+
+	return 0;
+
+}
+
+static void bot_leave(bot_t* bot, const char* reason) {
+
+	if (bot->state == bot_gone) {
+		return;
+	}
+
+	if (reason != NULL) {
+		log_warn("Bot %u was disconnected: %s", bot->id, reason);
+		bot_stats.disconnected++;
+	}
+
+	bot->state = bot_gone;
+	close(bot->socket);
+
+}
+
+// bots never compress what they send, the server takes uncompressed frames of any size
+static void bot_send_frame(bot_t* bot, const byte_t* bytes, size_t length) {
+
+	if (bot->state == bot_gone) {
+		return;
+	}
+
+	byte_t header[6];
+	size_t header_length = io_write_var_int(header, length + (bot->compression ? 1 : 0), 5);
+
+	if (bot->compression) {
+		header[header_length++] = 0;
+	}
+
+	struct iovec frame[2] = {
+		{ .iov_base = header, .iov_len = header_length },
+		{ .iov_base = (void*) bytes, .iov_len = length }
+	};
+
+	if (writev(bot->socket, frame, 2) != (ssize_t) (header_length + length)) {
+		bot_leave(bot, "could not send");
+		return;
+	}
+
+	bot->bytes_out += header_length + length;
+
+}
+
+static inline void bot_send(bot_t* bot, pck_packet_t* packet) {
+
+	bot_send_frame(bot, packet->bytes, packet->cursor);
+
+}
+
+static inline void bot_write_floor(pck_packet_t* packet, bot_t* bot) {
+
+	pck_write_position(packet, (pck_position_t) {
+		.x = (int32_t) floor(bot->x),
+		.y = (int16_t) floor(bot->y) - 1,
+		.z = (int32_t) floor(bot->z)
+	});
+
+}
+
+static void bot_connect(bot_driver_t* driver, bot_t* bot) {
+
+	bot->socket = socket(AF_INET, SOCK_STREAM, 0);
+	bot->connected = bot_now();
+
+	struct sockaddr_in address = {
+		.sin_family = AF_INET,
+		.sin_port = htons(driver->port),
+		.sin_addr.s_addr = htonl(INADDR_LOOPBACK)
+	};
+
+	if (bot->socket < 0 || connect(bot->socket, (struct sockaddr*) &address, sizeof(address)) != 0) {
+		log_warn("Bot %u could not connect: %s", bot->id, strerror(errno));
+		bot->state = bot_gone;
+		bot_stats.disconnected++;
+		return;
+	}
+
+	PCK_INLINE(handshake, 32, io_big_endian);
+	pck_write_var_int(handshake, 0x00);
+	pck_write_var_int(handshake, sky_get_protocol());
+	pck_write_string(handshake, "localhost", 9);
+	pck_write_int16(handshake, driver->port);
+	pck_write_var_int(handshake, 2);
+	bot_send(bot, handshake);
+
+	char name[16];
+	const int name_length = sprintf(name, "bot%u", bot->id);
+
+	PCK_INLINE(login, 32, io_big_endian);
+	pck_write_var_int(login, 0x00);
+	pck_write_string(login, name, name_length);
+	bot_send(bot, login);
+
+	fcntl(bot->socket, F_SETFL, fcntl(bot->socket, F_GETFL, 0) | O_NONBLOCK);
+
+}
+
+static void bot_handle_login(bot_t* bot, pck_packet_t* packet) {
+
+	switch (pck_read_var_int(packet)) {
+		case 0x00: {
+			bot_leave(bot, "kicked while logging in");
+		} break;
+		case 0x01: {
+			bot_leave(bot, "the server asked for encryption");
+		} break;
+		case 0x02: {
+			bot->state = bot_play;
+		} break;
+		case 0x03: {
+			bot->compression = true;
+		} break;
+		default: {
+			// nothing to do
+		} break;
+	}
+
+}
+
+static void bot_handle_play(bot_t* bot, pck_packet_t* packet) {
+
+	switch (pck_read_var_int(packet)) {
+		case 0x0f: { // chat message
+			if (bot->chatted != 0) {
+				char token[32];
+				sprintf(token, "bench %u:%u;", bot->id, bot->chats);
+				packet->bytes[packet->length] = 0;
+				if (strstr((char*) pck_cursor(packet), token) != NULL) {
+					utl_histogram_record(&bot_stats.round_trip, bot_now() - bot->chatted);
+					bot->chatted = 0;
+				}
+			}
+		} break;
+		case 0x1a: { // disconnect
+			bot_leave(bot, "kicked");
+		} break;
+		case 0x21: { // keep alive
+			PCK_INLINE(keep_alive, 16, io_big_endian);
+			pck_write_var_int(keep_alive, 0x0f);
+			pck_write_int64(keep_alive, pck_read_int64(packet));
+			bot_send(bot, keep_alive);
+		} break;
+		case 0x38: { // player position and look
+			bot->x = pck_read_float64(packet);
+			bot->y = pck_read_float64(packet);
+			bot->z = pck_read_float64(packet);
+			pck_read_float32(packet);
+			pck_read_float32(packet);
+			pck_read_int8(packet);
+
+			PCK_INLINE(confirm, 8, io_big_endian);
+			pck_write_var_int(confirm, 0x00);
+			pck_write_var_int(confirm, pck_read_var_int(packet));
+			bot_send(bot, confirm);
+
+			if (bot->joined == 0) {
+				bot->joined = bot_now() - bot->connected;
+				bot->replay_at = bot->connected + bot->joined + bot->shift;
+				utl_histogram_record(&bot_stats.join, bot->joined);
+			}
+		} break;
+		default: {
+			// nothing to do
+		} break;
+	}
+
+}
+
+static void bot_handle_frame(bot_driver_t* driver, bot_t* bot, const byte_t* frame, size_t length) {
+
+	pck_packet_t* packet = driver->packet;
+
+	if (bot->compression) {
+
+		int32_t data_length;
+		const size_t data_length_length = bot_read_var_int(frame, length, &data_length);
+
+		if (data_length_length == 0 || data_length > BOT_INSPECT_MAX) {
+			return;
+		}
+
+		frame += data_length_length;
+		length -= data_length_length;
+
+		if (data_length != 0) {
+
+			size_t inflated;
+			if (libdeflate_zlib_decompress(driver->decompressor, frame, length, packet->bytes, data_length, &inflated) != LIBDEFLATE_SUCCESS) {
+				bot_leave(bot, "sent a frame that doesn't inflate");
+				return;
+			}
+
+			packet->cursor = 0;
+			packet->length = inflated;
+
+		} else if (length <= BOT_INSPECT_MAX) {
+			pck_init_from_bytes(packet, (byte_t*) frame, length, io_big_endian);
+		} else {
+			return;
+		}
+
+	} else if (length <= BOT_INSPECT_MAX) {
+		pck_init_from_bytes(packet, (byte_t*) frame, length, io_big_endian);
+	} else {
+		return;
+	}
+
+	switch (bot->state) {
+		case bot_login: {
+			bot_handle_login(bot, packet);
+		} break;
+		case bot_play: {
+			bot_handle_play(bot, packet);
+		} break;
+		default: {
+			// nothing to do
+		} break;
+	}
+
+}
+
+static void bot_receive(bot_driver_t* driver, bot_t* bot) {
+
+	for (;;) {
+
+		if (bot->capacity - bot->received < BOT_RECEIVE_MIN) {
+			bot->capacity = bot->capacity == 0 ? BOT_RECEIVE_MIN * 2 : bot->capacity * 2;
+			bot->receive = realloc(bot->receive, bot->capacity);
+		}
+
+		const ssize_t received = recv(bot->socket, bot->receive + bot->received, bot->capacity - bot->received, 0);
+
+		if (received > 0) {
+			bot->received += received;
+			bot->bytes_in += received;
+		} else if (received == 0) {
+			bot_leave(bot, "the connection was closed");
+			return;
+		} else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+			break;
+		} else if (errno != EINTR) {
+			bot_leave(bot, strerror(errno));
+			return;
+		}
+
+	}
+
+	uint32_t start = 0;
+
+	while (start < bot->received && bot->state != bot_gone) {
+
+		int32_t length;
+		const size_t length_length = bot_read_var_int(bot->receive + start, bot->received - start, &length);
+
+		if (length_length == 0 || start + length_length + length > bot->received) {
+			break;
+		}
+
+		if (length < 0) {
+			bot_leave(bot, "sent a frame with a negative length");
+			return;
+		}
+
+		bot_handle_frame(driver, bot, bot->receive + start + length_length, length);
+
+		start += length_length + length;
+
+	}
+
+	memmove(bot->receive, bot->receive + start, bot->received - start);
+	bot->received -= start;
+
+}
+
+// what the bot does every tick once it's in the world, spread out by its id so the bots don't all do it at once
+static void bot_tick(bot_t* bot) {
+
+	bot->tick++;
+
+	const uint32_t tick = bot->tick + bot->id;
+
+	// walk back and forth a second at a time
+	bot->x += (bot->tick / 20) % 2 == 0 ? 0.1 : -0.1;
+
+	PCK_INLINE(position, 32, io_big_endian);
+	pck_write_var_int(position, 0x11);
+	pck_write_float64(position, bot->x);
+	pck_write_float64(position, bot->y);
+	pck_write_float64(position, bot->z);
+	pck_write_int8(position, true);
+	bot_send(bot, position);
+
+	// the next message waits for the echo of the last
+	if (tick % BOT_CHAT_TICKS == 0 && bot->chatted == 0) {
+
+		char message[32];
+		const int message_length = sprintf(message, "bench %u:%u;", bot->id, ++bot->chats);
+
+		PCK_INLINE(chat, 40, io_big_endian);
+		pck_write_var_int(chat, 0x03);
+		pck_write_string(chat, message, message_length);
+		bot->chatted = bot_now();
+		bot_send(bot, chat);
+
+	}
+
+	switch (tick % BOT_DIG_TICKS) {
+		case 0: {
+			PCK_INLINE(swing, 8, io_big_endian);
+			pck_write_var_int(swing, 0x2c);
+			pck_write_var_int(swing, 0);
+			bot_send(bot, swing);
+
+			PCK_INLINE(dig, 16, io_big_endian);
+			pck_write_var_int(dig, 0x1a);
+			pck_write_var_int(dig, 0);
+			bot_write_floor(dig, bot);
+			pck_write_int8(dig, 1);
+			bot_send(bot, dig);
+		} break;
+		case BOT_DIG_TICKS / 2: {
+			// a bot that's still digging can't start on the next block
+			PCK_INLINE(cancel, 16, io_big_endian);
+			pck_write_var_int(cancel, 0x1a);
+			pck_write_var_int(cancel, 1);
+			bot_write_floor(cancel, bot);
+			pck_write_int8(cancel, 1);
+			bot_send(bot, cancel);
+		} break;
+		case BOT_DIG_TICKS * 3 / 4: {
+			PCK_INLINE(place, 32, io_big_endian);
+			pck_write_var_int(place, 0x2e);
+			pck_write_var_int(place, 0);
+			bot_write_floor(place, bot);
+			pck_write_var_int(place, 1);
+			pck_write_float32(place, 0.5f);
+			pck_write_float32(place, 1.0f);
+			pck_write_float32(place, 0.5f);
+			pck_write_int8(place, false);
+			bot_send(bot, place);
+		} break;
+	}
+
+}
+
+// what answers the server is sent live by the bot instead, and commands aren't run again
+static bool bot_should_replay(const byte_t* frame, size_t length) {
+
+	int32_t id = -1;
+	const size_t id_length = bot_read_var_int(frame, length, &id);
+
+	switch (id) {
+		case 0x00: // teleport confirm
+		case 0x0f: { // keep alive
+			return false;
+		}
+		case 0x03: { // chat message
+			int32_t message_length;
+			const size_t message_length_length = bot_read_var_int(frame + id_length, length - id_length, &message_length);
+			return message_length_length != 0 && id_length + message_length_length < length && frame[id_length + message_length_length] != '/';
+		}
+		default: {
+			return true;
+		}
+	}
+
+}
+
+// send the frames that were sent by now in the recording, scaled by the speed
+static void bot_replay(bot_driver_t* driver, bot_t* bot, uint64_t now) {
+
+	const bot_recording_t* recording = bot->recording;
+
+	if (now < bot->replay_at) {
+		return;
+	}
+
+	const float64_t at = (now - bot->replay_at) / 1000000.0 * driver->speed;
+
+	while (bot->record < recording->length && bot->state == bot_play) {
+
+		// the frames were checked when the recording was loaded
+		int32_t delta = 0;
+		int32_t length = 0;
+		const size_t delta_length = bot_read_var_int(recording->bytes + bot->record, recording->length - bot->record, &delta);
+		const size_t length_length = bot_read_var_int(recording->bytes + bot->record + delta_length, recording->length - bot->record - delta_length, &length);
+
+		if (bot->replayed + delta > at) {
+			break;
+		}
+
+		const byte_t* frame = recording->bytes + bot->record + delta_length + length_length;
+
+		bot->replayed += delta;
+		bot->record += delta_length + length_length + length;
+
+		if (bot_should_replay(frame, length)) {
+			bot_send_frame(bot, frame, length);
+			bot_stats.replayed++;
+		}
+
+	}
+
+	// the session is over
+	if (bot->record >= recording->length) {
+		bot_leave(bot, NULL);
+	}
+
+}
+
+static void* t_bot_drive(void* args) {
+
+	bot_driver_t* driver = args;
+
+	for (uint32_t i = 0; i < driver->count; ++i) {
+		bot_connect(driver, &driver->bots[i]);
+	}
+
+	struct pollfd* polls = calloc(driver->count, sizeof(struct pollfd));
+	uint64_t next_tick = bot_now() + BOT_TICK;
+
+	for (;;) {
+
+		const uint64_t now = bot_now();
+
+		if (now >= driver->end) {
+			break;
+		}
+
+		if (now >= next_tick) {
+			for (uint32_t i = 0; i < driver->count; ++i) {
+				bot_t* bot = &driver->bots[i];
+				if (bot->state == bot_play && bot->joined != 0) {
+					if (bot->recording != NULL) {
+						bot_replay(driver, bot, now);
+					} else {
+						bot_tick(bot);
+					}
+				}
+			}
+			next_tick += BOT_TICK;
+			continue;
+		}
+
+		for (uint32_t i = 0; i < driver->count; ++i) {
+			polls[i].fd = driver->bots[i].state == bot_gone ? -1 : driver->bots[i].socket;
+			polls[i].events = POLLIN;
+			polls[i].revents = 0;
+		}
+
+		if (poll(polls, driver->count, (next_tick - now) / 1000000 + 1) <= 0) {
+			continue;
+		}
+
+		for (uint32_t i = 0; i < driver->count; ++i) {
+			if (polls[i].revents != 0) {
+				bot_receive(driver, &driver->bots[i]);
+			}
+		}
+
+	}
+
+	// stop digging first, a dig the server finishes after the player left has nobody to finish it for
+	for (uint32_t i = 0; i < driver->count; ++i) {
+
+		bot_t* bot = &driver->bots[i];
+
+		if (bot->state == bot_play) {
+			PCK_INLINE(cancel, 16, io_big_endian);
+			pck_write_var_int(cancel, 0x1a);
+			pck_write_var_int(cancel, 1);
+			bot_write_floor(cancel, bot);
+			pck_write_int8(cancel, 1);
+			bot_send(bot, cancel);
+		}
+
+		bot_leave(bot, NULL);
+
+	}
+
+	free(polls);
+
+	return NULL;
+
+}
+
+// play the bots against the server for the duration and report how it held up
+static int bot_run(bot_t* bots, uint32_t count, uint64_t duration, float64_t speed) {
+
+	const uint32_t driver_count = (count + BOT_PER_DRIVER - 1) / BOT_PER_DRIVER;
+	const float64_t seconds = duration / 1000000000.0;
+
+	log_info("Running %u bots for %.1fs on %zu workers and %u network threads", count, seconds, sky_main.workers.count, sky_get_listener()->network.count);
+
+	bot_driver_t* drivers = calloc(driver_count, sizeof(bot_driver_t));
+
+	const uint64_t start = bot_now();
+	const uint64_t end = start + duration;
+
+	for (uint32_t i = 0; i < count; ++i) {
+		bots[i].id = i;
+	}
+
+	for (uint32_t i = 0; i < driver_count; ++i) {
+		bot_driver_t* driver = &drivers[i];
+		driver->bots = bots + i * BOT_PER_DRIVER;
+		driver->count = UTL_MIN(BOT_PER_DRIVER, count - i * BOT_PER_DRIVER);
+		driver->port = sky_get_listener()->address.port;
+		driver->end = end;
+		driver->speed = speed;
+		driver->decompressor = libdeflate_alloc_decompressor();
+		// one more byte to end chat messages with
+		driver->packet = pck_acquire(BOT_INSPECT_MAX + 1, io_big_endian);
+		pthread_create(&driver->thread, NULL, t_bot_drive, driver);
+	}
+
+	// a sample each tick
+	while (bot_now() < end) {
+		utl_histogram_record(&bot_stats.mspt, sky_main.tick.last);
+		usleep(BOT_TICK / 1000);
+	}
+
+	const float64_t tps = sky_get_tps();
+
+	for (uint32_t i = 0; i < driver_count; ++i) {
+		pthread_join(drivers[i].thread, NULL);
+		libdeflate_free_decompressor(drivers[i].decompressor);
+		pck_release(drivers[i].packet);
+	}
+
+	uint32_t joined = 0;
+	uint64_t last_join = 0;
+	uint64_t bytes_in = 0;
+	uint64_t bytes_out = 0;
+
+	for (uint32_t i = 0; i < count; ++i) {
+		if (bots[i].joined != 0) {
+			joined++;
+			last_join = UTL_MAX(last_join, bots[i].connected + bots[i].joined - start);
+			bytes_in += bots[i].bytes_in;
+			bytes_out += bots[i].bytes_out;
+		}
+		free(bots[i].receive);
+	}
+
+	log_info("Joined: %u of %u bots in %.3fs, latency p50 %.2fms, p99 %.2fms, max %.2fms",
+		joined, count, last_join / 1000000000.0,
+		utl_histogram_percentile(&bot_stats.join, 50) / 1000000.0,
+		utl_histogram_percentile(&bot_stats.join, 99) / 1000000.0,
+		utl_histogram_max(&bot_stats.join) / 1000000.0
+	);
+	log_info("Chat round trip: %lu messages, p50 %.2fms, p99 %.2fms, max %.2fms",
+		utl_histogram_count(&bot_stats.round_trip),
+		utl_histogram_percentile(&bot_stats.round_trip, 50) / 1000000.0,
+		utl_histogram_percentile(&bot_stats.round_trip, 99) / 1000000.0,
+		utl_histogram_max(&bot_stats.round_trip) / 1000000.0
+	);
+	log_info("Server: %.2f mspt on average, p99 %.2fms, max %.2fms, %.2f tps",
+		utl_histogram_count(&bot_stats.mspt) == 0 ? 0 : utl_histogram_sum(&bot_stats.mspt) / (float64_t) utl_histogram_count(&bot_stats.mspt) / 1000000.0,
+		utl_histogram_percentile(&bot_stats.mspt, 99) / 1000000.0,
+		utl_histogram_max(&bot_stats.mspt) / 1000000.0,
+		tps
+	);
+	log_info("Traffic per player: %.1f KiB/s received, %.1f KiB/s sent",
+		joined == 0 ? 0 : bytes_in / 1024.0 / joined / seconds,
+		joined == 0 ? 0 : bytes_out / 1024.0 / joined / seconds
+	);
+
+	if (bot_stats.replayed != 0) {
+		log_info("Replayed %lu frames at %.2fx speed", (uint64_t) bot_stats.replayed, speed);
+	}
+
+	free(drivers);
+
+	if (joined != count || bot_stats.disconnected != 0) {
+		log_error("%u bots didn't join, %u were disconnected", count - joined, (uint32_t) bot_stats.disconnected);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+
+}
+
+int bot_run_all(uint32_t count, uint32_t seconds) {
+
+	bot_t* bots = calloc(count, sizeof(bot_t));
+
+	const int result = bot_run(bots, count, (uint64_t) seconds * 1000000000, 1);
+
+	free(bots);
+
+	return result;
+
+}
+
+// read the capture and walk its frames, false if it isn't one this server can replay
+static bool bot_load_recording(const char* path, bot_recording_t* recording) {
+
+	FILE* file = fopen(path, "rb");
+
+	if (file == NULL) {
+		log_error("Could not open '%s'!", path);
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	recording->length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	recording->bytes = malloc(recording->length);
+	const bool read = fread(recording->bytes, 1, recording->length, file) == recording->length;
+
+	fclose(file);
+
+	int32_t protocol = 0;
+	const size_t protocol_length = recording->length > 5 ? bot_read_var_int(recording->bytes + 5, recording->length - 5, &protocol) : 0;
+
+	if (!read || protocol_length == 0 || memcmp(recording->bytes, LTG_CAPTURE_MAGIC, 4) != 0 || recording->bytes[4] != LTG_CAPTURE_VERSION) {
+		log_error("'%s' isn't a capture!", path);
+		return false;
+	}
+
+	if (protocol != sky_get_protocol()) {
+		log_error("'%s' was captured with protocol %d, this server speaks %d!", path, protocol, sky_get_protocol());
+		return false;
+	}
+
+	recording->start = 5 + protocol_length;
+	recording->duration = 0;
+	recording->frames = 0;
+
+	for (size_t record = recording->start; record < recording->length;) {
+
+		int32_t delta = 0;
+		int32_t length = 0;
+		const size_t delta_length = bot_read_var_int(recording->bytes + record, recording->length - record, &delta);
+		const size_t length_length = delta_length == 0 ? 0 : bot_read_var_int(recording->bytes + record + delta_length, recording->length - record - delta_length, &length);
+
+		if (length_length == 0 || delta < 0 || length <= 0 || record + delta_length + length_length + length > recording->length) {
+			log_error("'%s' is cut off after %u frames!", path, recording->frames);
+			return false;
+		}
+
+		recording->duration += delta;
+		recording->frames++;
+		record += delta_length + length_length + length;
+
+	}
+
+	log_info("Loaded '%s', %u frames over %.1fs", path, recording->frames, recording->duration / 1000.0);
+
+	return true;
+
+}
+
+int bot_replay_all(uint32_t copies, float64_t speed, char* paths[], uint32_t path_count) {
+
+	bot_recording_t* recordings = calloc(path_count, sizeof(bot_recording_t));
+	bot_t* bots = calloc(path_count * copies, sizeof(bot_t));
+
+	uint64_t duration = 0;
+	int result = EXIT_FAILURE;
+
+	for (uint32_t i = 0; i < path_count; ++i) {
+
+		if (!bot_load_recording(paths[i], &recordings[i])) {
+			goto done;
+		}
+
+		// the copies are spread over the length of the recording
+		for (uint32_t j = 0; j < copies; ++j) {
+			bot_t* bot = &bots[i * copies + j];
+			bot->recording = &recordings[i];
+			bot->record = recordings[i].start;
+			bot->shift = (uint64_t) (recordings[i].duration * 1000000.0 * j / copies / speed);
+			duration = UTL_MAX(duration, bot->shift + (uint64_t) (recordings[i].duration * 1000000.0 / speed));
+		}
+
+	}
+
+	result = bot_run(bots, path_count * copies, duration + BOT_REPLAY_GRACE, speed);
+
+	done: {
+		for (uint32_t i = 0; i < path_count; ++i) {
+			free(recordings[i].bytes);
+		}
+		free(recordings);
+		free(bots);
+		return result;
+	}
+
+}
+
+#else
+
+int bot_run_all(uint32_t count, uint32_t seconds) {
+
+	(void) count;
+	(void) seconds;
+
+	log_error("bench-bots is unsupported on this platform");
+	return EXIT_FAILURE;
+
+}
+
+int bot_replay_all(uint32_t copies, float64_t speed, char* paths[], uint32_t path_count) {
+
+	(void) copies;
+	(void) speed;
+	(void) paths;
+	(void) path_count;
+
+	log_error("bench-replay is unsupported on this platform");
+	return EXIT_FAILURE;
+
+}
+
+#endif
@@ -0,0 +1,10 @@
+#pragma once
+#include "../main.h"
+
+#define BOT_DEFAULT_COUNT 100
+#define BOT_DEFAULT_SECONDS 30
+
+// connect offline players to the running server over loopback, script them for a while and report how it held up
+extern int bot_run_all(uint32_t count, uint32_t seconds);
+// play copies of each capture against the running server, each copy starts a bit further into its recording's length
+extern int bot_replay_all(uint32_t copies, float64_t speed, char* paths[], uint32_t path_count);
@@ -1,12 +1,27 @@
 #include "tests.h"
 #include <stdlib.h>
 #include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <libdeflate.h>
 #include "../io/logger/logger.h"
 #include "../io/packet/packet.h"
 #include "../util/util.h"
 #include "../util/str_util.h"
+#include "../util/deque.h"
+#include "../util/histogram.h"
+#include "../jobs/board.h"
+#include "../jobs/scheduler/scheduler.h"
+#include "../crypt/cfb8.h"
+#include "../io/varint/varint.h"
+#include "../listening/listening.h"
+#include "../listening/phd/handshake.h"
+#include "../motor.h"
 #include "../world/material/material.h"
 #include "../world/world.h"
+#include "../world/entity/living/living.h"
 
 bool test_materials() {
 
@@ -171,6 +186,1443 @@ bool test_worlds() {
 		wld_unload_all();
 	}
 
+	// regions with negative coordinates have to leave the tree too, or they are freed again when all worlds unload
+	// away from spawn, which already has regions
+	wld_world_t* world = wld_new(UTL_CSTRTOSTR("world"), 0, mat_dimension_overworld);
+	wld_region_t* region = wld_gen_region(world, -100, -100);
+	wld_region_t* east = wld_gen_region(world, -99, -100);
+	wld_region_t* south = wld_gen_region(world, -100, -99);
+
+	wld_unload_region(region);
+
+	if (utl_tree_get(&world->regions, ((uint64_t) (uint16_t) -100 << 16) | (uint16_t) -100) != NULL || east->relative.west != NULL || south->relative.north != NULL) {
+		log_error("FAIL ON NEGATIVE REGION");
+		return false;
+	}
+
+	wld_unload_all();
+
+	return true;
+
+}
+
+#define TEST_DEQUE_COUNT 100000
+#define TEST_DEQUE_THIEVES 3
+
+typedef struct {
+	utl_deque_t* deque;
+	_Atomic bool* done;
+	_Atomic uint8_t* seen;
+} test_deque_args_t;
+
+static void* t_test_deque_thief(void* input) {
+
+	test_deque_args_t* args = input;
+	uint64_t value;
+
+	while (!*args->done || utl_deque_size(args->deque) != 0) {
+		if (utl_deque_steal(args->deque, &value)) {
+			args->seen[value]++;
+		}
+	}
+
+	return NULL;
+
+}
+
+bool test_deques() {
+
+	utl_deque_t deque;
+	utl_init_deque(&deque, 2);
+
+	// owner pops newest first, thieves steal oldest first
+	for (uint32_t i = 0; i < 5; ++i) {
+		utl_deque_push(&deque, i);
+	}
+
+	uint64_t value = 0;
+	if (!utl_deque_pop(&deque, &value) || value != 4) {
+		log_error("FAIL ON POP");
+		return false;
+	}
+
+	if (!utl_deque_steal(&deque, &value) || value != 0) {
+		log_error("FAIL ON STEAL");
+		return false;
+	}
+
+	while (utl_deque_pop(&deque, &value));
+
+	if (utl_deque_size(&deque) != 0 || utl_deque_steal(&deque, &value)) {
+		log_error("FAIL ON EMPTY");
+		return false;
+	}
+
+	// every value has to be taken exactly once while thieves are stealing
+	_Atomic uint8_t* seen = calloc(TEST_DEQUE_COUNT, sizeof(_Atomic uint8_t));
+	_Atomic bool done = false;
+	test_deque_args_t args = {
+		.deque = &deque,
+		.done = &done,
+		.seen = seen
+	};
+
+	pthread_t thieves[TEST_DEQUE_THIEVES];
+	for (uint32_t i = 0; i < TEST_DEQUE_THIEVES; ++i) {
+		pthread_create(&thieves[i], NULL, t_test_deque_thief, &args);
+	}
+
+	for (uint32_t i = 0; i < TEST_DEQUE_COUNT; ++i) {
+		utl_deque_push(&deque, i);
+		if ((i & 3) == 0 && utl_deque_pop(&deque, &value)) {
+			seen[value]++;
+		}
+	}
+	while (utl_deque_pop(&deque, &value)) {
+		seen[value]++;
+	}
+
+	done = true;
+	for (uint32_t i = 0; i < TEST_DEQUE_THIEVES; ++i) {
+		pthread_join(thieves[i], NULL);
+	}
+
+	bool passed = true;
+	for (uint32_t i = 0; i < TEST_DEQUE_COUNT; ++i) {
+		if (seen[i] != 1) {
+			log_error("FAIL ON CONCURRENT STEAL (%u taken %u times)", i, seen[i]);
+			passed = false;
+			break;
+		}
+	}
+
+	free(seen);
+	utl_term_deque(&deque);
+
+	return passed;
+
+}
+
+#define TEST_JOB_THREADS 4
+#define TEST_JOB_ROUNDS 2000
+#define TEST_JOB_BATCH 200
+
+static void* t_test_job_pool(void* input) {
+
+	_Atomic bool* failed = input;
+	uint64_t jobs[TEST_JOB_BATCH];
+
+	for (uint32_t round = 0; round < TEST_JOB_ROUNDS; ++round) {
+
+		for (uint32_t i = 0; i < TEST_JOB_BATCH; ++i) {
+			jobs[i] = job_new(job_tick_world, (job_payload_t) { .world = (wld_world_t*) (uintptr_t) (i + 1) });
+			job_retain(jobs[i]);
+		}
+
+		// no other thread may have been handed the same slot while we hold it
+		for (uint32_t i = 0; i < TEST_JOB_BATCH; ++i) {
+			const job_work_t* work = job_get_work(jobs[i]);
+			if (work == NULL || work->payload.world != (wld_world_t*) (uintptr_t) (i + 1)) {
+				*failed = true;
+			}
+			job_free(jobs[i]);
+		}
+
+	}
+
+	return NULL;
+
+}
+
+bool test_jobs() {
+
+	if (job_get_work(0) != NULL) {
+		log_error("FAIL ON NULL HANDLE");
+		return false;
+	}
+
+	const uint64_t job = job_new(job_tick_world, (job_payload_t) { .world = NULL });
+
+	// one reference for the board and one for the scheduler
+	job_retain(job);
+	job_retain(job);
+	job_cancel(job);
+	job_free(job);
+
+	if (job_get_work(job) == NULL || !job_is_canceled(job)) {
+		log_error("FAIL ON CANCEL");
+		return false;
+	}
+
+	job_free(job);
+
+	if (job_get_work(job) != NULL || job_retain(job)) {
+		log_error("FAIL ON FREE");
+		return false;
+	}
+
+	// a new job in the same slot doesn't answer to the old handle
+	const uint64_t reused = job_new(job_tick_world, (job_payload_t) { .world = NULL });
+	job_cancel(job);
+
+	if (reused == job || job_is_canceled(reused) || job_get_type(job) != job_count) {
+		log_error("FAIL ON STALE HANDLE");
+		return false;
+	}
+
+	job_retain(reused);
+	job_free(reused);
+
+	// a slot on its last generation is retired instead of handed out again
+	const uint64_t fresh = job_new(job_tick_world, (job_payload_t) { .world = NULL });
+	job_slot_t* slot = job_get_slot(job_get_index(fresh));
+	atomic_store(&slot->state, ((uint64_t) UINT32_MAX << 32) | (uint32_t) atomic_load(&slot->state));
+	const uint64_t last = ((uint64_t) UINT32_MAX << 32) | job_get_index(fresh);
+	job_retain(last);
+	job_free(last);
+
+	const uint64_t after = job_new(job_tick_world, (job_payload_t) { .world = NULL });
+	if (job_get_index(after) == job_get_index(fresh) || job_get_work(last) != NULL || job_get_work(fresh) != NULL) {
+		log_error("FAIL ON RETIRED SLOT");
+		return false;
+	}
+
+	job_retain(after);
+	job_free(after);
+
+	_Atomic bool failed = false;
+
+	pthread_t threads[TEST_JOB_THREADS];
+	for (uint32_t i = 0; i < TEST_JOB_THREADS; ++i) {
+		pthread_create(&threads[i], NULL, t_test_job_pool, &failed);
+	}
+	for (uint32_t i = 0; i < TEST_JOB_THREADS; ++i) {
+		pthread_join(threads[i], NULL);
+	}
+
+	if (failed) {
+		log_error("FAIL ON CONCURRENT ALLOCATION");
+		return false;
+	}
+
+	return true;
+
+}
+
+#define TEST_SCHEDULER_TICKS 70100
+
+bool test_scheduler() {
+
+	// delays around the edges of the wheel levels
+	const uint32_t delays[] = { 1, 2, 255, 256, 257, 511, 1000, 65535, 65536, 65537, 70000 };
+	const uint32_t count = sizeof(delays) / sizeof(delays[0]);
+
+	uint64_t jobs[sizeof(delays) / sizeof(delays[0])];
+	uint32_t ran[sizeof(delays) / sizeof(delays[0])] = { 0 };
+
+	const uint64_t start = sch_get_tick();
+
+	// any type but a tick phase one, those have to be handled once they are taken off the board
+
+	for (uint32_t i = 0; i < count; ++i) {
+		jobs[i] = sch_schedule(job_new(job_entity_teleport, (job_payload_t) { .client = NULL }), delays[i]);
+	}
+
+	const uint64_t canceled = sch_schedule(job_new(job_entity_teleport, (job_payload_t) { .client = NULL }), 300);
+	const uint64_t repeating = sch_schedule_repeating(job_new(job_entity_teleport, (job_payload_t) { .client = NULL }), 3, 300);
+	uint32_t repeats = 0;
+
+	sch_cancel(canceled);
+
+	for (uint32_t tick = 1; tick <= TEST_SCHEDULER_TICKS; ++tick) {
+
+		sch_tick();
+
+		while (job_get_count() != 0) {
+
+			const uint64_t job = job_get();
+
+			if (job == canceled) {
+				log_error("FAIL ON CANCEL");
+				return false;
+			}
+
+			if (job == repeating) {
+				if ((tick - 3) % 300 != 0) {
+					log_error("FAIL ON REPEAT (tick %u)", tick);
+					return false;
+				}
+				repeats++;
+			}
+
+			for (uint32_t i = 0; i < count; ++i) {
+				if (job == jobs[i]) {
+					if (tick != delays[i] || ran[i]++ != 0) {
+						log_error("FAIL ON DELAY %u (ran at %u)", delays[i], tick);
+						return false;
+					}
+				}
+			}
+
+			job_free(job);
+
+		}
+
+	}
+
+	sch_cancel(repeating);
+
+	for (uint32_t i = 0; i < count; ++i) {
+		if (ran[i] != 1) {
+			log_error("FAIL ON DELAY %u (never ran)", delays[i]);
+			return false;
+		}
+	}
+
+	if (repeats != (TEST_SCHEDULER_TICKS - 3) / 300 + 1 || sch_get_tick() - start != TEST_SCHEDULER_TICKS) {
+		log_error("FAIL ON REPEAT COUNT");
+		return false;
+	}
+
+	// a repeating job canceled without the scheduler is dropped the next time it is due
+	const uint64_t stopped = sch_schedule_repeating(job_new(job_entity_teleport, (job_payload_t) { .client = NULL }), 1, 1);
+	job_cancel(stopped);
+
+	for (uint32_t tick = 0; tick < 3; ++tick) {
+		sch_tick();
+		while (job_get_count() != 0) {
+			job_free(job_get());
+		}
+	}
+
+	if (job_get_work(stopped) != NULL) {
+		log_error("FAIL ON CANCELED REPEAT");
+		return false;
+	}
+
+	return true;
+
+}
+
+bool test_lanes() {
+
+	uint32_t targets[job_lane_count];
+	for (job_lane_t lane = 0; lane < job_lane_count; ++lane) {
+		targets[lane] = job_board.lanes[lane].target_latency;
+		job_board.lanes[lane].target_latency = UINT32_MAX;
+	}
+
+	const job_type_t types[job_lane_count] = {
+		[job_lane_latency_critical] = job_keep_alive,
+		[job_lane_tick_critical] = job_entity_teleport,
+		[job_lane_background] = job_unload_region
+	};
+
+	for (uint32_t i = 0; i < 130; ++i) {
+		for (job_lane_t lane = 0; lane < job_lane_count; ++lane) {
+			job_add(job_new(types[lane], (job_payload_t) { .client = NULL }));
+		}
+	}
+
+	// lanes are served by weight while they all have jobs
+	uint32_t taken[job_lane_count] = { 0 };
+	uint32_t weights = 0;
+	for (job_lane_t lane = 0; lane < job_lane_count; ++lane) {
+		weights += job_board.lanes[lane].weight;
+	}
+
+	for (uint32_t i = 0; i < weights * 5; ++i) {
+		const uint64_t job = job_get();
+		taken[job_get_lane(job_get_type(job))]++;
+		job_free(job);
+	}
+
+	bool passed = true;
+
+	for (job_lane_t lane = 0; lane < job_lane_count; ++lane) {
+		const int32_t expected = job_board.lanes[lane].weight * 5;
+		if ((int32_t) taken[lane] < expected - 1 || (int32_t) taken[lane] > expected + 1) {
+			log_error("FAIL ON WEIGHT (lane %u took %u, expected %d)", lane, taken[lane], expected);
+			passed = false;
+		}
+	}
+
+	// a lane past its target latency goes first
+	job_board.lanes[job_lane_background].target_latency = 0;
+	const struct timespec wait = { .tv_sec = 0, .tv_nsec = 2000000 };
+	nanosleep(&wait, NULL);
+
+	uint64_t job = job_get();
+	if (passed && job_get_lane(job_get_type(job)) != job_lane_background) {
+		log_error("FAIL ON TARGET LATENCY");
+		passed = false;
+	}
+	job_free(job);
+
+	while (job_get_count() != 0) {
+		job_free(job_get());
+	}
+
+	for (job_lane_t lane = 0; lane < job_lane_count; ++lane) {
+		job_board.lanes[lane].target_latency = targets[lane];
+	}
+
+	return passed;
+
+}
+
+bool test_telemetry() {
+
+	static utl_histogram_t histogram;
+
+	for (uint64_t i = 1; i <= 100000; ++i) {
+		utl_histogram_record(&histogram, i);
+	}
+
+	// every bucket is within 1/16th of its values
+	const uint64_t p50 = utl_histogram_percentile(&histogram, 50);
+	const uint64_t p99 = utl_histogram_percentile(&histogram, 99);
+
+	if (utl_histogram_count(&histogram) != 100000 || utl_histogram_max(&histogram) != 100000 || utl_histogram_percentile(&histogram, 100) != 100000) {
+		log_error("FAIL ON HISTOGRAM COUNT");
+		return false;
+	}
+
+	if (p50 < 50000 || p50 > 50000 + 50000 / 16 || p99 < 99000 || p99 > 100000) {
+		log_error("FAIL ON HISTOGRAM PERCENTILE (p50 %" PRIu64 ", p99 %" PRIu64 ")", p50, p99);
+		return false;
+	}
+
+	utl_histogram_reset(&histogram);
+
+	if (utl_histogram_percentile(&histogram, 50) != 0) {
+		log_error("FAIL ON HISTOGRAM RESET");
+		return false;
+	}
+
+	// pings have nothing to do without clients, so they are safe to run here
+	job_reset_telemetry();
+
+	for (uint32_t i = 0; i < 100; ++i) {
+		job_add(job_new(job_send_update_pings, (job_payload_t) { .client = NULL }));
+	}
+
+	const uint64_t canceled = job_new(job_send_update_pings, (job_payload_t) { .client = NULL });
+	job_add(canceled);
+	job_cancel(canceled);
+	job_cancel(canceled);
+
+	while (job_get_count() != 0) {
+		job_handle(job_get());
+	}
+
+	if (job_board.telemetry.types[job_send_update_pings].completed != 100 || job_board.telemetry.types[job_send_update_pings].canceled != 1) {
+		log_error("FAIL ON JOB COUNTERS");
+		return false;
+	}
+
+	if (utl_histogram_count(&job_board.telemetry.types[job_send_update_pings].wait) != 100 || utl_histogram_count(&job_board.telemetry.types[job_send_update_pings].run) != 100) {
+		log_error("FAIL ON JOB TIMINGS");
+		return false;
+	}
+
+	job_reset_telemetry();
+
+	return true;
+
+}
+
+#define TEST_TICK_JOBS 200
+
+static void* t_test_tick_helper(void* args) {
+
+	_Atomic bool* taken = args;
+
+	// take a job and sit on it for a while, the join has to wait for it to finish
+	const uint64_t job = job_get();
+	*taken = true;
+
+	const struct timespec wait = { .tv_sec = 0, .tv_nsec = 20000000 };
+	nanosleep(&wait, NULL);
+
+	job_handle(job);
+
+	return NULL;
+
+}
+
+bool test_tick() {
+
+	wld_world_t* world = calloc(1, sizeof(wld_world_t));
+
+	for (uint32_t i = 0; i < TEST_TICK_JOBS; ++i) {
+		job_add(job_new(job_tick_world, (job_payload_t) { .world = world }));
+	}
+
+	const uint64_t canceled = job_new(job_tick_world, (job_payload_t) { .world = world });
+	job_add(canceled);
+	job_cancel(canceled);
+
+	_Atomic bool taken = false;
+	pthread_t helper;
+	pthread_create(&helper, NULL, t_test_tick_helper, &taken);
+
+	while (!taken);
+
+	job_join_tick();
+
+	// every tick job has been handled once the join returns, including the one still running on the helper
+	const uint64_t age = world->age;
+
+	pthread_join(helper, NULL);
+	free(world);
+
+	if (age != TEST_TICK_JOBS || job_board.tick.pending != 0 || job_get_count() != 0) {
+		log_error("FAIL ON JOIN (age %" PRIu64 ", pending %u)", age, job_board.tick.pending);
+		return false;
+	}
+
+	return true;
+
+}
+
+bool test_continuations() {
+
+	const uint32_t allocated = job_get_allocated();
+	wld_world_t* world = calloc(1, sizeof(wld_world_t));
+	const job_payload_t payload = { .world = world };
+
+	// first runs before both middles, last after both middles
+	const uint64_t first = job_new(job_tick_world, payload);
+	const uint64_t middle[2] = { job_new(job_tick_world, payload), job_new(job_tick_world, payload) };
+	const uint64_t last = job_new(job_tick_world, payload);
+
+	for (uint32_t i = 0; i < 2; ++i) {
+		job_then(first, middle[i]);
+		job_then(middle[i], last);
+	}
+
+	// added in reverse, only the first can go on the board
+	job_add(last);
+	job_add(middle[1]);
+	job_add(middle[0]);
+	job_add(first);
+
+	if (job_get_count() != 1) {
+		log_error("FAIL ON WAITING JOBS");
+		free(world);
+		return false;
+	}
+
+	// each job handled puts what it completes on the board
+	const size_t expected[4] = { 2, 1, 1, 0 };
+
+	for (uint32_t i = 0; i < 4; ++i) {
+		job_handle(job_get());
+		if (job_get_count() != expected[i]) {
+			log_error("FAIL ON CONTINUATION ORDER (%zu jobs after %u)", job_get_count(), i + 1);
+			free(world);
+			return false;
+		}
+	}
+
+	// nothing to wait on once a job has finished
+	const uint64_t after = job_new(job_tick_world, payload);
+	if (job_then(first, after)) {
+		log_error("FAIL ON FINISHED JOB");
+		free(world);
+		return false;
+	}
+	job_add(after);
+	job_handle(job_get());
+
+	// canceling a job cancels what waits on it
+	const uint64_t canceled = job_new(job_tick_world, payload);
+	const uint64_t skipped = job_new(job_tick_world, payload);
+	job_then(canceled, skipped);
+	job_add(skipped);
+	job_add(canceled);
+	job_cancel(canceled);
+	while (job_get_count() != 0) {
+		job_handle(job_get());
+	}
+
+	const uint64_t age = world->age;
+	free(world);
+
+	if (age != 5 || job_board.tick.pending != 0 || job_get_allocated() != allocated) {
+		log_error("FAIL ON CANCELED CONTINUATION (age %" PRIu64 ", pending %u)", age, job_board.tick.pending);
+		return false;
+	}
+
+	return true;
+
+}
+
+static void* t_test_idle_worker(void* args) {
+
+	_Atomic uint64_t* job = args;
+	*job = job_get();
+
+	return NULL;
+
+}
+
+bool test_idle() {
+
+	const uint32_t spin_rounds = job_board.idle.spin_rounds;
+	const uint32_t yield_rounds = job_board.idle.yield_rounds;
+	job_reset_telemetry();
+
+	// one worker parks straight away
+	job_board.idle.spin_rounds = 0;
+	job_board.idle.yield_rounds = 0;
+
+	_Atomic uint64_t parked_job = 0;
+	pthread_t parked;
+	pthread_create(&parked, NULL, t_test_idle_worker, &parked_job);
+
+	while (job_board.queue.sleeping == 0) {
+		sched_yield();
+	}
+
+	// the other spins for long enough to be found spinning
+	job_board.idle.spin_rounds = 24;
+
+	_Atomic uint64_t spinning_job = 0;
+	pthread_t spinning;
+	pthread_create(&spinning, NULL, t_test_idle_worker, &spinning_job);
+
+	while (job_board.idle.spinning == 0) {
+		sched_yield();
+	}
+
+	// taken by the spinning worker, the parked one is left alone
+	job_add(job_new(job_send_update_pings, (job_payload_t) { .client = NULL }));
+	pthread_join(spinning, NULL);
+
+	const uint64_t avoided = job_board.idle.wakeups_avoided;
+	const uint64_t wakeups = job_board.idle.wakeups;
+
+	// nobody spinning now, this one has to wake the parked worker
+	job_add(job_new(job_send_update_pings, (job_payload_t) { .client = NULL }));
+	pthread_join(parked, NULL);
+
+	job_handle(spinning_job);
+	job_handle(parked_job);
+
+	job_board.idle.spin_rounds = spin_rounds;
+	job_board.idle.yield_rounds = yield_rounds;
+
+	if (spinning_job == 0 || parked_job == 0 || avoided != 1 || wakeups != 0 || job_board.idle.wakeups != 1) {
+		log_error("FAIL ON WAKEUPS (avoided %" PRIu64 ", wakeups %" PRIu64 ")", avoided, (uint64_t) job_board.idle.wakeups);
+		return false;
+	}
+
+	job_reset_telemetry();
+
+	return true;
+
+}
+
+// write a handshake frame asking for the given state, returns its length
+static size_t test_handshake_frame(byte_t* frame, size_t address_length, int32_t next_state) {
+
+	byte_t body[address_length + 16];
+	size_t length = 0;
+
+	length += io_write_var_int(body + length, 0x00, 5); // id
+	length += io_write_var_int(body + length, 757, 5); // protocol
+	length += io_write_var_int(body + length, address_length, 5);
+	memset(body + length, 'a', address_length);
+	length += address_length;
+	body[length++] = 0x63; // port
+	body[length++] = 0xDD;
+	length += io_write_var_int(body + length, next_state, 5);
+
+	const size_t length_length = io_write_var_int(frame, length, 5);
+	memcpy(frame + length_length, body, length);
+
+	return length_length + length;
+
+}
+
+// write a login plugin response frame carrying the given bytes of data, returns its length
+static size_t test_plugin_response_frame(byte_t* frame, size_t data_length) {
+
+	byte_t body[data_length + 16];
+	size_t length = 0;
+
+	length += io_write_var_int(body + length, 0x02, 5); // id
+	length += io_write_var_int(body + length, 0, 5); // message id, the client's
+	body[length++] = 1; // successful
+	memset(body + length, 'a', data_length);
+	length += data_length;
+
+	const size_t length_length = io_write_var_int(frame, length, 5);
+	memcpy(frame + length_length, body, length);
+
+	return length_length + length;
+
+}
+
+bool test_frames() {
+
+	ltg_client_t* client = calloc(1, sizeof(ltg_client_t));
+	client->state = ltg_handshake;
+
+	// a frame trickling in a byte at a time is only handled once all of it is there
+	byte_t frame[8192];
+	size_t length = test_handshake_frame(frame, 9, ltg_login);
+
+	for (size_t i = 0; i < length; ++i) {
+		if (!ltg_receive_bytes(client, frame + i, 1) || client->state != (i == length - 1 ? ltg_login : ltg_handshake)) {
+			log_error("FAIL ON SPLIT FRAME (byte %zu)", i);
+			return false;
+		}
+	}
+
+	// the start of the next frame waits for the rest of it
+	if (!ltg_receive_bytes(client, frame, 2) || client->receive.end - client->receive.start != 2) {
+		log_error("FAIL ON PARTIAL FRAME");
+		return false;
+	}
+	client->receive.start = client->receive.end;
+
+	// a frame bigger than the buffer grows it, which shrinks back once the frame is handled
+	client->state = ltg_login;
+	length = test_plugin_response_frame(frame, 6000);
+
+	for (size_t i = 0; i < length; i += 1000) {
+		if (!ltg_receive_bytes(client, frame + i, length - i < 1000 ? length - i : 1000)) {
+			log_error("FAIL ON BIG FRAME");
+			return false;
+		}
+	}
+
+	if (client->state != ltg_login || client->receive.capacity <= LTG_RECEIVE_BUFFER) {
+		log_error("FAIL ON BIG FRAME (capacity %u)", client->receive.capacity);
+		return false;
+	}
+
+	client->state = ltg_handshake;
+	length = test_handshake_frame(frame, 9, ltg_login);
+
+	if (!ltg_receive_bytes(client, frame, length) || client->state != ltg_login || client->receive.capacity != LTG_RECEIVE_BUFFER) {
+		log_error("FAIL ON SHRINK (capacity %u)", client->receive.capacity);
+		return false;
+	}
+
+	// lengths longer than 3 bytes are never valid
+	const byte_t too_long[] = { 0x80, 0x80, 0x80, 0x01 };
+
+	if (ltg_receive_bytes(client, too_long, sizeof(too_long))) {
+		log_error("FAIL ON LENGTH");
+		return false;
+	}
+
+	// a connection that doesn't start with a handshake is dropped as soon as that can be told
+	client->state = ltg_handshake;
+	client->receive.start = client->receive.end = 0;
+	length = io_write_var_int(frame, PHD_HANDSHAKE_MAX_LENGTH + 1, 5);
+	frame[length++] = 0x00;
+
+	if (ltg_receive_bytes(client, frame, length) || client->state != ltg_handshake) {
+		log_error("FAIL ON BIG HANDSHAKE");
+		return false;
+	}
+
+	client->receive.start = client->receive.end = 0;
+	const byte_t not_handshake[] = { 0x10, 0x05 };
+
+	if (ltg_receive_bytes(client, not_handshake, sizeof(not_handshake))) {
+		log_error("FAIL ON HANDSHAKE ID");
+		return false;
+	}
+
+	// proxies forward players in long addresses, and anything after the next state is ignored
+	client->receive.start = client->receive.end = 0;
+	length = test_handshake_frame(frame, 4000, ltg_status);
+	frame[0]++;
+	frame[length++] = 0;
+
+	if (!ltg_receive_bytes(client, frame, length) || client->state != ltg_status) {
+		log_error("FAIL ON HANDSHAKE LENGTH");
+		return false;
+	}
+
+	free(client->receive.bytes);
+	free(client);
+
+	return true;
+
+}
+
+bool test_broadcasts() {
+
+	// compressible and over the compression threshold
+	PCK_INLINE(big_packet, 4000, io_big_endian);
+	for (uint32_t i = 0; i < 4000; ++i) {
+		pck_write_int8(big_packet, i % 7);
+	}
+
+	ltg_broadcast_t* big = ltg_create_broadcast(big_packet);
+
+	// clients without compression get the packet behind its length
+	byte_t plain[4005];
+	const size_t plain_length = io_write_var_int(plain, 4000, 5);
+	memcpy(plain + plain_length, big_packet->bytes, 4000);
+
+	if (big->plain_length != plain_length + 4000 || memcmp(big->plain, plain, big->plain_length) != 0) {
+		log_error("FAIL ON PLAIN FRAME");
+		return false;
+	}
+
+	// clients with compression get it compressed, once for all of them
+	size_t frame_length_length = 0;
+	size_t data_length_length = 0;
+	const int32_t frame_length = io_read_var_int(big->bytes, 5, &frame_length_length);
+	const int32_t data_length = io_read_var_int(big->bytes + frame_length_length, 5, &data_length_length);
+
+	byte_t decompressed[4000];
+	size_t decompressed_length = 0;
+	struct libdeflate_decompressor* decompressor = libdeflate_alloc_decompressor();
+	const enum libdeflate_result result = libdeflate_zlib_decompress(decompressor, big->bytes + frame_length_length + data_length_length, frame_length - data_length_length, decompressed, sizeof(decompressed), &decompressed_length);
+	libdeflate_free_decompressor(decompressor);
+
+	if (big->length >= big->plain_length || frame_length_length + frame_length != big->length || data_length != 4000 || result != LIBDEFLATE_SUCCESS || decompressed_length != 4000 || memcmp(decompressed, big_packet->bytes, 4000) != 0) {
+		log_error("FAIL ON COMPRESSED FRAME (length %u)", big->length);
+		return false;
+	}
+
+	// under the threshold, the frame says it's not compressed
+	PCK_INLINE(small_packet, 3, io_big_endian);
+	pck_write_int8(small_packet, 0x0C);
+	pck_write_int8(small_packet, 1);
+	pck_write_int8(small_packet, 2);
+
+	ltg_broadcast_t* small = ltg_create_broadcast(small_packet);
+	const byte_t small_frame[] = { 4, 0, 0x0C, 1, 2 };
+
+	if (small->length != sizeof(small_frame) || memcmp(small->bytes, small_frame, sizeof(small_frame)) != 0) {
+		log_error("FAIL ON UNCOMPRESSED FRAME");
+		return false;
+	}
+
+	// a packet type that doesn't get smaller is tried a few times and then sent uncompressed
+	PCK_INLINE(random_packet, 4000, io_big_endian);
+	pck_write_int8(random_packet, 0x7E);
+	uint32_t seed = 1;
+	for (uint32_t i = 1; i < 4000; ++i) {
+		seed = seed * 1103515245 + 12345;
+		pck_write_int8(random_packet, (int8_t) (seed >> 24));
+	}
+
+	for (uint32_t i = 0; i <= LTG_INCOMPRESSIBLE_STREAK; ++i) {
+		ltg_broadcast_t* random = ltg_create_broadcast(random_packet);
+		const bool uncompressed = random->length == random->plain_length + 1 && random->bytes[2] == 0 && memcmp(random->bytes + 3, random_packet->bytes, 4000) == 0;
+		ltg_release_broadcast(random);
+		if (!uncompressed) {
+			log_error("FAIL ON INCOMPRESSIBLE FRAME %u", i);
+			return false;
+		}
+	}
+
+	if (sky_get_listener()->compression.incompressible[0x7E] != LTG_INCOMPRESSIBLE_STREAK + 1 || sky_get_listener()->compression.incompressible[0] != 0) {
+		log_error("FAIL ON INCOMPRESSIBLE STREAK");
+		return false;
+	}
+
+	// to a client without compression, a big broadcast is queued as it is and a small one is copied like any other frame
+	ltg_network_t* network = calloc(1, sizeof(ltg_network_t));
+	pthread_mutex_init(&network->ready.lock, NULL);
+	utl_init_list(&network->ready.list, sizeof(ltg_client_t*));
+
+	ltg_client_t* client = calloc(1, sizeof(ltg_client_t));
+	pthread_mutex_init(&client->lock, NULL);
+	utl_init_list(&client->outbound.chunks, sizeof(ltg_send_chunk_t));
+	client->network = network;
+
+	ltg_broadcast(client, big);
+	ltg_broadcast(client, small);
+
+	ltg_send_chunk_t* shared = utl_list_first(&client->outbound.chunks);
+	ltg_send_chunk_t* copied = utl_list_last(&client->outbound.chunks);
+
+	if (client->outbound.chunks.length != 2 || shared->broadcast != big || big->references != 2 || copied->broadcast != NULL || memcmp(copied->bytes, small->plain, small->plain_length) != 0 || copied->encrypted != copied->length) {
+		log_error("FAIL ON QUEUE");
+		return false;
+	}
+
+	if (client->outbound.bytes != big->plain_length + small->plain_length || network->ready.list.length != 1) {
+		log_error("FAIL ON READY (%u bytes queued)", client->outbound.bytes);
+		return false;
+	}
+
+	ltg_release_broadcast(shared->broadcast);
+	pck_release(copied->buffer);
+	utl_term_list(&client->outbound.chunks);
+	pthread_mutex_destroy(&client->lock);
+	free(client);
+
+	utl_term_list(&network->ready.list);
+	pthread_mutex_destroy(&network->ready.lock);
+	free(network);
+
+	ltg_release_broadcast(big);
+	ltg_release_broadcast(small);
+
+	return true;
+
+}
+
+bool test_movement() {
+
+	ent_living_entity_t player = { .entity = { .type = ent_player, .lock = PTHREAD_MUTEX_INITIALIZER, .position = { .x = 0, .y = 64, .z = 0 } } };
+	ent_entity_t hook = { .type = ent_fishing_hook, .lock = PTHREAD_MUTEX_INITIALIZER, .position = { .x = 10, .y = 64, .z = 10 } };
+
+	// several positions from the player and several moves of another entity in the same tick
+	for (int32_t i = 1; i <= 5; ++i) {
+		ent_le_move_look_to(&player, i, 64, i * 2, i * 10, -i, i == 5);
+	}
+	ent_move(&hook, 1, 0, 0, false);
+	ent_move(&hook, 1, 0.5, 0, true);
+
+	sch_tick();
+
+	// one update for each entity
+	uint32_t player_moves = 0;
+	uint32_t hook_moves = 0;
+
+	while (job_get_count() != 0) {
+
+		const uint64_t job = job_get();
+		const job_work_t* work = job_get_work(job);
+
+		if (work->type == job_living_entity_move_look && work->payload.living_entity_move_look.entity == &player) {
+			player_moves++;
+		} else if (work->type == job_entity_move && work->payload.entity_move.entity == &hook) {
+			hook_moves++;
+		}
+
+		job_free(job);
+
+	}
+
+	if (player_moves != 1 || hook_moves != 1) {
+		log_error("FAIL ON UPDATE COUNT (%u player, %u other)", player_moves, hook_moves);
+		return false;
+	}
+
+	// each update carries the last values it was given
+	ent_pending_move_t move;
+
+	if (!ent_take_pending_move(&player.entity, &move) || player.entity.position.x != 5 || player.entity.position.y != 64 || player.entity.position.z != 10 || !move.looked || move.yaw != 50 || move.pitch != -5 || !move.on_ground) {
+		log_error("FAIL ON PLAYER MOVE");
+		return false;
+	}
+	ent_finish_pending_move(&player.entity);
+
+	if (!ent_take_pending_move(&hook, &move) || hook.position.x != 12 || hook.position.y != 64.5 || hook.position.z != 10 || move.looked || !move.on_ground) {
+		log_error("FAIL ON ENTITY MOVE");
+		return false;
+	}
+	ent_finish_pending_move(&hook);
+
+	if (player.entity.pending.scheduled || hook.pending.scheduled) {
+		log_error("FAIL ON FINISH");
+		return false;
+	}
+
+	return true;
+
+}
+
+bool test_admission() {
+
+	ltg_listener_t* listener = calloc(1, sizeof(ltg_listener_t));
+	pthread_mutex_init(&listener->admission.lock, NULL);
+	listener->admission.address_rate = 1;
+	listener->admission.address_burst = 2;
+
+	// an address gets its burst at once and then a connection a second
+	const uint32_t address = htonl(0x0A000001);
+
+	if (!ltg_admit(listener, address, 1000) || !ltg_admit(listener, address, 1000) || ltg_admit(listener, address, 1500) || !ltg_admit(listener, address, 2000) || ltg_admit(listener, address, 2000)) {
+		log_error("FAIL ON ADDRESS RATE");
+		return false;
+	}
+
+	// other addresses and loopback aren't held back by it
+	if (!ltg_admit(listener, htonl(0x0A000002), 2000) || !ltg_admit(listener, htonl(0x7F000001), 2000) || !ltg_admit(listener, htonl(0x7F000001), 2000) || !ltg_admit(listener, htonl(0x7F000001), 2000)) {
+		log_error("FAIL ON OTHER ADDRESSES");
+		return false;
+	}
+
+	// connections throttled by their address don't use up everyone's tokens
+	listener->admission.rate = 1;
+	listener->admission.burst = 2;
+	listener->admission.all.tokens = 2;
+	listener->admission.all.refilled = 3000;
+
+	if (!ltg_admit(listener, address, 3000) || ltg_admit(listener, address, 3000) || ltg_admit(listener, address, 3000) || !ltg_admit(listener, htonl(0x0A000003), 3000) || ltg_admit(listener, htonl(0x0A000004), 3000)) {
+		log_error("FAIL ON RATE");
+		return false;
+	}
+
+	if (listener->admission.admitted != 9 || listener->admission.throttled_address != 4 || listener->admission.throttled != 1) {
+		log_error("FAIL ON COUNTS (%lu admitted, %lu throttled by address, %lu throttled)", (uint64_t) listener->admission.admitted, (uint64_t) listener->admission.throttled_address, (uint64_t) listener->admission.throttled);
+		return false;
+	}
+
+	pthread_mutex_destroy(&listener->admission.lock);
+	free(listener);
+
+	return true;
+
+}
+
+bool test_status() {
+
+	ltg_listener_t* listener = calloc(1, sizeof(ltg_listener_t));
+	pthread_mutex_init(&listener->status.lock, NULL);
+	listener->status.rate = 1;
+	listener->status.burst = 2;
+
+	PCK_INLINE(packet, 16, io_big_endian);
+	pck_write_var_int(packet, 0x00);
+	pck_write_string(packet, "{}", 2);
+
+	uint32_t generation;
+
+	if (ltg_get_status(listener, &generation) != NULL) {
+		log_error("FAIL ON EMPTY CACHE");
+		return false;
+	}
+
+	// cached responses are shared with whoever asks next
+	ltg_broadcast_t* response = ltg_create_broadcast(packet);
+	ltg_set_status(listener, response, generation);
+	ltg_release_broadcast(response);
+
+	ltg_broadcast_t* cached = ltg_get_status(listener, &generation);
+	if (cached != response || cached->references != 2) {
+		log_error("FAIL ON CACHE");
+		return false;
+	}
+	ltg_release_broadcast(cached);
+
+	// a response built before a player joined isn't cached
+	ltg_invalidate_status(listener);
+	if (ltg_get_status(listener, &generation) != NULL) {
+		log_error("FAIL ON INVALIDATE");
+		return false;
+	}
+
+	response = ltg_create_broadcast(packet);
+	ltg_invalidate_status(listener);
+	ltg_set_status(listener, response, generation);
+	ltg_release_broadcast(response);
+
+	if (ltg_get_status(listener, &generation) != NULL) {
+		log_error("FAIL ON OUT OF DATE RESPONSE");
+		return false;
+	}
+
+	// status requests are limited by address and loopback isn't
+	const uint32_t address = htonl(0x0A000001);
+
+	if (!ltg_admit_status(listener, address, 1000) || !ltg_admit_status(listener, address, 1000) || ltg_admit_status(listener, address, 1000) || !ltg_admit_status(listener, address, 2000)) {
+		log_error("FAIL ON STATUS RATE");
+		return false;
+	}
+
+	for (uint32_t i = 0; i < 4; ++i) {
+		if (!ltg_admit_status(listener, htonl(0x7F000001), 2000)) {
+			log_error("FAIL ON LOOPBACK");
+			return false;
+		}
+	}
+
+	if (listener->status.throttled != 1) {
+		log_error("FAIL ON COUNTS (%lu throttled)", (uint64_t) listener->status.throttled);
+		return false;
+	}
+
+	pthread_mutex_destroy(&listener->status.lock);
+	free(listener);
+
+	return true;
+
+}
+
+bool test_backpressure() {
+
+	ltg_network_t* network = calloc(1, sizeof(ltg_network_t));
+	pthread_mutex_init(&network->ready.lock, NULL);
+	utl_init_list(&network->ready.list, sizeof(ltg_client_t*));
+	sck_poller_init(&network->poller);
+
+	ltg_client_t* client = calloc(1, sizeof(ltg_client_t));
+	pthread_mutex_init(&client->lock, NULL);
+	utl_init_list(&client->outbound.chunks, sizeof(ltg_send_chunk_t));
+	utl_init_bit_vector(&client->outbound.stale);
+	client->network = network;
+	client->listener = sky_get_listener();
+
+	// big broadcasts are queued without a copy, so the queue can grow past the marks cheaply
+	PCK_INLINE(packet, 65536, io_big_endian);
+	pck_write_int8(packet, 0x7D);
+	for (uint32_t i = 1; i < 65536; ++i) {
+		pck_write_int8(packet, (int8_t) i);
+	}
+
+	ltg_broadcast_t* broadcast = ltg_create_broadcast(packet);
+
+	while (client->outbound.bytes + broadcast->plain_length < LTG_QUEUE_HIGH) {
+		ltg_broadcast(client, broadcast);
+	}
+
+	if (client->outbound.lagging || ltg_shed_movement(client, 7) != ltg_movement_send || ltg_defer_chunk(client, LTG_DEFER_DISTANCE + 1)) {
+		log_error("FAIL ON UNDER HIGH MARK");
+		return false;
+	}
+
+	ltg_broadcast(client, broadcast);
+
+	// over the high mark, movement updates are skipped and only the chunks around the client are sent
+	if (!client->outbound.lagging || ltg_shed_movement(client, 7) != ltg_movement_skip || ltg_defer_chunk(client, LTG_DEFER_DISTANCE) || !ltg_defer_chunk(client, LTG_DEFER_DISTANCE + 1) || !client->outbound.held) {
+		log_error("FAIL ON OVER HIGH MARK");
+		return false;
+	}
+
+	// once caught up, a skipped entity is sent where it is once and the others carry on as they were
+	client->outbound.lagging = false;
+
+	if (ltg_shed_movement(client, 8) != ltg_movement_send || ltg_shed_movement(client, 7) != ltg_movement_resync || ltg_shed_movement(client, 7) != ltg_movement_send || ltg_take_stale(client, 7)) {
+		log_error("FAIL ON RESYNC");
+		return false;
+	}
+
+	// a client that falls too far behind is disconnected and its queue thrown away
+	client->outbound.lagging = true;
+	client->outbound.lagging_since = INT64_MAX / 2;
+
+	while (!client->outbound.disconnect && client->outbound.bytes < LTG_QUEUE_MAX * 2) {
+		ltg_broadcast(client, broadcast);
+	}
+
+	if (!client->outbound.overflowed || client->outbound.bytes < LTG_QUEUE_MAX || client->outbound.bytes >= LTG_QUEUE_MAX + broadcast->plain_length) {
+		log_error("FAIL ON OVERFLOW (%u bytes queued)", client->outbound.bytes);
+		return false;
+	}
+
+	const uint32_t queued = client->outbound.chunks.length;
+	ltg_broadcast(client, broadcast);
+
+	if (client->outbound.chunks.length != queued) {
+		log_error("FAIL ON QUEUE AFTER OVERFLOW");
+		return false;
+	}
+
+	while (client->outbound.chunks.length != 0) {
+		ltg_send_chunk_t* chunk = utl_list_first(&client->outbound.chunks);
+		ltg_release_broadcast(chunk->broadcast);
+		utl_list_shift(&client->outbound.chunks);
+	}
+
+	utl_term_list(&client->outbound.chunks);
+	utl_term_bit_vector(&client->outbound.stale);
+	pthread_mutex_destroy(&client->lock);
+	free(client);
+
+	sck_poller_term(&network->poller);
+	utl_term_list(&network->ready.list);
+	pthread_mutex_destroy(&network->ready.lock);
+	free(network);
+
+	ltg_release_broadcast(broadcast);
+
+	return true;
+
+}
+
+static void* test_release_packets(void* args) {
+
+	pck_packet_t** packets = args;
+
+	for (uint32_t i = 0; i < 4; ++i) {
+		pck_release(packets[i]);
+	}
+
+	return NULL;
+
+}
+
+bool test_packet_pool() {
+
+	// a released packet is handed out again for anything of its size class
+	pck_packet_t* first = pck_acquire(300, io_big_endian);
+	pck_release(first);
+
+	const pck_pool_stats_t before = pck_get_pool_stats();
+	pck_packet_t* second = pck_acquire(500, io_little_endian);
+	const pck_pool_stats_t after = pck_get_pool_stats();
+
+	if (second != first || second->length != 500 || second->cursor != 0 || second->endianness != io_little_endian || after.acquired != before.acquired + 1 || after.allocated != before.allocated) {
+		log_error("FAIL ON REUSE");
+		return false;
+	}
+
+	pck_release(second);
+
+	// too big for any size class, it's only allocated
+	pck_packet_t* big = pck_acquire(((size_t) 1 << (PCK_POOL_MIN_SHIFT + PCK_POOL_CLASSES)) + 1, io_big_endian);
+
+	if (pck_get_pool_stats().oversized != after.oversized + 1) {
+		log_error("FAIL ON OVERSIZED");
+		return false;
+	}
+
+	pck_release(big);
+
+	// what a thread had cached goes to the other threads when it exits
+	pck_packet_t* packets[4];
+	for (uint32_t i = 0; i < 4; ++i) {
+		packets[i] = pck_acquire(40000, io_big_endian);
+	}
+
+	pthread_t thread;
+	pthread_create(&thread, NULL, test_release_packets, packets);
+	pthread_join(thread, NULL);
+
+	const pck_pool_stats_t shared = pck_get_pool_stats();
+
+	for (uint32_t i = 0; i < 4; ++i) {
+		packets[i] = pck_acquire(40000, io_big_endian);
+	}
+
+	if (pck_get_pool_stats().allocated != shared.allocated) {
+		log_error("FAIL ON SHARED");
+		return false;
+	}
+
+	for (uint32_t i = 0; i < 4; ++i) {
+		pck_release(packets[i]);
+	}
+
+	return true;
+
+}
+
+bool test_cfb8() {
+
+	byte_t key[16];
+	byte_t plain[4099];
+	uint32_t seed = 7;
+	for (uint32_t i = 0; i < sizeof(key); ++i) {
+		seed = seed * 1103515245 + 12345;
+		key[i] = seed >> 24;
+	}
+	for (uint32_t i = 0; i < sizeof(plain); ++i) {
+		seed = seed * 1103515245 + 12345;
+		plain[i] = seed >> 24;
+	}
+
+	// what OpenSSL makes of it in one go
+	byte_t expected[sizeof(plain)];
+	int expected_length = sizeof(expected);
+	EVP_CIPHER_CTX* reference = EVP_CIPHER_CTX_new();
+	EVP_EncryptInit_ex(reference, EVP_aes_128_cfb8(), NULL, key, key);
+	EVP_EncryptUpdate(reference, expected, &expected_length, plain, sizeof(plain));
+	EVP_CIPHER_CTX_free(reference);
+
+	cfb8_cipher_t encrypt;
+	cfb8_cipher_t decrypt;
+	if (cfb8_init(key, &encrypt, &decrypt) != 1) {
+		log_error("FAIL ON INIT");
+		return false;
+	}
+
+	// the stream carries on between calls of any length, and works in place
+	const uint32_t parts[] = { 1, 15, 16, 17, 3, 33, 1000, 2014 };
+	byte_t encrypted[sizeof(plain)];
+	byte_t decrypted[sizeof(plain)];
+	uint32_t offset = 0;
+
+	for (uint32_t i = 0; i < sizeof(parts) / sizeof(parts[0]); ++i) {
+		memcpy(encrypted + offset, plain + offset, parts[i]);
+		cfb8_encrypt(&encrypt, encrypted + offset, parts[i], encrypted + offset);
+		cfb8_decrypt(&decrypt, encrypted + offset, parts[i], decrypted + offset);
+		offset += parts[i];
+	}
+
+	// what's left goes out of place
+	cfb8_encrypt(&encrypt, plain + offset, sizeof(plain) - offset, encrypted + offset);
+	memcpy(decrypted + offset, encrypted + offset, sizeof(plain) - offset);
+	cfb8_decrypt(&decrypt, decrypted + offset, sizeof(plain) - offset, decrypted + offset);
+
+	cfb8_done(&encrypt, &decrypt);
+
+	if (memcmp(encrypted, expected, sizeof(plain)) != 0) {
+		log_error("FAIL ON ENCRYPT (%s)", cfb8_accelerated() ? "AES-NI" : "OpenSSL");
+		return false;
+	}
+
+	if (memcmp(decrypted, plain, sizeof(plain)) != 0) {
+		log_error("FAIL ON DECRYPT (%s)", cfb8_accelerated() ? "AES-NI" : "OpenSSL");
+		return false;
+	}
+
+	return true;
+
+}
+
+// how varints were read before, one byte at a time
+static int32_t test_varint_reference_read(const byte_t* buffer, size_t max_length, size_t* length) {
+
+	uint32_t result = 0;
+	int8_t read = 0x80;
+
+	if (max_length > 5) max_length = 5;
+
+	for (*length = 0; *length < max_length && (read & 0x80); ++*length) {
+		read = io_read_int8(buffer + *length);
+		result |= ((uint32_t) (read & 0x7F) << (7 * *length));
+	}
+
+	return result;
+
+}
+
+static size_t test_varint_reference_length(uint32_t value) {
+
+	size_t length = 0;
+
+	do {
+		length++;
+		value >>= 7;
+	} while (value != 0);
+
+	return length;
+
+}
+
+static inline uint32_t test_varint_random(uint32_t* seed) {
+
+	*seed = *seed * 1103515245 + 12345;
+	const uint32_t high = *seed >> 16;
+	*seed = *seed * 1103515245 + 12345;
+
+	return (high << 16) | (*seed >> 16);
+
+}
+
+bool test_varints() {
+
+	const int32_t edges[] = { 0, 1, 127, 128, 16383, 16384, 2097151, 2097152, 268435455, 268435456, INT32_MAX, -1, INT32_MIN };
+
+	for (uint32_t i = 0; i < sizeof(edges) / sizeof(edges[0]); ++i) {
+
+		byte_t bytes[5];
+		const size_t length = io_write_var_int(bytes, edges[i], sizeof(bytes));
+
+		if (io_var_int_length(edges[i]) != test_varint_reference_length(edges[i])) {
+			log_error("FAIL ON LENGTH OF %d", edges[i]);
+			return false;
+		}
+
+		size_t read_length;
+		if (io_read_var_int(bytes, length, &read_length) != edges[i] || read_length != length) {
+			log_error("FAIL ON READING %d", edges[i]);
+			return false;
+		}
+
+	}
+
+	uint32_t seed = 25;
+	const io_varint_kernel_t best = io_get_varint_kernel();
+
+	for (io_varint_kernel_t kernel = io_varint_scalar; kernel <= best; ++kernel) {
+
+		const io_varint_codec_t* codec = io_get_varint_codec(kernel);
+
+		for (uint32_t round = 0; round < 2000; ++round) {
+
+			// values of every width, in runs the way chunk palettes and tags have them
+			const size_t count = 1 + test_varint_random(&seed) % 300;
+			int32_t* values = malloc(count * sizeof(int32_t));
+			uint32_t width = 0;
+			for (size_t i = 0; i < count; ++i) {
+				if (test_varint_random(&seed) % 8 == 0) width = test_varint_random(&seed) % 33;
+				values[i] = width == 32 ? test_varint_random(&seed) : test_varint_random(&seed) & ((1u << width) - 1);
+			}
+
+			byte_t* expected = malloc(count * 5);
+			size_t expected_length = 0;
+			for (size_t i = 0; i < count; ++i) {
+				expected_length += io_write_var_int(expected + expected_length, values[i], count * 5 - expected_length);
+			}
+
+			if (codec->length(values, count) != expected_length) {
+				log_error("FAIL ON LENGTH (%s)", codec->name);
+				return false;
+			}
+
+			// buffers are exactly max_length long so nothing can get away with going past it
+			const size_t max_length = expected_length + test_varint_random(&seed) % 16;
+			byte_t* written = malloc(max_length);
+			if (codec->write(written, values, count, max_length) != expected_length || memcmp(written, expected, expected_length) != 0) {
+				log_error("FAIL ON WRITE (%s)", codec->name);
+				return false;
+			}
+			free(written);
+
+			byte_t* short_buffer = malloc(expected_length - 1);
+			if (codec->write(short_buffer, values, count, expected_length - 1) != 0) {
+				log_error("FAIL ON WRITE PAST THE END (%s)", codec->name);
+				return false;
+			}
+			free(short_buffer);
+
+			byte_t* readable = malloc(expected_length);
+			memcpy(readable, expected, expected_length);
+			int32_t* read = malloc(count * sizeof(int32_t));
+			if (codec->read(readable, expected_length, read, count) != expected_length || memcmp(read, values, count * sizeof(int32_t)) != 0) {
+				log_error("FAIL ON READ (%s)", codec->name);
+				return false;
+			}
+			free(readable);
+
+			// and whatever else turns up, cut off anywhere, overlong and all
+			const size_t noise_length = 1 + test_varint_random(&seed) % 200;
+			byte_t* noise = malloc(noise_length);
+			const uint32_t high_bits = test_varint_random(&seed) % 4;
+			for (size_t i = 0; i < noise_length; ++i) {
+				noise[i] = test_varint_random(&seed) & (test_varint_random(&seed) % 4 < high_bits ? 0xFF : 0x7F);
+			}
+
+			size_t expected_read = 0;
+			for (size_t i = 0; i < count; ++i) {
+				size_t length;
+				values[i] = test_varint_reference_read(noise + expected_read, noise_length - expected_read, &length);
+				expected_read += length;
+			}
+
+			if (codec->read(noise, noise_length, read, count) != expected_read || memcmp(read, values, count * sizeof(int32_t)) != 0) {
+				log_error("FAIL ON READING NOISE (%s)", codec->name);
+				return false;
+			}
+
+			free(noise);
+			free(read);
+			free(expected);
+			free(values);
+
+		}
+
+	}
+
 	return true;
 
 }
@@ -194,6 +1646,74 @@ int test_run_all() {
 		(test_t) {
 			.func = test_worlds,
 			.label = UTL_CSTRTOSTR("worlds")
+		},
+		(test_t) {
+			.func = test_deques,
+			.label = UTL_CSTRTOSTR("deques")
+		},
+		(test_t) {
+			.func = test_jobs,
+			.label = UTL_CSTRTOSTR("jobs")
+		},
+		(test_t) {
+			.func = test_scheduler,
+			.label = UTL_CSTRTOSTR("scheduler")
+		},
+		(test_t) {
+			.func = test_lanes,
+			.label = UTL_CSTRTOSTR("lanes")
+		},
+		(test_t) {
+			.func = test_telemetry,
+			.label = UTL_CSTRTOSTR("telemetry")
+		},
+		(test_t) {
+			.func = test_tick,
+			.label = UTL_CSTRTOSTR("tick")
+		},
+		(test_t) {
+			.func = test_continuations,
+			.label = UTL_CSTRTOSTR("continuations")
+		},
+		(test_t) {
+			.func = test_idle,
+			.label = UTL_CSTRTOSTR("idle")
+		},
+		(test_t) {
+			.func = test_frames,
+			.label = UTL_CSTRTOSTR("frames")
+		},
+		(test_t) {
+			.func = test_broadcasts,
+			.label = UTL_CSTRTOSTR("broadcasts")
+		},
+		(test_t) {
+			.func = test_movement,
+			.label = UTL_CSTRTOSTR("movement")
+		},
+		(test_t) {
+			.func = test_admission,
+			.label = UTL_CSTRTOSTR("admission")
+		},
+		(test_t) {
+			.func = test_status,
+			.label = UTL_CSTRTOSTR("status")
+		},
+		(test_t) {
+			.func = test_backpressure,
+			.label = UTL_CSTRTOSTR("backpressure")
+		},
+		(test_t) {
+			.func = test_packet_pool,
+			.label = UTL_CSTRTOSTR("packet pool")
+		},
+		(test_t) {
+			.func = test_cfb8,
+			.label = UTL_CSTRTOSTR("cfb8")
+		},
+		(test_t) {
+			.func = test_varints,
+			.label = UTL_CSTRTOSTR("varints")
 		}
 	};
 
@@ -4,5 +4,22 @@
 extern bool test_materials();
 extern bool test_packets();
 extern bool test_worlds();
+extern bool test_deques();
+extern bool test_jobs();
+extern bool test_scheduler();
+extern bool test_lanes();
+extern bool test_telemetry();
+extern bool test_tick();
+extern bool test_continuations();
+extern bool test_idle();
+extern bool test_frames();
+extern bool test_broadcasts();
+extern bool test_movement();
+extern bool test_admission();
+extern bool test_status();
+extern bool test_backpressure();
+extern bool test_packet_pool();
+extern bool test_cfb8();
+extern bool test_varints();
 
 extern int test_run_all();
\ No newline at end of file
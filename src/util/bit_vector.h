@@ -34,7 +34,7 @@ static inline bool utl_bit_vector_test_bit(utl_bit_vector_t* vector, uint32_t bi
 
 		const byte_t byte = UTL_VECTOR_GET_AS(byte_t, &vector->vector, bit >> 3);
 		
-		return ((byte & 0x7) | (1 << bit)) ? true : false;
+		return (byte & (1 << (bit & 0x7))) ? true : false;
 
 	}
 
@@ -52,7 +52,7 @@ static inline void utl_bit_vector_expand(utl_bit_vector_t* vector, uint32_t to)
 
 	if (vector->vector.size <= to) {
 		
-		memset(vector->vector.array + vector->vector.size, 0, to + 1);
+		memset(vector->vector.array + vector->vector.size, 0, to + 1 - vector->vector.size);
 		vector->vector.size = to + 1;
 
 	}
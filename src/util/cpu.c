@@ -0,0 +1,133 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <inttypes.h>
+#include "cpu.h"
+
+#ifdef __WINDOWS__
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+static uint32_t utl_get_online_cpus(uint32_t* cpus, uint32_t max) {
+
+#ifdef __WINDOWS__
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	const long online = info.dwNumberOfProcessors;
+#else
+	const long online = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+
+	uint32_t count = 0;
+	for (long i = 0; i < online && count < max; ++i) {
+		cpus[count++] = i;
+	}
+
+	return count;
+
+}
+
+uint32_t utl_get_cpus(uint32_t* cpus, uint32_t max) {
+
+#ifdef __linux__
+	cpu_set_t set;
+	uint32_t count = 0;
+
+	if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+		// can't tell, assume every online CPU
+		return utl_get_online_cpus(cpus, max);
+	}
+
+	for (uint32_t i = 0; i < CPU_SETSIZE && count < max; ++i) {
+		if (CPU_ISSET(i, &set)) {
+			cpus[count++] = i;
+		}
+	}
+
+	return count;
+#else
+	// no affinity mask to read, every online CPU
+	return utl_get_online_cpus(cpus, max);
+#endif
+
+}
+
+// CPUs worth of quota from the cgroup, 0 if there is no limit
+static uint32_t utl_get_cgroup_cpus() {
+
+	int64_t quota = -1;
+	int64_t period = 0;
+
+	// cgroup v2, "max 100000" when unlimited
+	FILE* file = fopen("/sys/fs/cgroup/cpu.max", "r");
+	if (file != NULL) {
+		char max[32];
+		if (fscanf(file, "%31s %" SCNd64, max, &period) == 2 && max[0] != 'm') {
+			sscanf(max, "%" SCNd64, &quota);
+		}
+		fclose(file);
+	} else {
+		// cgroup v1, quota is -1 when unlimited
+		file = fopen("/sys/fs/cgroup/cpu/cpu.cfs_quota_us", "r");
+		if (file != NULL) {
+			if (fscanf(file, "%" SCNd64, &quota) != 1) {
+				quota = -1;
+			}
+			fclose(file);
+			file = fopen("/sys/fs/cgroup/cpu/cpu.cfs_period_us", "r");
+			if (file != NULL) {
+				if (fscanf(file, "%" SCNd64, &period) != 1) {
+					period = 0;
+				}
+				fclose(file);
+			}
+		}
+	}
+
+	if (quota <= 0 || period <= 0) {
+		return 0;
+	}
+
+	return (quota + period - 1) / period;
+
+}
+
+uint32_t utl_get_available_cpus() {
+
+	uint32_t cpus[UTL_MAX_CPUS];
+	uint32_t count = utl_get_cpus(cpus, UTL_MAX_CPUS);
+	const uint32_t quota = utl_get_cgroup_cpus();
+
+	if (quota != 0 && quota < count) {
+		count = quota;
+	}
+
+	return count == 0 ? 1 : count;
+
+}
+
+bool utl_pin_thread(pthread_t thread, const uint32_t* cpus, uint32_t count) {
+
+#ifdef __linux__
+	cpu_set_t set;
+	CPU_ZERO(&set);
+
+	for (uint32_t i = 0; i < count; ++i) {
+		CPU_SET(cpus[i], &set);
+	}
+
+	return pthread_setaffinity_np(thread, sizeof(set), &set) == 0;
+#else
+	// threads can only be pinned on linux
+	(void) thread;
+	(void) cpus;
+	(void) count;
+	return false;
+#endif
+
+}
\ No newline at end of file
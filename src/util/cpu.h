@@ -0,0 +1,20 @@
+#pragma once
+#include <pthread.h>
+#include "../main.h"
+
+#define UTL_MAX_CPUS 1024
+
+/*
+	Write the CPUs this process is allowed to run on to cpus, in order
+	Returns how many were written
+*/
+extern uint32_t utl_get_cpus(uint32_t* cpus, uint32_t max);
+
+/*
+	How many CPUs worth of time this process can use
+	The smaller of the CPUs in its affinity mask and its cgroup CPU quota, rounded up
+*/
+extern uint32_t utl_get_available_cpus();
+
+// returns false if the thread could not be pinned, always on platforms other than linux
+extern bool utl_pin_thread(pthread_t thread, const uint32_t* cpus, uint32_t count);
\ No newline at end of file
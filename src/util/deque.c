@@ -0,0 +1,22 @@
+#include <assert.h>
+#include "deque.h"
+
+utl_deque_array_t* utl_deque_grow(utl_deque_t* deque, utl_deque_array_t* array, int64_t top, int64_t bottom) {
+
+	const uint64_t capacity = (array->mask + 1) << 1;
+
+	utl_deque_array_t* grown = malloc(sizeof(utl_deque_array_t) + sizeof(uint64_t) * capacity);
+	grown->mask = capacity - 1;
+
+	for (int64_t i = top; i < bottom; ++i) {
+		atomic_store_explicit(&grown->elements[i & grown->mask], atomic_load_explicit(&array->elements[i & array->mask], memory_order_relaxed), memory_order_relaxed);
+	}
+
+	// thieves may still be reading the old array, so it is kept until the deque is terminated
+	grown->retired = array;
+
+	atomic_store_explicit(&deque->array, grown, memory_order_release);
+
+	return grown;
+
+}
\ No newline at end of file
@@ -0,0 +1,131 @@
+#pragma once
+#include <stdlib.h>
+#include <assert.h>
+#include <stdatomic.h>
+#include "../main.h"
+
+/*
+	Chase-Lev work-stealing deque of 64-bit values
+	Only the owning thread may push and pop (from the bottom), any thread may steal (from the top)
+*/
+
+typedef struct utl_deque_array utl_deque_array_t;
+
+struct utl_deque_array {
+
+	utl_deque_array_t* retired; // arrays replaced by a resize, freed when the deque is terminated
+	uint64_t mask;
+	_Atomic uint64_t elements[];
+
+};
+
+typedef struct {
+
+	_Atomic int64_t top;
+	_Atomic int64_t bottom;
+	utl_deque_array_t* _Atomic array;
+
+} utl_deque_t;
+
+static inline void utl_init_deque(utl_deque_t* deque, uint32_t capacity) {
+
+	// capacity must be a power of 2
+	assert((capacity & (capacity - 1)) == 0);
+
+	utl_deque_array_t* array = malloc(sizeof(utl_deque_array_t) + sizeof(uint64_t) * capacity);
+	array->retired = NULL;
+	array->mask = capacity - 1;
+
+	atomic_init(&deque->top, 0);
+	atomic_init(&deque->bottom, 0);
+	atomic_init(&deque->array, array);
+
+}
+
+extern utl_deque_array_t* utl_deque_grow(utl_deque_t* deque, utl_deque_array_t* array, int64_t top, int64_t bottom);
+
+static inline void utl_deque_push(utl_deque_t* deque, uint64_t value) {
+
+	const int64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+	const int64_t top = atomic_load_explicit(&deque->top, memory_order_acquire);
+	utl_deque_array_t* array = atomic_load_explicit(&deque->array, memory_order_relaxed);
+
+	if ((uint64_t) (bottom - top) > array->mask) {
+		array = utl_deque_grow(deque, array, top, bottom);
+	}
+
+	atomic_store_explicit(&array->elements[bottom & array->mask], value, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+
+}
+
+// returns false if the deque is empty
+static inline bool utl_deque_pop(utl_deque_t* deque, uint64_t* value) {
+
+	const int64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+	utl_deque_array_t* array = atomic_load_explicit(&deque->array, memory_order_relaxed);
+	atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	int64_t top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+	if (top > bottom) {
+		// empty
+		atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+		return false;
+	}
+
+	*value = atomic_load_explicit(&array->elements[bottom & array->mask], memory_order_relaxed);
+
+	if (top == bottom) {
+		// last element, race against thieves for it
+		const bool won = atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed);
+		atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+		return won;
+	}
+
+	return true;
+
+}
+
+// returns false if the deque is empty or another thread won the element
+static inline bool utl_deque_steal(utl_deque_t* deque, uint64_t* value) {
+
+	int64_t top = atomic_load_explicit(&deque->top, memory_order_acquire);
+	atomic_thread_fence(memory_order_seq_cst);
+	const int64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+
+	if (top >= bottom) {
+		return false;
+	}
+
+	utl_deque_array_t* array = atomic_load_explicit(&deque->array, memory_order_acquire);
+	*value = atomic_load_explicit(&array->elements[top & array->mask], memory_order_relaxed);
+
+	return atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed);
+
+}
+
+// approximate when other threads are using the deque
+static inline uint32_t utl_deque_size(utl_deque_t* deque) {
+
+	const int64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+	const int64_t top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+	return bottom > top ? bottom - top : 0;
+
+}
+
+static inline void utl_term_deque(utl_deque_t* deque) {
+
+	utl_deque_array_t* array = atomic_load(&deque->array);
+
+	while (array != NULL) {
+		utl_deque_array_t* retired = array->retired;
+		free(array);
+		array = retired;
+	}
+
+	atomic_store(&deque->array, NULL);
+
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#include <math.h>
+#include "histogram.h"
+
+uint64_t utl_histogram_percentile(utl_histogram_t* histogram, float64_t percentile) {
+
+	const uint64_t count = utl_histogram_count(histogram);
+
+	if (count == 0) {
+		return 0;
+	}
+
+	uint64_t target = ceil(count * percentile / 100);
+
+	if (target == 0) {
+		target = 1;
+	}
+
+	uint64_t seen = 0;
+
+	for (uint32_t i = 0; i < UTL_HISTOGRAM_BUCKETS; ++i) {
+
+		seen += atomic_load_explicit(&histogram->buckets[i], memory_order_relaxed);
+
+		if (seen >= target) {
+			const uint64_t max = utl_histogram_max(histogram);
+			const uint64_t value = utl_histogram_bucket_max(i);
+			return value < max ? value : max;
+		}
+
+	}
+
+	return utl_histogram_max(histogram);
+
+}
+
+void utl_histogram_reset(utl_histogram_t* histogram) {
+
+	for (uint32_t i = 0; i < UTL_HISTOGRAM_BUCKETS; ++i) {
+		atomic_store_explicit(&histogram->buckets[i], 0, memory_order_relaxed);
+	}
+
+	atomic_store_explicit(&histogram->count, 0, memory_order_relaxed);
+	atomic_store_explicit(&histogram->sum, 0, memory_order_relaxed);
+	atomic_store_explicit(&histogram->max, 0, memory_order_relaxed);
+
+}
\ No newline at end of file
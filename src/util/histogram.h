@@ -0,0 +1,92 @@
+#pragma once
+#include <stdatomic.h>
+#include "../main.h"
+
+/*
+	Log-linear histogram in the style of HdrHistogram
+	Values are bucketed by their highest set bit and the UTL_HISTOGRAM_SUB_BITS bits below it,
+	so a bucket never spans more than 1/16th of the values in it
+	Recording is lock free, any thread may record while others read
+*/
+
+#define UTL_HISTOGRAM_SUB_BITS 4
+#define UTL_HISTOGRAM_SUB_BUCKETS (1 << UTL_HISTOGRAM_SUB_BITS)
+// larger values are clamped, 2^40 nanoseconds is a bit over 18 minutes
+#define UTL_HISTOGRAM_MAX_BITS 40
+#define UTL_HISTOGRAM_BUCKETS ((UTL_HISTOGRAM_MAX_BITS - UTL_HISTOGRAM_SUB_BITS + 1) * UTL_HISTOGRAM_SUB_BUCKETS)
+
+typedef struct {
+
+	_Atomic uint64_t count;
+	_Atomic uint64_t sum;
+	_Atomic uint64_t max;
+	_Atomic uint64_t buckets[UTL_HISTOGRAM_BUCKETS];
+
+} utl_histogram_t;
+
+static inline uint32_t utl_histogram_bucket(uint64_t value) {
+
+	if (value < UTL_HISTOGRAM_SUB_BUCKETS) {
+		return value;
+	}
+
+	const uint32_t bit = 63 - __builtin_clzll(value);
+
+	return (bit - UTL_HISTOGRAM_SUB_BITS + 1) * UTL_HISTOGRAM_SUB_BUCKETS + ((value >> (bit - UTL_HISTOGRAM_SUB_BITS)) & (UTL_HISTOGRAM_SUB_BUCKETS - 1));
+
+}
+
+// highest value that falls in a bucket
+static inline uint64_t utl_histogram_bucket_max(uint32_t bucket) {
+
+	if (bucket < UTL_HISTOGRAM_SUB_BUCKETS) {
+		return bucket;
+	}
+
+	const uint32_t shift = bucket / UTL_HISTOGRAM_SUB_BUCKETS - 1;
+
+	return (((uint64_t) (UTL_HISTOGRAM_SUB_BUCKETS + bucket % UTL_HISTOGRAM_SUB_BUCKETS + 1)) << shift) - 1;
+
+}
+
+static inline void utl_histogram_record(utl_histogram_t* histogram, uint64_t value) {
+
+	if (value >= (1ull << UTL_HISTOGRAM_MAX_BITS)) {
+		value = (1ull << UTL_HISTOGRAM_MAX_BITS) - 1;
+	}
+
+	atomic_fetch_add_explicit(&histogram->buckets[utl_histogram_bucket(value)], 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&histogram->count, 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&histogram->sum, value, memory_order_relaxed);
+
+	uint64_t max = atomic_load_explicit(&histogram->max, memory_order_relaxed);
+	while (value > max && !atomic_compare_exchange_weak_explicit(&histogram->max, &max, value, memory_order_relaxed, memory_order_relaxed));
+
+}
+
+static inline uint64_t utl_histogram_count(utl_histogram_t* histogram) {
+
+	return atomic_load_explicit(&histogram->count, memory_order_relaxed);
+
+}
+
+static inline uint64_t utl_histogram_sum(utl_histogram_t* histogram) {
+
+	return atomic_load_explicit(&histogram->sum, memory_order_relaxed);
+
+}
+
+static inline uint64_t utl_histogram_max(utl_histogram_t* histogram) {
+
+	return atomic_load_explicit(&histogram->max, memory_order_relaxed);
+
+}
+
+/*
+	Value at a percentile (0-100), reported as the highest value of its bucket
+	Approximate while other threads are recording
+*/
+extern uint64_t utl_histogram_percentile(utl_histogram_t* histogram, float64_t percentile);
+
+// values recorded during a reset may be partially lost
+extern void utl_histogram_reset(utl_histogram_t* histogram);
\ No newline at end of file
@@ -61,6 +61,27 @@ static inline void* utl_list_first(utl_list_t* list) {
 
 }
 
+static inline void* utl_list_last(utl_list_t* list) {
+
+	utl_list_node_t* node = utl_id_vector_get(&list->nodes, list->last);
+
+	return node->element;
+
+}
+
+// walk the list with: for (uint32_t i = 0, node = list->first; i < list->length; ++i, node = utl_list_next(list, node))
+static inline void* utl_list_get(utl_list_t* list, uint32_t node) {
+
+	return ((utl_list_node_t*) utl_id_vector_get(&list->nodes, node))->element;
+
+}
+
+static inline uint32_t utl_list_next(utl_list_t* list, uint32_t node) {
+
+	return ((utl_list_node_t*) utl_id_vector_get(&list->nodes, node))->next;
+
+}
+
 static inline void utl_list_shift(utl_list_t* list) {
 
 	uint32_t node_id = list->first;
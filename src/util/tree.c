@@ -224,6 +224,10 @@ void utl_tree_remove(utl_tree_t* tree, uint32_t key) {
 					} else {
 						tree->root = look->left;
 					}
+
+					// the branch moves up to where this one was
+					utl_tree_branch_t* child = utl_id_vector_get(&tree->nodes, look->left);
+					child->parent = look->parent;
 					
 					tree->length--;
 					utl_id_vector_remove(&tree->nodes, look_idx);
@@ -241,6 +245,10 @@ void utl_tree_remove(utl_tree_t* tree, uint32_t key) {
 					} else {
 						tree->root = look->right;
 					}
+
+					// the branch moves up to where this one was
+					utl_tree_branch_t* child = utl_id_vector_get(&tree->nodes, look->right);
+					child->parent = look->parent;
 					
 					tree->length--;
 					utl_id_vector_remove(&tree->nodes, look_idx);
@@ -115,8 +115,86 @@ void ent_set_chunk(ent_entity_t* entity) {
 
 }
 
+void ent_schedule_move(ent_entity_t* entity) {
+
+	if (entity->pending.scheduled) {
+		return;
+	}
+
+	entity->pending.scheduled = true;
+
+	if (ent_is_le(entity)) {
+		sch_schedule(job_new(job_living_entity_move_look, (job_payload_t) { .living_entity_move_look = { .entity = (ent_living_entity_t*) entity, .pending = true } }), 1);
+	} else {
+		sch_schedule(job_new(job_entity_move, (job_payload_t) { .entity_move = { .entity = entity, .pending = true } }), 1);
+	}
+
+}
+
+bool ent_take_pending_move(ent_entity_t* entity, ent_pending_move_t* move) {
+
+	bool removed = false;
+
+	with_lock (&entity->lock) {
+
+		*move = entity->pending.move;
+		entity->pending.move = (ent_pending_move_t) { 0 };
+		removed = entity->pending.removed;
+
+		// applied under the lock so ent_move_to always measures from where the broadcast left off
+		if (!removed) {
+			entity->position.x = entity->position.x + move->d_x;
+			entity->position.y = entity->position.y + move->d_y;
+			entity->position.z = entity->position.z + move->d_z;
+			if (move->moved || move->looked) {
+				entity->on_ground = move->on_ground;
+			}
+		}
+
+	}
+
+	return !removed;
+
+}
+
+void ent_finish_pending_move(ent_entity_t* entity) {
+
+	bool removed = false;
+
+	with_lock (&entity->lock) {
+
+		entity->pending.scheduled = false;
+		removed = entity->pending.removed;
+
+		// movement that arrived during the broadcast goes out next tick
+		if (!removed && (entity->pending.move.moved || entity->pending.move.looked)) {
+			ent_schedule_move(entity);
+		}
+
+	}
+
+	if (removed) {
+		ent_free_entity(entity);
+	}
+
+}
+
 void ent_free_entity(ent_entity_t* entity) {
 
+	// the pending move job still refers to the entity, it frees the entity once it has run
+	bool deferred = false;
+
+	with_lock (&entity->lock) {
+		if (entity->pending.scheduled) {
+			entity->pending.removed = true;
+			deferred = true;
+		}
+	}
+
+	if (deferred) {
+		return;
+	}
+
 	// remove entity from clients
 	wld_chunk_subscribers_foreach(ent_get_chunk(entity), ent_destroy_entity, entity);
 
@@ -9,6 +9,22 @@
 #include "../../jobs/board.h"
 #include "../positions.h"
 
+// movement received since the last broadcast, relative to the entity's position
+typedef struct {
+
+	float64_t d_x;
+	float64_t d_y;
+	float64_t d_z;
+
+	float32_t yaw;
+	float32_t pitch;
+
+	bool on_ground : 1;
+	bool moved : 1;
+	bool looked : 1;
+
+} ent_pending_move_t;
+
 struct ent_entity {
 
 	wld_position_t position;
@@ -39,6 +55,13 @@ struct ent_entity {
 	bool on_ground : 1;
 	uint8_t powder_snow_ticks;
 
+	// merged into a single broadcast on the next tick, guarded by lock
+	struct {
+		ent_pending_move_t move;
+		bool scheduled;
+		bool removed;
+	} pending;
+
 };
 
 extern uint32_t ent_register_entity(ent_entity_t* entity);
@@ -124,8 +147,55 @@ static inline void ent_remove_chunk(ent_entity_t* entity) {
 
 }
 
+/*
+Schedule the broadcast of the entity's pending move for the next tick, if it isn't already
+entity lock must be held
+*/
+extern void ent_schedule_move(ent_entity_t* entity);
+/*
+Take the pending move and apply its position, returns false if the entity has been freed
+*/
+extern bool ent_take_pending_move(ent_entity_t* entity, ent_pending_move_t* move);
+/*
+Called once the pending move has been broadcast, frees the entity if it was freed meanwhile
+*/
+extern void ent_finish_pending_move(ent_entity_t* entity);
+
 static inline void ent_move(ent_entity_t* entity, float64_t d_x, float64_t d_y, float64_t d_z, bool on_ground) {
-	job_add(job_new(job_entity_move, (job_payload_t) { .entity_move = { .entity = entity, .initial_chunk = ent_get_chunk(entity), .d_x = d_x, .d_y = d_y, .d_z = d_z, .on_ground = on_ground } }));
+
+	with_lock (&entity->lock) {
+		entity->pending.move.d_x += d_x;
+		entity->pending.move.d_y += d_y;
+		entity->pending.move.d_z += d_z;
+		entity->pending.move.on_ground = on_ground;
+		entity->pending.move.moved = true;
+		ent_schedule_move(entity);
+	}
+
+}
+
+static inline void ent_move_to(ent_entity_t* entity, float64_t x, float64_t y, float64_t z, bool on_ground) {
+
+	with_lock (&entity->lock) {
+		entity->pending.move.d_x = x - entity->position.x;
+		entity->pending.move.d_y = y - entity->position.y;
+		entity->pending.move.d_z = z - entity->position.z;
+		entity->pending.move.on_ground = on_ground;
+		entity->pending.move.moved = true;
+		ent_schedule_move(entity);
+	}
+
+}
+
+static inline void ent_clear_pending_move(ent_entity_t* entity) {
+
+	with_lock (&entity->lock) {
+		entity->pending.move.d_x = 0;
+		entity->pending.move.d_y = 0;
+		entity->pending.move.d_z = 0;
+		entity->pending.move.moved = false;
+	}
+
 }
 
 extern void ent_set_chunk(ent_entity_t* entity);
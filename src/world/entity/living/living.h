@@ -64,39 +64,29 @@ static inline bool ent_le_is_dead(ent_living_entity_t* living_entity) {
 }
 
 static inline void ent_le_look(ent_living_entity_t* entity, float32_t yaw, float32_t pitch, bool on_ground) {
-	job_add(
-		job_new(
-			job_living_entity_look,
-			(job_payload_t) {
-				.living_entity_look = {
-					.entity = entity,
-					.yaw = yaw,
-					.pitch = pitch,
-					.on_ground = on_ground
-				}
-			}
-		)
-	);
+
+	with_lock (&entity->entity.lock) {
+		entity->entity.pending.move.yaw = yaw;
+		entity->entity.pending.move.pitch = pitch;
+		entity->entity.pending.move.on_ground = on_ground;
+		entity->entity.pending.move.looked = true;
+		ent_schedule_move(ent_le_get_entity(entity));
+	}
+
 }
 
 static inline void ent_le_move_look(ent_living_entity_t* entity, float64_t d_x, float64_t d_y, float64_t d_z, float32_t yaw, float32_t pitch, bool on_ground) {
-	job_add(
-		job_new(
-			job_living_entity_move_look,
-			(job_payload_t) {
-				.living_entity_move_look = {
-					.entity = entity,
-					.initial_chunk = ent_get_chunk(ent_le_get_entity(entity)),
-					.d_x = d_x,
-					.d_y = d_y,
-					.d_z = d_z,
-					.yaw = yaw,
-					.pitch = pitch,
-					.on_ground = on_ground
-			 	}
-			}
-		)
-	);
+
+	ent_le_look(entity, yaw, pitch, on_ground);
+	ent_move(ent_le_get_entity(entity), d_x, d_y, d_z, on_ground);
+
+}
+
+static inline void ent_le_move_look_to(ent_living_entity_t* entity, float64_t x, float64_t y, float64_t z, float32_t yaw, float32_t pitch, bool on_ground) {
+
+	ent_le_look(entity, yaw, pitch, on_ground);
+	ent_move_to(ent_le_get_entity(entity), x, y, z, on_ground);
+
 }
 
 static inline void ent_le_teleport_look(ent_living_entity_t* entity, wld_world_t* world, float64_t x, float64_t y, float64_t z, float32_t yaw, float32_t pitch, bool on_ground) {
@@ -15,7 +15,7 @@ struct ent_player {
 	float32_t additional_hearts;
 	int32_t score;
 	
-	uint32_t digging;
+	uint64_t digging;
 	
 	_Atomic float32_t saturation;
 
@@ -147,7 +147,7 @@ static inline void ent_player_stop_digging_block(ent_player_t* player) {
 
 }
 
-static inline void ent_player_start_digging_block(ent_player_t* player, uint32_t job) {
+static inline void ent_player_start_digging_block(ent_player_t* player, uint64_t job) {
 
 	with_lock (&ent_player_get_entity(player)->lock) {
 		player->digging_block = true;
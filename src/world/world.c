@@ -129,7 +129,7 @@ wld_region_t* wld_gen_region(wld_world_t* world, int16_t x, int16_t z) {
 	const int64_t key = ((uint64_t) (uint16_t) x << 16) | (uint16_t) z;
 
 	// tick job
-	uint32_t tick_job = job_new(job_tick_region, (job_payload_t) { .region = region });
+	uint64_t tick_job = job_new(job_tick_region, (job_payload_t) { .region = region });
 
 	with_lock (&world->lock) {
 		wld_region_t region_init = (wld_region_t) {
@@ -241,10 +241,10 @@ void wld_recalc_chunk_ticket_l(wld_chunk_t* chunk) {
 
 static inline void wld_set_block_send(uint32_t client_id, void* arg) {
 
-	pck_packet_t* packet = arg;
+	ltg_broadcast_t* broadcast = arg;
 	ltg_client_t* client = ltg_get_client_by_id(sky_get_listener(), client_id);
 
-	ltg_send(client, packet);
+	ltg_broadcast(client, broadcast);
 
 }
 
@@ -287,20 +287,23 @@ void wld_set_block_at(wld_chunk_t* chunk, int32_t x, int16_t y, int32_t z, mat_b
 	});
 	pck_write_var_int(packet, type);
 
-	utl_bit_vector_foreach(&block_chunk->subscribers, wld_set_block_send, packet);
+	// framed once for all subscribers
+	ltg_broadcast_t* broadcast = ltg_create_broadcast(packet);
+	utl_bit_vector_foreach(&block_chunk->subscribers, wld_set_block_send, broadcast);
+	ltg_release_broadcast(broadcast);
 
 }
 
 void wld_unload_region(wld_region_t* region) {
 
-	// unload region crashes sometimes on stop server TODO
-
-	with_lock (&region->world->lock) {
-		utl_tree_remove(&region->world->regions, ((uint64_t) wld_region_get_x(region) << 16) | (uint64_t) wld_region_get_z(region));
+	// same key as wld_gen_region, a sign extended coordinate would leave the region in the tree,
+	// and unlink the neighbours under the lock so neighbouring unloads and generations don't race
+	wld_world_t* world = region->world;
+	with_lock (&world->lock) {
+		utl_tree_remove(&world->regions, ((uint64_t) (uint16_t) wld_region_get_x(region) << 16) | (uint16_t) wld_region_get_z(region));
+		wld_free_region(region);
 	}
 
-	wld_free_region(region);
-
 }
 
 void wld_free_region(wld_region_t* region) {
@@ -68,7 +68,7 @@ struct wld_region {
 	
 	wld_world_t* const world; // typeof wld_world_t*
 
-	uint32_t tick;
+	uint64_t tick;
 
 	// chunks
 	wld_chunk_t* _Atomic chunks[32 * 32];
@@ -110,7 +110,7 @@ struct wld_world {
 
 	} spawn;
 	
-	uint32_t tick;
+	uint64_t tick;
 	
 	_Atomic uint16_t time;
 	const uint16_t id;